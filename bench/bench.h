@@ -0,0 +1,76 @@
+/* Helpers shared by the benchmarks */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Number of times each measurement is repeated, the best run is reported */
+#define BENCH_RUNS 5
+
+/* Return monotonic time in seconds */
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* Print a single result line */
+static void bench_report(const char *name, double seconds)
+{
+    printf("%-40s %12.3f ms\n", name, seconds * 1e3);
+}
+
+/* Write a YAML file with sections * keys scalars of mixed types, and
+   return the path (must be freed and unlinked by the caller) */
+static char *bench_yaml_file_create(int sections, int keys)
+{
+    char *path = strdup("/tmp/sconf-bench-XXXXXX.yaml");
+    if (!path) {
+        return NULL;
+    }
+
+    int fd = mkstemps(path, 5);
+    if (fd == -1) {
+        free(path);
+        return NULL;
+    }
+
+    FILE *fp = fdopen(fd, "w");
+    if (!fp) {
+        close(fd);
+        unlink(path);
+        free(path);
+        return NULL;
+    }
+
+    for (int s = 0; s < sections; s++)
+    {
+        fprintf(fp, "section-%d:\n", s);
+        for (int k = 0; k < keys; k++)
+        {
+            switch (k % 4)
+            {
+                case 0:
+                    fprintf(fp, "  key-%d: value-%d-%d\n", k, s, k);
+                    break;
+                case 1:
+                    fprintf(fp, "  key-%d: %d\n", k, s * keys + k);
+                    break;
+                case 2:
+                    fprintf(fp, "  key-%d: %d.%d\n", k, s, k);
+                    break;
+                default:
+                    fprintf(fp, "  key-%d: %s\n", k, k % 8 ? "true" : "false");
+                    break;
+            }
+        }
+    }
+
+    fclose(fp);
+
+    return path;
+}
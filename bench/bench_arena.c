@@ -0,0 +1,78 @@
+/* Compare load and destroy time of heap-backed and arena-backed trees */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sconf.h>
+
+#include "bench.h"
+
+/* Default size of the generated config (sections * keys) */
+#define BENCH_SECTIONS 400
+#define BENCH_KEYS     100
+
+static int bench_run(const char *name, const char *filename, bool arena)
+{
+    double best_load = 0;
+    double best_destroy = 0;
+
+    for (int run = 0; run < BENCH_RUNS; run++)
+    {
+        struct SConfErr err = {0};
+
+        double start = bench_now();
+
+        struct SConfNode *root = arena ? SCONF_ROOT_ARENA(&err)
+                                       : SCONF_ROOT(&err);
+        if (!root || sconf_yaml_read(root, filename, &err) == -1) {
+            fprintf(stderr, "Error: %s\n", sconf_strerror(&err));
+            sconf_node_destroy(root);
+            return -1;
+        }
+
+        double loaded = bench_now();
+        sconf_node_destroy(root);
+        double destroyed = bench_now();
+
+        if (run == 0 || loaded - start < best_load) {
+            best_load = loaded - start;
+        }
+        if (run == 0 || destroyed - loaded < best_destroy) {
+            best_destroy = destroyed - loaded;
+        }
+    }
+
+    char label[64];
+    snprintf(label, sizeof(label), "%s load", name);
+    bench_report(label, best_load);
+    snprintf(label, sizeof(label), "%s destroy", name);
+    bench_report(label, best_destroy);
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int sections = argc > 1 ? atoi(argv[1]) : BENCH_SECTIONS;
+    int keys = argc > 2 ? atoi(argv[2]) : BENCH_KEYS;
+
+    char *filename = bench_yaml_file_create(sections, keys);
+    if (!filename) {
+        fprintf(stderr, "Error: could not create YAML file\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("%d keys, best of %d runs\n", sections * keys, BENCH_RUNS);
+
+    int rc = EXIT_SUCCESS;
+    if (bench_run("heap", filename, false) == -1 ||
+            bench_run("arena", filename, true) == -1) {
+        rc = EXIT_FAILURE;
+    }
+
+    unlink(filename);
+    free(filename);
+
+    return rc;
+}
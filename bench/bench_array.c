@@ -0,0 +1,85 @@
+/* Show that building arrays scales linearly with the number of elements */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <sconf.h>
+
+#include "bench.h"
+
+/* Largest array built by default */
+#define BENCH_MAX_ELEMENTS (5 * 1000 * 1000)
+
+static int bench_run(uint32_t elements, bool arena, double *seconds)
+{
+    for (int run = 0; run < BENCH_RUNS; run++)
+    {
+        struct SConfErr err = {0};
+
+        struct SConfNode *root = arena ?
+            sconf_node_create_arena(SCONF_TYPE_DICT, NULL, &err) :
+            sconf_node_create(SCONF_TYPE_DICT, NULL, &err);
+        if (!root) {
+            fprintf(stderr, "Error: %s\n", sconf_strerror(&err));
+            return -1;
+        }
+
+        double start = bench_now();
+
+        struct SConfNode *array = sconf_node_create_and_insert(
+            "values", SCONF_TYPE_ARRAY, root, 0, NULL, &err);
+        if (!array) {
+            fprintf(stderr, "Error: %s\n", sconf_strerror(&err));
+            sconf_node_destroy(root);
+            return -1;
+        }
+
+        /* Creates the nodes in the array one index at a time */
+        for (uint32_t i = 0; i < elements; i++)
+        {
+            int64_t integer = i;
+            if (!sconf_node_create_and_insert(NULL, SCONF_TYPE_INT, array, i,
+                                              &integer, &err)) {
+                fprintf(stderr, "Error: %s\n", sconf_strerror(&err));
+                sconf_node_destroy(root);
+                return -1;
+            }
+        }
+
+        double elapsed = bench_now() - start;
+        if (run == 0 || elapsed < *seconds) {
+            *seconds = elapsed;
+        }
+
+        sconf_node_destroy(root);
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t max = argc > 1 ? (uint32_t)atol(argv[1]) : BENCH_MAX_ELEMENTS;
+
+    printf("Array build time, best of %d runs\n", BENCH_RUNS);
+
+    for (uint32_t elements = 1000; elements <= max; elements *= 4)
+    {
+        for (int arena = 0; arena <= 1; arena++)
+        {
+            double seconds = 0;
+            if (bench_run(elements, arena, &seconds) == -1) {
+                return EXIT_FAILURE;
+            }
+
+            char label[64];
+            snprintf(label, sizeof(label), "%s %u elements",
+                     arena ? "arena" : "heap", elements);
+            bench_report(label, seconds);
+            printf("%-40s %12.1f ns\n", "  per element",
+                   seconds * 1e9 / elements);
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,130 @@
+/* Compare memory use and lookup time of dictionaries of different sizes.
+   Dictionaries with up to 8 keys are stored as small sorted vectors, larger
+   ones in an ART. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#include <sconf.h>
+
+#include "bench.h"
+
+/* Number of dictionaries built for each size */
+#define BENCH_DICTS 20000
+
+/* Number of times all keys in all dictionaries are looked up per run */
+#define BENCH_ROUNDS 10
+
+static const int bench_sizes[] = { 1, 2, 4, 8, 9, 16, 32 };
+
+/* Return number of bytes allocated from the heap, or 0 if unknown */
+static size_t bench_heap_used(void)
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    return mallinfo2().uordblks;
+#else
+    return 0;
+#endif
+}
+
+static int bench_run(int dicts, int keys)
+{
+    struct SConfErr err = {0};
+
+    struct SConfNode **nodes = calloc(dicts, sizeof(struct SConfNode *));
+    char (*names)[16] = calloc(keys, sizeof(*names));
+    if (!nodes || !names) {
+        free(nodes);
+        free(names);
+        return -1;
+    }
+
+    for (int k = 0; k < keys; k++)
+    {
+        snprintf(names[k], sizeof(names[k]), "key-%d", k);
+    }
+
+    size_t before = bench_heap_used();
+
+    for (int d = 0; d < dicts; d++)
+    {
+        nodes[d] = sconf_node_create(SCONF_TYPE_DICT, NULL, &err);
+        for (int k = 0; nodes[d] && k < keys; k++)
+        {
+            if (sconf_set_int(nodes[d], names[k], k, &err) == -1) {
+                break;
+            }
+        }
+        if (!nodes[d] || err.msg[0]) {
+            fprintf(stderr, "Error: %s\n", sconf_strerror(&err));
+            return -1;
+        }
+    }
+
+    size_t after = bench_heap_used();
+
+    double best = 0;
+    int64_t sum = 0;
+
+    for (int run = 0; run < BENCH_RUNS; run++)
+    {
+        double start = bench_now();
+        for (int round = 0; round < BENCH_ROUNDS; round++)
+        {
+            for (int d = 0; d < dicts; d++)
+            {
+                for (int k = 0; k < keys; k++)
+                {
+                    struct SConfNode *node = NULL;
+                    sconf_node_dict_search(names[k], nodes[d], &node, &err);
+                    sum += sconf_int(node);
+                }
+            }
+        }
+        double elapsed = bench_now() - start;
+
+        if (run == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    char label[64];
+    snprintf(label, sizeof(label), "%d keys lookup", keys);
+    printf("%-40s %12.1f ns\n", label,
+           best * 1e9 / ((double)BENCH_ROUNDS * dicts * keys));
+    if (after > before) {
+        snprintf(label, sizeof(label), "%d keys memory per dict", keys);
+        printf("%-40s %12zu B\n", label, (after - before) / dicts);
+    }
+
+    for (int d = 0; d < dicts; d++)
+    {
+        sconf_node_destroy(nodes[d]);
+    }
+    free(nodes);
+    free(names);
+
+    /* Keep the compiler from removing the lookups */
+    return sum < 0 ? -1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    int dicts = argc > 1 ? atoi(argv[1]) : BENCH_DICTS;
+
+    printf("%d dictionaries per size, best of %d runs\n", dicts, BENCH_RUNS);
+
+    for (size_t i = 0; i < sizeof(bench_sizes) / sizeof(bench_sizes[0]); i++)
+    {
+        if (bench_run(dicts, bench_sizes[i]) == -1) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,146 @@
+/* Compare looking up a batch of paths with shared prefixes one at a time
+   with sconf_get and all at once with sconf_get_many */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sconf.h>
+
+#include "bench.h"
+
+/* Default number of batches per run */
+#define BENCH_BATCHES 5000
+
+/* Services in the tree, paths are looked up for the first few of them */
+#define BENCH_SERVICES 100
+#define BENCH_LOOKED_UP 30
+#define BENCH_KEYS 10
+#define BENCH_PATHS (BENCH_LOOKED_UP * BENCH_KEYS)
+
+static char *paths[BENCH_PATHS];
+static struct SConfGetResult results[BENCH_PATHS];
+
+static int bench_lookup(struct SConfNode *root, bool many, int batches,
+                        int64_t *sum)
+{
+    struct SConfErr err = {0};
+
+    for (int b = 0; b < batches; b++)
+    {
+        if (many) {
+            if (sconf_get_many(root, (const char *const *)paths, BENCH_PATHS,
+                               results, &err) == -1) {
+                fprintf(stderr, "Error: %s\n", sconf_strerror(&err));
+                return -1;
+            }
+            for (int i = 0; i < BENCH_PATHS; i++)
+            {
+                *sum += sconf_int(results[i].node);
+            }
+            continue;
+        }
+
+        for (int i = 0; i < BENCH_PATHS; i++)
+        {
+            struct SConfNode *node = NULL;
+            if (sconf_get(root, paths[i], &node, &err) != 1) {
+                fprintf(stderr, "Error: %s\n", sconf_strerror(&err));
+                return -1;
+            }
+            *sum += sconf_int(node);
+        }
+    }
+
+    return 0;
+}
+
+static int bench_run(const char *name, struct SConfNode *root, bool many,
+                     int batches)
+{
+    double best = 0;
+    int64_t sum = 0;
+
+    for (int run = 0; run < BENCH_RUNS; run++)
+    {
+        double start = bench_now();
+        if (bench_lookup(root, many, batches, &sum) == -1) {
+            return -1;
+        }
+        double elapsed = bench_now() - start;
+
+        if (run == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    bench_report(name, best);
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int batches = argc > 1 ? atoi(argv[1]) : BENCH_BATCHES;
+
+    struct SConfErr err = {0};
+    struct SConfNode *root = SCONF_ROOT(&err);
+    struct SConfNode *frozen = NULL;
+    int rc = EXIT_FAILURE;
+
+    if (!root) {
+        fprintf(stderr, "Error: %s\n", sconf_strerror(&err));
+        return EXIT_FAILURE;
+    }
+
+    for (int s = 0; s < BENCH_SERVICES; s++)
+    {
+        for (int k = 0; k < BENCH_KEYS; k++)
+        {
+            char path[64];
+            snprintf(path, sizeof(path), "services.svc-%d.db.primary.key-%d",
+                     s, k);
+
+            if (sconf_set_int(root, path, k, &err) == -1) {
+                fprintf(stderr, "Error: %s\n", sconf_strerror(&err));
+                goto out;
+            }
+
+            /* Paths are listed key by key, so the parents are mixed */
+            if (s < BENCH_LOOKED_UP) {
+                int i = k * BENCH_LOOKED_UP + s;
+                paths[i] = strdup(path);
+                if (!paths[i]) {
+                    fprintf(stderr, "Error: could not copy path\n");
+                    goto out;
+                }
+            }
+        }
+    }
+
+    frozen = sconf_freeze(root, &err);
+    if (!frozen) {
+        fprintf(stderr, "Error: %s\n", sconf_strerror(&err));
+        goto out;
+    }
+
+    printf("%d batches of %d paths, best of %d runs\n", batches, BENCH_PATHS,
+           BENCH_RUNS);
+
+    if (bench_run("sconf_get", root, false, batches) == 0 &&
+            bench_run("sconf_get_many", root, true, batches) == 0 &&
+            bench_run("frozen sconf_get", frozen, false, batches) == 0 &&
+            bench_run("frozen sconf_get_many", frozen, true, batches) == 0) {
+        rc = EXIT_SUCCESS;
+    }
+
+out:
+    for (int i = 0; i < BENCH_PATHS; i++)
+    {
+        free(paths[i]);
+    }
+    sconf_node_destroy(frozen);
+    sconf_node_destroy(root);
+
+    return rc;
+}
@@ -0,0 +1,142 @@
+/* Compare lookups using string paths, compiled paths, handles and frozen
+   snapshots with and without path index */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sconf.h>
+
+#include "bench.h"
+
+/* Default number of lookups per run */
+#define BENCH_LOOKUPS 2000000
+
+#define BENCH_PATH "section-42.key-1"
+
+static int bench_lookup(struct SConfNode *root, const struct SConfPath *path,
+                        struct SConfHandle *handle, int lookups, int64_t *sum)
+{
+    struct SConfErr err = {0};
+    const int64_t *integer = NULL;
+
+    for (int i = 0; i < lookups; i++)
+    {
+        int r;
+        if (handle) {
+            r = sconf_handle_int(handle, &integer, &err);
+        }
+        else if (path) {
+            r = sconf_get_int_p(root, path, &integer, &err);
+        }
+        else {
+            r = sconf_get_int(root, BENCH_PATH, &integer, &err);
+        }
+        if (r != 1) {
+            fprintf(stderr, "Error: %s\n", sconf_strerror(&err));
+            return -1;
+        }
+        *sum += *integer;
+    }
+
+    return 0;
+}
+
+static int bench_run(const char *name, struct SConfNode *root,
+                     const struct SConfPath *path, struct SConfHandle *handle,
+                     int lookups)
+{
+    double best = 0;
+    int64_t sum = 0;
+
+    for (int run = 0; run < BENCH_RUNS; run++)
+    {
+        double start = bench_now();
+        if (bench_lookup(root, path, handle, lookups, &sum) == -1) {
+            return -1;
+        }
+        double elapsed = bench_now() - start;
+
+        if (run == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    bench_report(name, best);
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int lookups = argc > 1 ? atoi(argv[1]) : BENCH_LOOKUPS;
+
+    char *filename = bench_yaml_file_create(100, 10);
+    if (!filename) {
+        fprintf(stderr, "Error: could not create YAML file\n");
+        return EXIT_FAILURE;
+    }
+
+    struct SConfErr err = {0};
+    struct SConfNode *root = SCONF_ROOT(&err);
+    struct SConfPath *path = NULL;
+    struct SConfHandle *handle = NULL;
+    struct SConfNode *frozen = NULL;
+    struct SConfNode *indexed = NULL;
+    int rc = EXIT_FAILURE;
+
+    if (!root || sconf_yaml_read(root, filename, &err) == -1) {
+        fprintf(stderr, "Error: %s\n", sconf_strerror(&err));
+        goto out;
+    }
+
+    path = sconf_path_compile(BENCH_PATH, &err);
+    if (!path) {
+        fprintf(stderr, "Error: %s\n", sconf_strerror(&err));
+        goto out;
+    }
+
+    handle = sconf_handle_create(root, BENCH_PATH, &err);
+    if (!handle) {
+        fprintf(stderr, "Error: %s\n", sconf_strerror(&err));
+        goto out;
+    }
+
+    frozen = sconf_freeze(root, &err);
+    if (!frozen) {
+        fprintf(stderr, "Error: %s\n", sconf_strerror(&err));
+        goto out;
+    }
+
+    indexed = sconf_freeze(root, &err);
+    if (!indexed || sconf_index_paths(indexed, &err) == -1) {
+        fprintf(stderr, "Error: %s\n", sconf_strerror(&err));
+        goto out;
+    }
+
+    printf("%d lookups of '%s', best of %d runs\n", lookups, BENCH_PATH,
+           BENCH_RUNS);
+
+    if (bench_run("string path", root, NULL, NULL, lookups) == 0 &&
+            bench_run("compiled path", root, path, NULL, lookups) == 0 &&
+            bench_run("handle", root, NULL, handle, lookups) == 0 &&
+            bench_run("frozen string path", frozen, NULL, NULL,
+                      lookups) == 0 &&
+            bench_run("frozen compiled path", frozen, path, NULL,
+                      lookups) == 0 &&
+            bench_run("indexed string path", indexed, NULL, NULL,
+                      lookups) == 0) {
+        rc = EXIT_SUCCESS;
+    }
+
+out:
+    sconf_handle_destroy(handle);
+    sconf_path_destroy(path);
+    sconf_node_destroy(indexed);
+    sconf_node_destroy(frozen);
+    sconf_node_destroy(root);
+    unlink(filename);
+    free(filename);
+
+    return rc;
+}
@@ -0,0 +1,128 @@
+/* Measure YAML parse throughput on large generated files */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include <sconf.h>
+
+#include "bench.h"
+
+/* Default number of services in the generated config, about 40 MB */
+#define BENCH_SERVICES 100000
+
+/* Write a YAML file with nested mappings, sequences of mappings and flow
+   sequences of numbers, and return the path (must be freed and unlinked by
+   the caller) */
+static char *bench_yaml_nested_file_create(int services)
+{
+    char *path = strdup("/tmp/sconf-bench-XXXXXX.yaml");
+    if (!path) {
+        return NULL;
+    }
+
+    int fd = mkstemps(path, 5);
+    if (fd == -1) {
+        free(path);
+        return NULL;
+    }
+
+    FILE *fp = fdopen(fd, "w");
+    if (!fp) {
+        close(fd);
+        unlink(path);
+        free(path);
+        return NULL;
+    }
+
+    fprintf(fp, "services:\n");
+    for (int s = 0; s < services; s++)
+    {
+        fprintf(fp, "  service-%d:\n", s);
+        fprintf(fp, "    name: \"service number %d\"\n", s);
+        fprintf(fp, "    enabled: %s\n", s % 3 ? "true" : "false");
+        fprintf(fp, "    timeout: %d.%d\n", s % 60, s % 10);
+        fprintf(fp, "    upstream:\n");
+        fprintf(fp, "      host: host-%d.example.com\n", s);
+        fprintf(fp, "      port: %d\n", 1024 + s % 60000);
+        fprintf(fp, "    listeners:\n");
+        for (int l = 0; l < 2; l++)
+        {
+            fprintf(fp, "      - address: 10.0.%d.%d\n", s % 256, l);
+            fprintf(fp, "        port: %d\n", 8000 + l);
+        }
+        fprintf(fp, "    weights: [%d, %d, %d, %d]\n", s, s + 1, s + 2,
+                s + 3);
+    }
+
+    fclose(fp);
+
+    return path;
+}
+
+static int bench_run(const char *filename, int flags, double *seconds)
+{
+    for (int run = 0; run < BENCH_RUNS; run++)
+    {
+        struct SConfErr err = {0};
+
+        struct SConfNode *root = SCONF_ROOT(&err);
+        if (!root) {
+            fprintf(stderr, "Error: %s\n", sconf_strerror(&err));
+            return -1;
+        }
+
+        double start = bench_now();
+        int r = sconf_yaml_read_flags(root, filename, flags, &err);
+        double elapsed = bench_now() - start;
+
+        sconf_node_destroy(root);
+
+        if (r == -1) {
+            fprintf(stderr, "Error: %s\n", sconf_strerror(&err));
+            return -1;
+        }
+
+        if (run == 0 || elapsed < *seconds) {
+            *seconds = elapsed;
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int services = argc > 1 ? atoi(argv[1]) : BENCH_SERVICES;
+
+    char *filename = bench_yaml_nested_file_create(services);
+    if (!filename) {
+        fprintf(stderr, "Error: could not create YAML file\n");
+        return EXIT_FAILURE;
+    }
+
+    int rc = EXIT_SUCCESS;
+
+    struct stat st;
+    double libyaml = 0;
+    double native = 0;
+    if (stat(filename, &st) == -1 ||
+            bench_run(filename, SCONF_YAML_LIBYAML, &libyaml) == -1 ||
+            bench_run(filename, SCONF_YAML_NATIVE | SCONF_YAML_NO_FALLBACK,
+                      &native) == -1) {
+        rc = EXIT_FAILURE;
+    }
+    else {
+        double mb = (double)st.st_size / (1024 * 1024);
+        printf("%.1f MB, best of %d runs\n", mb, BENCH_RUNS);
+        bench_report("sconf_yaml_read (libyaml)", libyaml);
+        printf("%-40s %12.1f MB/s\n", "throughput", mb / libyaml);
+        bench_report("sconf_yaml_read (native)", native);
+        printf("%-40s %12.1f MB/s\n", "throughput", mb / native);
+    }
+
+    unlink(filename);
+    free(filename);
+
+    return rc;
+}
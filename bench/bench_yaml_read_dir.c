@@ -0,0 +1,166 @@
+/* Measure reading a conf.d directory of YAML fragments, one by one and in
+   parallel */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <sconf.h>
+
+#include "bench.h"
+
+/* Default number of fragments, and of sections in each fragment */
+#define BENCH_FRAGMENTS 200
+#define BENCH_SECTIONS 200
+
+/* Keys in each section */
+#define BENCH_KEYS 8
+
+/* Path of fragment i in dir, fragments are named so they sort by number */
+static void bench_fragment_path(char *path, size_t size, const char *dir,
+                                int i)
+{
+    snprintf(path, size, "%s/%04d-fragment.yaml", dir, i);
+}
+
+/* Write fragments to a new directory, each overriding some of the sections
+   of the fragment before it, and return the path of the directory (must be
+   freed and removed by the caller) */
+static char *bench_dir_create(int fragments, int sections)
+{
+    char *dir = strdup("/tmp/sconf-bench-XXXXXX");
+    if (!dir || !mkdtemp(dir)) {
+        free(dir);
+        return NULL;
+    }
+
+    for (int f = 0; f < fragments; f++)
+    {
+        char path[256];
+        bench_fragment_path(path, sizeof(path), dir, f);
+
+        FILE *fp = fopen(path, "w");
+        if (!fp) {
+            return dir;
+        }
+
+        for (int s = 0; s < sections; s++)
+        {
+            fprintf(fp, "section-%d:\n", (f * sections / 2 + s) % 10000);
+            for (int k = 0; k < BENCH_KEYS; k++)
+            {
+                switch (k % 4)
+                {
+                    case 0:
+                        fprintf(fp, "  key-%d: value-%d-%d\n", k, f, s);
+                        break;
+                    case 1:
+                        fprintf(fp, "  key-%d: %d\n", k, f * sections + s);
+                        break;
+                    case 2:
+                        fprintf(fp, "  key-%d: %d.%d\n", k, f, s);
+                        break;
+                    default:
+                        fprintf(fp, "  key-%d: [%d, %d]\n", k, f, s);
+                        break;
+                }
+            }
+        }
+
+        fclose(fp);
+    }
+
+    return dir;
+}
+
+static void bench_dir_remove(char *dir, int fragments)
+{
+    for (int f = 0; f < fragments; f++)
+    {
+        char path[256];
+        bench_fragment_path(path, sizeof(path), dir, f);
+        unlink(path);
+    }
+
+    rmdir(dir);
+    free(dir);
+}
+
+/* Read the fragments with sconf_yaml_read_dir if nthreads >= 0, otherwise
+   with sconf_yaml_read on each file in turn */
+static int bench_run(const char *dir, int fragments, int nthreads,
+                     double *seconds)
+{
+    for (int run = 0; run < BENCH_RUNS; run++)
+    {
+        struct SConfErr err = {0};
+
+        struct SConfNode *root = SCONF_ROOT(&err);
+        if (!root) {
+            fprintf(stderr, "Error: %s\n", sconf_strerror(&err));
+            return -1;
+        }
+
+        int r = 0;
+        double start = bench_now();
+        if (nthreads >= 0) {
+            r = sconf_yaml_read_dir(root, dir, "*.yaml", nthreads, &err);
+        }
+        else {
+            for (int f = 0; f < fragments && r == 0; f++)
+            {
+                char path[256];
+                bench_fragment_path(path, sizeof(path), dir, f);
+                r = sconf_yaml_read(root, path, &err);
+            }
+        }
+        double elapsed = bench_now() - start;
+
+        sconf_node_destroy(root);
+
+        if (r == -1) {
+            fprintf(stderr, "Error: %s\n", sconf_strerror(&err));
+            return -1;
+        }
+
+        if (run == 0 || elapsed < *seconds) {
+            *seconds = elapsed;
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int fragments = argc > 1 ? atoi(argv[1]) : BENCH_FRAGMENTS;
+    int sections = argc > 2 ? atoi(argv[2]) : BENCH_SECTIONS;
+
+    char *dir = bench_dir_create(fragments, sections);
+    if (!dir) {
+        fprintf(stderr, "Error: could not create YAML fragments\n");
+        return EXIT_FAILURE;
+    }
+
+    int rc = EXIT_SUCCESS;
+
+    double serial = 0;
+    double one = 0;
+    double parallel = 0;
+    if (bench_run(dir, fragments, -1, &serial) == -1 ||
+            bench_run(dir, fragments, 1, &one) == -1 ||
+            bench_run(dir, fragments, 0, &parallel) == -1) {
+        rc = EXIT_FAILURE;
+    }
+    else {
+        printf("%d fragments, %ld CPUs, best of %d runs\n", fragments,
+               sysconf(_SC_NPROCESSORS_ONLN), BENCH_RUNS);
+        bench_report("sconf_yaml_read (each file)", serial);
+        bench_report("sconf_yaml_read_dir (1 thread)", one);
+        bench_report("sconf_yaml_read_dir (1 thread per CPU)", parallel);
+    }
+
+    bench_dir_remove(dir, fragments);
+
+    return rc;
+}
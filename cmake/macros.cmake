@@ -5,3 +5,4 @@ include("${simpleconfig_SOURCE_DIR}/cmake/enable_ubsan.cmake")
 include("${simpleconfig_SOURCE_DIR}/cmake/enable_coverage.cmake")
 include("${simpleconfig_SOURCE_DIR}/cmake/enable_check_clang_tidy.cmake")
 include("${simpleconfig_SOURCE_DIR}/cmake/enable_check_cppcheck.cmake")
+include("${simpleconfig_SOURCE_DIR}/cmake/sconf_generate.cmake")
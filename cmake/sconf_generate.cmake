@@ -0,0 +1,29 @@
+#
+# Generate a config struct, typed accessors, a config map and a loader from a
+# YAML schema and add them to a target. The generated header is named after
+# the schema (e.g "app_config.yaml" generates "app_config.h").
+#
+# Usage: sconf_generate(<target> <schema.yaml>)
+function(sconf_generate target schema)
+    if (NOT TARGET sconf-gen)
+        message(FATAL_ERROR "sconf_generate needs SCONF_BUILD_GENERATOR")
+    endif()
+
+    get_filename_component(schema_path ${schema} ABSOLUTE)
+    get_filename_component(name ${schema} NAME_WE)
+
+    set(out_dir ${CMAKE_CURRENT_BINARY_DIR}/sconf_generated)
+    set(header ${out_dir}/${name}.h)
+    set(source ${out_dir}/${name}.c)
+
+    add_custom_command(
+        OUTPUT ${header} ${source}
+        COMMAND ${CMAKE_COMMAND} -E make_directory ${out_dir}
+        COMMAND sconf-gen ${schema_path} ${header} ${source}
+        DEPENDS sconf-gen ${schema_path}
+        COMMENT "Generating config code from ${schema}"
+    )
+
+    target_sources(${target} PRIVATE ${header} ${source})
+    target_include_directories(${target} PRIVATE ${out_dir})
+endfunction(sconf_generate)
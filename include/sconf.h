@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <unistd.h>
 
@@ -40,6 +41,24 @@ enum {
  */
 struct SConfNode;
 
+/**
+ * Opaque pointer type to represent a compiled path (see sconf_path_compile).
+ */
+struct SConfPath;
+
+/**
+ * Opaque pointer type to represent a cached node handle (see
+ * sconf_handle_create).
+ */
+struct SConfHandle;
+
+/**
+ * Opaque pointer types to represent a registry of published config trees,
+ * and a reader of the registry (see sconf_registry_create).
+ */
+struct SConfRegistry;
+struct SConfReader;
+
 /**
  * Node access helper functions.
  *
@@ -75,6 +94,7 @@ struct SConfNode;
  *   }
  */
 const char *sconf_str(const struct SConfNode *node);
+size_t sconf_str_len(const struct SConfNode *node);
 int64_t sconf_int(const struct SConfNode *node);
 double sconf_float(const struct SConfNode *node);
 bool sconf_bool(const struct SConfNode *node);
@@ -82,6 +102,27 @@ bool sconf_true(const struct SConfNode *node);
 bool sconf_false(const struct SConfNode *node);
 uint8_t sconf_type(const struct SConfNode *node);
 
+/**
+ * Node access helper functions using atomic loads.
+ *
+ * Use these to read values that other threads update with the
+ * sconf_set_*_atomic functions. A reader sees either the old or the new
+ * value, never a mix of both.
+ */
+int64_t sconf_int_atomic(const struct SConfNode *node);
+double sconf_float_atomic(const struct SConfNode *node);
+bool sconf_bool_atomic(const struct SConfNode *node);
+
+/**
+ * Compare the strings of two string nodes.
+ *
+ * In arena-backed trees (see sconf_node_create_arena), strings too long to
+ * be stored in the node are interned: equal strings share one copy, so
+ * comparing two of them is a pointer comparison. Frozen snapshots store
+ * each distinct key and long string once as well.
+ */
+bool sconf_str_equal(const struct SConfNode *a, const struct SConfNode *b);
+
 /**
  * Structure representing a config map.
  */
@@ -124,6 +165,74 @@ struct SConfMap {
                          struct SConfErr *);
 };
 
+/**
+ * Structure binding a config node to a field in a C struct (see sconf_bind).
+ */
+struct SConfBinding {
+    /* Path to node, relative to the enclosing binding (e.g "db.port") */
+    char *path;
+
+    /* Node type (SCONF_TYPE_STR, _INT, _BOOL or _FLOAT), SCONF_TYPE_DICT
+       for a nested struct or SCONF_TYPE_ARRAY for an array of scalars */
+    uint8_t type;
+
+    /* Offset and size of the field, usually set with SCONF_FIELD */
+    size_t offset;
+    size_t size;
+
+    /* Specify if the integer field (or the integer elements of an array) is
+       unsigned, usually set with SCONF_FIELD_UNSIGNED. Integers must fit in
+       the range of the C type. */
+    bool is_unsigned;
+
+    /* Default value to use if the node is missing (scalars only) */
+    char *default_value;
+
+    /* Specify if the node is required */
+    bool required;
+
+    /* Allowed range of integers and floats, checked if range is set */
+    bool range;
+    int64_t min;
+    int64_t max;
+    double min_float;
+    double max_float;
+
+    /* Bindings of the fields of a nested struct (SCONF_TYPE_DICT), with
+       offsets relative to the nested struct */
+    const struct SConfBinding *fields;
+
+    /* Type and size of the elements of an array (SCONF_TYPE_ARRAY), the
+       number of elements is size / element_size */
+    uint8_t element_type;
+    size_t element_size;
+
+    /* Store the number of elements in a size_t at count_offset, usually set
+       with SCONF_COUNT. Otherwise the array must have exactly as many
+       elements as the field. */
+    bool counted;
+    size_t count_offset;
+};
+
+/**
+ * Set offset and size of a binding to those of a field in a struct.
+ */
+#define SCONF_FIELD(type, field) \
+    .offset = offsetof(type, field), .size = sizeof(((type *)0)->field)
+
+/**
+ * Set offset and size of a binding to those of an unsigned integer field (or
+ * an array of unsigned integers) in a struct.
+ */
+#define SCONF_FIELD_UNSIGNED(type, field) \
+    SCONF_FIELD(type, field), .is_unsigned = true
+
+/**
+ * Set count of an array binding to a size_t field in a struct.
+ */
+#define SCONF_COUNT(type, field) \
+    .counted = true, .count_offset = offsetof(type, field)
+
 /**
  * Create a new config node.
  *
@@ -159,6 +268,246 @@ void sconf_node_destroy(struct SConfNode *node);
  */
 #define SCONF_ROOT(err) sconf_node_create(SCONF_TYPE_DICT, NULL, err)
 
+/**
+ * Create a new config node owning an arena.
+ *
+ * All nodes, dictionary keys, strings and arrays added below the node are
+ * allocated from the arena. Destroying the node releases everything at
+ * once, without traversing the tree. Destroying any other node in the
+ * tree does nothing, the memory is kept until the owner is destroyed.
+ *
+ * Nodes created with sconf_node_create can not be inserted into an
+ * arena-backed tree (and vice versa).
+ *
+ * Example:
+ *   struct SConfNode *root = sconf_node_create_arena(SCONF_TYPE_DICT, NULL,
+ *                                                    &err);
+ *   if (!root) {
+ *       printf("Error: %s\n", sconf_strerror(&err));
+ *       return EXIT_FAILURE;
+ *   }
+ */
+struct SConfNode *sconf_node_create_arena(int type, void *data,
+                                          struct SConfErr *err);
+
+/**
+ * Macro for creating arena-backed root config node.
+ *
+ * Example:
+ *   struct SConfNode *root = SCONF_ROOT_ARENA(&err);
+ *   if (!root) {
+ *       printf("Error: %s\n", sconf_strerror(&err));
+ *       return EXIT_FAILURE;
+ *   }
+ */
+#define SCONF_ROOT_ARENA(err) sconf_node_create_arena(SCONF_TYPE_DICT, NULL, \
+                                                      err)
+
+/**
+ * Create an immutable snapshot of a config tree.
+ *
+ * The snapshot is a copy of the tree stored in a single allocation, with
+ * the keys of each dictionary sorted for binary search. It is meant for
+ * config that is read-only after being initialized, and is faster to look up
+ * than the original tree. All get functions, iterators and handles work on
+ * the snapshot, while set and insert functions fail. Since it is never
+ * modified, a snapshot can be read from multiple threads without locking.
+ *
+ * The original tree is not changed, and can be destroyed after freezing.
+ * Destroy the snapshot with sconf_node_destroy.
+ *
+ * Example:
+ *   struct SConfNode *frozen = sconf_freeze(root, &err);
+ *   if (!frozen) {
+ *       printf("Error: %s\n", sconf_strerror(&err));
+ *       return EXIT_FAILURE;
+ *   }
+ *   sconf_node_destroy(root);
+ */
+struct SConfNode *sconf_freeze(struct SConfNode *root, struct SConfErr *err);
+
+/**
+ * Create a copy-on-write overlay on a config tree.
+ *
+ * The overlay starts out empty and nothing is copied from the base, so
+ * creating and destroying it costs about the number of values set in it.
+ * Set functions store values in the overlay, leaving the base untouched,
+ * and get functions (including handles and sconf_get_many) look in the
+ * overlay first and then in the base. A value set in the overlay must have
+ * the same type as the value it hides in the base.
+ *
+ * Iterators and dict/array search functions only see the values set in the
+ * overlay, and a dictionary returned by a get function is either the one in
+ * the overlay or the one in the base. Look up values by their full path.
+ * Atomic set functions only update values set in the overlay, and an
+ * overlay can not be frozen.
+ *
+ * The base must outlive the overlay, and is typically a frozen snapshot
+ * shared by many overlays. Destroy the overlay with sconf_node_destroy.
+ *
+ * Example:
+ *   struct SConfNode *overlay = sconf_overlay_create(base, &err);
+ *   if (!overlay) {
+ *       printf("Error: %s\n", sconf_strerror(&err));
+ *       return EXIT_FAILURE;
+ *   }
+ *
+ *   // Override for this request only, base is not changed
+ *   sconf_set_int(overlay, "upstream.timeout", 5, &err);
+ *
+ *   const int64_t *timeout;
+ *   sconf_get_int(overlay, "upstream.timeout", &timeout, &err);
+ *   sconf_node_destroy(overlay);
+ */
+struct SConfNode *sconf_overlay_create(struct SConfNode *base,
+                                       struct SConfErr *err);
+
+/* Policies for nodes that exist in both trees when merging */
+enum {
+    /* Value from src replaces the one in dst, also if types differ */
+    SCONF_MERGE_OVERWRITE = 0,
+    /* Value in dst is kept */
+    SCONF_MERGE_KEEP,
+    /* Value from src replaces the one in dst, fail if types differ */
+    SCONF_MERGE_ERROR,
+};
+
+/**
+ * Merge config tree into another, e.g a conf.d fragment or an override file
+ * read with sconf_yaml_read into a tree of its own.
+ *
+ * Nodes are moved from src to dst instead of being copied. src is left empty
+ * on success and when the merge fails part way, but it is not changed when
+ * an argument is invalid, when the SCONF_MERGE_ERROR type check fails or
+ * when memory for the merge can not be allocated. In all cases src must
+ * still be destroyed by the caller.
+ * Dictionaries in both trees are merged by walking their keys in order,
+ * and arrays are merged index by index, growing each array once.
+ * Dictionaries and arrays present in both trees are always merged, policy
+ * decides what happens to other nodes present in both trees.
+ *
+ * With SCONF_MERGE_ERROR the types are checked before anything is moved, so
+ * dst is not changed if they differ. Both trees must be allocated on the
+ * heap, or from the same arena, and dst can not be frozen or an overlay.
+ *
+ * Example:
+ *   struct SConfNode *fragment = SCONF_ROOT(&err);
+ *   if (!fragment ||
+ *           sconf_yaml_read(fragment, "conf.d/10-db.yaml", &err) == -1 ||
+ *           sconf_merge(root, fragment, SCONF_MERGE_ERROR, &err) == -1) {
+ *       printf("Error: %s\n", sconf_strerror(&err));
+ *   }
+ *   sconf_node_destroy(fragment);
+ */
+int sconf_merge(struct SConfNode *dst, struct SConfNode *src, int policy,
+                struct SConfErr *err);
+
+/**
+ * Build path index for a frozen snapshot.
+ *
+ * Indexes the full path of every node in the snapshot (e.g
+ * "servers.[2].host") using a minimal perfect hash, so get functions find
+ * the node with one hash lookup instead of walking the tree. Paths not
+ * found in the index (missing, or not written in canonical form like
+ * "a..b") are looked up by walking the tree as usual.
+ *
+ * Must be called before the snapshot is shared between threads.
+ *
+ * Example:
+ *   struct SConfNode *frozen = sconf_freeze(root, &err);
+ *   if (!frozen || sconf_index_paths(frozen, &err) == -1) {
+ *       printf("Error: %s\n", sconf_strerror(&err));
+ *       return EXIT_FAILURE;
+ *   }
+ */
+int sconf_index_paths(struct SConfNode *root, struct SConfErr *err);
+
+/**
+ * Create registry holding the current config tree, for reloading config
+ * while other threads are reading it.
+ *
+ * Readers never block or take a lock. A writer builds a new tree (using
+ * sconf_yaml_read, sconf_initialize, ...) and publishes it, replacing the
+ * current tree with an atomic swap. Replaced trees are freed when all
+ * readers that may be using them are done.
+ *
+ * The registry owns the trees published to it, and destroys them.
+ *
+ * Example:
+ *   struct SConfRegistry *registry = sconf_registry_create(root, &err);
+ *
+ *   [...]
+ *
+ *   // In each reader thread
+ *   struct SConfReader *reader = sconf_registry_reader_create(registry, &err);
+ *   while (running)
+ *   {
+ *       struct SConfNode *root = sconf_registry_read_begin(reader);
+ *       r = sconf_get_int(root, "limits.rate", &rate, &err);
+ *       [...]
+ *       sconf_registry_read_end(reader);
+ *   }
+ *   sconf_registry_reader_destroy(reader);
+ *
+ *   [...]
+ *
+ *   // On SIGHUP
+ *   struct SConfNode *new_root = SCONF_ROOT(&err);
+ *   if (sconf_yaml_read(new_root, "config.yaml", &err) == -1 ||
+ *           sconf_registry_publish(registry, new_root, &err) == -1) {
+ *       sconf_node_destroy(new_root);
+ *   }
+ */
+struct SConfRegistry *sconf_registry_create(struct SConfNode *root,
+                                            struct SConfErr *err);
+
+/**
+ * Destroy registry and all config trees in it.
+ *
+ * No thread can be reading from the registry.
+ */
+void sconf_registry_destroy(struct SConfRegistry *registry);
+
+/**
+ * Publish new config tree, replacing the current one.
+ *
+ * Replaced trees are freed by this function or by a later call to
+ * sconf_registry_publish or sconf_registry_synchronize, once no reader can
+ * be using them.
+ */
+int sconf_registry_publish(struct SConfRegistry *registry,
+                           struct SConfNode *root, struct SConfErr *err);
+
+/**
+ * Wait for readers of replaced config trees to finish, and free the trees.
+ */
+void sconf_registry_synchronize(struct SConfRegistry *registry);
+
+/**
+ * Create reader, used by one thread at a time to read from the registry.
+ */
+struct SConfReader *sconf_registry_reader_create(
+        struct SConfRegistry *registry, struct SConfErr *err);
+
+/**
+ * Release reader. Released readers are reused, and freed when the registry
+ * is destroyed.
+ */
+void sconf_registry_reader_destroy(struct SConfReader *reader);
+
+/**
+ * Start reading, and get the current config tree.
+ *
+ * The tree, and all nodes in it, can be used until sconf_registry_read_end
+ * is called. Read-side sections can not be nested.
+ */
+struct SConfNode *sconf_registry_read_begin(struct SConfReader *reader);
+
+/**
+ * Stop reading.
+ */
+void sconf_registry_read_end(struct SConfReader *reader);
+
 /**
  * Get config node at path.
  *
@@ -179,6 +528,51 @@ void sconf_node_destroy(struct SConfNode *node);
 int sconf_get(struct SConfNode *root, const char *path, struct SConfNode **node,
               struct SConfErr *err);
 
+/**
+ * Get config node at path of given length.
+ *
+ * Same as sconf_get, but the path does not need to be null terminated, e.g
+ * a path in a network buffer. The path is split in place, nothing is copied.
+ *
+ * Example:
+ *   struct SConfNode *node;
+ *   int r = sconf_get_n(root, buf + off, path_len, &node, &err);
+ */
+int sconf_get_n(struct SConfNode *root, const char *path, size_t len,
+                struct SConfNode **node, struct SConfErr *err);
+
+/**
+ * Result of one path in sconf_get_many.
+ */
+struct SConfGetResult {
+    /* The config node, NULL if not found */
+    struct SConfNode *node;
+    bool found;
+};
+
+/**
+ * Get config nodes at many paths in one call.
+ *
+ * Same as calling sconf_get for each path, but paths with the same parent
+ * (e.g "db.primary.host" and "db.primary.port") only look up the parent
+ * once, in any order. Returns -1 if any path is invalid, otherwise
+ * results[i] tells if paths[i] was found.
+ *
+ * Example:
+ *   const char *paths[] = {"db.primary.host", "db.primary.port"};
+ *   struct SConfGetResult results[2];
+ *   int r = sconf_get_many(root, paths, 2, results, &err);
+ *   if (r == -1) {
+ *       printf("Error: %s\n", sconf_strerror(&err));
+ *       return EXIT_FAILURE;
+ *   }
+ *   else if (results[1].found) {
+ *       printf("port: %" PRId64 "\n", sconf_int(results[1].node));
+ *   }
+ */
+int sconf_get_many(struct SConfNode *root, const char *const *paths, size_t n,
+                   struct SConfGetResult *results, struct SConfErr *err);
+
 /**
  * Get string from config node at path.
  *
@@ -196,6 +590,27 @@ int sconf_get(struct SConfNode *root, const char *path, struct SConfNode **node,
 int sconf_get_str(struct SConfNode *root, const char *path, const char **str,
                   struct SConfErr *err);
 
+/**
+ * Get string and its length from config node at path.
+ *
+ * Same as sconf_get_str, but also returns the length of the string, which
+ * is stored in the node.
+ *
+ * Example:
+ *   const char *string;
+ *   size_t len;
+ *   int r = sconf_get_str_n(root, "a.b.c", &string, &len, &err);
+ *   if (r == -1) {
+ *       printf("Error: %s\n", sconf_strerror(&err));
+ *       return EXIT_FAILURE;
+ *   }
+ *   else if (r == 1) {
+ *       fwrite(string, 1, len, stdout);
+ *   }
+ */
+int sconf_get_str_n(struct SConfNode *root, const char *path,
+                    const char **str, size_t *len, struct SConfErr *err);
+
 /**
  * Get integer from config node at path.
  *
@@ -249,6 +664,52 @@ int sconf_get_bool(struct SConfNode *root, const char *path,
 int sconf_get_float(struct SConfNode *root, const char *path, const double **fp,
 		    struct SConfErr *err);
 
+/**
+ * Get integers from packed array at path, without copying them.
+ *
+ * Sequences of only integers, only floating-point numbers or only booleans
+ * read from YAML files are stored packed in one contiguous buffer. The
+ * elements can still be accessed as nodes (e.g "ports.[3]"), but adding an
+ * element of another type turns the array into a regular array of nodes.
+ *
+ * An empty array is returned as NULL with length 0. It is an error if the
+ * array has elements, but is not packed with integers.
+ *
+ * Example:
+ *   const int64_t *ports;
+ *   size_t len;
+ *   int r = sconf_get_int_array(root, "ports", &ports, &len, &err);
+ *   if (r == -1) {
+ *       printf("Error: %s\n", sconf_strerror(&err));
+ *       return EXIT_FAILURE;
+ *   }
+ *   else if (r == 1) {
+ *       for (size_t i = 0; i < len; i++) {
+ *           printf("port: %" PRId64 "\n", ports[i]);
+ *       }
+ *   }
+ */
+int sconf_get_int_array(struct SConfNode *root, const char *path,
+                        const int64_t **integers, size_t *len,
+                        struct SConfErr *err);
+
+/**
+ * Get floating-point numbers from packed array at path, without copying
+ * them. See sconf_get_int_array.
+ */
+int sconf_get_float_array(struct SConfNode *root, const char *path,
+                          const double **fps, size_t *len,
+                          struct SConfErr *err);
+
+/**
+ * Get booleans from packed array at path, without copying them. The
+ * booleans are stored as a bitset, element i is (bits[i / 64] >> (i % 64)) & 1.
+ * See sconf_get_int_array.
+ */
+int sconf_get_bool_array(struct SConfNode *root, const char *path,
+                         const uint64_t **bits, size_t *len,
+                         struct SConfErr *err);
+
 /**
  * Set config node of type to value at path.
  *
@@ -266,6 +727,14 @@ int sconf_get_float(struct SConfNode *root, const char *path, const double **fp,
 int sconf_set(struct SConfNode *root, const char *path, uint8_t type,
               void *value, struct SConfErr *err);
 
+/**
+ * Set config node of type to value at path of given length.
+ *
+ * Same as sconf_set, but the path does not need to be null terminated.
+ */
+int sconf_set_n(struct SConfNode *root, const char *path, size_t len,
+                uint8_t type, void *value, struct SConfErr *err);
+
 /**
  * Set string in config node at path.
  *
@@ -280,6 +749,23 @@ int sconf_set(struct SConfNode *root, const char *path, uint8_t type,
 int sconf_set_str(struct SConfNode *root, const char *path, const char *str,
                   struct SConfErr *err);
 
+/**
+ * Set string in config node at path, with path and string of given length.
+ *
+ * Neither the path nor the string need to be null terminated. The stored
+ * string is null terminated, and its length can be read back with
+ * sconf_get_str_n or sconf_str_len.
+ *
+ * Example:
+ *   int r = sconf_set_str_n(root, "bar", 3, buf + off, value_len, &err);
+ *   if (r == -1) {
+ *       printf("Error: %s\n", sconf_strerror(&err));
+ *       return EXIT_FAILURE;
+ *   }
+ */
+int sconf_set_str_n(struct SConfNode *root, const char *path, size_t path_len,
+                    const char *str, size_t str_len, struct SConfErr *err);
+
 /**
  * Set integer in config node at path.
  *
@@ -322,6 +808,170 @@ int sconf_set_bool(struct SConfNode *root, const char *path, bool boolean,
 int sconf_set_float(struct SConfNode *root, const char *path, double fp,
 		    struct SConfErr *err);
 
+/**
+ * Update existing integer, boolean or floating-point number in place, using
+ * an atomic store.
+ *
+ * Meant for tunable values changed at runtime (rate limits, sampling
+ * ratios, ...) while other threads are reading them. Readers must use
+ * sconf_int_atomic, sconf_bool_atomic or sconf_float_atomic on the node.
+ * The node must already exist and be of the right type, since the tree
+ * itself is not changed.
+ *
+ * Example:
+ *   struct SConfNode *rate;
+ *   int r = sconf_get(root, "limits.rate", &rate, &err);
+ *
+ *   [...]
+ *
+ *   // In one thread
+ *   r = sconf_set_int_atomic(root, "limits.rate", 1000, &err);
+ *
+ *   // In other threads
+ *   int64_t limit = sconf_int_atomic(rate);
+ */
+int sconf_set_int_atomic(struct SConfNode *root, const char *path,
+                         int64_t integer, struct SConfErr *err);
+int sconf_set_bool_atomic(struct SConfNode *root, const char *path,
+                          bool boolean, struct SConfErr *err);
+int sconf_set_float_atomic(struct SConfNode *root, const char *path,
+                           double fp, struct SConfErr *err);
+
+/**
+ * Compile path for repeated lookups.
+ *
+ * The string based sconf_get_* and sconf_set_* functions split the path on
+ * every call. For paths used on hot code paths, compile the path once and
+ * use the *_p variants below instead. A compiled path is not bound to a
+ * config tree, and can be used with any root. Compiled paths are read-only
+ * and can be shared between threads.
+ *
+ * Example:
+ *   struct SConfPath *port = sconf_path_compile("servers.[0].port", &err);
+ *   if (!port) {
+ *       printf("Error: %s\n", sconf_strerror(&err));
+ *       return EXIT_FAILURE;
+ *   }
+ *
+ *   const int64_t *integer;
+ *   int r = sconf_get_int_p(root, port, &integer, &err);
+ *
+ *   [...]
+ *
+ *   sconf_path_destroy(port);
+ */
+struct SConfPath *sconf_path_compile(const char *path, struct SConfErr *err);
+
+/**
+ * Compile path of given length, which does not need to be null terminated.
+ */
+struct SConfPath *sconf_path_compile_n(const char *path, size_t len,
+                                       struct SConfErr *err);
+
+/**
+ * Destroy compiled path.
+ */
+void sconf_path_destroy(struct SConfPath *path);
+
+/**
+ * Get config node, string, integer, boolean or floating-point number at
+ * compiled path.
+ *
+ * Same as sconf_get and the type specific sconf_get_* functions, but using a
+ * path compiled with sconf_path_compile.
+ */
+int sconf_get_p(struct SConfNode *root, const struct SConfPath *path,
+                struct SConfNode **node, struct SConfErr *err);
+int sconf_get_str_p(struct SConfNode *root, const struct SConfPath *path,
+                    const char **str, struct SConfErr *err);
+int sconf_get_int_p(struct SConfNode *root, const struct SConfPath *path,
+                    const int64_t **integer, struct SConfErr *err);
+int sconf_get_bool_p(struct SConfNode *root, const struct SConfPath *path,
+                     const bool **boolean, struct SConfErr *err);
+int sconf_get_float_p(struct SConfNode *root, const struct SConfPath *path,
+                      const double **fp, struct SConfErr *err);
+
+/**
+ * Set config node of type, string, integer, boolean or floating-point number
+ * at compiled path.
+ *
+ * Same as sconf_set and the type specific sconf_set_* functions, but using a
+ * path compiled with sconf_path_compile.
+ */
+int sconf_set_p(struct SConfNode *root, const struct SConfPath *path,
+                uint8_t type, void *value, struct SConfErr *err);
+int sconf_set_str_p(struct SConfNode *root, const struct SConfPath *path,
+                    const char *str, struct SConfErr *err);
+int sconf_set_int_p(struct SConfNode *root, const struct SConfPath *path,
+                    int64_t integer, struct SConfErr *err);
+int sconf_set_bool_p(struct SConfNode *root, const struct SConfPath *path,
+                     bool boolean, struct SConfErr *err);
+int sconf_set_float_p(struct SConfNode *root, const struct SConfPath *path,
+                      double fp, struct SConfErr *err);
+
+/**
+ * Create handle caching the config node at path.
+ *
+ * A handle remembers the node a path resolved to, so repeated reads skip
+ * the path walk. Any change to a config tree (set, insert, destroy, reading
+ * YAML, ...) marks the handles on it as stale, and they resolve the path
+ * again on the next access. Each arena-backed tree is tracked on its own,
+ * while trees allocated from the heap are tracked together, so a change to
+ * one of them marks handles on all of them as stale. Handles on an overlay
+ * also see changes to its base. A handle can be used for a path that does
+ * not exist (yet).
+ *
+ * Handles are not thread safe, use one handle per thread. The root must
+ * outlive the handle.
+ *
+ * Example:
+ *   struct SConfHandle *port = sconf_handle_create(root, "server.port", &err);
+ *   if (!port) {
+ *       printf("Error: %s\n", sconf_strerror(&err));
+ *       return EXIT_FAILURE;
+ *   }
+ *
+ *   const int64_t *integer;
+ *   int r = sconf_handle_int(port, &integer, &err);
+ *   if (r == -1) {
+ *       printf("Error: %s\n", sconf_strerror(&err));
+ *       return EXIT_FAILURE;
+ *   }
+ *   else if (r == 1) {
+ *       printf("%" PRId64 "\n", *integer);
+ *   }
+ *
+ *   [...]
+ *
+ *   sconf_handle_destroy(port);
+ */
+struct SConfHandle *sconf_handle_create(struct SConfNode *root,
+                                        const char *path,
+                                        struct SConfErr *err);
+
+/**
+ * Destroy handle.
+ */
+void sconf_handle_destroy(struct SConfHandle *handle);
+
+/**
+ * Get config node, string, integer, boolean or floating-point number from
+ * handle.
+ *
+ * Same return values as sconf_get and the type specific sconf_get_*
+ * functions.
+ */
+int sconf_handle_get(struct SConfHandle *handle, struct SConfNode **node,
+                     struct SConfErr *err);
+int sconf_handle_str(struct SConfHandle *handle, const char **str,
+                     struct SConfErr *err);
+int sconf_handle_int(struct SConfHandle *handle, const int64_t **integer,
+                     struct SConfErr *err);
+int sconf_handle_bool(struct SConfHandle *handle, const bool **boolean,
+                      struct SConfErr *err);
+int sconf_handle_float(struct SConfHandle *handle, const double **fp,
+                       struct SConfErr *err);
+
 /**
  * Insert node into dictionary.
  *
@@ -341,6 +991,16 @@ int sconf_set_float(struct SConfNode *root, const char *path, double fp,
 int sconf_node_dict_insert(const char *name, struct SConfNode *parent,
                            struct SConfNode *node, struct SConfErr *err);
 
+/**
+ * Insert node into dictionary, with name of given length.
+ *
+ * Same as sconf_node_dict_insert, but the name does not need to be null
+ * terminated. The name is copied, and can not contain null bytes.
+ */
+int sconf_node_dict_insert_n(const char *name, size_t name_len,
+                             struct SConfNode *parent, struct SConfNode *node,
+                             struct SConfErr *err);
+
 /**
  * Search for node in dictinary.
  *
@@ -355,6 +1015,16 @@ int sconf_node_dict_insert(const char *name, struct SConfNode *parent,
 int sconf_node_dict_search(const char *name, struct SConfNode *parent,
                            struct SConfNode **node, struct SConfErr *err);
 
+/**
+ * Search for node in dictionary, with name of given length.
+ *
+ * Same as sconf_node_dict_search, but the name does not need to be null
+ * terminated.
+ */
+int sconf_node_dict_search_n(const char *name, size_t name_len,
+                             struct SConfNode *parent, struct SConfNode **node,
+                             struct SConfErr *err);
+
 /**
  * Iterate over nodes in dictionary using a callback function.
  *
@@ -404,6 +1074,42 @@ int sconf_node_dict_foreach(struct SConfNode *dict,
 int sconf_node_array_insert(uint32_t index, struct SConfNode *parent,
                             struct SConfNode *node, struct SConfErr *err);
 
+/**
+ * Append node to array, after the element with the highest index.
+ *
+ * Arrays grow geometrically, so appending takes amortized constant time.
+ *
+ * Example:
+ *   struct SConfNode *node = sconf_node_create(SCONF_TYPE_STR, "foobar", &err);
+ *   if (!node) {
+ *       printf("Error: %s\n", sconf_strerror(&err));
+ *       return EXIT_FAILURE;
+ *   }
+ *
+ *   int r = sconf_node_array_append(array, node, &err);
+ *   if (r == -1) {
+ *       printf("Error: %s\n", sconf_strerror(&err));
+ *       sconf_node_destroy(node);
+ *       return EXIT_FAILURE;
+ *   }
+ */
+int sconf_node_array_append(struct SConfNode *parent, struct SConfNode *node,
+                            struct SConfErr *err);
+
+/**
+ * Make room for capacity elements in array, so they can be added without
+ * growing the array again.
+ *
+ * Example:
+ *   int r = sconf_node_array_reserve(array, 100000, &err);
+ *   if (r == -1) {
+ *       printf("Error: %s\n", sconf_strerror(&err));
+ *       return EXIT_FAILURE;
+ *   }
+ */
+int sconf_node_array_reserve(struct SConfNode *array, uint32_t capacity,
+                             struct SConfErr *err);
+
 /**
  * Search for node in array.
  *
@@ -501,6 +1207,10 @@ struct SConfNode *sconf_node_create_and_insert(const char *name, uint8_t type,
 /**
  * Read YAML file.
  *
+ * Regular files are mapped into memory and parsed in place instead of being
+ * copied through stdio buffers, so the file must not be truncated while it
+ * is read. Other files (e.g pipes) are read through stdio.
+ *
  * Example:
  *   int r = sconf_yaml_read(root, "/etc/app.yaml", &err);
  *   if (r == -1) {
@@ -511,6 +1221,122 @@ struct SConfNode *sconf_node_create_and_insert(const char *name, uint8_t type,
 int sconf_yaml_read(struct SConfNode *root, const char *filename,
                     struct SConfErr *err);
 
+/**
+ * Read YAML from memory buffer, e.g an embedded config or one received over
+ * IPC. The buffer does not need to be null terminated, and is not used after
+ * the function returns.
+ *
+ * Example:
+ *   static const char config[] = "port: 8080\n";
+ *
+ *   int r = sconf_yaml_read_buffer(root, config, sizeof(config) - 1, &err);
+ *   if (r == -1) {
+ *       printf("Error: %s\n", sconf_strerror(&err));
+ *       return EXIT_FAILURE;
+ *   }
+ */
+int sconf_yaml_read_buffer(struct SConfNode *root, const char *data,
+                           size_t len, struct SConfErr *err);
+
+/* Flags for sconf_yaml_read_flags and sconf_yaml_read_buffer_flags */
+enum {
+    /* Parser selected at build time (option SCONF_ENABLE_NATIVE_YAML) */
+    SCONF_YAML_DEFAULT = 0,
+    /* Built-in parser, falls back to libyaml for YAML outside its subset */
+    SCONF_YAML_NATIVE = 1 << 0,
+    /* Always libyaml */
+    SCONF_YAML_LIBYAML = 1 << 1,
+    /* Fail instead of falling back to libyaml */
+    SCONF_YAML_NO_FALLBACK = 1 << 2,
+};
+
+/**
+ * Read YAML file or memory buffer, with the parser selected by flags.
+ *
+ * The native parser reads the subset of YAML that config files are usually
+ * written in: block mappings and sequences, single line flow sequences of
+ * scalars, and single line plain or quoted scalars without escapes, in
+ * printable ASCII. It skips the per event allocations of libyaml, which
+ * makes reading large configs considerably faster. The whole input is
+ * checked before anything is read, YAML outside of the subset (e.g anchors,
+ * block scalars or flow mappings) is read with libyaml, so the result is the
+ * same with either parser. Files that can not be mapped into memory are
+ * always read with libyaml.
+ *
+ * Example:
+ *   int r = sconf_yaml_read_flags(root, "/etc/app.yaml", SCONF_YAML_NATIVE,
+ *                                 &err);
+ *   if (r == -1) {
+ *       printf("Error: %s\n", sconf_strerror(&err));
+ *       return EXIT_FAILURE;
+ *   }
+ */
+int sconf_yaml_read_flags(struct SConfNode *root, const char *filename,
+                          int flags, struct SConfErr *err);
+int sconf_yaml_read_buffer_flags(struct SConfNode *root, const char *data,
+                                 size_t len, int flags, struct SConfErr *err);
+
+/**
+ * Read stream of YAML documents, handing each document to a callback
+ * function as a root of its own.
+ *
+ * Unlike sconf_yaml_read, which reads all documents into the same root, a
+ * fresh arena-backed root is built for each document. The root and
+ * everything in it is only valid until the callback returns, and must not
+ * be destroyed by it. Its memory is reused for the next document, so an
+ * unbounded stream (e.g a pipe) is read in constant memory. Reading stops
+ * with an error if the callback returns anything other than 0.
+ *
+ * Example:
+ *   int document_cb(struct SConfNode *root, void *user, struct SConfErr *err)
+ *   {
+ *       const char *tenant;
+ *       if (sconf_get_str(root, "tenant", &tenant, err) != 1) {
+ *           return -1;
+ *       }
+ *       printf("Tenant: %s\n", tenant);
+ *       return 0;
+ *   }
+ *
+ *   [...]
+ *
+ *   int r = sconf_yaml_read_stream("/dev/stdin", &document_cb, NULL, &err);
+ *   if (r == -1) {
+ *       printf("Error: %s\n", sconf_strerror(&err));
+ *       return EXIT_FAILURE;
+ *   }
+ */
+int sconf_yaml_read_stream(const char *filename,
+                           int (*cb)(struct SConfNode *root, void *user,
+                                     struct SConfErr *err),
+                           void *user, struct SConfErr *err);
+
+/**
+ * Read YAML files in directory matching pattern (e.g conf.d fragments), in
+ * lexical (byte) order of their names.
+ *
+ * Files are parsed in parallel on nthreads threads (0 for one per CPU),
+ * each into a tree of its own. The trees are merged into root in order
+ * with SCONF_MERGE_ERROR, so later files override earlier ones and the
+ * result is the same as calling sconf_yaml_read on each file in turn.
+ * Reading stops at the first file that can not be read or merged. The
+ * files before it are merged into root, and none of that file is, whatever
+ * the number of threads. Hidden files only match patterns starting with
+ * '.', and directories are skipped. Files for arena-backed roots are parsed
+ * on the calling thread. Overlay roots can not be merged into, so files are
+ * read into them one by one and a file that fails may be partly applied.
+ *
+ * Example:
+ *   int r = sconf_yaml_read_dir(root, "/etc/app/conf.d", "*.yaml", 0, &err);
+ *   if (r == -1) {
+ *       printf("Error: %s\n", sconf_strerror(&err));
+ *       return EXIT_FAILURE;
+ *   }
+ */
+int sconf_yaml_read_dir(struct SConfNode *root, const char *dir,
+                        const char *pattern, int nthreads,
+                        struct SConfErr *err);
+
 /**
  * Parse command-line arguments.
  *
@@ -651,6 +1477,185 @@ int sconf_env_read(struct SConfNode *root, const struct SConfMap *map,
 int sconf_initialize(struct SConfNode *root, const struct SConfMap *map,
                      int argc, char **argv, void *user, struct SConfErr *err);
 
+/* Config sources, in order of precedence */
+enum {
+    SCONF_SOURCE_OPTS = 0,
+    SCONF_SOURCE_ENV,
+    SCONF_SOURCE_FILE,
+    SCONF_SOURCE_DEFAULTS,
+
+    SCONF_SOURCE_MAX,
+};
+
+struct SConfLayers;
+
+/**
+ * Create config layers, keeping the config from each source (options,
+ * environment variables, YAML files and defaults) in a tree of its own.
+ *
+ * sconf_layers_initialize reads the same sources as sconf_initialize, but
+ * every source only writes to its own layer, so nothing is looked up in the
+ * other sources first. Values resolve by a fixed precedence: options, then
+ * environment variables, then YAML files, then defaults. This differs from
+ * sconf_initialize, which reads options and YAML files in command-line order
+ * (a later YAML file overrides an earlier option) and then lets environment
+ * variables override both. Lookups on the root of the layers (see
+ * sconf_layers_root) resolve values by precedence, and sconf_layers_get
+ * also tells which source set a value. sconf_layers_flatten creates a
+ * single config tree on demand.
+ *
+ * Iterating over the root only sees the options layer, use a flattened tree
+ * to iterate over the resolved config.
+ *
+ * Example:
+ *   struct SConfLayers *layers = sconf_layers_create(&err);
+ *   if (!layers ||
+ *           sconf_layers_initialize(layers, map, argc, argv, NULL,
+ *                                   &err) == -1) {
+ *       printf("Error: %s\n", sconf_strerror(&err));
+ *       return EXIT_FAILURE;
+ *   }
+ *
+ *   struct SConfNode *node;
+ *   int source;
+ *   if (sconf_layers_get(layers, "log.level", &node, &source, &err) == 1) {
+ *       printf("log.level set by %s\n", sconf_source_to_str(source));
+ *   }
+ *
+ *   sconf_layers_destroy(layers);
+ */
+struct SConfLayers *sconf_layers_create(struct SConfErr *err);
+
+/**
+ * Destroy config layers, including the trees of all sources.
+ */
+void sconf_layers_destroy(struct SConfLayers *layers);
+
+/**
+ * Fill config layers based on config map, see sconf_initialize and
+ * sconf_layers_create for how the precedence of sources differs.
+ */
+int sconf_layers_initialize(struct SConfLayers *layers,
+                            const struct SConfMap *map, int argc, char **argv,
+                            void *user, struct SConfErr *err);
+
+/**
+ * Get root of the resolved config. Values are looked up in each source in
+ * order of precedence. Setting values on the root sets them in the options
+ * layer.
+ */
+struct SConfNode *sconf_layers_root(struct SConfLayers *layers);
+
+/**
+ * Get config tree holding the values set by a single source. The trees of
+ * sources with higher precedence are overlays, lookups on them fall back to
+ * the sources below.
+ */
+struct SConfNode *sconf_layers_source(struct SConfLayers *layers, int source);
+
+/**
+ * Get config node based on path, and the source (e.g SCONF_SOURCE_ENV) that
+ * set it.
+ */
+int sconf_layers_get(struct SConfLayers *layers, const char *path,
+                     struct SConfNode **node, int *source,
+                     struct SConfErr *err);
+
+/**
+ * Flatten config layers into a new config tree, owned by the caller.
+ */
+struct SConfNode *sconf_layers_flatten(struct SConfLayers *layers,
+                                       struct SConfErr *err);
+
+/**
+ * Return string representation of config source.
+ */
+const char *sconf_source_to_str(int source);
+
+/**
+ * Fill a C struct from config.
+ *
+ * Walks the bindings once, looking up each node relative to its enclosing
+ * struct, checking its type and range and storing it in the struct. Missing
+ * nodes get their default value, or leave the field untouched. Hot paths can
+ * then read plain struct fields instead of looking up paths.
+ *
+ * Integers can be stored in fields of 1, 2, 4 or 8 bytes (signed or
+ * unsigned), floats in float or double fields and booleans in bool fields.
+ * Strings are stored as const char * pointing into the config tree (or to
+ * the default value), so the tree must outlive the struct.
+ *
+ * Example:
+ *   struct db {
+ *       const char *host;
+ *       uint16_t port;
+ *   };
+ *
+ *   struct config {
+ *       int max_conns;
+ *       double timeout;
+ *       struct db db;
+ *       int64_t weights[8];
+ *       size_t weights_count;
+ *   };
+ *
+ *   const struct SConfBinding db_bindings[] = {
+ *       {
+ *           .path = "host",
+ *           .type = SCONF_TYPE_STR,
+ *           .required = true,
+ *           SCONF_FIELD(struct db, host),
+ *       },
+ *       {
+ *           .path = "port",
+ *           .type = SCONF_TYPE_INT,
+ *           .default_value = "5432",
+ *           .range = true, .min = 1, .max = 65535,
+ *           SCONF_FIELD_UNSIGNED(struct db, port),
+ *       },
+ *       {0}
+ *   };
+ *
+ *   const struct SConfBinding bindings[] = {
+ *       {
+ *           .path = "max-conns",
+ *           .type = SCONF_TYPE_INT,
+ *           .default_value = "1024",
+ *           SCONF_FIELD(struct config, max_conns),
+ *       },
+ *       {
+ *           .path = "timeout",
+ *           .type = SCONF_TYPE_FLOAT,
+ *           .default_value = "2.5",
+ *           SCONF_FIELD(struct config, timeout),
+ *       },
+ *       {
+ *           .path = "db",
+ *           .type = SCONF_TYPE_DICT,
+ *           .fields = db_bindings,
+ *           SCONF_FIELD(struct config, db),
+ *       },
+ *       {
+ *           .path = "weights",
+ *           .type = SCONF_TYPE_ARRAY,
+ *           .element_type = SCONF_TYPE_INT,
+ *           .element_size = sizeof(int64_t),
+ *           SCONF_FIELD(struct config, weights),
+ *           SCONF_COUNT(struct config, weights_count),
+ *       },
+ *       {0}
+ *   };
+ *
+ *   struct config cfg = {0};
+ *   int r = sconf_bind(root, bindings, &cfg, &err);
+ *   if (r == -1) {
+ *       printf("Error: %s\n", sconf_strerror(&err));
+ *       return EXIT_FAILURE;
+ *   }
+ */
+int sconf_bind(struct SConfNode *root, const struct SConfBinding *bindings,
+               void *out, struct SConfErr *err);
+
 /**
  * Set error message.
  *
@@ -1,22 +1,90 @@
 #pragma once
 
+#include <stdalign.h>
+
 #include "art.h"
 
 #include "sconf.h"
 
+struct SConfArena;
+
+/* Node flags */
+#define SCONF_NODE_FLAG_ARENA_OWNER  0x01 /* node owns the arena */
+#define SCONF_NODE_FLAG_FROZEN       0x02 /* node is part of a snapshot */
+#define SCONF_NODE_FLAG_FROZEN_OWNER 0x04 /* node owns the snapshot */
+#define SCONF_NODE_FLAG_INDEXED      0x08 /* snapshot has a path index */
+#define SCONF_NODE_FLAG_STR_INLINE   0x10 /* string is stored in the node */
+#define SCONF_NODE_FLAG_PACKED       0x20 /* node is a view of a packed value */
+#define SCONF_NODE_FLAG_DICT_TREE    0x40 /* dictionary is stored in an ART */
+#define SCONF_NODE_FLAG_OVERLAY      0x80 /* node is an overlay on a tree */
+
+/* Strings shorter than this are stored in the node itself */
+#define SCONF_NODE_STR_INLINE_SIZE 32
+
+/* Entry in a small dictionary */
+struct SConfDictEntry {
+    uint32_t name; /* offset of the null terminated name in the key bytes */
+    uint32_t len;
+    struct SConfNode *node;
+};
+
+/* Small dictionary, entries sorted by key followed by the key bytes in one
+   allocation. Replaced by an ART when it grows past SCONF_DICT_SMALL_MAX
+   entries. */
+struct SConfSmallDict {
+    struct SConfDictEntry *entries;
+    uint32_t count;
+    uint32_t keys_len;
+};
+
+/* Key in a frozen dictionary */
+struct SConfFrozenKey {
+    const char *name;
+    uint32_t len;
+};
+
+/* Frozen dictionary, keys are sorted and children[i] is the value of
+   keys[i] */
+struct SConfFrozenDict {
+    const struct SConfFrozenKey *keys;
+    struct SConfNode *children;
+    uint32_t count;
+};
+
 /**
  * Private structure representing a config node. Should not be used
  * directly outside the library.
  */
 struct SConfNode {
     uint8_t type;
+    uint8_t flags;
+
+    /* Length of the string, if the node is a string */
+    uint32_t len;
+
+    /* Arena the node is allocated from, NULL if allocated on the heap */
+    struct SConfArena *arena;
 
     union {
         art_tree dictionary;
-        char *string;
-        int64_t integer;
+        struct SConfSmallDict small;
+        struct SConfFrozenDict frozen;
+
+        /* String not stored in the node, capacity is the size of the buffer
+           owned by the node (0 if the buffer is not owned, e.g. a string
+           interned in the arena or part of a snapshot) */
+        struct {
+            char *string;
+            uint32_t capacity;
+        };
+
+        /* Short string (SCONF_NODE_FLAG_STR_INLINE), null terminated */
+        char short_string[SCONF_NODE_STR_INLINE_SIZE];
+
+        /* Naturally aligned, so they can be updated with atomic stores */
+        alignas(8) int64_t integer;
         bool boolean;
-        double fp;
+        alignas(8) double fp;
         struct SConfArray *array;
     };
 };
@@ -31,3 +99,67 @@ const char *sconf_type_to_str(uint8_t type);
  */
 const char *sconf_type_to_arg_type_str(uint8_t arg_type);
 
+/**
+ * Return string stored in string config node.
+ */
+static inline const char *sconf_node_str(const struct SConfNode *node)
+{
+    if (node->flags & SCONF_NODE_FLAG_STR_INLINE) {
+        return node->short_string;
+    }
+
+    return node->string;
+}
+
+/**
+ * Variants of sconf_opts_parse, sconf_env_read and sconf_defaults reading
+ * YAML files into a separate config tree (files), used for layered config.
+ * sconf_defaults_into checks view to tell if a YAML file path is set.
+ */
+int sconf_opts_parse_into(struct SConfNode *root, struct SConfNode *files,
+                          const struct SConfMap *map, int argc, char **argv,
+                          void *user, struct SConfErr *err);
+int sconf_env_read_into(struct SConfNode *root, struct SConfNode *files,
+                        const struct SConfMap *map, struct SConfErr *err);
+int sconf_defaults_into(struct SConfNode *root, struct SConfNode *view,
+                        struct SConfNode *files, const struct SConfMap *map,
+                        struct SConfErr *err);
+
+/**
+ * Set scalar value at index in array, packing integers, floats and booleans
+ * when the array is empty or already packed with values of the same type.
+ */
+int sconf_node_array_set_value(struct SConfNode *array, uint32_t index,
+                               uint8_t type, void *data,
+                               struct SConfErr *err);
+
+/**
+ * Get child node with name (not null terminated) in dict, or at index in
+ * array, creating it if it does not exist or replacing its value if it is a
+ * scalar. Fails if the child exists with another type.
+ */
+struct SConfNode *sconf_node_child_set(struct SConfNode *parent,
+                                       const char *name, uint32_t name_len,
+                                       uint32_t index, uint8_t type,
+                                       void *data, struct SConfErr *err);
+
+/**
+ * Create config node allocated from arena, or from the heap if arena is NULL.
+ * A node allocated from an arena does not own it, destroying the node frees
+ * nothing and its memory is released with the arena.
+ */
+struct SConfNode *sconf_node_create_in(struct SConfArena *arena, int type,
+                                       void *data, struct SConfErr *err);
+
+/**
+ * Replace tree owning an arena (see sconf_node_create_arena) with a new empty
+ * node allocated from the same, emptied, arena.
+ */
+struct SConfNode *sconf_node_arena_reset(struct SConfNode *owner, int type,
+                                         void *data, struct SConfErr *err);
+
+/**
+ * Convert packed array to an array of nodes, does nothing if the array is
+ * not packed.
+ */
+int sconf_node_array_unpack(struct SConfNode *node, struct SConfErr *err);
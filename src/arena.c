@@ -0,0 +1,286 @@
+#include <assert.h>
+#include <stdalign.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "sconf.h"
+
+/* Size of the first block in an arena */
+#define SCONF_ARENA_BLOCK_MIN_SIZE (16 * 1024)
+
+/* Blocks grow geometrically until they reach this size */
+#define SCONF_ARENA_BLOCK_MAX_SIZE (1024 * 1024)
+
+/* All allocations are aligned to this */
+#define SCONF_ARENA_ALIGN alignof(max_align_t)
+
+struct SConfArenaBlock {
+    struct SConfArenaBlock *next;
+    size_t size;
+    size_t used;
+    alignas(max_align_t) unsigned char data[];
+};
+
+/**
+ * @internal
+ * @brief libart calloc hook for arena-backed dictionaries.
+ *
+ * @param ctx  The arena.
+ * @param size Number of bytes to allocate.
+ *
+ * @return zeroed memory on success, NULL otherwise.
+ */
+static void *sconf_arena_art_calloc(void *ctx, size_t size)
+{
+    return sconf_arena_calloc((struct SConfArena *)ctx, 1, size);
+}
+
+/**
+ * @internal
+ * @brief libart free hook for arena-backed dictionaries.
+ *
+ * Memory is released when the arena is destroyed, so this does nothing.
+ *
+ * @param ctx The arena.
+ * @param ptr Memory to free.
+ */
+static void sconf_arena_art_free(void *ctx, void *ptr)
+{
+    (void)ctx;
+    (void)ptr;
+}
+
+/**
+ * @brief Create a bump allocator arena.
+ *
+ * @param err Pointer to error struct.
+ *
+ * @return arena on success, NULL otherwise.
+ */
+struct SConfArena *sconf_arena_create(struct SConfErr *err)
+{
+    struct SConfArena *arena = calloc(1, sizeof(struct SConfArena));
+    if (!arena) {
+        sconf_err_set(err, "failed to allocate memory for arena");
+        return NULL;
+    }
+
+    arena->next_block_size = SCONF_ARENA_BLOCK_MIN_SIZE;
+    arena->art.calloc = sconf_arena_art_calloc;
+    arena->art.free = sconf_arena_art_free;
+    arena->art.ctx = arena;
+    sconf_intern_init(&arena->strings, arena);
+
+    /* Generation 0 is used by handles not resolved yet */
+    arena->generation = 1;
+
+    return arena;
+}
+
+/**
+ * @brief Destroy arena and release all memory allocated from it.
+ *
+ * @param arena Arena to destroy.
+ */
+void sconf_arena_destroy(struct SConfArena *arena)
+{
+    if (!arena) {
+        return;
+    }
+
+    struct SConfArenaBlock *block = arena->blocks;
+    while (block)
+    {
+        struct SConfArenaBlock *next = block->next;
+        free(block);
+        block = next;
+    }
+
+    free(arena);
+}
+
+/**
+ * @brief Release everything allocated from arena, keeping its memory for
+ * reuse.
+ *
+ * The blocks are merged into a single block the size of everything that was
+ * allocated, so filling the arena with the same amount of data again does
+ * not allocate.
+ *
+ * @param arena Arena to reset.
+ */
+void sconf_arena_reset(struct SConfArena *arena)
+{
+    assert(arena);
+
+    struct SConfArenaBlock *block = arena->blocks;
+
+    if (block && !block->next) {
+        memset(block->data, 0, block->used);
+        block->used = 0;
+    }
+    else {
+        size_t used = 0;
+        while (block)
+        {
+            struct SConfArenaBlock *next = block->next;
+            used += block->used;
+            free(block);
+            block = next;
+        }
+
+        /* Without the merged block the arena just starts over */
+        arena->blocks = NULL;
+        if (used > 0) {
+            block = calloc(1, sizeof(struct SConfArenaBlock) + used);
+            if (block) {
+                block->size = used;
+                arena->blocks = block;
+            }
+        }
+    }
+
+    sconf_intern_init(&arena->strings, arena);
+}
+
+/**
+ * @internal
+ * @brief Allocate a new block and link it into the arena.
+ *
+ * Allocations too large for a regular block get a block of their own,
+ * which is linked in behind the current block so it can still be used.
+ *
+ * @param arena Arena to add block to.
+ * @param size  Number of bytes that must fit in the block.
+ *
+ * @return new block on success, NULL otherwise.
+ */
+static struct SConfArenaBlock *sconf_arena_block_add(struct SConfArena *arena,
+                                                     size_t size)
+{
+    assert(arena);
+
+    bool dedicated = size > arena->next_block_size / 4;
+    size_t block_size = dedicated ? size : arena->next_block_size;
+
+    struct SConfArenaBlock *block = calloc(1, sizeof(struct SConfArenaBlock) +
+                                              block_size);
+    if (!block) {
+        return NULL;
+    }
+
+    block->size = block_size;
+
+    if (dedicated && arena->blocks) {
+        block->next = arena->blocks->next;
+        arena->blocks->next = block;
+        return block;
+    }
+
+    block->next = arena->blocks;
+    arena->blocks = block;
+
+    if (arena->next_block_size < SCONF_ARENA_BLOCK_MAX_SIZE) {
+        arena->next_block_size *= 2;
+    }
+
+    return block;
+}
+
+/**
+ * @brief Allocate zeroed memory.
+ *
+ * Falls back to calloc if arena is NULL, which makes it possible to use
+ * the same code path for nodes with and without an arena.
+ *
+ * @param arena Arena to allocate from, or NULL.
+ * @param nmemb Number of elements.
+ * @param size  Size of each element.
+ *
+ * @return zeroed memory on success, NULL otherwise.
+ */
+void *sconf_arena_calloc(struct SConfArena *arena, size_t nmemb, size_t size)
+{
+    if (!arena) {
+        return calloc(nmemb, size);
+    }
+
+    if (size && nmemb > SIZE_MAX / size) {
+        return NULL;
+    }
+
+    size_t total = nmemb * size;
+    if (total > SIZE_MAX - SCONF_ARENA_ALIGN) {
+        return NULL;
+    }
+    total = (total + SCONF_ARENA_ALIGN - 1) & ~(SCONF_ARENA_ALIGN - 1);
+
+    struct SConfArenaBlock *block = arena->blocks;
+    if (!block || block->size - block->used < total) {
+        block = sconf_arena_block_add(arena, total);
+        if (!block) {
+            return NULL;
+        }
+    }
+
+    void *ptr = block->data + block->used;
+    block->used += total;
+
+    return ptr;
+}
+
+/**
+ * @brief Resize memory, zeroing any added bytes.
+ *
+ * With an arena the old memory is not reclaimed until the arena is
+ * destroyed.
+ *
+ * @param arena    Arena to allocate from, or NULL.
+ * @param ptr      Memory to resize.
+ * @param old_size Current size of memory.
+ * @param new_size Wanted size of memory.
+ *
+ * @return resized memory on success, NULL otherwise.
+ */
+void *sconf_arena_realloc(struct SConfArena *arena, void *ptr, size_t old_size,
+                          size_t new_size)
+{
+    if (!arena) {
+        unsigned char *new = realloc(ptr, new_size);
+        if (new && new_size > old_size) {
+            memset(new + old_size, 0, new_size - old_size);
+        }
+        return new;
+    }
+
+    if (new_size <= old_size) {
+        return ptr;
+    }
+
+    void *new = sconf_arena_calloc(arena, 1, new_size);
+    if (new && ptr) {
+        memcpy(new, ptr, old_size);
+    }
+
+    return new;
+}
+
+/**
+ * @brief Free memory.
+ *
+ * Does nothing if arena is set, since the memory is released when the
+ * arena is destroyed.
+ *
+ * @param arena Arena the memory was allocated from, or NULL.
+ * @param ptr   Memory to free.
+ */
+void sconf_arena_free(struct SConfArena *arena, void *ptr)
+{
+    if (!arena) {
+        free(ptr);
+    }
+}
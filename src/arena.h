@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "art.h"
+#include "intern.h"
+#include "sconf.h"
+
+struct SConfArenaBlock;
+
+struct SConfArena {
+    struct SConfArenaBlock *blocks;
+    size_t next_block_size;
+    art_allocator art;
+
+    /* Long string values of the tree, each stored once */
+    struct SConfIntern strings;
+
+    /* Generation of the tree, see sconf_generation_bump */
+    uint64_t generation;
+};
+
+struct SConfArena *sconf_arena_create(struct SConfErr *err);
+void sconf_arena_destroy(struct SConfArena *arena);
+void sconf_arena_reset(struct SConfArena *arena);
+void *sconf_arena_calloc(struct SConfArena *arena, size_t nmemb, size_t size);
+void *sconf_arena_realloc(struct SConfArena *arena, void *ptr, size_t old_size,
+                          size_t new_size);
+void sconf_arena_free(struct SConfArena *arena, void *ptr);
@@ -1,46 +1,60 @@
 #include <assert.h>
 #include <inttypes.h>
+#include <stdbool.h>
 #include <stdlib.h>
 
+#include "arena.h"
 #include "array.h"
 #include "sconf.h"
+#include "sconf_private.h"
 
-#define SCONF_ARRAY_MAX_SIZE 65536
+static_assert(SCONF_ARRAY_MAX_SIZE > 0 && SCONF_ARRAY_MAX_SIZE <= UINT32_MAX,
+              "SCONF_ARRAY_MAX_SIZE must fit in 32 bits");
+
+/* Capacity of an array when the first element is added */
+#define SCONF_ARRAY_MIN_CAPACITY 4
 
 /**
  * @brief Create dynamic array.
  *
- * @param size Initial size of array.
- * @param err  Pointer to error struct.
+ * @param capacity Initial capacity of array.
+ * @param arena    Arena to allocate from, or NULL to use the heap.
+ * @param err      Pointer to error struct.
  *
  * @return array on success, NULL otherwise.
  */
-struct SConfArray *sconf_array_create(uint32_t size, struct SConfErr *err)
+struct SConfArray *sconf_array_create(uint32_t capacity,
+                                      struct SConfArena *arena,
+                                      struct SConfErr *err)
 {
-    if (size == 0) {
+    if (capacity == 0) {
         sconf_err_set(err, "array size must be >0");
         return NULL;
     }
 
-    if (size > SCONF_ARRAY_MAX_SIZE) {
-        sconf_err_set(err, "array size must be <%d", SCONF_ARRAY_MAX_SIZE);
+    if (capacity > SCONF_ARRAY_MAX_SIZE) {
+        sconf_err_set(err, "array size must be <=%" PRIu64,
+                      (uint64_t)SCONF_ARRAY_MAX_SIZE);
         return NULL;
     }
 
-    struct SConfArray *array = calloc(1, sizeof(struct SConfArray));
+    struct SConfArray *array = sconf_arena_calloc(arena, 1,
+                                                  sizeof(struct SConfArray));
     if (!array) {
         sconf_err_set(err, "failed to allocate memory for array");
         return NULL;
     }
 
-    array->entries = calloc(size, sizeof(struct SConfNode *));
+    array->entries = sconf_arena_calloc(arena, capacity,
+                                        sizeof(struct SConfNode *));
     if (!array->entries) {
         sconf_err_set(err, "failed to allocate memory for array elements");
-        free(array);
+        sconf_arena_free(arena, array);
         return NULL;
     }
 
-    array->size = size;
+    array->capacity = capacity;
+    array->arena = arena;
 
     return array;
 }
@@ -57,55 +71,104 @@ void sconf_array_destroy(struct SConfArray *array)
     }
 
     if (array->entries) {
-        free(array->entries);
+        sconf_arena_free(array->arena, array->entries);
     }
 
-    free(array);
+    sconf_array_pack_release(array);
+
+    sconf_arena_free(array->arena, array);
 }
 
 /**
  * @internal
  * @brief Grow array to make room if necessary.
  *
- * @param array       Array to check.
- * @param size_needed How much room the array must have.
- * @param err         Pointer to error struct.
+ * Unless exact is set, the capacity is at least doubled, so adding elements
+ * one at a time takes amortized constant time.
+ *
+ * @param array  Array to grow.
+ * @param needed Number of entries, or words if packed, the array must have
+ *               room for.
+ * @param exact  Grow to exactly what is needed.
+ * @param err    Pointer to error struct.
  *
  * @return 0 on success, -1 otherwise.
  */
-static int sconf_array_grow(struct SConfArray *array, uint32_t size_needed,
-                            struct SConfErr *err)
+static int sconf_array_grow(struct SConfArray *array, size_t needed,
+                            bool exact, struct SConfErr *err)
 {
     assert(array);
-    assert(array->entries);
 
-    if (array->size >= size_needed) {
+    if (array->capacity >= needed) {
         return 0;
     }
 
-    if (size_needed > SCONF_ARRAY_MAX_SIZE) {
-        sconf_err_set(err, "array is full (max size reached)");
-        return -1;
+    size_t max = array->packed ?
+        SCONF_ARRAY_PACKED_WORDS(array->packed, SCONF_ARRAY_MAX_SIZE) :
+        SCONF_ARRAY_MAX_SIZE;
+    assert(needed <= max);
+
+    size_t capacity = needed;
+    if (!exact) {
+        capacity = array->capacity ? (size_t)array->capacity * 2 :
+                                     SCONF_ARRAY_MIN_CAPACITY;
+        if (capacity < needed) {
+            capacity = needed;
+        }
+        if (capacity > max) {
+            capacity = max;
+        }
     }
 
-    struct SConfNode **new = realloc(array->entries,
-                                     sizeof(struct SConfNode *) * size_needed);
+    size_t elem_size = array->packed ? sizeof(uint64_t) :
+                                       sizeof(struct SConfNode *);
+    void *old = array->packed ? (void *)array->bits : (void *)array->entries;
+
+    void *new = sconf_arena_realloc(array->arena, old,
+                                    elem_size * array->capacity,
+                                    elem_size * capacity);
     if (!new) {
         sconf_err_set(err, "failed to realloc array");
         return -1;
     }
 
-    for (uint32_t i = array->size; i < size_needed; i++)
-    {
-        new[i] = NULL;
+    if (array->packed) {
+        array->bits = new;
     }
-
-    array->entries = new;
-    array->size = size_needed;
+    else {
+        array->entries = new;
+    }
+    array->capacity = (uint32_t)capacity;
 
     return 0;
 }
 
+/**
+ * @brief Make room for a number of elements in array.
+ *
+ * @param array    Array to reserve room in.
+ * @param capacity Number of elements the array must have room for.
+ * @param err      Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sconf_array_reserve(struct SConfArray *array, uint64_t capacity,
+                        struct SConfErr *err)
+{
+    assert(array);
+
+    if (capacity > SCONF_ARRAY_MAX_SIZE) {
+        sconf_err_set(err, "array size must be <=%" PRIu64,
+                      (uint64_t)SCONF_ARRAY_MAX_SIZE);
+        return -1;
+    }
+
+    size_t needed = array->packed ?
+        SCONF_ARRAY_PACKED_WORDS(array->packed, capacity) : (size_t)capacity;
+
+    return sconf_array_grow(array, needed, true, err);
+}
+
 /**
  * @brief Insert into dynamic array.
  *
@@ -128,18 +191,344 @@ int sconf_array_insert(struct SConfArray *array, uint32_t index,
         return -1;
     }
 
-    if (sconf_array_grow(array, index + 1, err) != 0) {
+    if (index >= SCONF_ARRAY_MAX_SIZE) {
+        sconf_err_set(err, "array is full (max size reached)");
+        return -1;
+    }
+
+    if (sconf_array_grow(array, (size_t)index + 1, false, err) != 0) {
         return -1;
     }
 
-    if (array->entries[index]) {
+    if (index < array->size && array->entries[index]) {
         sconf_err_set(err, "there is already a node in array at index '%"
                       PRIu32 "'", index);
         return -1;
     }
 
     array->entries[index] = node;
+    if (index >= array->size) {
+        array->size = index + 1;
+    }
 
     return 0;
 }
 
+/**
+ * @brief Check if array has no nodes or values.
+ *
+ * @param array Array to check.
+ *
+ * @return true if empty, false otherwise.
+ */
+bool sconf_array_is_empty(const struct SConfArray *array)
+{
+    assert(array);
+
+    /* The size is one more than the highest index in use */
+    return array->size == 0;
+}
+
+/**
+ * @internal
+ * @brief Free view nodes and the list of them.
+ *
+ * @param view  The view.
+ * @param count Number of nodes in the view.
+ */
+static void sconf_array_view_free(struct SConfNode **view, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        free(view[i]);
+    }
+
+    free(view);
+}
+
+/**
+ * @internal
+ * @brief Create read-only node for a value of packed array.
+ *
+ * Allocated from the heap, since readers can not share the arena.
+ *
+ * @param type Type of the array values.
+ * @param err  Pointer to error struct.
+ *
+ * @return node on success, NULL otherwise.
+ */
+static struct SConfNode *sconf_array_view_node(uint8_t type,
+                                               struct SConfErr *err)
+{
+    struct SConfNode *node = calloc(1, sizeof(struct SConfNode));
+    if (!node) {
+        sconf_err_set(err, "failed to allocate memory for array element");
+        return NULL;
+    }
+
+    node->type = type;
+    node->flags = SCONF_NODE_FLAG_PACKED;
+
+    return node;
+}
+
+/**
+ * @internal
+ * @brief Make room in the view of packed array for one more node.
+ *
+ * @param array Packed array with a view.
+ * @param err   Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int sconf_array_view_grow(struct SConfArray *array,
+                                 struct SConfErr *err)
+{
+    assert(array);
+    assert(array->view);
+
+    if (array->view_capacity > array->size) {
+        return 0;
+    }
+
+    size_t capacity = array->view_capacity ?
+                      (size_t)array->view_capacity * 2 :
+                      SCONF_ARRAY_MIN_CAPACITY;
+    if (capacity > SCONF_ARRAY_MAX_SIZE) {
+        capacity = SCONF_ARRAY_MAX_SIZE;
+    }
+
+    struct SConfNode **view = realloc(array->view,
+                                      capacity * sizeof(struct SConfNode *));
+    if (!view) {
+        sconf_err_set(err, "failed to realloc array elements");
+        return -1;
+    }
+
+    array->view = view;
+    array->view_capacity = (uint32_t)capacity;
+
+    return 0;
+}
+
+/**
+ * @brief Append value to packed array.
+ *
+ * An empty array that is not packed yet becomes a packed array of type.
+ *
+ * @param array Array to append to, packed with values of type or empty.
+ * @param type  Type of value (SCONF_TYPE_INT, SCONF_TYPE_FLOAT or
+ *              SCONF_TYPE_BOOL).
+ * @param data  Pointer to the value.
+ * @param err   Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sconf_array_pack_append(struct SConfArray *array, uint8_t type,
+                            const void *data, struct SConfErr *err)
+{
+    assert(array);
+    assert(type == SCONF_TYPE_INT || type == SCONF_TYPE_FLOAT ||
+           type == SCONF_TYPE_BOOL);
+    assert(array->packed == type ||
+           (!array->packed && sconf_array_is_empty(array)));
+
+    if (!array->packed) {
+        sconf_arena_free(array->arena, array->entries);
+        array->entries = NULL;
+        array->capacity = 0;
+        array->packed = type;
+        array->size = 0;
+    }
+
+    if (array->size >= SCONF_ARRAY_MAX_SIZE) {
+        sconf_err_set(err, "array is full (max size reached)");
+        return -1;
+    }
+
+    if (sconf_array_grow(array, SCONF_ARRAY_PACKED_WORDS(type,
+                                                         array->size + 1),
+                         false, err) == -1) {
+        return -1;
+    }
+
+    /* Nodes already handed out for the values stay valid, so the view is
+       extended rather than created again */
+    if (array->view) {
+        if (sconf_array_view_grow(array, err) == -1) {
+            return -1;
+        }
+
+        array->view[array->size] = sconf_array_view_node(type, err);
+        if (!array->view[array->size]) {
+            return -1;
+        }
+    }
+
+    sconf_array_pack_set(array, array->size++, data);
+
+    return 0;
+}
+
+/**
+ * @brief Set value in packed array.
+ *
+ * @param array Packed array.
+ * @param index Index of value to set, must be less than the size.
+ * @param data  Pointer to the value, of the type of the array.
+ */
+void sconf_array_pack_set(struct SConfArray *array, uint32_t index,
+                          const void *data)
+{
+    assert(array);
+    assert(array->packed);
+    assert(index < array->size);
+
+    switch (array->packed)
+    {
+        case SCONF_TYPE_INT:
+            array->integers[index] = *(const int64_t *)data;
+            break;
+        case SCONF_TYPE_FLOAT:
+            array->floats[index] = *(const double *)data;
+            break;
+        case SCONF_TYPE_BOOL:
+            if (*(const bool *)data) {
+                array->bits[index / 64] |= UINT64_C(1) << (index % 64);
+            }
+            else {
+                array->bits[index / 64] &= ~(UINT64_C(1) << (index % 64));
+            }
+            break;
+    }
+
+    if (array->view) {
+        sconf_array_pack_value(array, index, array->view[index]);
+    }
+}
+
+/**
+ * @brief Copy value from packed array into node.
+ *
+ * @param array Packed array.
+ * @param index Index of value to copy.
+ * @param node  Node of the type of the array.
+ */
+void sconf_array_pack_value(const struct SConfArray *array, uint32_t index,
+                            struct SConfNode *node)
+{
+    assert(array);
+    assert(node);
+    assert(index < array->size);
+
+    switch (array->packed)
+    {
+        case SCONF_TYPE_INT:
+            node->integer = array->integers[index];
+            break;
+        case SCONF_TYPE_FLOAT:
+            node->fp = array->floats[index];
+            break;
+        case SCONF_TYPE_BOOL:
+            node->boolean = (array->bits[index / 64] >> (index % 64)) & 1;
+            break;
+    }
+}
+
+/**
+ * @brief Release packed values and view of array.
+ *
+ * The array is left empty and without entries, so it must be given new
+ * entries or destroyed.
+ *
+ * @param array Array to release packed values of.
+ */
+void sconf_array_pack_release(struct SConfArray *array)
+{
+    assert(array);
+
+    if (!array->packed) {
+        return;
+    }
+
+    sconf_array_view_clear(array);
+    sconf_arena_free(array->arena, array->bits);
+
+    array->bits = NULL;
+    array->capacity = 0;
+    array->packed = 0;
+    array->size = 0;
+}
+
+/**
+ * @brief Get read-only nodes for the values of packed array.
+ *
+ * The nodes are created on first access. Readers may race to create them,
+ * so they are published with compare-and-swap and the loser frees its copy.
+ * Once created, the nodes live as long as the array.
+ *
+ * @param array Packed array.
+ * @param err   Pointer to error struct.
+ *
+ * @return the nodes on success, NULL otherwise.
+ */
+struct SConfNode **sconf_array_view(struct SConfArray *array,
+                                    struct SConfErr *err)
+{
+    assert(array);
+    assert(array->packed);
+
+    struct SConfNode **view = __atomic_load_n(&array->view, __ATOMIC_ACQUIRE);
+    if (view) {
+        return view;
+    }
+
+    uint32_t capacity = array->size ? array->size : 1;
+    view = calloc(capacity, sizeof(struct SConfNode *));
+    if (!view) {
+        sconf_err_set(err, "failed to allocate memory for array elements");
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < array->size; i++)
+    {
+        view[i] = sconf_array_view_node(array->packed, err);
+        if (!view[i]) {
+            sconf_array_view_free(view, i);
+            return NULL;
+        }
+        sconf_array_pack_value(array, i, view[i]);
+    }
+
+    struct SConfNode **expected = NULL;
+    if (!__atomic_compare_exchange_n(&array->view, &expected, view, false,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        sconf_array_view_free(view, array->size);
+        return expected;
+    }
+
+    /* Only the winner sets the capacity, written before any append */
+    array->view_capacity = capacity;
+
+    return view;
+}
+
+/**
+ * @brief Free the view of packed array, if it has been created.
+ *
+ * Nodes handed out for the values are freed as well, so this is only done
+ * when the array is destroyed or its values are released.
+ *
+ * @param array Packed array.
+ */
+void sconf_array_view_clear(struct SConfArray *array)
+{
+    assert(array);
+
+    if (array->view) {
+        sconf_array_view_free(array->view, array->size);
+    }
+
+    array->view = NULL;
+    array->view_capacity = 0;
+}
@@ -2,15 +2,66 @@
 
 #include <stdint.h>
 
+#include "arena.h"
 #include "sconf.h"
 
+/* Maximum number of elements in an array, set with the CMake variable of
+   the same name */
+#ifndef SCONF_ARRAY_MAX_SIZE
+#define SCONF_ARRAY_MAX_SIZE UINT32_MAX
+#endif
+
 struct SConfArray {
     struct SConfNode **entries;
+
+    /* One more than the highest index in use */
     uint32_t size;
+
+    /* Number of entries, or 64-bit words if packed, allocated */
+    uint32_t capacity;
+
+    struct SConfArena *arena;
+
+    /* Type of the values if they are packed (SCONF_TYPE_INT, SCONF_TYPE_FLOAT
+       or SCONF_TYPE_BOOL), 0 otherwise. A packed array has no entries and no
+       holes, and size is the number of values. */
+    uint8_t packed;
+    union {
+        int64_t *integers;
+        double *floats;
+        uint64_t *bits;
+    };
+
+    /* Read-only nodes for the packed values, created on first access. Each
+       node is allocated on its own and lives as long as the array, it is
+       kept when values are appended and moved into the entries when the
+       array is unpacked. */
+    struct SConfNode **view;
+
+    /* Number of nodes the view has room for */
+    uint32_t view_capacity;
 };
 
-struct SConfArray *sconf_array_create(uint32_t size, struct SConfErr *err);
+/* Number of 64-bit words needed to store count packed values of type */
+#define SCONF_ARRAY_PACKED_WORDS(type, count) \
+    ((type) == SCONF_TYPE_BOOL ? ((size_t)(count) + 63) / 64 : (size_t)(count))
+
+struct SConfArray *sconf_array_create(uint32_t capacity,
+                                      struct SConfArena *arena,
+                                      struct SConfErr *err);
 void sconf_array_destroy(struct SConfArray *array);
+int sconf_array_reserve(struct SConfArray *array, uint64_t capacity,
+                        struct SConfErr *err);
 int sconf_array_insert(struct SConfArray *array, uint32_t index,
                        struct SConfNode *node, struct SConfErr *err);
-
+bool sconf_array_is_empty(const struct SConfArray *array);
+int sconf_array_pack_append(struct SConfArray *array, uint8_t type,
+                            const void *data, struct SConfErr *err);
+void sconf_array_pack_set(struct SConfArray *array, uint32_t index,
+                          const void *data);
+void sconf_array_pack_value(const struct SConfArray *array, uint32_t index,
+                            struct SConfNode *node);
+void sconf_array_pack_release(struct SConfArray *array);
+struct SConfNode **sconf_array_view(struct SConfArray *array,
+                                    struct SConfErr *err);
+void sconf_array_view_clear(struct SConfArray *array);
@@ -0,0 +1,529 @@
+#include <assert.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "array.h"
+#include "convert.h"
+#include "sconf_private.h"
+
+/**
+ * @internal
+ * @brief Get size of field for binding, using the natural size of the type
+ * if no size is set.
+ *
+ * @param type The node type.
+ * @param size Size set in the binding.
+ *
+ * @return size of field.
+ */
+static size_t sconf_bind_size(uint8_t type, size_t size)
+{
+    if (size > 0) {
+        return size;
+    }
+
+    switch (type)
+    {
+        case SCONF_TYPE_STR:
+            return sizeof(const char *);
+        case SCONF_TYPE_INT:
+            return sizeof(int64_t);
+        case SCONF_TYPE_BOOL:
+            return sizeof(bool);
+        case SCONF_TYPE_FLOAT:
+            return sizeof(double);
+    }
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Check that field size is valid for type.
+ *
+ * @param path The full path of the binding (used in error message).
+ * @param type The node type.
+ * @param size Size of field.
+ * @param err  Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int sconf_bind_check_size(const char *path, uint8_t type, size_t size,
+                                 struct SConfErr *err)
+{
+    bool valid = false;
+
+    switch (type)
+    {
+        case SCONF_TYPE_STR:
+            valid = size == sizeof(const char *);
+            break;
+        case SCONF_TYPE_INT:
+            valid = size == 1 || size == 2 || size == 4 || size == 8;
+            break;
+        case SCONF_TYPE_BOOL:
+            valid = size == sizeof(bool);
+            break;
+        case SCONF_TYPE_FLOAT:
+            valid = size == sizeof(float) || size == sizeof(double);
+            break;
+        default:
+            sconf_err_set(err, "can not bind '%s' of type %s", path,
+                          sconf_type_to_str(type));
+            return -1;
+    }
+
+    if (!valid) {
+        sconf_err_set(err, "can not bind '%s' of type %s to field of %zu "
+                      "bytes", path, sconf_type_to_str(type), size);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Range check and store integer in field.
+ *
+ * The integer must fit in the range of the signed or unsigned C type of the
+ * field, in addition to the range of the binding.
+ *
+ * @param binding The binding.
+ * @param path    The full path of the binding (used in error message).
+ * @param size    Size of field.
+ * @param integer The integer to store.
+ * @param dst     The field.
+ * @param err     Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int sconf_bind_store_int(const struct SConfBinding *binding,
+                                const char *path, size_t size,
+                                int64_t integer, void *dst,
+                                struct SConfErr *err)
+{
+    if (binding->range && (integer < binding->min ||
+                           integer > binding->max)) {
+        sconf_err_set(err, "config node '%s' is %" PRId64 ", outside of range "
+                      "[%" PRId64 ", %" PRId64 "]", path, integer,
+                      binding->min, binding->max);
+        return -1;
+    }
+
+    int64_t low = INT64_MIN;
+    int64_t high = INT64_MAX;
+
+    if (binding->is_unsigned) {
+        low = 0;
+        if (size < sizeof(int64_t)) {
+            high = ((int64_t)1 << (size * 8)) - 1;
+        }
+    }
+    else if (size < sizeof(int64_t)) {
+        low = -((int64_t)1 << (size * 8 - 1));
+        high = ((int64_t)1 << (size * 8 - 1)) - 1;
+    }
+
+    if (integer < low || integer > high) {
+        sconf_err_set(err, "config node '%s' is %" PRId64 ", which does not "
+                      "fit in %zu byte %s integer", path, integer, size,
+                      binding->is_unsigned ? "unsigned" : "signed");
+        return -1;
+    }
+
+    switch (size)
+    {
+        case 1:
+        {
+            uint8_t value = (uint8_t)integer;
+            memcpy(dst, &value, size);
+            break;
+        }
+        case 2:
+        {
+            uint16_t value = (uint16_t)integer;
+            memcpy(dst, &value, size);
+            break;
+        }
+        case 4:
+        {
+            uint32_t value = (uint32_t)integer;
+            memcpy(dst, &value, size);
+            break;
+        }
+        default:
+            memcpy(dst, &integer, size);
+            break;
+    }
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Range check and store floating-point number in field.
+ *
+ * @param binding The binding.
+ * @param path    The full path of the binding (used in error message).
+ * @param size    Size of field.
+ * @param fp      The floating-point number to store.
+ * @param dst     The field.
+ * @param err     Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int sconf_bind_store_float(const struct SConfBinding *binding,
+                                  const char *path, size_t size, double fp,
+                                  void *dst, struct SConfErr *err)
+{
+    if (binding->range && !(fp >= binding->min_float &&
+                            fp <= binding->max_float)) {
+        sconf_err_set(err, "config node '%s' is %g, outside of range "
+                      "[%g, %g]", path, fp, binding->min_float,
+                      binding->max_float);
+        return -1;
+    }
+
+    if (size == sizeof(float)) {
+        float value = (float)fp;
+        memcpy(dst, &value, size);
+    }
+    else {
+        memcpy(dst, &fp, size);
+    }
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Store value of scalar node in field.
+ *
+ * @param binding The binding.
+ * @param path    The full path of the binding (used in error message).
+ * @param type    The expected node type.
+ * @param size    Size of field.
+ * @param node    The config node.
+ * @param dst     The field.
+ * @param err     Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int sconf_bind_store(const struct SConfBinding *binding,
+                            const char *path, uint8_t type, size_t size,
+                            const struct SConfNode *node, void *dst,
+                            struct SConfErr *err)
+{
+    if (node->type != type) {
+        sconf_err_set(err, "config node '%s' is %s not %s", path,
+                      sconf_type_to_str(node->type), sconf_type_to_str(type));
+        return -1;
+    }
+
+    switch (type)
+    {
+        case SCONF_TYPE_STR:
+        {
+            const char *string = sconf_node_str(node);
+            memcpy(dst, &string, size);
+            return 0;
+        }
+        case SCONF_TYPE_INT:
+            return sconf_bind_store_int(binding, path, size, node->integer,
+                                        dst, err);
+        case SCONF_TYPE_BOOL:
+            memcpy(dst, &node->boolean, size);
+            return 0;
+        case SCONF_TYPE_FLOAT:
+            return sconf_bind_store_float(binding, path, size, node->fp, dst,
+                                          err);
+    }
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Convert and store default value in field.
+ *
+ * @param binding The binding.
+ * @param path    The full path of the binding (used in error message).
+ * @param size    Size of field.
+ * @param dst     The field.
+ * @param err     Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int sconf_bind_default(const struct SConfBinding *binding,
+                              const char *path, size_t size, void *dst,
+                              struct SConfErr *err)
+{
+    const char *string = binding->default_value;
+    int r = 0;
+
+    switch (binding->type)
+    {
+        case SCONF_TYPE_STR:
+            memcpy(dst, &string, size);
+            return 0;
+        case SCONF_TYPE_INT:
+        {
+            int64_t integer;
+            r = sconf_string_to_integer(string, &integer, err);
+            if (r == 1) {
+                return sconf_bind_store_int(binding, path, size, integer, dst,
+                                            err);
+            }
+            break;
+        }
+        case SCONF_TYPE_BOOL:
+        {
+            bool boolean;
+            r = sconf_string_to_bool(string, &boolean);
+            if (r == 1) {
+                memcpy(dst, &boolean, size);
+                return 0;
+            }
+            break;
+        }
+        case SCONF_TYPE_FLOAT:
+        {
+            double fp;
+            r = sconf_string_to_float(string, &fp, err);
+            if (r == 1) {
+                return sconf_bind_store_float(binding, path, size, fp, dst,
+                                              err);
+            }
+            break;
+        }
+    }
+
+    if (r == 0) {
+        sconf_err_set(err, "expected default value for '%s' to be %s", path,
+                      sconf_type_to_str(binding->type));
+    }
+
+    return -1;
+}
+
+/**
+ * @internal
+ * @brief Store elements of array node in array field.
+ *
+ * @param binding The binding.
+ * @param path    The full path of the binding (used in error message).
+ * @param node    The array node, or NULL if missing.
+ * @param base    The struct holding the field.
+ * @param err     Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int sconf_bind_array(const struct SConfBinding *binding,
+                            const char *path, struct SConfNode *node,
+                            char *base, struct SConfErr *err)
+{
+    uint8_t type = binding->element_type;
+    size_t element_size = sconf_bind_size(type, binding->element_size);
+
+    if (sconf_bind_check_size(path, type, element_size, err) == -1) {
+        return -1;
+    }
+
+    if (binding->size < element_size) {
+        sconf_err_set(err, "array field of '%s' is smaller than an element",
+                      path);
+        return -1;
+    }
+
+    size_t capacity = binding->size / element_size;
+    size_t count = 0;
+
+    if (node) {
+        if (node->type != SCONF_TYPE_ARRAY) {
+            sconf_err_set(err, "config node '%s' is %s not %s", path,
+                          sconf_type_to_str(node->type),
+                          sconf_type_to_str(SCONF_TYPE_ARRAY));
+            return -1;
+        }
+
+        struct SConfArray *array = node->array;
+        count = array ? array->size : 0;
+
+        if (count > capacity || (!binding->counted && count != capacity)) {
+            sconf_err_set(err, "config node '%s' has %zu elements, expected "
+                          "%s%zu", path, count,
+                          binding->counted ? "at most " : "", capacity);
+            return -1;
+        }
+
+        struct SConfNode **view = NULL;
+        if (count > 0 && array->packed) {
+            view = sconf_array_view(array, err);
+            if (!view) {
+                return -1;
+            }
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            struct SConfNode *element = view ? view[i] : array->entries[i];
+            if (!element) {
+                sconf_err_set(err, "config node '%s' has no element %zu",
+                              path, i);
+                return -1;
+            }
+
+            if (sconf_bind_store(binding, path, type, element_size, element,
+                                 base + binding->offset + i * element_size,
+                                 err) == -1) {
+                return -1;
+            }
+        }
+    }
+    else if (binding->required) {
+        sconf_err_set(err, "config node '%s' is required", path);
+        return -1;
+    }
+    else if (!binding->counted) {
+        /* Leave the field untouched */
+        return 0;
+    }
+
+    if (binding->counted) {
+        memcpy(base + binding->count_offset, &count, sizeof(size_t));
+    }
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Fill struct from the children of a node.
+ *
+ * @param node     The node the binding paths are relative to, or NULL if it
+ *                 is missing.
+ * @param prefix   Full path of the node (used in error messages).
+ * @param bindings The bindings, terminated by a binding with type 0.
+ * @param base     The struct to fill in.
+ * @param err      Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int sconf_bind_fields(struct SConfNode *node, const char *prefix,
+                             const struct SConfBinding *bindings, char *base,
+                             struct SConfErr *err)
+{
+    for (const struct SConfBinding *binding = bindings; binding->type;
+         binding++)
+    {
+        if (!binding->path) {
+            sconf_err_set(err, "binding in '%s' has no path", prefix);
+            return -1;
+        }
+
+        char path[ERR_MSG_MAX_LEN];
+        snprintf(path, sizeof(path), "%s%s%s", prefix, prefix[0] ? "." : "",
+                 binding->path);
+
+        struct SConfNode *child = NULL;
+        if (node && sconf_get(node, binding->path, &child, err) == -1) {
+            return -1;
+        }
+
+        switch (binding->type)
+        {
+            case SCONF_TYPE_DICT:
+                if (!binding->fields) {
+                    sconf_err_set(err, "binding '%s' has no fields", path);
+                    return -1;
+                }
+                if (child && child->type != SCONF_TYPE_DICT) {
+                    sconf_err_set(err, "config node '%s' is %s not %s", path,
+                                  sconf_type_to_str(child->type),
+                                  sconf_type_to_str(SCONF_TYPE_DICT));
+                    return -1;
+                }
+                if (!child && binding->required) {
+                    sconf_err_set(err, "config node '%s' is required", path);
+                    return -1;
+                }
+                if (sconf_bind_fields(child, path, binding->fields,
+                                      base + binding->offset, err) == -1) {
+                    return -1;
+                }
+                continue;
+            case SCONF_TYPE_ARRAY:
+                if (sconf_bind_array(binding, path, child, base,
+                                     err) == -1) {
+                    return -1;
+                }
+                continue;
+        }
+
+        size_t size = sconf_bind_size(binding->type, binding->size);
+        if (sconf_bind_check_size(path, binding->type, size, err) == -1) {
+            return -1;
+        }
+
+        void *dst = base + binding->offset;
+
+        if (child) {
+            if (sconf_bind_store(binding, path, binding->type, size, child,
+                                 dst, err) == -1) {
+                return -1;
+            }
+        }
+        else if (binding->default_value) {
+            if (sconf_bind_default(binding, path, size, dst, err) == -1) {
+                return -1;
+            }
+        }
+        else if (binding->required) {
+            sconf_err_set(err, "config node '%s' is required", path);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Fill C struct from config.
+ *
+ * @param root     The config root node.
+ * @param bindings The bindings, terminated by a binding with type 0.
+ * @param out      The struct to fill in.
+ * @param err      Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sconf_bind(struct SConfNode *root, const struct SConfBinding *bindings,
+               void *out, struct SConfErr *err)
+{
+    if (!root) {
+        sconf_err_set(err, "no root specified when binding config");
+        return -1;
+    }
+
+    if (!bindings) {
+        sconf_err_set(err, "no bindings specified when binding config");
+        return -1;
+    }
+
+    if (!out) {
+        sconf_err_set(err, "no struct specified when binding config");
+        return -1;
+    }
+
+    if (root->type != SCONF_TYPE_DICT) {
+        sconf_err_set(err, "config root must be a dict");
+        return -1;
+    }
+
+    return sconf_bind_fields(root, "", bindings, out, err);
+}
@@ -1,26 +1,580 @@
 #include <errno.h>
 #include <limits.h>
+#include <locale.h>
 #include <math.h>
+#include <pthread.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
-#include "sconf.h"
+#include "convert.h"
+#include "convert_pow5.h"
 
 #define NUMBER_BASE_OCTAL       8
 #define NUMBER_BASE_DECIMAL     10
 #define NUMBER_BASE_HEXADECIMAL 16
 
+/* Significant decimal digits that always fit in 64 bits */
+#define SCONF_FLOAT_MAX_DIGITS 19
+
+/* Exponents above this are out of range anyway, and are clamped so the
+   exponent can not overflow */
+#define SCONF_FLOAT_MAX_EXPONENT 100000
+
+/* Powers of ten that are exact as doubles */
+static const double sconf_pow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+/* C locale for strtod, so '.' is the decimal point whatever the locale of
+   the process is */
+static locale_t sconf_c_locale;
+static pthread_once_t sconf_c_locale_once = PTHREAD_ONCE_INIT;
+
 /**
- * @brief Convert string to integer.
+ * @internal
+ * @brief Create C locale, see sconf_strtod.
+ */
+static void sconf_c_locale_create(void)
+{
+    sconf_c_locale = newlocale(LC_ALL_MASK, "C", (locale_t)0);
+}
+
+/**
+ * @internal
+ * @brief strtod in the C locale, errno is 0 unless the result is out of
+ * range.
+ */
+static double sconf_strtod(const char *string, char **endptr)
+{
+    pthread_once(&sconf_c_locale_once, &sconf_c_locale_create);
+
+    if (!sconf_c_locale) {
+        errno = 0;
+        return strtod(string, endptr);
+    }
+
+    locale_t locale = uselocale(sconf_c_locale);
+    errno = 0;
+    double fp = strtod(string, endptr);
+    int saved_errno = errno;
+    uselocale(locale);
+    errno = saved_errno;
+
+    return fp;
+}
+
+/**
+ * @internal
+ * @brief Get value of decimal or hexadecimal digit.
  *
- * @param string  String to convert.
+ * @return value of digit, or -1 if c is not a digit.
+ */
+static inline int sconf_digit(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+
+    return -1;
+}
+
+/**
+ * @internal
+ * @brief Check if character is a decimal digit.
+ */
+static inline bool sconf_is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+/**
+ * @internal
+ * @brief Check if string starts with "true", "yes", "on", "false", "no" or
+ * "off".
+ *
+ * @param string  Null terminated string.
+ * @param boolean Pointer to boolean to store result in.
+ *
+ * @return true if string starts with a boolean, false otherwise.
+ */
+static bool sconf_bool_prefix(const char *string, bool *boolean)
+{
+    switch (string[0])
+    {
+        case 't':
+            *boolean = true;
+            return strncmp(string, "true", 4) == 0;
+        case 'y':
+            *boolean = true;
+            return strncmp(string, "yes", 3) == 0;
+        case 'o':
+            *boolean = string[1] == 'n';
+            return *boolean || strncmp(string, "off", 3) == 0;
+        case 'f':
+            *boolean = false;
+            return strncmp(string, "false", 5) == 0;
+        case 'n':
+            *boolean = false;
+            return string[1] == 'o';
+    }
+
+    return false;
+}
+
+/**
+ * @brief Classify scalar in a single pass, following the rules of
+ * sconf_string_to_integer, sconf_string_to_float and sconf_string_to_bool.
+ *
+ * Integers are decimal, hexadecimal ("0x" prefix) or octal ("0" prefix),
+ * floating point numbers are decimal. Forms that are only accepted by
+ * strtoll and strtod (leading whitespace, infinity, NaN, hexadecimal floats,
+ * the empty string) are SCONF_SCALAR_OTHER. Booleans are matched by prefix,
+ * like sconf_string_to_bool does.
+ *
+ * @param string Null terminated string.
+ * @param len    Length of string.
+ *
+ * @return kind of scalar (e.g SCONF_SCALAR_INT).
+ */
+int sconf_scalar_classify(const char *string, size_t len)
+{
+    const char *p = string;
+    const char *end = string + len;
+    bool sign = false;
+
+    if (len == 0) {
+        return SCONF_SCALAR_OTHER;
+    }
+
+    switch (*p)
+    {
+        case '+':
+        case '-':
+            sign = true;
+            p++;
+            break;
+        case ' ':
+        case '\t':
+        case '\n':
+        case '\v':
+        case '\f':
+        case '\r':
+            return SCONF_SCALAR_OTHER;
+    }
+
+    /* Infinity and NaN (in any case) */
+    if (end - p >= 3 &&
+            ((((p[0] | 0x20) == 'i') && ((p[1] | 0x20) == 'n') &&
+              ((p[2] | 0x20) == 'f')) ||
+             (((p[0] | 0x20) == 'n') && ((p[1] | 0x20) == 'a') &&
+              ((p[2] | 0x20) == 'n')))) {
+        return SCONF_SCALAR_OTHER;
+    }
+
+    if (end - p > 1 && p[0] == '0') {
+        if (p[1] == 'x' || p[1] == 'X') {
+            /* Signed or with 'X' only strtod reads it, as hexadecimal
+               float */
+            if (sign || p[1] == 'X' || end - p == 2) {
+                return SCONF_SCALAR_OTHER;
+            }
+            for (const char *q = p + 2; q < end; q++)
+            {
+                if (sconf_digit(*q) == -1) {
+                    return SCONF_SCALAR_OTHER;
+                }
+            }
+            return SCONF_SCALAR_HEX;
+        }
+
+        if (!sign) {
+            const char *q = p + 1;
+            while (q < end && *q >= '0' && *q <= '7')
+            {
+                q++;
+            }
+            if (q == end) {
+                return SCONF_SCALAR_OCTAL;
+            }
+        }
+    }
+
+    const char *digits = p;
+    while (p < end && sconf_is_digit(*p))
+    {
+        p++;
+    }
+
+    size_t mantissa = p - digits;
+    if (p == end && mantissa > 0) {
+        /* Leading zero selects octal, so "09" is only a float */
+        if (!sign && mantissa > 1 && digits[0] == '0') {
+            return SCONF_SCALAR_FLOAT;
+        }
+        return SCONF_SCALAR_INT;
+    }
+
+    if (p < end && *p == '.') {
+        const char *fraction = ++p;
+        while (p < end && sconf_is_digit(*p))
+        {
+            p++;
+        }
+        mantissa += p - fraction;
+    }
+
+    if (mantissa > 0 && p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        if (p < end && (*p == '+' || *p == '-')) {
+            p++;
+        }
+        const char *exponent = p;
+        while (p < end && sconf_is_digit(*p))
+        {
+            p++;
+        }
+        if (p == exponent) {
+            /* strtod stops before the 'e' */
+            mantissa = 0;
+        }
+    }
+
+    if (mantissa > 0 && p == end) {
+        return SCONF_SCALAR_FLOAT;
+    }
+
+    bool boolean;
+    if (sconf_bool_prefix(string, &boolean)) {
+        return SCONF_SCALAR_BOOL;
+    }
+
+    return SCONF_SCALAR_STR;
+}
+
+/**
+ * @internal
+ * @brief Set error for integer out of range.
+ */
+static int sconf_integer_range_err(bool negative, int64_t *integer,
+                                   struct SConfErr *err)
+{
+    if (negative) {
+        *integer = LLONG_MIN;
+        sconf_err_set(err, "integer value underflow detected");
+    }
+    else {
+        *integer = LLONG_MAX;
+        sconf_err_set(err, "integer value overflow detected");
+    }
+
+    return -1;
+}
+
+/**
+ * @internal
+ * @brief Set error for floating point number out of range.
+ */
+static int sconf_float_range_err(double fp, struct SConfErr *err)
+{
+    if (fp == HUGE_VAL) {
+        sconf_err_set(err, "floating-point number overflow detected");
+    }
+    else {
+        sconf_err_set(err, "floating-point number underflow detected");
+    }
+
+    return -1;
+}
+
+/**
+ * @internal
+ * @brief Parse digits of classified integer.
+ *
+ * @param p       Start of integer, after any prefix (optionally signed).
+ * @param end     End of integer.
+ * @param base    Base of digits.
  * @param integer Pointer to integer to store result in.
+ * @param err     Pointer to error struct.
+ *
+ * @return 1 on success, -1 if integer is out of range.
+ */
+static int sconf_parse_integer(const char *p, const char *end, int base,
+                               int64_t *integer, struct SConfErr *err)
+{
+    bool negative = false;
+
+    if (p < end && (*p == '+' || *p == '-')) {
+        negative = *p == '-';
+        p++;
+    }
+
+    uint64_t limit = negative ? (uint64_t)INT64_MAX + 1 : INT64_MAX;
+    uint64_t value = 0;
+
+    for (; p < end; p++)
+    {
+        if (__builtin_mul_overflow(value, (uint64_t)base, &value) ||
+                __builtin_add_overflow(value, (uint64_t)sconf_digit(*p),
+                                       &value) ||
+                value > limit) {
+            return sconf_integer_range_err(negative, integer, err);
+        }
+    }
+
+    if (negative) {
+        *integer = value == limit ? INT64_MIN : -(int64_t)value;
+    }
+    else {
+        *integer = (int64_t)value;
+    }
+
+    return 1;
+}
+
+/**
+ * @internal
+ * @brief Multiply 64-bit integers into 128-bit product.
+ *
+ * @return high 64 bits of product, the low 64 bits are stored in low.
+ */
+static inline uint64_t sconf_mul128(uint64_t a, uint64_t b, uint64_t *low)
+{
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 product = (unsigned __int128)a * b;
+    *low = (uint64_t)product;
+    return (uint64_t)(product >> 64);
+#else
+    uint64_t a_lo = (uint32_t)a;
+    uint64_t a_hi = a >> 32;
+    uint64_t b_lo = (uint32_t)b;
+    uint64_t b_hi = b >> 32;
+    uint64_t lo_lo = a_lo * b_lo;
+    uint64_t hi_lo = a_hi * b_lo;
+    uint64_t lo_hi = a_lo * b_hi;
+    uint64_t hi_hi = a_hi * b_hi;
+    uint64_t cross = (lo_lo >> 32) + (uint32_t)hi_lo + lo_hi;
+    *low = (cross << 32) | (uint32_t)lo_lo;
+    return (hi_lo >> 32) + (cross >> 32) + hi_hi;
+#endif
+}
+
+/**
+ * @internal
+ * @brief Compute w * 10^q as correctly rounded double.
+ *
+ * Small values are computed exactly with a single multiplication or
+ * division (Clinger's fast path), others with the Eisel-Lemire algorithm,
+ * which multiplies w by a 128-bit approximation of 5^q.
+ *
+ * @param w        Decimal significand (at most 19 digits).
+ * @param q        Decimal exponent.
+ * @param negative true if the number is negative.
+ * @param fp       Pointer to floating point number to store result in.
+ *
+ * @return true on success, false if the result is not a normal finite
+ * number.
+ */
+static bool sconf_float_compute(uint64_t w, int64_t q, bool negative,
+                                double *fp)
+{
+    if (w == 0) {
+        *fp = negative ? -0.0 : 0.0;
+        return true;
+    }
+
+    if (q >= -22 && q <= 22 && w <= (1ULL << 53)) {
+        double d = (double)w;
+        d = q < 0 ? d / sconf_pow10[-q] : d * sconf_pow10[q];
+        *fp = negative ? -d : d;
+        return true;
+    }
+
+    if (q < SCONF_POW5_MIN_EXPONENT || q > SCONF_POW5_MAX_EXPONENT) {
+        return false;
+    }
+
+    int lz = __builtin_clzll(w);
+    w <<= lz;
+
+    /* Only the top 55 bits of the product are needed, the low part of the
+       power is only used if they may be off by one */
+    const uint64_t *pow5 = sconf_pow5_128[q - SCONF_POW5_MIN_EXPONENT];
+    uint64_t low;
+    uint64_t high = sconf_mul128(w, pow5[0], &low);
+    if ((high & 0x1FF) == 0x1FF) {
+        uint64_t low2;
+        uint64_t high2 = sconf_mul128(w, pow5[1], &low2);
+        low += high2;
+        if (high2 > low) {
+            high++;
+        }
+    }
+
+    int upperbit = (int)(high >> 63);
+    int shift = upperbit + 9;
+    uint64_t mantissa = high >> shift;
+    int64_t power2 = ((217706 * q) >> 16) + 63 + upperbit - lz + 1023;
+
+    if (power2 <= 0) {
+        /* Subnormal */
+        return false;
+    }
+
+    /* Halfway between two doubles, round to even */
+    if (low <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 &&
+            (mantissa << shift) == high) {
+        mantissa &= ~1ULL;
+    }
+
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+    if (mantissa >= (2ULL << 52)) {
+        mantissa = 1ULL << 52;
+        power2++;
+    }
+    mantissa &= ~(1ULL << 52);
+
+    if (power2 >= 0x7FF) {
+        return false;
+    }
+
+    uint64_t bits = mantissa | ((uint64_t)power2 << 52) |
+                    ((uint64_t)negative << 63);
+    memcpy(fp, &bits, sizeof(*fp));
+
+    return true;
+}
+
+/**
+ * @internal
+ * @brief Convert string to floating point number with strtod.
+ *
+ * @return 1 if string is floating point number, 0 if not, or -1 on error.
+ */
+static int sconf_float_fallback(const char *string, double *fp,
+                                struct SConfErr *err)
+{
+    char *endptr;
+    *fp = sconf_strtod(string, &endptr);
+    if (*endptr != '\0') {
+        return 0;
+    }
+
+    if (errno == ERANGE) {
+        return sconf_float_range_err(*fp, err);
+    }
+
+    return 1;
+}
+
+/**
+ * @internal
+ * @brief Parse classified decimal floating point number (or integer).
+ *
+ * Numbers with more than 19 significant digits, and results that are
+ * subnormal or out of range, are left to strtod.
+ *
+ * @param string Null terminated string.
+ * @param end    End of string.
+ * @param fp     Pointer to floating point number to store result in.
+ * @param err    Pointer to error struct.
+ *
+ * @return 1 on success, -1 if number is out of range.
+ */
+static int sconf_parse_float(const char *string, const char *end, double *fp,
+                             struct SConfErr *err)
+{
+    const char *p = string;
+    bool negative = false;
+
+    if (p < end && (*p == '+' || *p == '-')) {
+        negative = *p == '-';
+        p++;
+    }
+
+    uint64_t w = 0;
+    int64_t q = 0;
+    int digits = 0;
+    bool truncated = false;
+
+    while (p < end && *p == '0')
+    {
+        p++;
+    }
+
+    for (; p < end && sconf_is_digit(*p); p++)
+    {
+        if (digits < SCONF_FLOAT_MAX_DIGITS) {
+            w = w * 10 + (uint64_t)(*p - '0');
+            digits++;
+        }
+        else {
+            q++;
+            truncated |= *p != '0';
+        }
+    }
+
+    if (p < end && *p == '.') {
+        p++;
+        if (digits == 0) {
+            for (; p < end && *p == '0'; p++)
+            {
+                q--;
+            }
+        }
+        for (; p < end && sconf_is_digit(*p); p++)
+        {
+            if (digits < SCONF_FLOAT_MAX_DIGITS) {
+                w = w * 10 + (uint64_t)(*p - '0');
+                digits++;
+                q--;
+            }
+            else {
+                truncated |= *p != '0';
+            }
+        }
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        bool negative_exponent = false;
+        if (p < end && (*p == '+' || *p == '-')) {
+            negative_exponent = *p == '-';
+            p++;
+        }
+        int64_t exponent = 0;
+        for (; p < end; p++)
+        {
+            if (exponent < SCONF_FLOAT_MAX_EXPONENT) {
+                exponent = exponent * 10 + (*p - '0');
+            }
+        }
+        q += negative_exponent ? -exponent : exponent;
+    }
+
+    if (!truncated && sconf_float_compute(w, q, negative, fp)) {
+        return 1;
+    }
+
+    return sconf_float_fallback(string, fp, err);
+}
+
+/**
+ * @internal
+ * @brief Convert string to integer with strtoll.
  *
  * @return 1 if string is integer, 0 if not, or -1 on error.
  */
-int sconf_string_to_integer(const char *string, int64_t *integer,
-                            struct SConfErr *err)
+static int sconf_integer_fallback(const char *string, int64_t *integer,
+                                  struct SConfErr *err)
 {
     errno = 0;
     int base = NUMBER_BASE_DECIMAL;
@@ -39,18 +593,44 @@ int sconf_string_to_integer(const char *string, int64_t *integer,
     }
 
     if (errno == ERANGE) {
-        if (*integer == LLONG_MAX) {
-            sconf_err_set(err, "integer value overflow detected");
-        }
-        else {
-            sconf_err_set(err, "integer value underflow detected");
-        }
-        return -1;
+        return sconf_integer_range_err(*integer != LLONG_MAX, integer, err);
     }
 
     return 1;
 }
 
+/**
+ * @brief Convert string to integer.
+ *
+ * @param string  String to convert.
+ * @param integer Pointer to integer to store result in.
+ *
+ * @return 1 if string is integer, 0 if not, or -1 on error.
+ */
+int sconf_string_to_integer(const char *string, int64_t *integer,
+                            struct SConfErr *err)
+{
+    size_t len = strlen(string);
+    const char *end = string + len;
+
+    switch (sconf_scalar_classify(string, len))
+    {
+        case SCONF_SCALAR_INT:
+            return sconf_parse_integer(string, end, NUMBER_BASE_DECIMAL,
+                                       integer, err);
+        case SCONF_SCALAR_HEX:
+            return sconf_parse_integer(string + 2, end,
+                                       NUMBER_BASE_HEXADECIMAL, integer, err);
+        case SCONF_SCALAR_OCTAL:
+            return sconf_parse_integer(string, end, NUMBER_BASE_OCTAL,
+                                       integer, err);
+        case SCONF_SCALAR_OTHER:
+            return sconf_integer_fallback(string, integer, err);
+    }
+
+    return 0;
+}
+
 /**
  * @brief Convert string to floating point number.
  *
@@ -62,25 +642,21 @@ int sconf_string_to_integer(const char *string, int64_t *integer,
  */
 int sconf_string_to_float(const char *string, double *fp, struct SConfErr *err)
 {
-    errno = 0;
-
-    char *endptr;
-    *fp = strtod(string, &endptr);
-    if (*endptr != '\0') {
-        return 0;
-    }
+    size_t len = strlen(string);
 
-    if (errno == ERANGE) {
-        if (*fp == HUGE_VAL) {
-            sconf_err_set(err, "floating-point number overflow detected");
-        }
-        else {
-            sconf_err_set(err, "floating-point number underflow detected");
-        }
-        return -1;
+    switch (sconf_scalar_classify(string, len))
+    {
+        /* Leading zeros of octal integers are decimal for strtod */
+        case SCONF_SCALAR_INT:
+        case SCONF_SCALAR_OCTAL:
+        case SCONF_SCALAR_FLOAT:
+            return sconf_parse_float(string, string + len, fp, err);
+        case SCONF_SCALAR_HEX:
+        case SCONF_SCALAR_OTHER:
+            return sconf_float_fallback(string, fp, err);
     }
 
-    return 1;
+    return 0;
 }
 
 /**
@@ -94,20 +670,71 @@ int sconf_string_to_float(const char *string, double *fp, struct SConfErr *err)
  */
 int sconf_string_to_bool(const char *string, bool *boolean)
 {
-    if ((strncmp(string, "true", 4) == 0) ||
-            (strncmp(string, "yes", 3) == 0) ||
-            (strncmp(string, "on", 2) == 0)) {
-        *boolean = true;
-        return 1;
+    return sconf_bool_prefix(string, boolean) ? 1 : 0;
+}
+
+/**
+ * @brief Convert string to integer, floating point number or boolean, in
+ * that order of preference.
+ *
+ * Same as trying sconf_string_to_integer, sconf_string_to_float and
+ * sconf_string_to_bool in turn, but the string is only classified once.
+ *
+ * @param string Null terminated string to convert.
+ * @param len    Length of string.
+ * @param scalar Pointer to scalar to store result in, the type is
+ *               SCONF_TYPE_STR if the string is not converted.
+ * @param err    Pointer to error struct.
+ *
+ * @return 1 if string is converted, 0 if not, or -1 on error.
+ */
+int sconf_string_to_scalar(const char *string, size_t len,
+                           struct SConfScalar *scalar, struct SConfErr *err)
+{
+    const char *end = string + len;
+    int r = 0;
+
+    switch (sconf_scalar_classify(string, len))
+    {
+        case SCONF_SCALAR_INT:
+            scalar->type = SCONF_TYPE_INT;
+            r = sconf_parse_integer(string, end, NUMBER_BASE_DECIMAL,
+                                    &scalar->integer, err);
+            break;
+        case SCONF_SCALAR_HEX:
+            scalar->type = SCONF_TYPE_INT;
+            r = sconf_parse_integer(string + 2, end, NUMBER_BASE_HEXADECIMAL,
+                                    &scalar->integer, err);
+            break;
+        case SCONF_SCALAR_OCTAL:
+            scalar->type = SCONF_TYPE_INT;
+            r = sconf_parse_integer(string, end, NUMBER_BASE_OCTAL,
+                                    &scalar->integer, err);
+            break;
+        case SCONF_SCALAR_FLOAT:
+            scalar->type = SCONF_TYPE_FLOAT;
+            r = sconf_parse_float(string, end, &scalar->fp, err);
+            break;
+        case SCONF_SCALAR_BOOL:
+            scalar->type = SCONF_TYPE_BOOL;
+            r = sconf_string_to_bool(string, &scalar->boolean);
+            break;
+        case SCONF_SCALAR_OTHER:
+            if ((r = sconf_integer_fallback(string, &scalar->integer, err))) {
+                scalar->type = SCONF_TYPE_INT;
+            }
+            else if ((r = sconf_float_fallback(string, &scalar->fp, err))) {
+                scalar->type = SCONF_TYPE_FLOAT;
+            }
+            else if ((r = sconf_string_to_bool(string, &scalar->boolean))) {
+                scalar->type = SCONF_TYPE_BOOL;
+            }
+            break;
     }
 
-    if ((strncmp(string, "false", 5) == 0) ||
-            (strncmp(string, "no", 2) == 0) ||
-            (strncmp(string, "off", 3) == 0)) {
-        *boolean = false;
-        return 1;
+    if (r == 0) {
+        scalar->type = SCONF_TYPE_STR;
     }
 
-    return 0;
+    return r;
 }
-
@@ -1,8 +1,33 @@
 #pragma once
 
+#include <stddef.h>
+
 #include "sconf.h"
 
+/* Kinds of scalars, see sconf_scalar_classify */
+enum {
+    SCONF_SCALAR_STR = 0,
+    SCONF_SCALAR_INT,    /* decimal integer, optionally signed */
+    SCONF_SCALAR_HEX,    /* 0x followed by hexadecimal digits */
+    SCONF_SCALAR_OCTAL,  /* 0 followed by octal digits */
+    SCONF_SCALAR_FLOAT,  /* decimal floating point number */
+    SCONF_SCALAR_BOOL,
+    SCONF_SCALAR_OTHER,  /* left to strtoll/strtod (e.g " 1", "inf", "0x1p3") */
+};
+
+/* Scalar converted to integer, floating point number, boolean or string */
+struct SConfScalar {
+    uint8_t type;
+    union {
+        int64_t integer;
+        double fp;
+        bool boolean;
+    };
+};
+
+int sconf_scalar_classify(const char *string, size_t len);
+int sconf_string_to_scalar(const char *string, size_t len,
+                           struct SConfScalar *scalar, struct SConfErr *err);
 int sconf_string_to_integer(const char *, int64_t *, struct SConfErr *);
 int sconf_string_to_float(const char *, double *, struct SConfErr *);
 int sconf_string_to_bool(const char *, bool *);
-
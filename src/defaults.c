@@ -185,23 +185,29 @@ static int sconf_defaults_handle_bool(struct SConfNode *root,
  * @internal
  * @brief Apply default YAML file.
  *
- * @param root The config root node.
- * @param curr Config node entry.
- * @param err  Pointer to error struct.
+ * @param root  The config root node.
+ * @param view  The config root node used to check if the path is set.
+ * @param files The config root node to read the YAML file into.
+ * @param curr  Config node entry.
+ * @param err   Pointer to error struct.
  *
  * @return 0 on success, -1 otherwise.
  */
 static int sconf_defaults_handle_yaml_file(struct SConfNode *root,
+                                           struct SConfNode *view,
+                                           struct SConfNode *files,
                                            const struct SConfMap *curr,
                                            struct SConfErr *err)
 {
     assert(root);
+    assert(view);
+    assert(files);
     assert(curr);
     assert(curr->path);
     assert(curr->default_value);
 
     const char *string;
-    int r = sconf_get_str(root, curr->path, &string, err);
+    int r = sconf_get_str(view, curr->path, &string, err);
     if (r == -1) {
         return -1;
     }
@@ -210,7 +216,7 @@ static int sconf_defaults_handle_yaml_file(struct SConfNode *root,
         return 0;
     }
 
-    if (sconf_yaml_read(root, curr->default_value, err) == -1) {
+    if (sconf_yaml_read(files, curr->default_value, err) == -1) {
         return -1;
     }
     if (sconf_set_str(root, curr->path, curr->default_value, err) == -1) {
@@ -232,7 +238,27 @@ static int sconf_defaults_handle_yaml_file(struct SConfNode *root,
 int sconf_defaults(struct SConfNode *root, const struct SConfMap *map,
                    struct SConfErr *err)
 {
-    if (!root) {
+    return sconf_defaults_into(root, root, root, map, err);
+}
+
+/**
+ * @brief Apply configuration defaults, reading YAML files into a separate
+ * config tree.
+ *
+ * @param root  The config root node.
+ * @param view  The config root node used to check if a YAML file path is
+ *              already set.
+ * @param files The config root node to read YAML files into.
+ * @param map   Config map.
+ * @param err   Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sconf_defaults_into(struct SConfNode *root, struct SConfNode *view,
+                        struct SConfNode *files, const struct SConfMap *map,
+                        struct SConfErr *err)
+{
+    if (!root || !view || !files) {
         sconf_err_set(err, "no root specified when applying defaults");
         return -1;
     }
@@ -281,7 +307,8 @@ int sconf_defaults(struct SConfNode *root, const struct SConfMap *map,
                 break;
 
             case SCONF_TYPE_YAML_FILE:
-                if (sconf_defaults_handle_yaml_file(root, entry, err) == -1) {
+                if (sconf_defaults_handle_yaml_file(root, view, files, entry,
+                                                    err) == -1) {
                     return -1;
                 }
                 break;
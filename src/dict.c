@@ -0,0 +1,409 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "art.h"
+#include "dict.h"
+#include "freeze.h"
+#include "sconf.h"
+#include "sconf_private.h"
+
+/* Struct only used to pass needed pointers to art_iter callback when
+   implementing dictionary iterator. */
+struct SConfDictIterData {
+    int (*cb)(const unsigned char *, struct SConfNode *, void *,
+              struct SConfErr *);
+    void *user;
+    struct SConfErr *err;
+};
+
+/**
+ * @internal
+ * @brief Initialize ART for dictionary.
+ *
+ * @param dict The dictionary node.
+ * @param tree The tree to initialize.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int sconf_dict_tree_init(const struct SConfNode *dict, art_tree *tree)
+{
+    if (dict->arena) {
+        return art_tree_init_allocator(tree, &dict->arena->art);
+    }
+
+    return art_tree_init(tree);
+}
+
+/**
+ * @brief Initialize dictionary config node.
+ *
+ * Dictionaries start out small, and are moved to an ART when they grow.
+ *
+ * @param dict The dictionary node.
+ * @param err  Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sconf_dict_init(struct SConfNode *dict, struct SConfErr *err)
+{
+    assert(dict);
+    assert(dict->type == SCONF_TYPE_DICT);
+
+    (void)err;
+
+    dict->flags &= ~SCONF_NODE_FLAG_DICT_TREE;
+    dict->small.entries = NULL;
+    dict->small.count = 0;
+    dict->small.keys_len = 0;
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Free the entries of a small dictionary, but not the child nodes.
+ *
+ * @param dict The dictionary node.
+ */
+static void sconf_small_dict_free(struct SConfNode *dict)
+{
+    struct SConfSmallDict *small = &dict->small;
+
+    sconf_arena_free(dict->arena, small->entries);
+
+    small->entries = NULL;
+    small->count = 0;
+    small->keys_len = 0;
+}
+
+/**
+ * @internal
+ * @brief Callback function to iterate used when destroying dictionary.
+ *
+ * @param data    User-supplied data.
+ * @param key     Key from dictionary.
+ * @param key_len Length of the key.
+ * @param value   Value from dictionary.
+ *
+ * @return 0 on success.
+ */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static int sconf_dict_destroy_iter_cb(void *data, const unsigned char *key,
+                                      uint32_t key_len, void *value)
+{
+    assert(key);
+    assert(value);
+
+    struct SConfNode *node = (struct SConfNode *)value;
+
+    sconf_node_destroy(node);
+
+    return 0;
+}
+#pragma GCC diagnostic pop
+
+/**
+ * @brief Destroy dictionary and all nodes in it.
+ *
+ * @param dict The dictionary node.
+ */
+void sconf_dict_destroy(struct SConfNode *dict)
+{
+    assert(dict);
+    assert(dict->type == SCONF_TYPE_DICT);
+
+    if (dict->flags & SCONF_NODE_FLAG_DICT_TREE) {
+        art_iter(&dict->dictionary, sconf_dict_destroy_iter_cb, NULL);
+        art_tree_destroy(&dict->dictionary);
+        return;
+    }
+
+    for (uint32_t i = 0; i < dict->small.count; i++)
+    {
+        sconf_node_destroy(dict->small.entries[i].node);
+    }
+
+    sconf_small_dict_free(dict);
+}
+
+/**
+ * @internal
+ * @brief Move small dictionary into an ART.
+ *
+ * @param dict The dictionary node.
+ * @param err  Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int sconf_dict_upgrade(struct SConfNode *dict, struct SConfErr *err)
+{
+    art_tree tree;
+    if (sconf_dict_tree_init(dict, &tree) != 0) {
+        sconf_err_set(err, "failed to create dict node tree");
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < dict->small.count; i++)
+    {
+        const struct SConfDictEntry *entry = &dict->small.entries[i];
+        art_insert(&tree,
+                   (const unsigned char *)sconf_small_dict_name(&dict->small,
+                                                                i),
+                   (int)entry->len, entry->node);
+    }
+
+    /* The tree and the small dictionary share memory in the node */
+    sconf_small_dict_free(dict);
+
+    dict->dictionary = tree;
+    dict->flags |= SCONF_NODE_FLAG_DICT_TREE;
+
+    return 0;
+}
+
+/**
+ * @brief Add child node to dictionary.
+ *
+ * @param dict     The dictionary node.
+ * @param name     Name of the child (not null terminated).
+ * @param name_len Length of name.
+ * @param node     Config node to add.
+ * @param err      Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sconf_dict_add(struct SConfNode *dict, const char *name, uint32_t name_len,
+                   struct SConfNode *node, struct SConfErr *err)
+{
+    assert(dict);
+    assert(dict->type == SCONF_TYPE_DICT);
+    assert(!(dict->flags & SCONF_NODE_FLAG_FROZEN));
+
+    struct SConfSmallDict *small = &dict->small;
+
+    if (!(dict->flags & SCONF_NODE_FLAG_DICT_TREE)) {
+        /* Keep the entries sorted, so iteration order matches the ART */
+        uint32_t pos = 0;
+        while (pos < small->count)
+        {
+            int r = sconf_frozen_key_cmp(sconf_small_dict_name(small, pos),
+                                         small->entries[pos].len, name,
+                                         name_len);
+            if (r == 0) {
+                sconf_err_set(err, "inserting node into dict failed");
+                return -1;
+            }
+            if (r > 0) {
+                break;
+            }
+            pos++;
+        }
+
+        if (small->count < SCONF_DICT_SMALL_MAX &&
+                (uint64_t)small->keys_len + name_len < UINT32_MAX) {
+            /* Grows by exactly one entry and one key, which is cheap since
+               the dictionary is small */
+            size_t size = small->count * sizeof(struct SConfDictEntry) +
+                          small->keys_len;
+            struct SConfDictEntry *entries = sconf_arena_realloc(
+                dict->arena, small->entries, size,
+                size + sizeof(struct SConfDictEntry) + name_len + 1);
+            if (!entries) {
+                sconf_err_set(err, "failed to allocate memory for dict");
+                return -1;
+            }
+
+            /* Move the key bytes to make room for the new entry */
+            char *keys = (char *)(entries + small->count + 1);
+            memmove(keys, entries + small->count, small->keys_len);
+            memcpy(keys + small->keys_len, name, name_len);
+            keys[small->keys_len + name_len] = '\0';
+
+            memmove(&entries[pos + 1], &entries[pos],
+                    (small->count - pos) * sizeof(struct SConfDictEntry));
+            entries[pos].name = small->keys_len;
+            entries[pos].len = name_len;
+            entries[pos].node = node;
+
+            small->entries = entries;
+            small->count++;
+            small->keys_len += name_len + 1;
+
+            return 0;
+        }
+
+        if (sconf_dict_upgrade(dict, err) == -1) {
+            return -1;
+        }
+    }
+
+    /* art_insert replaces the value of an existing key */
+    if (art_search(&dict->dictionary, (const unsigned char *)name,
+                   (int)name_len)) {
+        sconf_err_set(err, "inserting node into dict failed");
+        return -1;
+    }
+
+    art_insert(&dict->dictionary, (const unsigned char *)name, (int)name_len,
+               node);
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief art_iter callback function used when iterating over dictionary.
+ *
+ * @param data    User-supplied data.
+ * @param key     Key from dictionary.
+ * @param key_len Length of the key.
+ * @param value   Value from dictionary.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static int sconf_dict_foreach_iter_cb(void *data, const unsigned char *key,
+                                      uint32_t key_len, void *value)
+{
+    assert(data);
+    assert(key);
+    assert(value);
+
+    struct SConfDictIterData *iter_data = (struct SConfDictIterData *)data;
+    struct SConfNode *node = (struct SConfNode *)value;
+
+    if (iter_data->cb(key, node, iter_data->user, iter_data->err) != 0) {
+        return -1;
+    }
+
+    return 0;
+}
+#pragma GCC diagnostic pop
+
+/**
+ * @brief Iterate over all nodes in a dictionary that is not frozen, in key
+ *        order.
+ *
+ * @param dict The dictionary node.
+ * @param cb   Callback function.
+ * @param user User-supplied data passed to callback function.
+ * @param err  Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sconf_dict_foreach(struct SConfNode *dict,
+                       int (*cb)(const unsigned char *name,
+                                 struct SConfNode *node, void *user,
+                                 struct SConfErr *err),
+                       void *user, struct SConfErr *err)
+{
+    assert(dict);
+    assert(!(dict->flags & SCONF_NODE_FLAG_FROZEN));
+
+    if (dict->flags & SCONF_NODE_FLAG_DICT_TREE) {
+        struct SConfDictIterData iter_data = { cb, user, err };
+        return art_iter(&dict->dictionary, sconf_dict_foreach_iter_cb,
+                        &iter_data) != 0 ? -1 : 0;
+    }
+
+    for (uint32_t i = 0; i < dict->small.count; i++)
+    {
+        const struct SConfDictEntry *entry = &dict->small.entries[i];
+        if (cb((const unsigned char *)sconf_small_dict_name(&dict->small, i),
+               entry->node, user, err) != 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Replace the child of an existing key in dictionary.
+ *
+ * @param dict     The dictionary node.
+ * @param name     Name of the child (not null terminated).
+ * @param name_len Length of name.
+ * @param node     Config node replacing the child.
+ *
+ * @return the replaced child, NULL if the key does not exist.
+ */
+struct SConfNode *sconf_dict_replace(struct SConfNode *dict, const char *name,
+                                     uint32_t name_len, struct SConfNode *node)
+{
+    assert(dict);
+    assert(dict->type == SCONF_TYPE_DICT);
+    assert(!(dict->flags & SCONF_NODE_FLAG_FROZEN));
+
+    if (dict->flags & SCONF_NODE_FLAG_DICT_TREE) {
+        if (!art_search(&dict->dictionary, (const unsigned char *)name,
+                        (int)name_len)) {
+            return NULL;
+        }
+        return art_insert(&dict->dictionary, (const unsigned char *)name,
+                          (int)name_len, node);
+    }
+
+    struct SConfSmallDict *small = &dict->small;
+
+    for (uint32_t i = 0; i < small->count; i++)
+    {
+        struct SConfDictEntry *entry = &small->entries[i];
+        if (entry->len == name_len &&
+                memcmp(sconf_small_dict_name(small, i), name, name_len) == 0) {
+            struct SConfNode *replaced = entry->node;
+            entry->node = node;
+            return replaced;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Get number of children in dictionary that is not frozen.
+ *
+ * @param dict The dictionary node.
+ *
+ * @return number of children.
+ */
+uint64_t sconf_dict_count(struct SConfNode *dict)
+{
+    assert(dict);
+    assert(dict->type == SCONF_TYPE_DICT);
+    assert(!(dict->flags & SCONF_NODE_FLAG_FROZEN));
+
+    if (dict->flags & SCONF_NODE_FLAG_DICT_TREE) {
+        return art_size(&dict->dictionary);
+    }
+
+    return dict->small.count;
+}
+
+/**
+ * @brief Remove all children from dictionary, without destroying them.
+ *
+ * The children must be owned by someone else, e.g. moved to another
+ * dictionary.
+ *
+ * @param dict The dictionary node.
+ */
+void sconf_dict_release(struct SConfNode *dict)
+{
+    assert(dict);
+    assert(dict->type == SCONF_TYPE_DICT);
+    assert(!(dict->flags & SCONF_NODE_FLAG_FROZEN));
+
+    if (dict->flags & SCONF_NODE_FLAG_DICT_TREE) {
+        art_tree_destroy(&dict->dictionary);
+        sconf_dict_init(dict, NULL);
+        return;
+    }
+
+    sconf_small_dict_free(dict);
+}
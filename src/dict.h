@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include "art.h"
+#include "freeze.h"
+#include "sconf.h"
+#include "sconf_private.h"
+
+/* Dictionaries with more entries than this are stored in an ART */
+#ifndef SCONF_DICT_SMALL_MAX
+#define SCONF_DICT_SMALL_MAX 8
+#endif
+
+int sconf_dict_init(struct SConfNode *dict, struct SConfErr *err);
+void sconf_dict_destroy(struct SConfNode *dict);
+int sconf_dict_add(struct SConfNode *dict, const char *name, uint32_t name_len,
+                   struct SConfNode *node, struct SConfErr *err);
+struct SConfNode *sconf_dict_replace(struct SConfNode *dict, const char *name,
+                                     uint32_t name_len, struct SConfNode *node);
+uint64_t sconf_dict_count(struct SConfNode *dict);
+void sconf_dict_release(struct SConfNode *dict);
+int sconf_dict_foreach(struct SConfNode *dict,
+                       int (*cb)(const unsigned char *name,
+                                 struct SConfNode *node, void *user,
+                                 struct SConfErr *err),
+                       void *user, struct SConfErr *err);
+
+/**
+ * @brief Get name of entry in small dictionary.
+ *
+ * @param dict  The small dictionary.
+ * @param index Index of the entry.
+ *
+ * @return the null terminated name.
+ */
+static inline const char *sconf_small_dict_name(
+        const struct SConfSmallDict *dict, uint32_t index)
+{
+    return (const char *)(dict->entries + dict->count) +
+           dict->entries[index].name;
+}
+
+/**
+ * @brief Look up child in small dictionary using linear search.
+ *
+ * @param dict     The small dictionary.
+ * @param name     Name of the child (not null terminated).
+ * @param name_len Length of name.
+ *
+ * @return Pointer to node if found, NULL otherwise.
+ */
+static inline struct SConfNode *sconf_small_dict_lookup(
+        const struct SConfSmallDict *dict, const char *name, uint32_t name_len)
+{
+    for (uint32_t i = 0; i < dict->count; i++)
+    {
+        const struct SConfDictEntry *entry = &dict->entries[i];
+        if (entry->len == name_len &&
+                memcmp(sconf_small_dict_name(dict, i), name, name_len) == 0) {
+            return entry->node;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Look up child in dictionary, whichever way it is stored.
+ *
+ * @param dict     The dictionary node.
+ * @param name     Name of the child (not null terminated).
+ * @param name_len Length of name.
+ *
+ * @return Pointer to node if found, NULL otherwise.
+ */
+static inline struct SConfNode *sconf_dict_lookup(struct SConfNode *dict,
+                                                  const char *name,
+                                                  uint32_t name_len)
+{
+    if (dict->flags & SCONF_NODE_FLAG_FROZEN) {
+        return sconf_frozen_dict_lookup(dict, name, name_len);
+    }
+
+    if (dict->flags & SCONF_NODE_FLAG_DICT_TREE) {
+        return (struct SConfNode *)art_search(&dict->dictionary,
+                                              (const unsigned char *)name,
+                                              (int)name_len);
+    }
+
+    return sconf_small_dict_lookup(&dict->small, name, name_len);
+}
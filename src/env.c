@@ -151,20 +151,23 @@ static int sconf_env_set_bool(struct SConfNode *root, const char *path,
  * @brief Read YAML file from environment variable.
  *
  * @param root  The config root node.
+ * @param files The config root node to read the YAML file into.
  * @param path  Path to config node.
  * @param value Value of environment variable.
  * @param err   Pointer to error struct.
  *
  * @return 0 on success, -1 otherwise.
  */
-static int sconf_env_yaml_file(struct SConfNode *root, const char *path,
-                               const char *value, struct SConfErr *err)
+static int sconf_env_yaml_file(struct SConfNode *root, struct SConfNode *files,
+                               const char *path, const char *value,
+                               struct SConfErr *err)
 {
     assert(root);
+    assert(files);
     assert(path);
     assert(value);
 
-    if (sconf_yaml_read(root, value, err) == -1) {
+    if (sconf_yaml_read(files, value, err) == -1) {
         return -1;
     }
     if (sconf_set_str(root, path, value, err) == -1) {
@@ -186,7 +189,24 @@ static int sconf_env_yaml_file(struct SConfNode *root, const char *path,
 int sconf_env_read(struct SConfNode *root, const struct SConfMap *map,
                    struct SConfErr *err)
 {
-    if (!root) {
+    return sconf_env_read_into(root, root, map, err);
+}
+
+/**
+ * @brief Read environment variables based on config map, reading YAML files
+ * into a separate config tree.
+ *
+ * @param root  The config root node.
+ * @param files The config root node to read YAML files into.
+ * @param map   Config map.
+ * @param err   Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sconf_env_read_into(struct SConfNode *root, struct SConfNode *files,
+                        const struct SConfMap *map, struct SConfErr *err)
+{
+    if (!root || !files) {
         sconf_err_set(err, "no root specified when reading env");
         return -1;
     }
@@ -243,7 +263,8 @@ int sconf_env_read(struct SConfNode *root, const struct SConfMap *map,
                 break;
 
             case SCONF_TYPE_YAML_FILE:
-                if (sconf_env_yaml_file(root, entry->path, value, err) == -1) {
+                if (sconf_env_yaml_file(root, files, entry->path, value,
+                                        err) == -1) {
                     return -1;
                 }
                 break;
@@ -0,0 +1,562 @@
+#include <assert.h>
+#include <stdalign.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "array.h"
+#include "freeze.h"
+#include "intern.h"
+#include "sconf.h"
+#include "sconf_private.h"
+
+/* Number of objects of each kind needed for a snapshot, also used as
+   cursors into the snapshot memory while copying */
+struct SConfFreezeLayout {
+    size_t nodes;
+    size_t keys;
+    size_t arrays;
+    size_t entries;
+    size_t values;
+    size_t strings;
+
+    /* Strings counted so far, each distinct string is stored once */
+    struct SConfIntern seen;
+};
+
+/* Pointers to the next free object of each kind in the snapshot memory */
+struct SConfFreezeCursor {
+    struct SConfNode *nodes;
+    struct SConfFrozenKey *keys;
+    struct SConfArray *arrays;
+    struct SConfNode **entries;
+    uint64_t *values;
+    char *strings;
+
+    /* Strings copied so far */
+    struct SConfIntern copied;
+};
+
+/* Dictionary entry collected before sorting */
+struct SConfFreezeEntry {
+    const char *name;
+    uint32_t len;
+    struct SConfNode *node;
+};
+
+/* Used to collect dictionary entries with sconf_node_dict_foreach */
+struct SConfFreezeEntries {
+    struct SConfFreezeEntry *entries;
+    uint32_t count;
+    uint32_t size;
+};
+
+static int sconf_freeze_count(const struct SConfNode *node,
+                              struct SConfFreezeLayout *layout,
+                              struct SConfErr *err);
+
+/**
+ * @internal
+ * @brief Count the size of a string, unless an equal string is counted.
+ *
+ * @param layout Counters to update.
+ * @param str    String to count (not null terminated).
+ * @param len    Length of string.
+ * @param err    Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int sconf_freeze_count_str(struct SConfFreezeLayout *layout,
+                                  const char *str, uint32_t len,
+                                  struct SConfErr *err)
+{
+    uint32_t hash = sconf_intern_hash(str, len);
+
+    if (sconf_intern_find(&layout->seen, str, len, hash)) {
+        return 0;
+    }
+
+    if (sconf_intern_add(&layout->seen, str, len, hash, err) == -1) {
+        return -1;
+    }
+
+    layout->strings += len + 1;
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Dictionary iterator callback counting the size of a snapshot.
+ */
+static int sconf_freeze_count_cb(const unsigned char *name,
+                                 struct SConfNode *node, void *user,
+                                 struct SConfErr *err)
+{
+    struct SConfFreezeLayout *layout = (struct SConfFreezeLayout *)user;
+
+    layout->keys++;
+
+    if (sconf_freeze_count_str(layout, (const char *)name,
+                               (uint32_t)strlen((const char *)name),
+                               err) == -1) {
+        return -1;
+    }
+
+    return sconf_freeze_count(node, layout, err);
+}
+
+/**
+ * @internal
+ * @brief Count the number of objects needed to freeze a tree.
+ *
+ * @param node   The config node.
+ * @param layout Counters to update.
+ * @param err    Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int sconf_freeze_count(const struct SConfNode *node,
+                              struct SConfFreezeLayout *layout,
+                              struct SConfErr *err)
+{
+    layout->nodes++;
+
+    switch (node->type)
+    {
+        case SCONF_TYPE_DICT:
+            return sconf_node_dict_foreach((struct SConfNode *)node,
+                                           sconf_freeze_count_cb, layout, err);
+        case SCONF_TYPE_ARRAY:
+            layout->arrays++;
+            if (node->array->packed) {
+                /* Values and a view of them as nodes */
+                layout->nodes += node->array->size;
+                layout->entries += node->array->size;
+                layout->values += SCONF_ARRAY_PACKED_WORDS(node->array->packed,
+                                                           node->array->size);
+                return 0;
+            }
+            layout->entries += node->array->size;
+            for (uint32_t i = 0; i < node->array->size; i++)
+            {
+                if (node->array->entries[i] &&
+                        sconf_freeze_count(node->array->entries[i], layout,
+                                           err) == -1) {
+                    return -1;
+                }
+            }
+            return 0;
+        case SCONF_TYPE_STR:
+            if (!(node->flags & SCONF_NODE_FLAG_STR_INLINE)) {
+                return sconf_freeze_count_str(layout, node->string, node->len,
+                                              err);
+            }
+            return 0;
+        case SCONF_TYPE_INT:
+        case SCONF_TYPE_BOOL:
+        case SCONF_TYPE_FLOAT:
+            return 0;
+    }
+
+    sconf_err_set(err, "can not freeze node of type %s",
+                  sconf_type_to_str(node->type));
+    return -1;
+}
+
+/**
+ * @internal
+ * @brief Dictionary iterator callback collecting the entries.
+ */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static int sconf_freeze_collect_cb(const unsigned char *name,
+                                   struct SConfNode *node, void *user,
+                                   struct SConfErr *err)
+{
+    struct SConfFreezeEntries *entries = (struct SConfFreezeEntries *)user;
+
+    if (entries->count == entries->size) {
+        uint32_t size = entries->size ? entries->size * 2 : 8;
+        struct SConfFreezeEntry *tmp = realloc(
+                entries->entries, size * sizeof(struct SConfFreezeEntry));
+        if (!tmp) {
+            sconf_err_set(err, "failed to allocate memory for snapshot");
+            return -1;
+        }
+        entries->entries = tmp;
+        entries->size = size;
+    }
+
+    struct SConfFreezeEntry *entry = &entries->entries[entries->count++];
+    entry->name = (const char *)name;
+    entry->len = (uint32_t)strlen(entry->name);
+    entry->node = node;
+
+    return 0;
+}
+#pragma GCC diagnostic pop
+
+/**
+ * @internal
+ * @brief qsort callback ordering dictionary entries by key.
+ */
+static int sconf_freeze_entry_cmp(const void *a, const void *b)
+{
+    const struct SConfFreezeEntry *x = a;
+    const struct SConfFreezeEntry *y = b;
+
+    return sconf_frozen_key_cmp(x->name, x->len, y->name, y->len);
+}
+
+/**
+ * @internal
+ * @brief Copy string into the snapshot string blob, unless an equal string
+ * is already copied.
+ *
+ * @param cursor Next free objects in the snapshot memory.
+ * @param str    String to copy (not null terminated).
+ * @param len    Length of string.
+ * @param err    Pointer to error struct.
+ *
+ * @return string in the snapshot on success, NULL otherwise.
+ */
+static const char *sconf_freeze_str(struct SConfFreezeCursor *cursor,
+                                    const char *str, uint32_t len,
+                                    struct SConfErr *err)
+{
+    uint32_t hash = sconf_intern_hash(str, len);
+
+    const char *found = sconf_intern_find(&cursor->copied, str, len, hash);
+    if (found) {
+        return found;
+    }
+
+    char *copy = cursor->strings;
+
+    memcpy(copy, str, len);
+    copy[len] = '\0';
+
+    if (sconf_intern_add(&cursor->copied, copy, len, hash, err) == -1) {
+        return NULL;
+    }
+
+    cursor->strings += len + 1;
+
+    return copy;
+}
+
+/**
+ * @internal
+ * @brief Copy packed array into snapshot memory.
+ *
+ * The view of the values is created right away, so readers of the snapshot
+ * never have to create it.
+ *
+ * @param array  The packed array to copy.
+ * @param dst    The array node in the snapshot.
+ * @param cursor Next free objects in the snapshot memory.
+ */
+static void sconf_freeze_packed(const struct SConfArray *array,
+                                struct SConfNode *dst,
+                                struct SConfFreezeCursor *cursor)
+{
+    size_t words = SCONF_ARRAY_PACKED_WORDS(array->packed, array->size);
+
+    struct SConfArray *copy = cursor->arrays++;
+    copy->size = array->size;
+    copy->arena = NULL;
+    copy->packed = array->packed;
+    copy->capacity = (uint32_t)words;
+    copy->bits = cursor->values;
+    copy->view = cursor->entries;
+    copy->view_capacity = array->size;
+    cursor->values += words;
+    cursor->entries += array->size;
+
+    memcpy(copy->bits, array->bits, words * sizeof(uint64_t));
+
+    for (uint32_t i = 0; i < copy->size; i++)
+    {
+        struct SConfNode *node = cursor->nodes++;
+        node->type = copy->packed;
+        node->flags = SCONF_NODE_FLAG_FROZEN | SCONF_NODE_FLAG_PACKED;
+        sconf_array_pack_value(copy, i, node);
+        copy->view[i] = node;
+    }
+
+    dst->array = copy;
+}
+
+/**
+ * @internal
+ * @brief Copy node into snapshot memory.
+ *
+ * The children of a dictionary or array are placed next to each other, so
+ * their slots are reserved before copying them recursively.
+ *
+ * @param src    The node to copy.
+ * @param dst    Reserved slot for the copy.
+ * @param cursor Next free objects in the snapshot memory.
+ * @param err    Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int sconf_freeze_copy(const struct SConfNode *src,
+                             struct SConfNode *dst,
+                             struct SConfFreezeCursor *cursor,
+                             struct SConfErr *err)
+{
+    dst->type = src->type;
+    dst->flags = SCONF_NODE_FLAG_FROZEN;
+    dst->arena = NULL;
+
+    switch (src->type)
+    {
+        case SCONF_TYPE_DICT:
+        {
+            struct SConfFreezeEntries collected = {0};
+            if (sconf_node_dict_foreach((struct SConfNode *)src,
+                                        sconf_freeze_collect_cb, &collected,
+                                        err) == -1) {
+                free(collected.entries);
+                return -1;
+            }
+
+            if (collected.count > 0) {
+                qsort(collected.entries, collected.count,
+                      sizeof(struct SConfFreezeEntry), sconf_freeze_entry_cmp);
+            }
+
+            struct SConfFrozenKey *keys = cursor->keys;
+            struct SConfNode *children = cursor->nodes;
+            cursor->keys += collected.count;
+            cursor->nodes += collected.count;
+
+            dst->frozen.keys = keys;
+            dst->frozen.children = children;
+            dst->frozen.count = collected.count;
+
+            int r = 0;
+            for (uint32_t i = 0; i < collected.count && r == 0; i++)
+            {
+                const struct SConfFreezeEntry *entry = &collected.entries[i];
+                keys[i].name = sconf_freeze_str(cursor, entry->name,
+                                                entry->len, err);
+                keys[i].len = entry->len;
+                if (!keys[i].name) {
+                    r = -1;
+                    break;
+                }
+                r = sconf_freeze_copy(entry->node, &children[i], cursor, err);
+            }
+
+            free(collected.entries);
+            return r;
+        }
+        case SCONF_TYPE_ARRAY:
+        {
+            const struct SConfArray *array = src->array;
+
+            if (array->packed) {
+                sconf_freeze_packed(array, dst, cursor);
+                return 0;
+            }
+
+            uint32_t used = 0;
+            for (uint32_t i = 0; i < array->size; i++)
+            {
+                used += array->entries[i] != NULL;
+            }
+
+            struct SConfArray *copy = cursor->arrays++;
+            copy->entries = cursor->entries;
+            copy->size = array->size;
+            copy->capacity = array->size;
+            copy->arena = NULL;
+            cursor->entries += array->size;
+
+            struct SConfNode *children = cursor->nodes;
+            cursor->nodes += used;
+
+            dst->array = copy;
+
+            for (uint32_t i = 0; i < array->size; i++)
+            {
+                if (!array->entries[i]) {
+                    continue;
+                }
+                if (sconf_freeze_copy(array->entries[i], children, cursor,
+                                      err) == -1) {
+                    return -1;
+                }
+                copy->entries[i] = children++;
+            }
+            return 0;
+        }
+        case SCONF_TYPE_STR:
+            dst->len = src->len;
+            if (src->flags & SCONF_NODE_FLAG_STR_INLINE) {
+                dst->flags |= SCONF_NODE_FLAG_STR_INLINE;
+                memcpy(dst->short_string, src->short_string, src->len + 1);
+            }
+            else {
+                /* Owned by the snapshot and possibly shared with other
+                   nodes, so capacity is 0 */
+                dst->string = (char *)sconf_freeze_str(cursor, src->string,
+                                                       src->len, err);
+                if (!dst->string) {
+                    return -1;
+                }
+            }
+            return 0;
+        case SCONF_TYPE_INT:
+            dst->integer = src->integer;
+            return 0;
+        case SCONF_TYPE_BOOL:
+            dst->boolean = src->boolean;
+            return 0;
+        case SCONF_TYPE_FLOAT:
+            dst->fp = src->fp;
+            return 0;
+    }
+
+    sconf_err_set(err, "can not freeze node of type %s",
+                  sconf_type_to_str(src->type));
+    return -1;
+}
+
+/**
+ * @brief Create an immutable snapshot of a config tree.
+ *
+ * The snapshot is stored in one allocation: all nodes first (the children
+ * of each dictionary and array next to each other), then the sorted key
+ * tables, the arrays, the values of packed arrays and finally all strings.
+ * Each distinct key and string is stored once.
+ *
+ * @param root The config tree to freeze.
+ * @param err  Pointer to error struct.
+ *
+ * @return root of the snapshot on success, NULL otherwise.
+ */
+struct SConfNode *sconf_freeze(struct SConfNode *root, struct SConfErr *err)
+{
+    if (!root) {
+        sconf_err_set(err, "no root was specified");
+        return NULL;
+    }
+
+    if (root->flags & SCONF_NODE_FLAG_OVERLAY) {
+        /* The values of the base are not part of the tree */
+        sconf_err_set(err, "an overlay can not be frozen");
+        return NULL;
+    }
+
+    struct SConfFreezeLayout layout = {0};
+    sconf_intern_init(&layout.seen, NULL);
+
+    int r = sconf_freeze_count(root, &layout, err);
+    sconf_intern_destroy(&layout.seen);
+    if (r == -1) {
+        return NULL;
+    }
+
+    /* Everything but the strings are pointer aligned */
+    static_assert(alignof(struct SConfNode) >= alignof(struct SConfFrozenKey),
+                  "keys must be aligned");
+    static_assert(alignof(struct SConfNode) >= alignof(struct SConfArray),
+                  "arrays must be aligned");
+    static_assert(alignof(struct SConfNode) >= alignof(struct SConfNode *),
+                  "entries must be aligned");
+    static_assert(alignof(struct SConfNode) >= alignof(uint64_t),
+                  "packed values must be aligned");
+
+    size_t size = layout.nodes * sizeof(struct SConfNode) +
+                  layout.keys * sizeof(struct SConfFrozenKey) +
+                  layout.arrays * sizeof(struct SConfArray) +
+                  layout.entries * sizeof(struct SConfNode *) +
+                  layout.values * sizeof(uint64_t) +
+                  layout.strings;
+
+    struct SConfSnapshot *snapshot = calloc(1, sizeof(struct SConfSnapshot) +
+                                            size);
+    if (!snapshot) {
+        sconf_err_set(err, "failed to allocate memory for snapshot");
+        return NULL;
+    }
+
+    struct SConfFreezeCursor cursor;
+    cursor.nodes = snapshot->nodes;
+    cursor.keys = (struct SConfFrozenKey *)(cursor.nodes + layout.nodes);
+    cursor.arrays = (struct SConfArray *)(cursor.keys + layout.keys);
+    cursor.entries = (struct SConfNode **)(cursor.arrays + layout.arrays);
+    cursor.values = (uint64_t *)(cursor.entries + layout.entries);
+    cursor.strings = (char *)(cursor.values + layout.values);
+    sconf_intern_init(&cursor.copied, NULL);
+
+    struct SConfNode *frozen = cursor.nodes++;
+    r = sconf_freeze_copy(root, frozen, &cursor, err);
+    sconf_intern_destroy(&cursor.copied);
+    if (r == -1) {
+        free(snapshot);
+        return NULL;
+    }
+
+    assert(cursor.strings == (char *)snapshot->nodes + size);
+
+    frozen->flags |= SCONF_NODE_FLAG_FROZEN_OWNER;
+
+    return frozen;
+}
+
+/**
+ * @brief Build path index for a frozen snapshot.
+ *
+ * @param root Root of the frozen snapshot.
+ * @param err  Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sconf_index_paths(struct SConfNode *root, struct SConfErr *err)
+{
+    if (!root) {
+        sconf_err_set(err, "no root was specified");
+        return -1;
+    }
+
+    if (!(root->flags & SCONF_NODE_FLAG_FROZEN_OWNER)) {
+        sconf_err_set(err, "only the root of a frozen snapshot can be indexed");
+        return -1;
+    }
+
+    if (root->flags & SCONF_NODE_FLAG_INDEXED) {
+        return 0;
+    }
+
+    struct SConfIndex *index = sconf_index_create(root, err);
+    if (!index) {
+        return -1;
+    }
+
+    sconf_snapshot(root)->index = index;
+    root->flags |= SCONF_NODE_FLAG_INDEXED;
+
+    return 0;
+}
+
+/**
+ * @brief Free the memory of a frozen snapshot.
+ *
+ * @param root Root of the frozen snapshot.
+ */
+void sconf_snapshot_destroy(struct SConfNode *root)
+{
+    assert(root->flags & SCONF_NODE_FLAG_FROZEN_OWNER);
+
+    struct SConfSnapshot *snapshot = sconf_snapshot(root);
+
+    sconf_index_destroy(snapshot->index);
+    free(snapshot);
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "index.h"
+#include "sconf.h"
+#include "sconf_private.h"
+
+/* Memory of a frozen snapshot, starting with the root node */
+struct SConfSnapshot {
+    /* Optional path index, see sconf_index_paths */
+    struct SConfIndex *index;
+    struct SConfNode nodes[];
+};
+
+void sconf_snapshot_destroy(struct SConfNode *root);
+
+/**
+ * @brief Get snapshot from its root node.
+ */
+static inline struct SConfSnapshot *sconf_snapshot(
+        const struct SConfNode *root)
+{
+    return (struct SConfSnapshot *)((char *)root -
+                                    offsetof(struct SConfSnapshot, nodes));
+}
+
+/**
+ * @brief Compare two keys, same order as libart iterates in.
+ *
+ * @return <0, 0 or >0 like memcmp.
+ */
+static inline int sconf_frozen_key_cmp(const char *a, uint32_t a_len,
+                                       const char *b, uint32_t b_len)
+{
+    int r = memcmp(a, b, a_len < b_len ? a_len : b_len);
+    if (r != 0) {
+        return r;
+    }
+
+    return (a_len > b_len) - (a_len < b_len);
+}
+
+/**
+ * @brief Look up child in frozen dictionary using binary search.
+ *
+ * @param dict     The frozen dictionary node.
+ * @param name     Name of the child (not null terminated).
+ * @param name_len Length of name.
+ *
+ * @return Pointer to node if found, NULL otherwise.
+ */
+static inline struct SConfNode *sconf_frozen_dict_lookup(
+        const struct SConfNode *dict, const char *name, uint32_t name_len)
+{
+    const struct SConfFrozenKey *keys = dict->frozen.keys;
+    uint32_t low = 0;
+    uint32_t high = dict->frozen.count;
+
+    while (low < high)
+    {
+        uint32_t mid = low + (high - low) / 2;
+        int r = sconf_frozen_key_cmp(keys[mid].name, keys[mid].len, name,
+                                     name_len);
+        if (r == 0) {
+            return &dict->frozen.children[mid];
+        }
+        if (r < 0) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+
+    return NULL;
+}
@@ -0,0 +1,287 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "handle.h"
+#include "overlay.h"
+#include "path.h"
+#include "sconf.h"
+#include "sconf_private.h"
+
+uint64_t sconf_generation = 1;
+uint64_t sconf_handles = 0;
+
+struct SConfHandle {
+    struct SConfNode *root;
+    struct SConfPath *path;
+
+    /* Cached lookup result, valid while generation is current. node is NULL
+       if the path was not found. */
+    struct SConfNode *node;
+    uint8_t type;
+    uint64_t generation;
+};
+
+/**
+ * @brief Create handle caching the node at path.
+ *
+ * @param root Pointer to root config node.
+ * @param path The path to the config node.
+ * @param err  Pointer to error struct.
+ *
+ * @return handle on success, NULL otherwise.
+ */
+struct SConfHandle *sconf_handle_create(struct SConfNode *root,
+                                        const char *path,
+                                        struct SConfErr *err)
+{
+    if (!root) {
+        sconf_err_set(err, "no root was specified");
+        return NULL;
+    }
+
+    struct SConfHandle *handle = calloc(1, sizeof(struct SConfHandle));
+    if (!handle) {
+        sconf_err_set(err, "failed to allocate memory for handle");
+        return NULL;
+    }
+
+    handle->path = sconf_path_compile(path, err);
+    if (!handle->path) {
+        free(handle);
+        return NULL;
+    }
+
+    handle->root = root;
+
+    /* Generation 0 is never used, so the first access resolves the path */
+    handle->generation = 0;
+
+    __atomic_add_fetch(&sconf_handles, 1, __ATOMIC_ACQ_REL);
+
+    return handle;
+}
+
+/**
+ * @brief Destroy handle.
+ *
+ * @param handle The handle.
+ */
+void sconf_handle_destroy(struct SConfHandle *handle)
+{
+    if (!handle) {
+        return;
+    }
+
+    sconf_path_destroy(handle->path);
+    free(handle);
+
+    __atomic_sub_fetch(&sconf_handles, 1, __ATOMIC_ACQ_REL);
+}
+
+/**
+ * @internal
+ * @brief Get generation of the tree rooted at root.
+ *
+ * Lookups in an overlay fall back to its base, so the generation of an
+ * overlay includes the generation of the base. The counters only grow, so
+ * the sum changes whenever one of them does.
+ *
+ * @param root The config root node.
+ *
+ * @return the generation, never 0.
+ */
+static uint64_t sconf_generation_get(const struct SConfNode *root)
+{
+    uint64_t generation = __atomic_load_n(sconf_generation_counter(root),
+                                          __ATOMIC_ACQUIRE);
+
+    if (root->flags & SCONF_NODE_FLAG_OVERLAY) {
+        generation += sconf_generation_get(sconf_overlay_base(root));
+    }
+
+    return generation;
+}
+
+/**
+ * @internal
+ * @brief Resolve the path again if the cached node is stale.
+ *
+ * @param handle The handle.
+ * @param err    Pointer to error struct.
+ *
+ * @return 1 on found, 0 on not found, -1 on error.
+ */
+static int sconf_handle_resolve(struct SConfHandle *handle,
+                                struct SConfErr *err)
+{
+    /* Read the generation before walking, so a change during the walk makes
+       the next access resolve again */
+    uint64_t generation = sconf_generation_get(handle->root);
+
+    if (generation == handle->generation) {
+        return handle->node ? 1 : 0;
+    }
+
+    struct SConfNode *node = NULL;
+    int r = sconf_get_p(handle->root, handle->path, &node, err);
+    if (r == -1) {
+        return -1;
+    }
+
+    handle->node = r == 1 ? node : NULL;
+    handle->type = r == 1 ? node->type : SCONF_TYPE_UNKNOWN;
+    handle->generation = generation;
+
+    return r;
+}
+
+/**
+ * @internal
+ * @brief Resolve handle and check that the node is of the expected type.
+ *
+ * @param handle The handle.
+ * @param type   The expected type of the config node.
+ * @param err    Pointer to error struct.
+ *
+ * @return 1 on found, 0 on not found, -1 on error.
+ */
+static int sconf_handle_typed(struct SConfHandle *handle, uint8_t type,
+                              struct SConfErr *err)
+{
+    if (!handle) {
+        sconf_err_set(err, "no handle was specified");
+        return -1;
+    }
+
+    int r = sconf_handle_resolve(handle, err);
+    if (r != 1) {
+        return r;
+    }
+
+    if (handle->type != type) {
+        sconf_err_set(err, "config node '%.*s' is %s not %s",
+                      (int)handle->path->len, handle->path->string,
+                      sconf_type_to_str(handle->type),
+                      sconf_type_to_str(type));
+        return -1;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Get config node from handle.
+ *
+ * @param handle The handle.
+ * @param node   Pointer to node, if found.
+ * @param err    Pointer to error struct.
+ *
+ * @return 1 on found, 0 on not found, -1 on error.
+ */
+int sconf_handle_get(struct SConfHandle *handle, struct SConfNode **node,
+                     struct SConfErr *err)
+{
+    if (!handle) {
+        sconf_err_set(err, "no handle was specified");
+        return -1;
+    }
+
+    int r = sconf_handle_resolve(handle, err);
+    if (r != 1) {
+        return r;
+    }
+
+    *node = handle->node;
+
+    return 1;
+}
+
+/**
+ * @brief Get config string from handle.
+ *
+ * @param handle The handle.
+ * @param str    Pointer to string, if found.
+ * @param err    Pointer to error struct.
+ *
+ * @return 1 on found, 0 on not found, -1 on error.
+ */
+int sconf_handle_str(struct SConfHandle *handle, const char **str,
+                     struct SConfErr *err)
+{
+    int r = sconf_handle_typed(handle, SCONF_TYPE_STR, err);
+    if (r != 1) {
+        return r;
+    }
+
+    *str = sconf_node_str(handle->node);
+
+    return 1;
+}
+
+/**
+ * @brief Get config integer from handle.
+ *
+ * @param handle  The handle.
+ * @param integer Pointer to integer, if found.
+ * @param err     Pointer to error struct.
+ *
+ * @return 1 on found, 0 on not found, -1 on error.
+ */
+int sconf_handle_int(struct SConfHandle *handle, const int64_t **integer,
+                     struct SConfErr *err)
+{
+    int r = sconf_handle_typed(handle, SCONF_TYPE_INT, err);
+    if (r != 1) {
+        return r;
+    }
+
+    *integer = &handle->node->integer;
+
+    return 1;
+}
+
+/**
+ * @brief Get config boolean from handle.
+ *
+ * @param handle  The handle.
+ * @param boolean Pointer to boolean, if found.
+ * @param err     Pointer to error struct.
+ *
+ * @return 1 on found, 0 on not found, -1 on error.
+ */
+int sconf_handle_bool(struct SConfHandle *handle, const bool **boolean,
+                      struct SConfErr *err)
+{
+    int r = sconf_handle_typed(handle, SCONF_TYPE_BOOL, err);
+    if (r != 1) {
+        return r;
+    }
+
+    *boolean = &handle->node->boolean;
+
+    return 1;
+}
+
+/**
+ * @brief Get config floating point number from handle.
+ *
+ * @param handle The handle.
+ * @param fp     Pointer to floating point number, if found.
+ * @param err    Pointer to error struct.
+ *
+ * @return 1 on found, 0 on not found, -1 on error.
+ */
+int sconf_handle_float(struct SConfHandle *handle, const double **fp,
+                       struct SConfErr *err)
+{
+    int r = sconf_handle_typed(handle, SCONF_TYPE_FLOAT, err);
+    if (r != 1) {
+        return r;
+    }
+
+    *fp = &handle->node->fp;
+
+    return 1;
+}
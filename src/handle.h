@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "arena.h"
+#include "sconf.h"
+#include "sconf_private.h"
+
+/* Generation of the config trees allocated from the heap, bumped every time
+   one of them changes shape or value, used to invalidate cached node
+   handles. Arena-backed trees count their own generation in the arena. Not
+   exported, only accessed through the functions below. */
+extern uint64_t sconf_generation __attribute__((visibility("hidden")));
+
+/* Number of live handles. Changes are only counted while there are any, so
+   threads building trees without handles (e.g sconf_yaml_read_dir workers)
+   never write the shared counter. */
+extern uint64_t sconf_handles __attribute__((visibility("hidden")));
+
+/**
+ * @brief Get generation counter of the tree node is part of.
+ */
+static inline uint64_t *sconf_generation_counter(const struct SConfNode *node)
+{
+    return node->arena ? &node->arena->generation : &sconf_generation;
+}
+
+/**
+ * @brief Mark cached handles into the tree node is part of as stale.
+ *
+ * @param node Node that changed, or its parent.
+ */
+static inline void sconf_generation_bump(const struct SConfNode *node)
+{
+    if (__atomic_load_n(&sconf_handles, __ATOMIC_ACQUIRE) == 0) {
+        return;
+    }
+
+    __atomic_add_fetch(sconf_generation_counter(node), 1, __ATOMIC_RELEASE);
+}
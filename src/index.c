@@ -0,0 +1,466 @@
+#include <assert.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "array.h"
+#include "index.h"
+#include "sconf.h"
+#include "sconf_private.h"
+
+/* Average number of paths per bucket */
+#define SCONF_INDEX_BUCKET_SIZE 4
+
+/* Number of seeds tried before giving up building the index */
+#define SCONF_INDEX_ATTEMPTS 16
+
+/* Longer paths are not indexed, and found by walking the tree instead */
+#define SCONF_INDEX_MAX_PATH_LEN 1024
+
+/* Path collected while walking the tree */
+struct SConfIndexEntry {
+    size_t offset;
+    uint32_t len;
+    uint32_t bucket;
+    uint64_t hash;
+    struct SConfNode *node;
+};
+
+/* State used while walking the tree */
+struct SConfIndexCollector {
+    struct SConfIndexEntry *entries;
+    size_t count;
+    size_t size;
+
+    /* All collected paths, null terminated */
+    char *paths;
+    size_t paths_len;
+    size_t paths_size;
+
+    /* Path of the node currently visited, and its number of segments */
+    char path[SCONF_INDEX_MAX_PATH_LEN];
+    size_t path_len;
+    uint32_t depth;
+};
+
+static int sconf_index_collect(struct SConfIndexCollector *collector,
+                               struct SConfNode *node, struct SConfErr *err);
+
+/**
+ * @internal
+ * @brief Grow buffer to fit at least needed elements.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int sconf_index_grow(void **buffer, size_t *size, size_t needed,
+                            size_t elem_size, struct SConfErr *err)
+{
+    if (needed <= *size) {
+        return 0;
+    }
+
+    size_t new_size = *size ? *size : 64;
+    while (new_size < needed)
+    {
+        new_size *= 2;
+    }
+
+    void *tmp = realloc(*buffer, new_size * elem_size);
+    if (!tmp) {
+        sconf_err_set(err, "failed to allocate memory for path index");
+        return -1;
+    }
+
+    *buffer = tmp;
+    *size = new_size;
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Add segment to the current path, and collect the child node.
+ *
+ * @param collector The collector.
+ * @param segment   Path segment of the child.
+ * @param len       Length of the segment.
+ * @param node      The child node.
+ * @param descend   Whether paths below the child can be looked up.
+ * @param err       Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int sconf_index_collect_child(struct SConfIndexCollector *collector,
+                                     const char *segment, size_t len,
+                                     struct SConfNode *node, bool descend,
+                                     struct SConfErr *err)
+{
+    size_t saved_len = collector->path_len;
+    size_t needed = saved_len + (saved_len ? 1 : 0) + len;
+
+    if (needed >= sizeof(collector->path) ||
+            collector->depth + 1 >= SCONF_MAX_DEPTH) {
+        /* Can not be looked up, or left to the tree walk */
+        return 0;
+    }
+
+    if (sconf_index_grow((void **)&collector->entries, &collector->size,
+                         collector->count + 1,
+                         sizeof(struct SConfIndexEntry), err) == -1 ||
+            sconf_index_grow((void **)&collector->paths,
+                             &collector->paths_size,
+                             collector->paths_len + needed + 1, 1,
+                             err) == -1) {
+        return -1;
+    }
+
+    if (saved_len) {
+        collector->path[collector->path_len++] = '.';
+    }
+    memcpy(collector->path + collector->path_len, segment, len);
+    collector->path_len += len;
+
+    struct SConfIndexEntry *entry = &collector->entries[collector->count++];
+    entry->offset = collector->paths_len;
+    entry->len = (uint32_t)collector->path_len;
+    entry->node = node;
+
+    memcpy(collector->paths + collector->paths_len, collector->path,
+           collector->path_len);
+    collector->paths_len += collector->path_len;
+    collector->paths[collector->paths_len++] = '\0';
+
+    int r = 0;
+
+    if (descend) {
+        collector->depth++;
+        r = sconf_index_collect(collector, node, err);
+        collector->depth--;
+    }
+
+    collector->path_len = saved_len;
+
+    return r;
+}
+
+/**
+ * @internal
+ * @brief Dictionary iterator callback collecting paths.
+ */
+static int sconf_index_collect_cb(const unsigned char *name,
+                                  struct SConfNode *node, void *user,
+                                  struct SConfErr *err)
+{
+    struct SConfIndexCollector *collector = user;
+    const char *key = (const char *)name;
+    size_t len = strlen(key);
+
+    /* Keys that can not be part of a path are only reachable by iterating */
+    if (len == 0 || memchr(key, '.', len)) {
+        return 0;
+    }
+
+    /* Lookups do not go through dictionary keys looking like array
+       indexes, so only the key itself is indexed */
+    return sconf_index_collect_child(collector, key, len, node, key[0] != '[',
+                                     err);
+}
+
+/**
+ * @internal
+ * @brief Collect the paths of all nodes below node.
+ *
+ * @param collector The collector.
+ * @param node      The config node.
+ * @param err       Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int sconf_index_collect(struct SConfIndexCollector *collector,
+                               struct SConfNode *node, struct SConfErr *err)
+{
+    switch (node->type)
+    {
+        case SCONF_TYPE_DICT:
+            return sconf_node_dict_foreach(node, sconf_index_collect_cb,
+                                           collector, err);
+        case SCONF_TYPE_ARRAY:
+        {
+            struct SConfNode **view = NULL;
+            if (node->array->packed) {
+                view = sconf_array_view(node->array, err);
+                if (!view) {
+                    return -1;
+                }
+            }
+
+            for (uint32_t i = 0; i < node->array->size; i++)
+            {
+                struct SConfNode *child = view ? view[i] :
+                                                 node->array->entries[i];
+                if (!child) {
+                    continue;
+                }
+
+                char segment[16];
+                int len = snprintf(segment, sizeof(segment), "[%" PRIu32 "]",
+                                   i);
+                if (sconf_index_collect_child(collector, segment, (size_t)len,
+                                              child, true, err) == -1) {
+                    return -1;
+                }
+            }
+            return 0;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Find a displacement for a bucket that puts all its paths in free
+ *        slots.
+ *
+ * @param index   The index being built.
+ * @param entries Paths in the bucket.
+ * @param size    Number of paths in the bucket.
+ * @param taken   One flag per slot, set if the slot is used.
+ * @param slots   Scratch space for the slots of the bucket.
+ *
+ * @return displacement on success, -1 if none was found.
+ */
+static int64_t sconf_index_displace(const struct SConfIndex *index,
+                                    struct SConfIndexEntry **entries,
+                                    uint32_t size, const bool *taken,
+                                    uint32_t *slots)
+{
+    /* When few slots are left, the last buckets need about count tries */
+    uint64_t limit = (uint64_t)index->count * 8 + 1024;
+    if (limit > UINT32_MAX) {
+        limit = UINT32_MAX;
+    }
+
+    for (uint64_t d = 0; d < limit; d++)
+    {
+        uint32_t i;
+        for (i = 0; i < size; i++)
+        {
+            slots[i] = sconf_index_slot(entries[i]->hash, (uint32_t)d,
+                                        index->count);
+            if (taken[slots[i]]) {
+                break;
+            }
+
+            uint32_t j;
+            for (j = 0; j < i && slots[j] != slots[i]; j++)
+            {
+            }
+            if (j < i) {
+                break;
+            }
+        }
+
+        if (i == size) {
+            return (int64_t)d;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * @internal
+ * @brief Try to build the perfect hash with the current seed.
+ *
+ * Buckets are placed from the largest to the smallest, since large buckets
+ * are harder to place when the table fills up.
+ *
+ * @param index   The index to fill in.
+ * @param entries The collected paths.
+ * @param paths   The path strings, stored in the index.
+ * @param scratch Scratch space for sorting paths by bucket.
+ * @param sizes   Scratch space for one counter per bucket.
+ * @param taken   Scratch space for one flag per slot.
+ * @param slots   Scratch space for the slots of one bucket.
+ *
+ * @return true on success, false if the seed did not work.
+ */
+static bool sconf_index_place(struct SConfIndex *index,
+                              struct SConfIndexEntry *entries,
+                              const char *paths,
+                              struct SConfIndexEntry **scratch,
+                              uint32_t *sizes, bool *taken, uint32_t *slots)
+{
+    uint32_t count = index->count;
+    uint32_t buckets = index->buckets;
+
+    memset(sizes, 0, (buckets + 1) * sizeof(uint32_t));
+    memset(taken, 0, count * sizeof(bool));
+
+    uint32_t max_size = 0;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        entries[i].hash = sconf_index_hash(index->seed,
+                                           paths + entries[i].offset,
+                                           entries[i].len);
+        entries[i].bucket = (uint32_t)((entries[i].hash >> 32) % buckets);
+        if (++sizes[entries[i].bucket + 1] > max_size) {
+            max_size = sizes[entries[i].bucket + 1];
+        }
+    }
+
+    /* Group the paths by bucket, sizes[b] becomes the start of bucket b */
+    for (uint32_t b = 0; b < buckets; b++)
+    {
+        sizes[b + 1] += sizes[b];
+    }
+    for (uint32_t i = 0; i < count; i++)
+    {
+        scratch[sizes[entries[i].bucket]++] = &entries[i];
+    }
+    /* Shift back, so bucket b is scratch[sizes[b]] to scratch[sizes[b + 1]] */
+    for (uint32_t b = buckets; b > 0; b--)
+    {
+        sizes[b] = sizes[b - 1];
+    }
+    sizes[0] = 0;
+
+    for (uint32_t size = max_size; size > 0; size--)
+    {
+        for (uint32_t b = 0; b < buckets; b++)
+        {
+            if (sizes[b + 1] - sizes[b] != size) {
+                continue;
+            }
+
+            struct SConfIndexEntry **bucket = &scratch[sizes[b]];
+            int64_t d = sconf_index_displace(index, bucket, size, taken,
+                                             slots);
+            if (d == -1) {
+                return false;
+            }
+
+            index->displacements[b] = (uint32_t)d;
+
+            for (uint32_t i = 0; i < size; i++)
+            {
+                struct SConfIndexSlot *slot = &index->slots[slots[i]];
+                taken[slots[i]] = true;
+                slot->fingerprint = bucket[i]->hash;
+                slot->node = bucket[i]->node;
+                slot->len = bucket[i]->len;
+                slot->path = paths + bucket[i]->offset;
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Build index over the full paths of all nodes in a tree.
+ *
+ * @param root The config tree, must not be changed while the index is used.
+ * @param err  Pointer to error struct.
+ *
+ * @return index on success, NULL otherwise.
+ */
+struct SConfIndex *sconf_index_create(struct SConfNode *root,
+                                      struct SConfErr *err)
+{
+    assert(root);
+
+    struct SConfIndexCollector *collector = calloc(
+            1, sizeof(struct SConfIndexCollector));
+    if (!collector) {
+        sconf_err_set(err, "failed to allocate memory for path index");
+        return NULL;
+    }
+
+    struct SConfIndex *index = NULL;
+    struct SConfIndexEntry **scratch = NULL;
+    uint32_t *sizes = NULL;
+    bool *taken = NULL;
+    uint32_t *slots = NULL;
+
+    if (sconf_index_collect(collector, root, err) == -1) {
+        goto out;
+    }
+
+    if (collector->count > UINT32_MAX) {
+        sconf_err_set(err, "too many paths to index");
+        goto out;
+    }
+
+    uint32_t count = (uint32_t)collector->count;
+    uint32_t buckets = count / SCONF_INDEX_BUCKET_SIZE + 1;
+
+    /* The index, slots, displacements and paths in one allocation */
+    size_t size = sizeof(struct SConfIndex) +
+                  count * sizeof(struct SConfIndexSlot) +
+                  buckets * sizeof(uint32_t) + collector->paths_len;
+
+    index = calloc(1, size);
+    scratch = calloc(count + 1, sizeof(struct SConfIndexEntry *));
+    sizes = calloc(buckets + 1, sizeof(uint32_t));
+    taken = calloc(count + 1, sizeof(bool));
+    slots = calloc(count + 1, sizeof(uint32_t));
+    if (!index || !scratch || !sizes || !taken || !slots) {
+        sconf_err_set(err, "failed to allocate memory for path index");
+        free(index);
+        index = NULL;
+        goto out;
+    }
+
+    index->count = count;
+    index->buckets = buckets;
+    index->slots = (struct SConfIndexSlot *)(index + 1);
+    index->displacements = (uint32_t *)(index->slots + count);
+
+    char *paths = (char *)(index->displacements + buckets);
+    if (collector->paths_len > 0) {
+        memcpy(paths, collector->paths, collector->paths_len);
+    }
+
+    bool placed = false;
+    for (uint64_t attempt = 0; attempt < SCONF_INDEX_ATTEMPTS && !placed;
+         attempt++)
+    {
+        index->seed = sconf_index_mix(attempt + 0x9e3779b97f4a7c15ULL);
+        placed = sconf_index_place(index, collector->entries, paths, scratch,
+                                   sizes, taken, slots);
+    }
+
+    if (!placed) {
+        sconf_err_set(err, "failed to build path index");
+        free(index);
+        index = NULL;
+        goto out;
+    }
+
+out:
+    free(slots);
+    free(taken);
+    free(sizes);
+    free(scratch);
+    free(collector->paths);
+    free(collector->entries);
+    free(collector);
+
+    return index;
+}
+
+/**
+ * @brief Destroy path index.
+ *
+ * @param index The path index.
+ */
+void sconf_index_destroy(struct SConfIndex *index)
+{
+    free(index);
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "sconf.h"
+
+/* Slot in the path index, one per indexed path */
+struct SConfIndexSlot {
+    uint64_t fingerprint;
+    struct SConfNode *node;
+    const char *path;
+    uint32_t len;
+};
+
+/* Minimal perfect hash over all full paths in a config tree. A path is
+   hashed once, the hash picks a bucket, and the displacement of the bucket
+   picks the slot. */
+struct SConfIndex {
+    uint64_t seed;
+    uint32_t count;
+    uint32_t buckets;
+    uint32_t *displacements;
+    struct SConfIndexSlot *slots;
+};
+
+struct SConfIndex *sconf_index_create(struct SConfNode *root,
+                                      struct SConfErr *err);
+void sconf_index_destroy(struct SConfIndex *index);
+
+/**
+ * @brief Mix bits of 64-bit integer.
+ */
+static inline uint64_t sconf_index_mix(uint64_t x)
+{
+    x ^= x >> 32;
+    x *= 0xd6e8feb86659fd93ULL;
+    x ^= x >> 32;
+    x *= 0xd6e8feb86659fd93ULL;
+    x ^= x >> 32;
+
+    return x;
+}
+
+/**
+ * @brief Hash path, eight bytes at a time.
+ */
+static inline uint64_t sconf_index_hash(uint64_t seed, const char *path,
+                                        size_t len)
+{
+    uint64_t h = seed ^ (len * 0x9e3779b97f4a7c15ULL);
+
+    while (len >= 8)
+    {
+        uint64_t word;
+        memcpy(&word, path, 8);
+        h = (h ^ word) * 0xbf58476d1ce4e5b9ULL;
+        h ^= h >> 29;
+        path += 8;
+        len -= 8;
+    }
+
+    if (len > 0) {
+        uint64_t word = 0;
+        memcpy(&word, path, len);
+        h = (h ^ word) * 0xbf58476d1ce4e5b9ULL;
+    }
+
+    return sconf_index_mix(h);
+}
+
+/**
+ * @brief Get slot for hash and bucket displacement.
+ */
+static inline uint32_t sconf_index_slot(uint64_t hash, uint32_t displacement,
+                                        uint32_t count)
+{
+    return (uint32_t)(sconf_index_mix(hash + displacement *
+                                      0x9e3779b97f4a7c15ULL) % count);
+}
+
+/**
+ * @brief Look up full path in index.
+ *
+ * @param index The path index.
+ * @param path  The path (not null terminated).
+ * @param len   Length of path.
+ *
+ * @return Pointer to node if the path is indexed, NULL otherwise.
+ */
+static inline struct SConfNode *sconf_index_lookup(
+        const struct SConfIndex *index, const char *path, size_t len)
+{
+    if (index->count == 0) {
+        return NULL;
+    }
+
+    uint64_t hash = sconf_index_hash(index->seed, path, len);
+    uint32_t bucket = (uint32_t)((hash >> 32) % index->buckets);
+    const struct SConfIndexSlot *slot = &index->slots[
+            sconf_index_slot(hash, index->displacements[bucket],
+                             index->count)];
+
+    /* Paths not in the index also map to a slot, so check it is the same */
+    if (slot->fingerprint != hash || slot->len != len ||
+            memcmp(slot->path, path, len) != 0) {
+        return NULL;
+    }
+
+    return slot->node;
+}
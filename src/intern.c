@@ -0,0 +1,183 @@
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "arena.h"
+#include "intern.h"
+#include "sconf.h"
+
+/* Number of slots in a new pool, always a power of two */
+#define SCONF_INTERN_MIN_SLOTS 64
+
+/**
+ * @brief Initialize an empty intern pool.
+ *
+ * No memory is allocated until the first string is added.
+ *
+ * @param pool  Pool to initialize.
+ * @param arena Arena to allocate from, or NULL to use the heap.
+ */
+void sconf_intern_init(struct SConfIntern *pool, struct SConfArena *arena)
+{
+    pool->arena = arena;
+    pool->slots = NULL;
+    pool->count = 0;
+    pool->mask = 0;
+}
+
+/**
+ * @brief Release the slots of an intern pool.
+ *
+ * Strings added with sconf_intern_add are not owned by the pool and are not
+ * freed. Strings copied by sconf_intern are only used with arena-backed
+ * pools, and are released with the arena.
+ *
+ * @param pool Pool to destroy.
+ */
+void sconf_intern_destroy(struct SConfIntern *pool)
+{
+    sconf_arena_free(pool->arena, pool->slots);
+    pool->slots = NULL;
+    pool->count = 0;
+    pool->mask = 0;
+}
+
+/**
+ * @brief Find string in intern pool.
+ *
+ * @param pool Pool to search.
+ * @param str  String to find (not null terminated).
+ * @param len  Length of string.
+ * @param hash Hash of string, see sconf_intern_hash.
+ *
+ * @return the pooled string if found, NULL otherwise.
+ */
+const char *sconf_intern_find(const struct SConfIntern *pool, const char *str,
+                              uint32_t len, uint32_t hash)
+{
+    if (!pool->slots) {
+        return NULL;
+    }
+
+    for (uint32_t i = hash & pool->mask; pool->slots[i].str;
+         i = (i + 1) & pool->mask)
+    {
+        const struct SConfInternSlot *slot = &pool->slots[i];
+        if (slot->hash == hash && slot->len == len &&
+                memcmp(slot->str, str, len) == 0) {
+            return slot->str;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @internal
+ * @brief Put string in the first free slot for its hash.
+ */
+static void sconf_intern_place(struct SConfInternSlot *slots, uint32_t mask,
+                               const char *str, uint32_t len, uint32_t hash)
+{
+    uint32_t i = hash & mask;
+    while (slots[i].str)
+    {
+        i = (i + 1) & mask;
+    }
+
+    slots[i].str = str;
+    slots[i].len = len;
+    slots[i].hash = hash;
+}
+
+/**
+ * @brief Add string to intern pool.
+ *
+ * The string is not copied, so it must live as long as the pool. The
+ * caller makes sure the string is not already in the pool.
+ *
+ * @param pool Pool to add string to.
+ * @param str  String to add.
+ * @param len  Length of string.
+ * @param hash Hash of string, see sconf_intern_hash.
+ * @param err  Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sconf_intern_add(struct SConfIntern *pool, const char *str, uint32_t len,
+                     uint32_t hash, struct SConfErr *err)
+{
+    assert(!sconf_intern_find(pool, str, len, hash));
+
+    /* Keep the load factor at or below one half */
+    if (!pool->slots || pool->count + 1 > (pool->mask + 1) / 2) {
+        uint32_t size = pool->slots ? (pool->mask + 1) * 2 :
+                                      SCONF_INTERN_MIN_SLOTS;
+        if (size == 0) {
+            sconf_err_set(err, "too many strings in intern pool");
+            return -1;
+        }
+
+        struct SConfInternSlot *slots = sconf_arena_calloc(
+                pool->arena, size, sizeof(struct SConfInternSlot));
+        if (!slots) {
+            sconf_err_set(err, "failed to allocate memory for intern pool");
+            return -1;
+        }
+
+        for (uint32_t i = 0; pool->slots && i <= pool->mask; i++)
+        {
+            const struct SConfInternSlot *slot = &pool->slots[i];
+            if (slot->str) {
+                sconf_intern_place(slots, size - 1, slot->str, slot->len,
+                                   slot->hash);
+            }
+        }
+
+        sconf_arena_free(pool->arena, pool->slots);
+        pool->slots = slots;
+        pool->mask = size - 1;
+    }
+
+    sconf_intern_place(pool->slots, pool->mask, str, len, hash);
+    pool->count++;
+
+    return 0;
+}
+
+/**
+ * @brief Get pooled copy of string, copying it into the pool if needed.
+ *
+ * @param pool Pool to search and add to.
+ * @param str  String to intern (not null terminated).
+ * @param len  Length of string.
+ * @param err  Pointer to error struct.
+ *
+ * @return null terminated pooled string on success, NULL otherwise.
+ */
+const char *sconf_intern(struct SConfIntern *pool, const char *str,
+                         uint32_t len, struct SConfErr *err)
+{
+    assert(pool->arena);
+
+    uint32_t hash = sconf_intern_hash(str, len);
+
+    const char *found = sconf_intern_find(pool, str, len, hash);
+    if (found) {
+        return found;
+    }
+
+    char *copy = sconf_arena_calloc(pool->arena, 1, (size_t)len + 1);
+    if (!copy) {
+        sconf_err_set(err, "failed to allocate memory for interned string");
+        return NULL;
+    }
+    memcpy(copy, str, len);
+
+    if (sconf_intern_add(pool, copy, len, hash, err) == -1) {
+        return NULL;
+    }
+
+    return copy;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "index.h"
+#include "sconf.h"
+
+struct SConfArena;
+
+/* Slot in an intern pool, str is NULL if the slot is free */
+struct SConfInternSlot {
+    const char *str;
+    uint32_t len;
+    uint32_t hash;
+};
+
+/* Set of strings, each stored once. Two strings from the same pool are
+   equal only if they are the same pointer. */
+struct SConfIntern {
+    /* Arena strings and slots are allocated from, NULL for the heap */
+    struct SConfArena *arena;
+    struct SConfInternSlot *slots;
+    uint32_t count;
+    uint32_t mask;
+};
+
+void sconf_intern_init(struct SConfIntern *pool, struct SConfArena *arena);
+void sconf_intern_destroy(struct SConfIntern *pool);
+const char *sconf_intern_find(const struct SConfIntern *pool, const char *str,
+                              uint32_t len, uint32_t hash);
+int sconf_intern_add(struct SConfIntern *pool, const char *str, uint32_t len,
+                     uint32_t hash, struct SConfErr *err);
+const char *sconf_intern(struct SConfIntern *pool, const char *str,
+                         uint32_t len, struct SConfErr *err);
+
+/**
+ * @brief Hash string for an intern pool.
+ */
+static inline uint32_t sconf_intern_hash(const char *str, uint32_t len)
+{
+    return (uint32_t)sconf_index_hash(0, str, len);
+}
@@ -0,0 +1,361 @@
+#include <assert.h>
+#include <stdlib.h>
+
+#include "overlay.h"
+#include "sconf_private.h"
+
+/* Layers are a chain of overlays, each source on top of the ones it takes
+   precedence over: defaults <- files <- env <- opts. The opts layer is the
+   view of the resolved config. */
+struct SConfLayers {
+    struct SConfNode *sources[SCONF_SOURCE_MAX];
+};
+
+static const char *sconf_sources[] = {
+    [SCONF_SOURCE_OPTS]     = "command-line option",
+    [SCONF_SOURCE_ENV]      = "environment variable",
+    [SCONF_SOURCE_FILE]     = "YAML file",
+    [SCONF_SOURCE_DEFAULTS] = "default value",
+};
+
+/**
+ * @brief Return string representation of config source.
+ *
+ * @param source The config source (e.g SCONF_SOURCE_ENV).
+ *
+ * @return string representation of source.
+ */
+const char *sconf_source_to_str(int source)
+{
+    if (source < 0 || source >= SCONF_SOURCE_MAX) {
+        return "unknown";
+    }
+
+    return sconf_sources[source];
+}
+
+/**
+ * @brief Create config layers, one empty config tree per source.
+ *
+ * @param err Pointer to error struct.
+ *
+ * @return layers on success, NULL otherwise.
+ */
+struct SConfLayers *sconf_layers_create(struct SConfErr *err)
+{
+    struct SConfLayers *layers = calloc(1, sizeof(struct SConfLayers));
+    if (!layers) {
+        sconf_err_set(err, "failed to allocate memory for layers");
+        return NULL;
+    }
+
+    struct SConfNode *base = sconf_node_create(SCONF_TYPE_DICT, NULL, err);
+    if (!base) {
+        free(layers);
+        return NULL;
+    }
+    layers->sources[SCONF_SOURCE_DEFAULTS] = base;
+
+    for (int source = SCONF_SOURCE_DEFAULTS - 1; source >= 0; source--)
+    {
+        base = sconf_overlay_create(base, err);
+        if (!base) {
+            sconf_layers_destroy(layers);
+            return NULL;
+        }
+        layers->sources[source] = base;
+    }
+
+    return layers;
+}
+
+/**
+ * @brief Destroy config layers and the config trees of all sources.
+ *
+ * @param layers The config layers.
+ */
+void sconf_layers_destroy(struct SConfLayers *layers)
+{
+    if (!layers) {
+        return;
+    }
+
+    /* Overlays before the trees they are based on */
+    for (int source = 0; source < SCONF_SOURCE_MAX; source++)
+    {
+        sconf_node_destroy(layers->sources[source]);
+    }
+
+    free(layers);
+}
+
+/**
+ * @brief Get root of the resolved config.
+ *
+ * @param layers The config layers.
+ *
+ * @return root config node, or NULL if layers is NULL.
+ */
+struct SConfNode *sconf_layers_root(struct SConfLayers *layers)
+{
+    if (!layers) {
+        return NULL;
+    }
+
+    return layers->sources[SCONF_SOURCE_OPTS];
+}
+
+/**
+ * @brief Get config tree of a single source.
+ *
+ * @param layers The config layers.
+ * @param source The config source (e.g SCONF_SOURCE_ENV).
+ *
+ * @return root config node of source, or NULL if source is not valid.
+ */
+struct SConfNode *sconf_layers_source(struct SConfLayers *layers, int source)
+{
+    if (!layers || source < 0 || source >= SCONF_SOURCE_MAX) {
+        return NULL;
+    }
+
+    return layers->sources[source];
+}
+
+/**
+ * @brief Fill config layers based on config map.
+ *
+ * Unlike sconf_initialize, the precedence of sources does not depend on the
+ * order they are read in: options win over environment variables, which
+ * win over YAML files, regardless of where a YAML file is given on the
+ * command line.
+ *
+ * @param layers The config layers.
+ * @param map    Config map.
+ * @param argc   Number of arguments.
+ * @param argv   Array of arguments.
+ * @param user   User-supplied data passed to callback functions.
+ * @param err    Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sconf_layers_initialize(struct SConfLayers *layers,
+                            const struct SConfMap *map, int argc, char **argv,
+                            void *user, struct SConfErr *err)
+{
+    if (!layers) {
+        sconf_err_set(err, "layers are not specified");
+        return -1;
+    }
+
+    if (!map) {
+        sconf_err_set(err, "config map is missing");
+        return -1;
+    }
+
+    struct SConfNode **sources = layers->sources;
+    struct SConfNode *files = sources[SCONF_SOURCE_FILE];
+
+    if (sconf_opts_parse_into(sources[SCONF_SOURCE_OPTS], files, map, argc,
+                              argv, user, err) == -1) {
+        return -1;
+    }
+
+    if (sconf_env_read_into(sources[SCONF_SOURCE_ENV], files, map,
+                            err) == -1) {
+        return -1;
+    }
+
+    /* Defaults are only looked up in their own (initially empty) layer */
+    if (sconf_defaults_into(sources[SCONF_SOURCE_DEFAULTS],
+                            sources[SCONF_SOURCE_OPTS], files, map,
+                            err) == -1) {
+        return -1;
+    }
+
+    return sconf_validate(sources[SCONF_SOURCE_OPTS], map, user, err);
+}
+
+/**
+ * @brief Get config node based on path, and the source it was set by.
+ *
+ * @param layers The config layers.
+ * @param path   The path to the config node to get.
+ * @param node   Pointer to node, if found.
+ * @param source Pointer to source of node if found (may be NULL).
+ * @param err    Pointer to error struct.
+ *
+ * @return 1 on found, 0 on not found, -1 on error.
+ */
+int sconf_layers_get(struct SConfLayers *layers, const char *path,
+                     struct SConfNode **node, int *source,
+                     struct SConfErr *err)
+{
+    if (!layers) {
+        sconf_err_set(err, "layers are not specified");
+        return -1;
+    }
+
+    for (int i = 0; i < SCONF_SOURCE_MAX; i++)
+    {
+        int r = sconf_overlay_get_own(layers->sources[i], path, node, err);
+        if (r != 0) {
+            if (r == 1 && source) {
+                *source = i;
+            }
+            return r;
+        }
+    }
+
+    return 0;
+}
+
+static int sconf_layers_copy(struct SConfNode *dst, struct SConfNode *src,
+                             struct SConfErr *err);
+
+/**
+ * @internal
+ * @brief Copy node into parent, unless set by a source with higher
+ * precedence.
+ *
+ * @param parent The parent (dictionary or array) in the flattened tree.
+ * @param name   Name of node if parent is a dictionary.
+ * @param index  Index of node if parent is an array.
+ * @param node   The node to copy.
+ * @param err    Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int sconf_layers_copy_node(struct SConfNode *parent, const char *name,
+                                  uint32_t index, struct SConfNode *node,
+                                  struct SConfErr *err)
+{
+    struct SConfNode *existing = NULL;
+
+    int r = parent->type == SCONF_TYPE_DICT ?
+        sconf_node_dict_search(name, parent, &existing, err) :
+        sconf_node_array_search(index, parent, &existing, err);
+    if (r == -1) {
+        return -1;
+    }
+
+    if (existing) {
+        if (existing->type != node->type ||
+                (node->type != SCONF_TYPE_DICT &&
+                 node->type != SCONF_TYPE_ARRAY)) {
+            /* Scalar or other type set by a source with higher precedence */
+            return 0;
+        }
+        return sconf_layers_copy(existing, node, err);
+    }
+
+    void *data = NULL;
+
+    switch (node->type)
+    {
+        case SCONF_TYPE_STR:
+            data = (void *)sconf_node_str(node);
+            break;
+        case SCONF_TYPE_INT:
+            data = &node->integer;
+            break;
+        case SCONF_TYPE_BOOL:
+            data = &node->boolean;
+            break;
+        case SCONF_TYPE_FLOAT:
+            data = &node->fp;
+            break;
+    }
+
+    struct SConfNode *copy = sconf_node_create_and_insert(name, node->type,
+                                                          parent, index, data,
+                                                          err);
+    if (!copy) {
+        return -1;
+    }
+
+    if (node->type == SCONF_TYPE_DICT || node->type == SCONF_TYPE_ARRAY) {
+        return sconf_layers_copy(copy, node, err);
+    }
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Copy dictionary entry, see sconf_layers_copy_node.
+ */
+static int sconf_layers_copy_dict_cb(const unsigned char *name,
+                                     struct SConfNode *node, void *user,
+                                     struct SConfErr *err)
+{
+    return sconf_layers_copy_node(user, (const char *)name, 0, node, err);
+}
+
+/**
+ * @internal
+ * @brief Copy array entry, see sconf_layers_copy_node.
+ */
+static int sconf_layers_copy_array_cb(uint32_t index, struct SConfNode *node,
+                                      void *user, struct SConfErr *err)
+{
+    return sconf_layers_copy_node(user, NULL, index, node, err);
+}
+
+/**
+ * @internal
+ * @brief Copy children of a dictionary or array, keeping the ones already
+ * set in dst.
+ *
+ * @param dst The dictionary or array to copy to.
+ * @param src The dictionary or array to copy from (same type as dst).
+ * @param err Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int sconf_layers_copy(struct SConfNode *dst, struct SConfNode *src,
+                             struct SConfErr *err)
+{
+    assert(dst->type == src->type);
+
+    if (src->type == SCONF_TYPE_DICT) {
+        return sconf_node_dict_foreach(src, &sconf_layers_copy_dict_cb, dst,
+                                       err);
+    }
+
+    return sconf_node_array_foreach(src, &sconf_layers_copy_array_cb, dst,
+                                    err);
+}
+
+/**
+ * @brief Flatten config layers into a single config tree.
+ *
+ * @param layers The config layers.
+ * @param err    Pointer to error struct.
+ *
+ * @return root of new config tree on success, NULL otherwise.
+ */
+struct SConfNode *sconf_layers_flatten(struct SConfLayers *layers,
+                                       struct SConfErr *err)
+{
+    if (!layers) {
+        sconf_err_set(err, "layers are not specified");
+        return NULL;
+    }
+
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, err);
+    if (!root) {
+        return NULL;
+    }
+
+    /* Highest precedence first, values already copied are kept */
+    for (int source = 0; source < SCONF_SOURCE_MAX; source++)
+    {
+        if (sconf_layers_copy(root, layers->sources[source], err) == -1) {
+            sconf_node_destroy(root);
+            return NULL;
+        }
+    }
+
+    return root;
+}
@@ -0,0 +1,535 @@
+#include <assert.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "array.h"
+#include "dict.h"
+#include "freeze.h"
+#include "handle.h"
+#include "sconf_private.h"
+
+/* Dictionaries in dst with more children than this many times the children
+   to merge from src are searched instead of walked */
+#ifndef SCONF_MERGE_WALK_RATIO
+#define SCONF_MERGE_WALK_RATIO 4
+#endif
+
+/* Child of a dictionary in src, and the child with the same name in dst */
+struct SConfMergeEntry {
+    const char *name;
+    uint32_t len;
+    struct SConfNode *node;
+    struct SConfNode *match;
+};
+
+/* Used to collect and match dictionary entries with sconf_dict_foreach */
+struct SConfMergeEntries {
+    struct SConfMergeEntry *entries;
+    uint32_t count;
+    uint32_t size;
+
+    /* Next entry to match */
+    uint32_t pos;
+};
+
+static int sconf_merge_dict(struct SConfNode *dst, struct SConfNode *src,
+                            int policy, struct SConfErr *err);
+static int sconf_merge_check(struct SConfNode *dst, struct SConfNode *src,
+                             struct SConfErr *err);
+
+/**
+ * @internal
+ * @brief Merge src array into dst array, index by index.
+ *
+ * Nodes moved to dst are removed from src, the rest are left for the caller
+ * to destroy with src.
+ *
+ * @param dst    The array to merge into.
+ * @param src    The array to merge from.
+ * @param policy Merge policy (e.g SCONF_MERGE_OVERWRITE).
+ * @param err    Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int sconf_merge_array(struct SConfNode *dst, struct SConfNode *src,
+                             int policy, struct SConfErr *err);
+
+/**
+ * @internal
+ * @brief Merge src node into dst node with the same name or index.
+ *
+ * @param dst    The node in dst.
+ * @param src    The node in src.
+ * @param policy Merge policy (e.g SCONF_MERGE_OVERWRITE).
+ * @param err    Pointer to error struct.
+ *
+ * @return 1 if src replaces dst, 0 if dst is kept, -1 on error.
+ */
+static int sconf_merge_node(struct SConfNode *dst, struct SConfNode *src,
+                            int policy, struct SConfErr *err)
+{
+    if (dst->type == src->type) {
+        switch (dst->type)
+        {
+            case SCONF_TYPE_DICT:
+                return sconf_merge_dict(dst, src, policy, err);
+            case SCONF_TYPE_ARRAY:
+                return sconf_merge_array(dst, src, policy, err);
+        }
+
+        return policy == SCONF_MERGE_KEEP ? 0 : 1;
+    }
+
+    switch (policy)
+    {
+        case SCONF_MERGE_KEEP:
+            return 0;
+        case SCONF_MERGE_OVERWRITE:
+            return 1;
+    }
+
+    sconf_err_set(err, "node already exist, but types does not match "
+                  "('%s' != '%s')", sconf_type_to_str(src->type),
+                  sconf_type_to_str(dst->type));
+    return -1;
+}
+
+/**
+ * @internal
+ * @brief Get data of scalar, as used when creating nodes.
+ */
+static void *sconf_merge_value_data(struct SConfNode *value, uint8_t type)
+{
+    switch (type)
+    {
+        case SCONF_TYPE_FLOAT:
+            return &value->fp;
+        case SCONF_TYPE_BOOL:
+            return &value->boolean;
+    }
+
+    return &value->integer;
+}
+
+/**
+ * @internal
+ * @brief Merge src packed array into dst array packed with the same type, or
+ * empty.
+ *
+ * @param dst    The array to merge into.
+ * @param src    The packed array to merge from.
+ * @param policy Merge policy (e.g SCONF_MERGE_OVERWRITE).
+ * @param err    Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int sconf_merge_packed(struct SConfArray *dst, struct SConfArray *src,
+                              int policy, struct SConfErr *err)
+{
+    uint8_t type = src->packed;
+    struct SConfNode value;
+
+    uint32_t i = 0;
+    if (!dst->packed) {
+        /* Packs the empty array */
+        sconf_array_pack_value(src, 0, &value);
+        if (sconf_array_pack_append(dst, type,
+                                    sconf_merge_value_data(&value, type),
+                                    err) == -1) {
+            return -1;
+        }
+        i = 1;
+    }
+
+    if (sconf_array_reserve(dst, src->size, err) == -1) {
+        return -1;
+    }
+
+    if (policy != SCONF_MERGE_KEEP) {
+        for (; i < dst->size && i < src->size; i++)
+        {
+            sconf_array_pack_value(src, i, &value);
+            sconf_array_pack_set(dst, i, sconf_merge_value_data(&value, type));
+        }
+    }
+
+    for (i = dst->size; i < src->size; i++)
+    {
+        sconf_array_pack_value(src, i, &value);
+        if (sconf_array_pack_append(dst, type,
+                                    sconf_merge_value_data(&value, type),
+                                    err) == -1) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int sconf_merge_array(struct SConfNode *dst, struct SConfNode *src,
+                             int policy, struct SConfErr *err)
+{
+    struct SConfArray *d = dst->array;
+    struct SConfArray *s = src->array;
+
+    if (s->size == 0) {
+        return 0;
+    }
+
+    if (s->packed &&
+            (d->packed == s->packed || (!d->packed && sconf_array_is_empty(d)))) {
+        return sconf_merge_packed(d, s, policy, err);
+    }
+
+    if (sconf_node_array_unpack(dst, err) == -1 ||
+            sconf_node_array_unpack(src, err) == -1) {
+        return -1;
+    }
+
+    /* Grow once, instead of for each node moved */
+    if (s->size > d->size && sconf_array_reserve(d, s->size, err) == -1) {
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < s->size; i++)
+    {
+        struct SConfNode *node = s->entries[i];
+        if (!node) {
+            continue;
+        }
+
+        struct SConfNode *existing = i < d->size ? d->entries[i] : NULL;
+        if (!existing) {
+            if (sconf_array_insert(d, i, node, err) == -1) {
+                return -1;
+            }
+            s->entries[i] = NULL;
+            continue;
+        }
+
+        int r = sconf_merge_node(existing, node, policy, err);
+        if (r == -1) {
+            return -1;
+        }
+        if (r == 1) {
+            d->entries[i] = node;
+            s->entries[i] = NULL;
+            sconf_node_destroy(existing);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Collect child of dictionary in src.
+ */
+static int sconf_merge_collect_cb(const unsigned char *name,
+                                  struct SConfNode *node, void *user,
+                                  struct SConfErr *err)
+{
+    struct SConfMergeEntries *entries = user;
+
+    (void)err;
+
+    assert(entries->count < entries->size);
+
+    struct SConfMergeEntry *entry = &entries->entries[entries->count++];
+    entry->name = (const char *)name;
+    entry->len = (uint32_t)strlen((const char *)name);
+    entry->node = node;
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Match child of dictionary in dst with the collected children of
+ * src. Both are visited in key order.
+ */
+static int sconf_merge_match_cb(const unsigned char *name,
+                                struct SConfNode *node, void *user,
+                                struct SConfErr *err)
+{
+    struct SConfMergeEntries *entries = user;
+    uint32_t len = (uint32_t)strlen((const char *)name);
+
+    (void)err;
+
+    while (entries->pos < entries->count)
+    {
+        struct SConfMergeEntry *entry = &entries->entries[entries->pos];
+        int r = sconf_frozen_key_cmp(entry->name, entry->len,
+                                     (const char *)name, len);
+        if (r > 0) {
+            break;
+        }
+
+        entries->pos++;
+        if (r == 0) {
+            entry->match = node;
+            break;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Merge src dictionary into dst dictionary.
+ *
+ * The children of src are moved to dst or destroyed, src is left empty even
+ * on error, except when memory for the merge can not be allocated.
+ *
+ * @param dst    The dictionary to merge into.
+ * @param src    The dictionary to merge from.
+ * @param policy Merge policy (e.g SCONF_MERGE_OVERWRITE).
+ * @param err    Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int sconf_merge_dict(struct SConfNode *dst, struct SConfNode *src,
+                            int policy, struct SConfErr *err)
+{
+    uint64_t count = sconf_dict_count(src);
+    if (count == 0) {
+        return 0;
+    }
+
+    struct SConfMergeEntries entries = {
+        .entries = calloc(count, sizeof(struct SConfMergeEntry)),
+        .size = (uint32_t)count,
+    };
+    if (!entries.entries) {
+        sconf_err_set(err, "failed to allocate memory for merge");
+        return -1;
+    }
+
+    /* Children of both are visited in key order */
+    sconf_dict_foreach(src, &sconf_merge_collect_cb, &entries, err);
+    assert(entries.count == count);
+
+    if (sconf_dict_count(dst) / SCONF_MERGE_WALK_RATIO > count) {
+        for (uint32_t i = 0; i < entries.count; i++)
+        {
+            struct SConfMergeEntry *entry = &entries.entries[i];
+            entry->match = sconf_dict_lookup(dst, entry->name, entry->len);
+        }
+    }
+    else {
+        sconf_dict_foreach(dst, &sconf_merge_match_cb, &entries, err);
+    }
+
+    uint32_t i = 0;
+    for (; i < entries.count; i++)
+    {
+        struct SConfMergeEntry *entry = &entries.entries[i];
+
+        if (!entry->match) {
+            if (sconf_dict_add(dst, entry->name, entry->len, entry->node,
+                               err) == -1) {
+                break;
+            }
+            continue;
+        }
+
+        int r = sconf_merge_node(entry->match, entry->node, policy, err);
+        if (r == -1) {
+            break;
+        }
+        if (r == 1) {
+            sconf_dict_replace(dst, entry->name, entry->len, entry->node);
+            sconf_node_destroy(entry->match);
+        }
+        else {
+            sconf_node_destroy(entry->node);
+        }
+    }
+
+    int r = 0;
+    if (i < entries.count) {
+        /* Not moved to dst */
+        for (; i < entries.count; i++)
+        {
+            sconf_node_destroy(entries.entries[i].node);
+        }
+        r = -1;
+    }
+
+    sconf_dict_release(src);
+    free(entries.entries);
+
+    return r;
+}
+
+/**
+ * @internal
+ * @brief Get type of element in array.
+ *
+ * @return type of element, or 0 if there is no element at index.
+ */
+static uint8_t sconf_merge_element_type(const struct SConfArray *array,
+                                        uint32_t index)
+{
+    if (array->packed) {
+        return array->packed;
+    }
+
+    return array->entries[index] ? array->entries[index]->type : 0;
+}
+
+/**
+ * @internal
+ * @brief Check that nodes in both src and dst array have the same type.
+ */
+static int sconf_merge_check_array(struct SConfNode *dst,
+                                   struct SConfNode *src, struct SConfErr *err)
+{
+    const struct SConfArray *d = dst->array;
+    const struct SConfArray *s = src->array;
+
+    for (uint32_t i = 0; i < d->size && i < s->size; i++)
+    {
+        uint8_t d_type = sconf_merge_element_type(d, i);
+        uint8_t s_type = sconf_merge_element_type(s, i);
+        if (!d_type || !s_type) {
+            continue;
+        }
+
+        if (d_type != s_type) {
+            sconf_err_set(err, "node '[%" PRIu32 "]' already exist, but types "
+                          "does not match ('%s' != '%s')", i,
+                          sconf_type_to_str(s_type),
+                          sconf_type_to_str(d_type));
+            return -1;
+        }
+
+        if (!d->packed && !s->packed &&
+                sconf_merge_check(d->entries[i], s->entries[i], err) == -1) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Check that a child of src has the same type as in dst.
+ */
+static int sconf_merge_check_cb(const unsigned char *name,
+                                struct SConfNode *node, void *user,
+                                struct SConfErr *err)
+{
+    struct SConfNode *dst = user;
+    uint32_t len = (uint32_t)strlen((const char *)name);
+
+    struct SConfNode *existing = sconf_dict_lookup(dst, (const char *)name,
+                                                   len);
+    if (!existing) {
+        return 0;
+    }
+
+    if (existing->type != node->type) {
+        sconf_err_set(err, "node '%s' already exist, but types does not match "
+                      "('%s' != '%s')", (const char *)name,
+                      sconf_type_to_str(node->type),
+                      sconf_type_to_str(existing->type));
+        return -1;
+    }
+
+    return sconf_merge_check(existing, node, err);
+}
+
+/**
+ * @internal
+ * @brief Check that all nodes in both src and dst have the same type, before
+ * anything is moved.
+ *
+ * @param dst The node in dst.
+ * @param src The node in src, with the same type.
+ * @param err Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int sconf_merge_check(struct SConfNode *dst, struct SConfNode *src,
+                             struct SConfErr *err)
+{
+    switch (src->type)
+    {
+        case SCONF_TYPE_DICT:
+            return sconf_dict_foreach(src, &sconf_merge_check_cb, dst, err);
+        case SCONF_TYPE_ARRAY:
+            return sconf_merge_check_array(dst, src, err);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Merge config tree into another, moving its nodes.
+ *
+ * @param dst    The config root node to merge into.
+ * @param src    The config root node to merge from, left empty unless the
+ *               merge fails before anything is moved.
+ * @param policy Merge policy (e.g SCONF_MERGE_OVERWRITE).
+ * @param err    Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sconf_merge(struct SConfNode *dst, struct SConfNode *src, int policy,
+                struct SConfErr *err)
+{
+    if (!dst || !src) {
+        sconf_err_set(err, "no config tree was specified for merge");
+        return -1;
+    }
+
+    if (dst->type != SCONF_TYPE_DICT || src->type != SCONF_TYPE_DICT) {
+        sconf_err_set(err, "config trees to merge must be dicts");
+        return -1;
+    }
+
+    if ((dst->flags | src->flags) & SCONF_NODE_FLAG_FROZEN) {
+        sconf_err_set(err, "config node is frozen");
+        return -1;
+    }
+
+    if (dst == src) {
+        sconf_err_set(err, "can not merge config tree into itself");
+        return -1;
+    }
+
+    /* Merging into the values set in the overlay alone would ignore the
+       base, so types and policy could not be checked against what lookups
+       on the overlay see */
+    if (dst->flags & SCONF_NODE_FLAG_OVERLAY) {
+        sconf_err_set(err, "can not merge config tree into an overlay");
+        return -1;
+    }
+
+    if (dst->arena != src->arena) {
+        sconf_err_set(err, "config trees to merge must be allocated from the "
+                      "same arena");
+        return -1;
+    }
+
+    if (policy < SCONF_MERGE_OVERWRITE || policy > SCONF_MERGE_ERROR) {
+        sconf_err_set(err, "unknown merge policy %d", policy);
+        return -1;
+    }
+
+    if (policy == SCONF_MERGE_ERROR && sconf_merge_check(dst, src, err) == -1) {
+        return -1;
+    }
+
+    int r = sconf_merge_dict(dst, src, policy, err);
+
+    /* Nodes moved or destroyed */
+    sconf_generation_bump(dst);
+
+    return r;
+}
@@ -370,6 +370,7 @@ static int sconf_opts_handle_option_bool(struct SConfNode *root,
  * @brief Handle YAML file option.
  *
  * @param root  The config root node.
+ * @param files The config root node to read the YAML file into.
  * @param entry Config map entry.
  * @param value Option argument value.
  * @param err   Pointer to error struct.
@@ -377,15 +378,17 @@ static int sconf_opts_handle_option_bool(struct SConfNode *root,
  * @return 0 on success, -1 otherwise.
  */
 static int sconf_opts_handle_option_yaml_file(struct SConfNode *root,
+                                              struct SConfNode *files,
                                               const struct SConfMap *entry,
                                               const char *value,
                                               struct SConfErr *err)
 {
     assert(root);
+    assert(files);
     assert(entry);
     assert(value);
 
-    if (sconf_yaml_read(root, value, err) == -1) {
+    if (sconf_yaml_read(files, value, err) == -1) {
         return -1;
     }
     if (sconf_set_str(root, entry->path, value, err) == -1) {
@@ -639,6 +642,7 @@ static int sconf_opts_handle_option_usage(struct SConfNode *root,
  * @brief Handle option returned by `getopt_long`.
  *
  * @param root  The config root node.
+ * @param files The config root node to read YAML files into.
  * @param entry Config map entry.
  * @param map   Config map.
  * @param value Option argument value.
@@ -649,6 +653,7 @@ static int sconf_opts_handle_option_usage(struct SConfNode *root,
  * @return 0 on success, -1 otherwise.
  */
 static int sconf_opts_handle_option(struct SConfNode *root,
+                                    struct SConfNode *files,
                                     const struct SConfMap *entry,
                                     const struct SConfMap *map,
                                     const char *value, void *user,
@@ -684,7 +689,7 @@ static int sconf_opts_handle_option(struct SConfNode *root,
             break;
 
         case SCONF_TYPE_YAML_FILE:
-            if (sconf_opts_handle_option_yaml_file(root, entry,
+            if (sconf_opts_handle_option_yaml_file(root, files, entry,
                                                    value, err) == -1) {
                 return -1;
             }
@@ -721,7 +726,28 @@ static int sconf_opts_handle_option(struct SConfNode *root,
 int sconf_opts_parse(struct SConfNode *root, const struct SConfMap *map,
                      int argc, char **argv, void *user, struct SConfErr *err)
 {
-    if (!root) {
+    return sconf_opts_parse_into(root, root, map, argc, argv, user, err);
+}
+
+/**
+ * @brief Parse application arguments based on config map, reading YAML
+ * files into a separate config tree.
+ *
+ * @param root  The config root node.
+ * @param files The config root node to read YAML files into.
+ * @param map   Config map.
+ * @param argc  Number of arguments.
+ * @param argv  Array of arguments.
+ * @param user  User-supplied data passed to usage callback function.
+ * @param err   Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sconf_opts_parse_into(struct SConfNode *root, struct SConfNode *files,
+                          const struct SConfMap *map, int argc, char **argv,
+                          void *user, struct SConfErr *err)
+{
+    if (!root || !files) {
         sconf_err_set(err, "no root specified when parsing opts");
         return -1;
     }
@@ -796,8 +822,8 @@ int sconf_opts_parse(struct SConfNode *root, const struct SConfMap *map,
             return -1;
         }
 
-        r = sconf_opts_handle_option(root, opts_index[c], map, optarg, user,
-                                     argv[0], err);
+        r = sconf_opts_handle_option(root, files, opts_index[c], map, optarg,
+                                     user, argv[0], err);
         if (r == -1) {
             return -1;
         }
@@ -0,0 +1,47 @@
+#include <stdlib.h>
+
+#include "dict.h"
+#include "overlay.h"
+#include "sconf_private.h"
+
+/**
+ * @brief Create copy-on-write overlay on a config tree.
+ *
+ * Nothing is copied from the base, values set in the overlay are stored in
+ * the overlay itself and lookups fall back to the base.
+ *
+ * @param base The base config root node.
+ * @param err  Pointer to error struct.
+ *
+ * @return overlay root node on success, NULL otherwise.
+ */
+struct SConfNode *sconf_overlay_create(struct SConfNode *base,
+                                       struct SConfErr *err)
+{
+    if (!base) {
+        sconf_err_set(err, "no base was specified for overlay");
+        return NULL;
+    }
+
+    if (base->type != SCONF_TYPE_DICT) {
+        sconf_err_set(err, "base of overlay must be a dict");
+        return NULL;
+    }
+
+    struct SConfOverlay *overlay = calloc(1, sizeof(*overlay));
+    if (!overlay) {
+        sconf_err_set(err, "could not allocate memory for overlay");
+        return NULL;
+    }
+
+    overlay->node.type = SCONF_TYPE_DICT;
+    overlay->node.flags = SCONF_NODE_FLAG_OVERLAY;
+    overlay->base = base;
+
+    if (sconf_dict_init(&overlay->node, err) == -1) {
+        free(overlay);
+        return NULL;
+    }
+
+    return &overlay->node;
+}
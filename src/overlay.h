@@ -0,0 +1,30 @@
+#pragma once
+
+#include "sconf.h"
+#include "sconf_private.h"
+
+/* Overlay on a base tree (SCONF_NODE_FLAG_OVERLAY). The node is the
+   dictionary holding the values set in the overlay, lookups that do not
+   find a value there fall back to the base. */
+struct SConfOverlay {
+    /* Must be first, the overlay is freed through the node */
+    struct SConfNode node;
+
+    struct SConfNode *base;
+};
+
+/**
+ * @brief Get the base tree of an overlay.
+ */
+static inline struct SConfNode *sconf_overlay_base(
+        const struct SConfNode *overlay)
+{
+    return ((const struct SConfOverlay *)overlay)->base;
+}
+
+/**
+ * @brief Get config node set in an overlay itself, without falling back to
+ * the base. Also works on plain config trees.
+ */
+int sconf_overlay_get_own(struct SConfNode *overlay, const char *path,
+                          struct SConfNode **node, struct SConfErr *err);
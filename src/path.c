@@ -0,0 +1,209 @@
+#include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "path.h"
+#include "sconf.h"
+
+/* The delimiter used to split the path */
+#define SCONF_PATH_DELIMITER '.'
+
+/**
+ * @brief Get index of array from path segment.
+ *
+ * @param name  Path segment (e.g "[3]"), does not need to be null terminated.
+ * @param len   Length of path segment.
+ * @param index Pointer to index integer to set.
+ * @param err   Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sconf_path_index_parse(const char *name, uint32_t len, uint32_t *index,
+                           struct SConfErr *err)
+{
+    assert(name);
+
+    if (len < 2 || name[0] != '[' || name[len - 1] != ']') {
+        sconf_err_set(err, "array index must be between brackets");
+        return -1;
+    }
+
+    /* strtol stops at the end bracket at the latest */
+    char *endptr;
+    errno = 0;
+
+    long long num = strtoll(name + 1, &endptr, 10);
+
+    if (errno != 0) {
+        sconf_err_set(err, "could not get array index '%.*s': %s", (int)len,
+                      name, strerror(errno));
+        return -1;
+    }
+
+    if (endptr == name + 1) {
+        sconf_err_set(err, "no digits found in array index '%.*s'", (int)len,
+                      name);
+        return -1;
+    }
+
+    if (num < 0) {
+        sconf_err_set(err, "array index can not be a negative number '%.*s'",
+                      (int)len, name);
+        return -1;
+    }
+
+    if (endptr != name + len - 1) {
+        sconf_err_set(err, "invalid array index '%.*s'", (int)len, name);
+        return -1;
+    }
+
+    if (num > UINT32_MAX) {
+        errno = ERANGE;
+        sconf_err_set(err, "could not get array index '%.*s': %s", (int)len,
+                      name, strerror(errno));
+        return -1;
+    }
+
+    *index = (uint32_t)num;
+
+    return 0;
+}
+
+/**
+ * @brief Split path into segments.
+ *
+ * The segments point into the path string, which is not modified, so the
+ * string must outlive the parsed path. Empty segments are skipped, and
+ * array indexes (e.g "[3]") are parsed up front. Invalid array indexes are
+ * not an error here, since they are valid dictionary keys.
+ *
+ * @param path   Parsed path to fill in.
+ * @param string Path string (e.g "servers.[3].port").
+ * @param len    Length of path string.
+ * @param err    Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sconf_path_parse(struct SConfPath *path, const char *string, size_t len,
+                     struct SConfErr *err)
+{
+    assert(path);
+    assert(string);
+
+    path->string = string;
+    path->len = len;
+    path->depth = 0;
+
+    const char *end = string + len;
+    const char *curr = string;
+
+    while (curr < end)
+    {
+        const char *next = memchr(curr, SCONF_PATH_DELIMITER, end - curr);
+        if (!next) {
+            next = end;
+        }
+
+        if (next == curr) {
+            /* Skip empty segment */
+            curr++;
+            continue;
+        }
+
+        if (path->depth >= SCONF_MAX_DEPTH - 1) {
+            sconf_err_set(err, "maximum depth reached for path '%.*s'",
+                          (int)len, string);
+            return -1;
+        }
+
+        struct SConfPathSegment *segment = &path->segments[path->depth++];
+        segment->name = curr;
+        segment->len = (uint32_t)(next - curr);
+        segment->is_index = false;
+
+        if (curr[0] == '[' &&
+                sconf_path_index_parse(segment->name, segment->len,
+                                       &segment->index, NULL) == 0) {
+            segment->is_index = true;
+        }
+
+        curr = next + 1;
+    }
+
+    if (path->depth == 0) {
+        sconf_err_set(err, "path '%.*s' is empty", (int)len, string);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Compile path for repeated use.
+ *
+ * @param path The path to compile (e.g "upstream.servers.[3].port").
+ * @param err  Pointer to error struct.
+ *
+ * @return compiled path on success, NULL otherwise.
+ */
+struct SConfPath *sconf_path_compile(const char *path, struct SConfErr *err)
+{
+    if (!path) {
+        sconf_err_set(err, "no path was provided");
+        return NULL;
+    }
+
+    return sconf_path_compile_n(path, strlen(path), err);
+}
+
+/**
+ * @brief Compile path of given length for repeated use.
+ *
+ * @param path The path to compile (not null terminated).
+ * @param len  Length of path.
+ * @param err  Pointer to error struct.
+ *
+ * @return compiled path on success, NULL otherwise.
+ */
+struct SConfPath *sconf_path_compile_n(const char *path, size_t len,
+                                       struct SConfErr *err)
+{
+    if (!path) {
+        sconf_err_set(err, "no path was provided");
+        return NULL;
+    }
+
+    if (len > SIZE_MAX - sizeof(struct SConfPath) - 1) {
+        sconf_err_set(err, "path is too long");
+        return NULL;
+    }
+
+    /* The path string is stored right after the struct */
+    struct SConfPath *compiled = calloc(1, sizeof(struct SConfPath) + len + 1);
+    if (!compiled) {
+        sconf_err_set(err, "failed to allocate memory for path");
+        return NULL;
+    }
+
+    char *copy = (char *)(compiled + 1);
+    memcpy(copy, path, len);
+
+    if (sconf_path_parse(compiled, copy, len, err) == -1) {
+        free(compiled);
+        return NULL;
+    }
+
+    return compiled;
+}
+
+/**
+ * @brief Destroy compiled path.
+ *
+ * @param path The compiled path.
+ */
+void sconf_path_destroy(struct SConfPath *path)
+{
+    free(path);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sconf.h"
+
+struct SConfPathSegment {
+    /* Segment name, not null terminated */
+    const char *name;
+    uint32_t len;
+
+    /* Parsed array index, only valid if is_index is set */
+    uint32_t index;
+    bool is_index;
+};
+
+struct SConfPath {
+    /* The full path, used in error messages */
+    const char *string;
+    size_t len;
+
+    uint32_t depth;
+    struct SConfPathSegment segments[SCONF_MAX_DEPTH];
+};
+
+int sconf_path_parse(struct SConfPath *path, const char *string, size_t len,
+                     struct SConfErr *err);
+int sconf_path_index_parse(const char *name, uint32_t len, uint32_t *index,
+                           struct SConfErr *err);
@@ -0,0 +1,346 @@
+#include <assert.h>
+#include <pthread.h>
+#include <stdalign.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sconf.h"
+
+/* Readers are kept on separate cache lines, so a reader entering a read-side
+   section does not slow down the others */
+#define SCONF_CACHE_LINE 64
+
+/* Time to sleep between checks while waiting for readers */
+#define SCONF_REGISTRY_WAIT_NS 100000
+
+struct SConfReader {
+    alignas(SCONF_CACHE_LINE) struct SConfRegistry *registry;
+
+    /* Epoch when the current read-side section started, 0 if not reading */
+    uint64_t epoch;
+
+    /* Set while the reader is owned by a thread */
+    bool used;
+
+    /* Next reader, never changed after being added to the list */
+    struct SConfReader *next;
+};
+
+/* Tree replaced by a newer one, freed when no reader can use it anymore */
+struct SConfRetired {
+    struct SConfNode *root;
+    uint64_t epoch;
+    struct SConfRetired *next;
+};
+
+struct SConfRegistry {
+    struct SConfNode *root;
+    uint64_t epoch;
+
+    /* Lock-free list of readers, only ever grows */
+    struct SConfReader *readers;
+
+    /* Serializes writers, never taken by readers */
+    pthread_mutex_t lock;
+    struct SConfRetired *retired;
+};
+
+/**
+ * @brief Create registry holding the current config tree.
+ *
+ * @param root The initial config tree (may be NULL), owned by the registry.
+ * @param err  Pointer to error struct.
+ *
+ * @return registry on success, NULL otherwise.
+ */
+struct SConfRegistry *sconf_registry_create(struct SConfNode *root,
+                                            struct SConfErr *err)
+{
+    struct SConfRegistry *registry = calloc(1, sizeof(struct SConfRegistry));
+    if (!registry) {
+        sconf_err_set(err, "failed to allocate memory for registry");
+        return NULL;
+    }
+
+    if (pthread_mutex_init(&registry->lock, NULL) != 0) {
+        sconf_err_set(err, "failed to initialize registry lock");
+        free(registry);
+        return NULL;
+    }
+
+    registry->root = root;
+    registry->epoch = 1;
+
+    return registry;
+}
+
+/**
+ * @internal
+ * @brief Free retired trees that no reader can be using.
+ *
+ * Readers in a read-side section that started in an epoch after a tree was
+ * retired always see a newer tree, so the tree can be freed when all active
+ * readers started after it was retired. Must be called with the lock held.
+ *
+ * @param registry The registry.
+ *
+ * @return true if all retired trees were freed, false otherwise.
+ */
+static bool sconf_registry_reclaim(struct SConfRegistry *registry)
+{
+    uint64_t oldest = UINT64_MAX;
+
+    /* Readers added after this load see the new root */
+    for (struct SConfReader *reader = __atomic_load_n(&registry->readers,
+                                                      __ATOMIC_SEQ_CST);
+         reader; reader = reader->next)
+    {
+        uint64_t epoch = __atomic_load_n(&reader->epoch, __ATOMIC_SEQ_CST);
+        if (epoch != 0 && epoch < oldest) {
+            oldest = epoch;
+        }
+    }
+
+    struct SConfRetired **prev = &registry->retired;
+    while (*prev)
+    {
+        struct SConfRetired *retired = *prev;
+
+        if (retired->epoch < oldest) {
+            *prev = retired->next;
+            sconf_node_destroy(retired->root);
+            free(retired);
+        }
+        else {
+            prev = &retired->next;
+        }
+    }
+
+    return registry->retired == NULL;
+}
+
+/**
+ * @brief Destroy registry and all config trees it holds.
+ *
+ * No reader can be in a read-side section, and readers can not be used
+ * after the registry is destroyed.
+ *
+ * @param registry The registry.
+ */
+void sconf_registry_destroy(struct SConfRegistry *registry)
+{
+    if (!registry) {
+        return;
+    }
+
+    while (registry->retired)
+    {
+        struct SConfRetired *retired = registry->retired;
+        registry->retired = retired->next;
+        sconf_node_destroy(retired->root);
+        free(retired);
+    }
+
+    struct SConfReader *reader = registry->readers;
+    while (reader)
+    {
+        struct SConfReader *next = reader->next;
+        free(reader);
+        reader = next;
+    }
+
+    sconf_node_destroy(registry->root);
+    pthread_mutex_destroy(&registry->lock);
+    free(registry);
+}
+
+/**
+ * @brief Publish new config tree.
+ *
+ * The previous tree is freed once no reader can be using it anymore, which
+ * may happen in a later call to sconf_registry_publish or
+ * sconf_registry_synchronize.
+ *
+ * @param registry The registry.
+ * @param root     The new config tree, owned by the registry.
+ * @param err      Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sconf_registry_publish(struct SConfRegistry *registry,
+                           struct SConfNode *root, struct SConfErr *err)
+{
+    if (!registry) {
+        sconf_err_set(err, "no registry was specified");
+        return -1;
+    }
+
+    struct SConfRetired *retired = calloc(1, sizeof(struct SConfRetired));
+    if (!retired) {
+        sconf_err_set(err, "failed to allocate memory for registry");
+        return -1;
+    }
+
+    pthread_mutex_lock(&registry->lock);
+
+    retired->root = __atomic_exchange_n(&registry->root, root,
+                                        __ATOMIC_SEQ_CST);
+
+    /* Readers starting from now on see the new tree */
+    retired->epoch = __atomic_fetch_add(&registry->epoch, 1, __ATOMIC_SEQ_CST);
+
+    if (retired->root) {
+        retired->next = registry->retired;
+        registry->retired = retired;
+    }
+    else {
+        free(retired);
+    }
+
+    sconf_registry_reclaim(registry);
+
+    pthread_mutex_unlock(&registry->lock);
+
+    return 0;
+}
+
+/**
+ * @brief Wait until all replaced config trees are freed.
+ *
+ * Blocks until every reader that could be using a replaced tree has left
+ * its read-side section.
+ *
+ * @param registry The registry.
+ */
+void sconf_registry_synchronize(struct SConfRegistry *registry)
+{
+    if (!registry) {
+        return;
+    }
+
+    const struct timespec wait = { 0, SCONF_REGISTRY_WAIT_NS };
+
+    pthread_mutex_lock(&registry->lock);
+
+    while (!sconf_registry_reclaim(registry))
+    {
+        pthread_mutex_unlock(&registry->lock);
+        nanosleep(&wait, NULL);
+        pthread_mutex_lock(&registry->lock);
+    }
+
+    pthread_mutex_unlock(&registry->lock);
+}
+
+/**
+ * @brief Create reader used by one thread to read from registry.
+ *
+ * Readers released with sconf_registry_reader_destroy are reused.
+ *
+ * @param registry The registry.
+ * @param err      Pointer to error struct.
+ *
+ * @return reader on success, NULL otherwise.
+ */
+struct SConfReader *sconf_registry_reader_create(
+        struct SConfRegistry *registry, struct SConfErr *err)
+{
+    if (!registry) {
+        sconf_err_set(err, "no registry was specified");
+        return NULL;
+    }
+
+    /* Reuse a released reader */
+    for (struct SConfReader *reader = __atomic_load_n(&registry->readers,
+                                                      __ATOMIC_ACQUIRE);
+         reader; reader = reader->next)
+    {
+        bool used = false;
+        if (__atomic_compare_exchange_n(&reader->used, &used, true, false,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            return reader;
+        }
+    }
+
+    struct SConfReader *reader = aligned_alloc(
+            SCONF_CACHE_LINE, sizeof(struct SConfReader));
+    if (!reader) {
+        sconf_err_set(err, "failed to allocate memory for reader");
+        return NULL;
+    }
+
+    memset(reader, 0, sizeof(struct SConfReader));
+    reader->registry = registry;
+    reader->used = true;
+    reader->next = __atomic_load_n(&registry->readers, __ATOMIC_RELAXED);
+
+    while (!__atomic_compare_exchange_n(&registry->readers, &reader->next,
+                                        reader, true, __ATOMIC_SEQ_CST,
+                                        __ATOMIC_RELAXED))
+    {
+    }
+
+    return reader;
+}
+
+/**
+ * @brief Release reader, so it can be reused by another thread.
+ *
+ * The reader is freed when the registry is destroyed.
+ *
+ * @param reader The reader.
+ */
+void sconf_registry_reader_destroy(struct SConfReader *reader)
+{
+    if (!reader) {
+        return;
+    }
+
+    assert(__atomic_load_n(&reader->epoch, __ATOMIC_RELAXED) == 0);
+
+    __atomic_store_n(&reader->used, false, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Enter read-side section and get the current config tree.
+ *
+ * The tree stays valid until sconf_registry_read_end is called. Does not
+ * block or take any lock.
+ *
+ * @param reader The reader.
+ *
+ * @return the current config tree, NULL if none has been published.
+ */
+struct SConfNode *sconf_registry_read_begin(struct SConfReader *reader)
+{
+    assert(reader);
+    assert(__atomic_load_n(&reader->epoch, __ATOMIC_RELAXED) == 0);
+
+    struct SConfRegistry *registry = reader->registry;
+
+    /* Announce the epoch before loading the root, so a writer replacing the
+       root either sees the reader, or the reader sees the new root */
+    __atomic_store_n(&reader->epoch,
+                     __atomic_load_n(&registry->epoch, __ATOMIC_SEQ_CST),
+                     __ATOMIC_SEQ_CST);
+
+    return __atomic_load_n(&registry->root, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Leave read-side section.
+ *
+ * The config tree returned by sconf_registry_read_begin can not be used
+ * after this.
+ *
+ * @param reader The reader.
+ */
+void sconf_registry_read_end(struct SConfReader *reader)
+{
+    assert(reader);
+
+    __atomic_store_n(&reader->epoch, 0, __ATOMIC_RELEASE);
+}
@@ -2,17 +2,21 @@
 #include <errno.h>
 #include <inttypes.h>
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "arena.h"
 #include "array.h"
 #include "art.h"
+#include "dict.h"
+#include "freeze.h"
+#include "handle.h"
+#include "overlay.h"
+#include "path.h"
 #include "sconf_private.h"
 
-/* The delimiter used to split the path */
-#define SCONF_PATH_DELIMITER "."
-
 /**
  * Used to look up string representation of node types.
  */
@@ -86,7 +90,51 @@ const char *sconf_type_to_arg_type_str(uint8_t type)
  */
 const char *sconf_str(const struct SConfNode *node)
 {
-    return node->string;
+    return sconf_node_str(node);
+}
+
+/**
+ * @brief Return length of string from node.
+ *
+ * @param node Config node.
+ *
+ * @return length of string from node.
+ */
+size_t sconf_str_len(const struct SConfNode *node)
+{
+    return node->len;
+}
+
+/**
+ * @brief Compare strings of two string nodes.
+ *
+ * Long strings in the same arena-backed tree are interned, so they are
+ * compared by pointer.
+ *
+ * @param a First config node.
+ * @param b Second config node.
+ *
+ * @return true if the strings are equal, false otherwise.
+ */
+bool sconf_str_equal(const struct SConfNode *a, const struct SConfNode *b)
+{
+    if (a->len != b->len) {
+        return false;
+    }
+
+    bool inline_a = a->flags & SCONF_NODE_FLAG_STR_INLINE;
+    bool inline_b = b->flags & SCONF_NODE_FLAG_STR_INLINE;
+
+    if (!inline_a && !inline_b) {
+        if (a->string == b->string) {
+            return true;
+        }
+        if (a->arena && a->arena == b->arena) {
+            return false;
+        }
+    }
+
+    return memcmp(sconf_node_str(a), sconf_node_str(b), a->len) == 0;
 }
 
 /**
@@ -125,6 +173,53 @@ bool sconf_bool(const struct SConfNode *node)
     return node->boolean;
 }
 
+/* The atomic accessors need 8-byte values that are naturally aligned and
+   lock-free */
+static_assert(offsetof(struct SConfNode, integer) % 8 == 0,
+              "integer in config node must be naturally aligned");
+static_assert(offsetof(struct SConfNode, fp) % 8 == 0,
+              "float in config node must be naturally aligned");
+static_assert(sizeof(double) == sizeof(int64_t),
+              "double must be 8 bytes");
+
+/**
+ * @brief Return integer from node, using an atomic load.
+ *
+ * @param node Config node.
+ *
+ * @return integer from node.
+ */
+int64_t sconf_int_atomic(const struct SConfNode *node)
+{
+    return __atomic_load_n(&node->integer, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief Return floating-point number from node, using an atomic load.
+ *
+ * @param node Config node.
+ *
+ * @return float from node.
+ */
+double sconf_float_atomic(const struct SConfNode *node)
+{
+    double fp;
+    __atomic_load(&node->fp, &fp, __ATOMIC_ACQUIRE);
+    return fp;
+}
+
+/**
+ * @brief Return boolean from node, using an atomic load.
+ *
+ * @param node Config node.
+ *
+ * @return boolean from node.
+ */
+bool sconf_bool_atomic(const struct SConfNode *node)
+{
+    return __atomic_load_n(&node->boolean, __ATOMIC_ACQUIRE);
+}
+
 /**
  * @brief Return true if bool in node is true.
  *
@@ -203,51 +298,137 @@ const char *sconf_strerror(struct SConfErr *err)
 
 /**
  * @internal
- * @brief Get index of array from string.
+ * @brief Look up child node in dictionary.
  *
- * @param str   String to get index from.
- * @param index Pointer to index integer to set.
- * @param err   Pointer to error struct.
+ * @param dict     The dictionary node.
+ * @param name     Name of the child (not null terminated).
+ * @param name_len Length of name.
+ *
+ * @return Pointer to node if found, NULL otherwise.
+ */
+static inline struct SConfNode *sconf_node_dict_lookup(struct SConfNode *dict,
+                                                       const char *name,
+                                                       uint32_t name_len)
+{
+    return sconf_dict_lookup(dict, name, name_len);
+}
+
+/**
+ * @internal
+ * @brief Add child node to dictionary.
+ *
+ * @param dict     The dictionary node.
+ * @param name     Name of the child (not null terminated).
+ * @param name_len Length of name.
+ * @param node     Config node to add.
+ * @param err      Pointer to error struct.
  *
  * @return 0 on success, -1 otherwise.
  */
-static int sconf_array_get_index_from_string(const char *str,
-                                             uint32_t *index,
-                                             struct SConfErr *err)
+static int sconf_node_dict_add(struct SConfNode *dict, const char *name,
+                               uint32_t name_len, struct SConfNode *node,
+                               struct SConfErr *err)
 {
-    assert(str);
+    if (dict->flags & SCONF_NODE_FLAG_FROZEN) {
+        sconf_err_set(err, "config node is frozen");
+        return -1;
+    }
 
-    if ((str[0] != '[') || (str[strlen(str) -1] != ']')) {
-        sconf_err_set(err, "array index must be between brackets");
+    /* Names are handed out null terminated when iterating */
+    if (memchr(name, '\0', name_len)) {
+        sconf_err_set(err, "name '%.*s' contains a null byte", (int)name_len,
+                      name);
         return -1;
     }
 
-    char *endptr;
-    errno = 0;
+    if (sconf_dict_add(dict, name, name_len, node, err) == -1) {
+        return -1;
+    }
 
-    /* Skip start bracket */
-    str++;
+    sconf_generation_bump(dict);
 
-    long num = strtol(str, &endptr, 10);
+    return 0;
+}
 
-    if (errno != 0) {
-        sconf_err_set(err, "could not get array index '%s': %s", --str,
-                      strerror(errno));
-        return -1;
+/**
+ * @internal
+ * @brief Look up child node in array.
+ *
+ * @param array The array node.
+ * @param index Index of the child.
+ *
+ * @return Pointer to node if found, NULL otherwise.
+ */
+static inline struct SConfNode *sconf_node_array_lookup(
+        struct SConfNode *array, uint32_t index)
+{
+    if (!array->array || index >= array->array->size) {
+        return NULL;
+    }
+
+    if (array->array->packed) {
+        struct SConfNode **view = sconf_array_view(array->array, NULL);
+        return view ? view[index] : NULL;
     }
 
-    if (endptr == str) {
-        sconf_err_set(err, "no digits found in array index '%s'", --str);
+    return array->array->entries[index];
+}
+
+/**
+ * @brief Convert packed array to an array of nodes.
+ *
+ * @param node The array node.
+ * @param err  Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sconf_node_array_unpack(struct SConfNode *node, struct SConfErr *err)
+{
+    assert(node);
+    assert(node->type == SCONF_TYPE_ARRAY);
+
+    struct SConfArray *array = node->array;
+    if (!array->packed) {
+        return 0;
+    }
+
+    /* Packed arrays are never allocated from an arena */
+    assert(!array->arena);
+
+    struct SConfNode **entries = sconf_arena_calloc(array->arena, array->size,
+                                                    sizeof(struct SConfNode *));
+    if (!entries) {
+        sconf_err_set(err, "failed to allocate memory for array elements");
         return -1;
     }
 
-    if (num < 0) {
-        sconf_err_set(err, "array index can not be a negative number '%s'",
-                      --str);
+    /* Nodes already handed out for the values stay valid, they become the
+       entries of the array */
+    struct SConfNode **view = sconf_array_view(array, err);
+    if (!view) {
+        sconf_arena_free(array->arena, entries);
         return -1;
     }
 
-    *index = num;
+    for (uint32_t i = 0; i < array->size; i++)
+    {
+        entries[i] = view[i];
+        entries[i]->flags &= ~SCONF_NODE_FLAG_PACKED;
+    }
+
+    free(view);
+    array->view = NULL;
+    array->view_capacity = 0;
+
+    uint32_t size = array->size;
+
+    sconf_array_pack_release(array);
+    array->entries = entries;
+    array->size = size;
+    array->capacity = size;
+
+    /* The nodes are no longer part of a packed array */
+    sconf_generation_bump(node);
 
     return 0;
 }
@@ -270,6 +451,34 @@ int sconf_node_dict_insert(const char *name, struct SConfNode *parent,
         return -1;
     }
 
+    return sconf_node_dict_insert_n(name, strlen(name), parent, node, err);
+}
+
+/**
+ * @brief Insert config node in dictionary, with name of given length.
+ *
+ * @param name     The name of the node to insert (not null terminated).
+ * @param name_len Length of name.
+ * @param parent   Parent to add node to.
+ * @param node     Config node to add.
+ * @param err      Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sconf_node_dict_insert_n(const char *name, size_t name_len,
+                             struct SConfNode *parent, struct SConfNode *node,
+                             struct SConfErr *err)
+{
+    if (!name) {
+        sconf_err_set(err, "name was not specified");
+        return -1;
+    }
+
+    if (name_len > UINT32_MAX - 1) {
+        sconf_err_set(err, "name is too long");
+        return -1;
+    }
+
     if (!parent) {
         sconf_err_set(err, "parent was not specified");
         return -1;
@@ -285,13 +494,18 @@ int sconf_node_dict_insert(const char *name, struct SConfNode *parent,
         return -1;
     }
 
-    if (art_insert(&parent->dictionary, (unsigned char *)name,
-                   (int)strlen(name), node) != NULL) {
-        sconf_err_set(err, "inserting node into dict failed");
+    if (node->arena != parent->arena) {
+        sconf_err_set(err, "node and parent must be allocated from the same "
+                      "arena");
         return -1;
     }
 
-    return 0;
+    if ((node->flags | parent->flags) & SCONF_NODE_FLAG_FROZEN) {
+        sconf_err_set(err, "config node is frozen");
+        return -1;
+    }
+
+    return sconf_node_dict_add(parent, name, (uint32_t)name_len, node, err);
 }
 
 /**
@@ -312,62 +526,45 @@ int sconf_node_dict_search(const char *name, struct SConfNode *parent,
         return -1;
     }
 
-    if (!parent) {
-        sconf_err_set(err, "parent was not specified");
-        return -1;
-    }
-
-    if (parent->type != SCONF_TYPE_DICT) {
-        sconf_err_set(err, "parent node is not a dict");
-        return -1;
-    }
-
-    *node = (struct SConfNode *)art_search(&parent->dictionary,
-                                           (unsigned char *)name,
-                                           (int)strlen(name));
-
-    return 0;
+    return sconf_node_dict_search_n(name, strlen(name), parent, node, err);
 }
 
-/* Struct only used to pass needed pointers to art_iter callback when
-   implementing dictionary iterator. */
-struct SConfDictIterData {
-    int (*cb)(const unsigned char *, struct SConfNode *, void *,
-              struct SConfErr *);
-    void *user;
-    struct SConfErr *err;
-};
-
 /**
- * @internal
- * @brief art_iter callback function used when iterating over dictionary.
+ * @brief Search for node in dictionary, with name of given length.
  *
- * @param data    User-supplied data.
- * @param key     Key from dictionary.
- * @param key_len Length of the key.
- * @param value   Value from dictionary.
+ * @param name     The name to search for (not null terminated).
+ * @param name_len Length of name.
+ * @param parent   Parent to search for node in.
+ * @param node     Pointer to node, set to NULL if not found.
+ * @param err      Pointer to error struct.
  *
  * @return 0 on success, -1 otherwise.
  */
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wunused-parameter"
-static int sconf_node_dict_foreach_iter_cb(void *data, const unsigned char *key,
-                                           uint32_t key_len, void *value)
+int sconf_node_dict_search_n(const char *name, size_t name_len,
+                             struct SConfNode *parent, struct SConfNode **node,
+                             struct SConfErr *err)
 {
-    assert(data);
-    assert(key);
-    assert(value);
+    if (!name) {
+        sconf_err_set(err, "name was not specified");
+        return -1;
+    }
 
-    struct SConfDictIterData *iter_data = (struct SConfDictIterData *)data;
-    struct SConfNode *node = (struct SConfNode *)value;
+    if (!parent) {
+        sconf_err_set(err, "parent was not specified");
+        return -1;
+    }
 
-    if (iter_data->cb(key, node, iter_data->user, iter_data->err) != 0) {
+    if (parent->type != SCONF_TYPE_DICT) {
+        sconf_err_set(err, "parent node is not a dict");
         return -1;
     }
 
+    /* No name that long can be in the dictionary */
+    *node = name_len < UINT32_MAX ?
+            sconf_node_dict_lookup(parent, name, (uint32_t)name_len) : NULL;
+
     return 0;
 }
-#pragma GCC diagnostic pop
 
 /**
  * @brief Iterate over all nodes in dictionary.
@@ -401,14 +598,18 @@ int sconf_node_dict_foreach(struct SConfNode *dict,
         return -1;
     }
 
-    struct SConfDictIterData iter_data = { cb, user, err };
-    int r = art_iter(&dict->dictionary, sconf_node_dict_foreach_iter_cb,
-                     &iter_data);
-    if (r != 0) {
-        return -1;
+    if (dict->flags & SCONF_NODE_FLAG_FROZEN) {
+        for (uint32_t i = 0; i < dict->frozen.count; i++)
+        {
+            if (cb((const unsigned char *)dict->frozen.keys[i].name,
+                   &dict->frozen.children[i], user, err) != 0) {
+                return -1;
+            }
+        }
+        return 0;
     }
 
-    return 0;
+    return sconf_dict_foreach(dict, cb, user, err);
 }
 
 /**
@@ -439,13 +640,85 @@ int sconf_node_array_insert(uint32_t index, struct SConfNode *parent,
         return -1;
     }
 
+    if (node->arena != parent->arena) {
+        sconf_err_set(err, "node and parent must be allocated from the same "
+                      "arena");
+        return -1;
+    }
+
+    if ((node->flags | parent->flags) & SCONF_NODE_FLAG_FROZEN) {
+        sconf_err_set(err, "config node is frozen");
+        return -1;
+    }
+
+    if (sconf_node_array_unpack(parent, err) == -1) {
+        return -1;
+    }
+
     if (sconf_array_insert(parent->array, index, node, err) == -1) {
         return -1;
     }
 
+    sconf_generation_bump(parent);
+
     return 0;
 }
 
+/**
+ * @brief Append config node to array.
+ *
+ * @param parent Array to append node to.
+ * @param node   Config node to append.
+ * @param err    Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sconf_node_array_append(struct SConfNode *parent, struct SConfNode *node,
+                            struct SConfErr *err)
+{
+    if (!parent) {
+        sconf_err_set(err, "parent was not specified");
+        return -1;
+    }
+
+    if (parent->type != SCONF_TYPE_ARRAY) {
+        sconf_err_set(err, "parent node is not an array");
+        return -1;
+    }
+
+    return sconf_node_array_insert(parent->array->size, parent, node, err);
+}
+
+/**
+ * @brief Make room for a number of elements in array.
+ *
+ * @param array    The array node.
+ * @param capacity Number of elements the array must have room for.
+ * @param err      Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sconf_node_array_reserve(struct SConfNode *array, uint32_t capacity,
+                             struct SConfErr *err)
+{
+    if (!array) {
+        sconf_err_set(err, "array is not specified");
+        return -1;
+    }
+
+    if (array->type != SCONF_TYPE_ARRAY) {
+        sconf_err_set(err, "node is not an array");
+        return -1;
+    }
+
+    if (array->flags & SCONF_NODE_FLAG_FROZEN) {
+        sconf_err_set(err, "config node is frozen");
+        return -1;
+    }
+
+    return sconf_array_reserve(array->array, capacity, err);
+}
+
 /**
  * @brief Search for node in array.
  *
@@ -469,13 +742,18 @@ int sconf_node_array_search(uint32_t index, struct SConfNode *parent,
         return -1;
     }
 
-    if (!parent->array || !parent->array->entries) {
+    if (!parent->array ||
+            (!parent->array->entries && !parent->array->packed)) {
         sconf_err_set(err, "parent array is not initialized");
         return -1;
     }
 
+    if (parent->array->packed && !sconf_array_view(parent->array, err)) {
+        return -1;
+    }
+
     if (parent->array->size > index) {
-        *node = parent->array->entries[index];
+        *node = sconf_node_array_lookup(parent, index);
     }
 
     return 0;
@@ -505,14 +783,19 @@ int sconf_node_array_next(struct SConfNode *array, struct SConfNode **node,
         return -1;
     }
 
+    if (array->array->packed && !sconf_array_view(array->array, err)) {
+        return -1;
+    }
+
     for (uint32_t i = *next; i < array->array->size; i++)
     {
-        if (array->array->entries[i] == NULL) {
+        struct SConfNode *entry = sconf_node_array_lookup(array, i);
+        if (entry == NULL) {
             continue;
         }
 
         *next = i + 1;
-        *node = array->array->entries[i];
+        *node = entry;
 	return 1;
     }
 
@@ -550,13 +833,18 @@ int sconf_node_array_foreach(struct SConfNode *array,
         return -1;
     }
 
+    if (array->array->packed && !sconf_array_view(array->array, err)) {
+        return -1;
+    }
+
     for (uint32_t i = 0; i < array->array->size; i++)
     {
-        if (!array->array->entries[i]) {
+        struct SConfNode *entry = sconf_node_array_lookup(array, i);
+        if (!entry) {
             continue;
         }
 
-        if (cb(i, array->array->entries[i], user, err) != 0) {
+        if (cb(i, entry, user, err) != 0) {
             return -1;
         }
     }
@@ -564,48 +852,6 @@ int sconf_node_array_foreach(struct SConfNode *array,
     return 0;
 }
 
-/**
- * @internal
- * @brief Callback function to iterate used when destroying dictionary.
- *
- * @param data    User-supplied data.
- * @param key     Key from dictionary.
- * @param key_len Length of the key.
- * @param value   Value from dictionary.
- *
- * @return 0 on success.
- */
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wunused-parameter"
-static int sconf_node_dict_destroy_iter_cb(void *data, const unsigned char *key,
-                                           uint32_t key_len, void *value)
-{
-    assert(key);
-    assert(value);
-
-    struct SConfNode *node = (struct SConfNode *)value;
-
-    sconf_node_destroy(node);
-
-    return 0;
-}
-#pragma GCC diagnostic pop
-
-/**
- * @internal
- * @brief Destroy config node dictionary.
- *
- * @param node The config node.
- */
-static void sconf_node_dict_destroy(struct SConfNode *node)
-{
-    assert(node);
-    assert(node->type == SCONF_TYPE_DICT);
-
-    art_iter(&node->dictionary, sconf_node_dict_destroy_iter_cb, NULL);
-    art_tree_destroy(&node->dictionary);
-}
-
 /**
  * @internal
  * @brief Destroy config node array.
@@ -617,9 +863,10 @@ static void sconf_node_array_destroy(struct SConfNode *node)
     assert(node);
     assert(node->type == SCONF_TYPE_ARRAY);
     assert(node->array);
-    assert(node->array->entries);
+    assert(node->array->entries || node->array->packed);
 
-    for (uint32_t i = 0; i < node->array->size; i++)
+    /* Packed values are released with the array */
+    for (uint32_t i = 0; !node->array->packed && i < node->array->size; i++)
     {
         if (!node->array->entries[i]) {
             continue;
@@ -642,15 +889,20 @@ static void sconf_node_str_destroy(struct SConfNode *node)
     assert(node);
     assert(node->type == SCONF_TYPE_STR);
 
-    if (node->string) {
-        free(node->string);
+    if (!(node->flags & SCONF_NODE_FLAG_STR_INLINE) && node->capacity) {
+        sconf_arena_free(node->arena, node->string);
         node->string = NULL;
+        node->capacity = 0;
     }
 }
 
 /**
  * @brief Destroy a node.
  *
+ * Nodes allocated from an arena, or part of a frozen snapshot, are released
+ * all at once when the node owning the memory is destroyed, so the tree is
+ * not traversed.
+ *
  * @param node The config node.
  */
 void sconf_node_destroy(struct SConfNode *node)
@@ -659,10 +911,32 @@ void sconf_node_destroy(struct SConfNode *node)
         return;
     }
 
+    /* Invalidate handles that may point into the tree */
+    sconf_generation_bump(node);
+
+    if (node->flags & SCONF_NODE_FLAG_FROZEN) {
+        if (node->flags & SCONF_NODE_FLAG_FROZEN_OWNER) {
+            sconf_snapshot_destroy(node);
+        }
+        return;
+    }
+
+    if (node->flags & SCONF_NODE_FLAG_PACKED) {
+        /* Owned by the packed array */
+        return;
+    }
+
+    if (node->arena) {
+        if (node->flags & SCONF_NODE_FLAG_ARENA_OWNER) {
+            sconf_arena_destroy(node->arena);
+        }
+        return;
+    }
+
     switch (node->type)
     {
        case SCONF_TYPE_DICT:
-            sconf_node_dict_destroy(node);
+            sconf_dict_destroy(node);
             break;
         case SCONF_TYPE_ARRAY:
             sconf_node_array_destroy(node);
@@ -677,21 +951,20 @@ void sconf_node_destroy(struct SConfNode *node)
 
 /**
  * @internal
- * @brief Initialize dictionary config node.
+ * @brief Initialize array config node.
  *
  * @param node The config node.
  * @param err  Pointer to error struct.
  *
  * @return 0 on success, -1 otherwise.
  */
-static int sconf_node_dict_init(struct SConfNode *node, struct SConfErr *err)
+static int sconf_node_array_init(struct SConfNode *node, struct SConfErr *err)
 {
     assert(node);
-    assert(node->type == SCONF_TYPE_DICT);
+    assert(node->type == SCONF_TYPE_ARRAY);
 
-    int r = art_tree_init(&node->dictionary);
-    if (r != 0) {
-        sconf_err_set(err, "failed to create dict node tree");
+    node->array = sconf_array_create(1, node->arena, err);
+    if (!node->array) {
         return -1;
     }
 
@@ -700,22 +973,87 @@ static int sconf_node_dict_init(struct SConfNode *node, struct SConfErr *err)
 
 /**
  * @internal
- * @brief Initialize array config node.
+ * @brief Set string of string config node.
  *
  * @param node The config node.
+ * @param str  The string (not null terminated).
+ * @param len  Length of string.
  * @param err  Pointer to error struct.
  *
  * @return 0 on success, -1 otherwise.
  */
-static int sconf_node_array_init(struct SConfNode *node, struct SConfErr *err)
+static int sconf_node_str_set(struct SConfNode *node, const char *str,
+                              size_t len, struct SConfErr *err)
 {
     assert(node);
-    assert(node->type == SCONF_TYPE_ARRAY);
+    assert(node->type == SCONF_TYPE_STR);
+    assert(str);
 
-    node->array = sconf_array_create(1, err);
-    if (!node->array) {
+    if (len > UINT32_MAX - 1) {
+        sconf_err_set(err, "string is too long");
+        return -1;
+    }
+
+    bool owned = !(node->flags & SCONF_NODE_FLAG_STR_INLINE) &&
+                 node->capacity > 0;
+
+    if (len < SCONF_NODE_STR_INLINE_SIZE) {
+        /* Short string, copy before freeing in case str is the old value */
+        char copy[SCONF_NODE_STR_INLINE_SIZE];
+        memcpy(copy, str, len);
+
+        if (owned) {
+            sconf_arena_free(node->arena, node->string);
+        }
+
+        memcpy(node->short_string, copy, len);
+        node->short_string[len] = '\0';
+        node->flags |= SCONF_NODE_FLAG_STR_INLINE;
+        node->len = (uint32_t)len;
+
+        return 0;
+    }
+
+    if (node->arena) {
+        /* Shared with equal strings in the tree, so never written to */
+        const char *interned = sconf_intern(&node->arena->strings, str,
+                                            (uint32_t)len, err);
+        if (!interned) {
+            return -1;
+        }
+
+        node->flags &= ~SCONF_NODE_FLAG_STR_INLINE;
+        node->string = (char *)interned;
+        node->capacity = 0;
+        node->len = (uint32_t)len;
+
+        return 0;
+    }
+
+    if (owned && node->capacity > len) {
+        /* Overwrite, reusing the buffer */
+        memmove(node->string, str, len);
+        node->string[len] = '\0';
+        node->len = (uint32_t)len;
+
+        return 0;
+    }
+
+    char *string = sconf_arena_calloc(node->arena, 1, len + 1);
+    if (!string) {
+        sconf_err_set(err, "failed to allocate memory for node string");
         return -1;
     }
+    memcpy(string, str, len);
+
+    if (owned) {
+        sconf_arena_free(node->arena, node->string);
+    }
+
+    node->flags &= ~SCONF_NODE_FLAG_STR_INLINE;
+    node->string = string;
+    node->capacity = (uint32_t)(len + 1);
+    node->len = (uint32_t)len;
 
     return 0;
 }
@@ -725,7 +1063,7 @@ static int sconf_node_array_init(struct SConfNode *node, struct SConfErr *err)
  * @brief Initialize string config node.
  *
  * @param node The config node.
- * @param data Data used when initializing node.
+ * @param data Data used when initializing node (NULL for an empty string).
  * @param err  Pointer to error struct.
  *
  * @return 0 on success, -1 otherwise.
@@ -733,25 +1071,11 @@ static int sconf_node_array_init(struct SConfNode *node, struct SConfErr *err)
 static int sconf_node_str_init(struct SConfNode *node, void *data,
                                struct SConfErr *err)
 {
-    assert(node);
-    assert(node->type == SCONF_TYPE_STR);
-    assert(data);
-
-    char *str = (char *)data;
-
-    /* Allow overwrite */
-    if (node->string) {
-        free(node->string);
-        node->string = NULL;
-    }
-
-    node->string = strdup(str);
-    if (!node->string) {
-        sconf_err_set(err, "failed to allocate memory for node string");
-        return -1;
+    if (!data) {
+        return sconf_node_str_set(node, "", 0, err);
     }
 
-    return 0;
+    return sconf_node_str_set(node, (const char *)data, strlen(data), err);
 }
 
 /**
@@ -824,30 +1148,34 @@ static int sconf_node_float_init(struct SConfNode *node, void *data)
 }
 
 /**
- * @brief Create a new config node.
+ * @brief Create a new config node in arena.
  *
- * @param type The type of node to create.
- * @param data Data used when creating node.
- * @param err  Pointer to error struct.
+ * @param arena Arena to allocate node from, or NULL to use the heap.
+ * @param type  The type of node to create.
+ * @param data  Data used when creating node.
+ * @param err   Pointer to error struct.
  *
  * @return Created node on success, NULL otherwise.
  */
-struct SConfNode *sconf_node_create(int type, void *data, struct SConfErr *err)
+struct SConfNode *sconf_node_create_in(struct SConfArena *arena, int type,
+                                       void *data, struct SConfErr *err)
 {
     int r = 0;
 
-    struct SConfNode *node = calloc(1, sizeof(struct SConfNode));
+    struct SConfNode *node = sconf_arena_calloc(arena, 1,
+                                                sizeof(struct SConfNode));
     if (!node) {
         sconf_err_set(err, "could not allocate memory for node");
         return NULL;
     }
 
     node->type = type;
+    node->arena = arena;
 
     switch (type)
     {
         case SCONF_TYPE_DICT:
-            r = sconf_node_dict_init(node, err);
+            r = sconf_dict_init(node, err);
             break;
         case SCONF_TYPE_ARRAY:
             r = sconf_node_array_init(node, err);
@@ -871,7 +1199,7 @@ struct SConfNode *sconf_node_create(int type, void *data, struct SConfErr *err)
     }
 
     if (r == -1) {
-        free(node);
+        sconf_arena_free(arena, node);
         return NULL;
     }
 
@@ -879,96 +1207,217 @@ struct SConfNode *sconf_node_create(int type, void *data, struct SConfErr *err)
 }
 
 /**
- * @brief Create config node if it does not exist.
+ * @brief Create a new config node.
  *
- * @param name   The name of the config node.
- * @param type   The type of the config node.
- * @param parent Pointer to the parent.
- * @param index  Index to use if parent is an array.
- * @param data   Data used when creating node.
- * @param err    Pointer to the error struct.
+ * @param type The type of node to create.
+ * @param data Data used when creating node.
+ * @param err  Pointer to error struct.
  *
- * @return Pointer to node created on success, NULL otherwise.
+ * @return Created node on success, NULL otherwise.
  */
-struct SConfNode *sconf_node_create_and_insert(const char *name, uint8_t type,
-                                               struct SConfNode *parent,
-                                               uint32_t index, void *data,
-                                               struct SConfErr *err)
+struct SConfNode *sconf_node_create(int type, void *data, struct SConfErr *err)
 {
-    assert(parent);
+    return sconf_node_create_in(NULL, type, data, err);
+}
 
-    int r = 0;
-    struct SConfNode *node = NULL;
+/**
+ * @brief Create a new config node owning an arena.
+ *
+ * @param type The type of node to create.
+ * @param data Data used when creating node.
+ * @param err  Pointer to error struct.
+ *
+ * @return Created node on success, NULL otherwise.
+ */
+struct SConfNode *sconf_node_create_arena(int type, void *data,
+                                          struct SConfErr *err)
+{
+    struct SConfArena *arena = sconf_arena_create(err);
+    if (!arena) {
+        return NULL;
+    }
 
-    if (name && name[0] == '[' && parent->type == SCONF_TYPE_ARRAY) {
-        r = sconf_array_get_index_from_string(name, &index, err);
-        if (r == -1) {
-            return NULL;
-        }
+    struct SConfNode *node = sconf_node_create_in(arena, type, data, err);
+    if (!node) {
+        sconf_arena_destroy(arena);
+        return NULL;
+    }
+
+    node->flags |= SCONF_NODE_FLAG_ARENA_OWNER;
+
+    return node;
+}
+
+/**
+ * @brief Replace tree owning an arena with a new empty node, reusing the
+ * memory of the arena.
+ *
+ * @param owner The node owning the arena, no longer valid afterwards.
+ * @param type  The type of the new node.
+ * @param data  Data used when creating node.
+ * @param err   Pointer to error struct.
+ *
+ * @return new node owning the arena on success, NULL otherwise (the arena
+ * is destroyed).
+ */
+struct SConfNode *sconf_node_arena_reset(struct SConfNode *owner, int type,
+                                         void *data, struct SConfErr *err)
+{
+    assert(owner);
+    assert(owner->flags & SCONF_NODE_FLAG_ARENA_OWNER);
+
+    struct SConfArena *arena = owner->arena;
+
+    /* Invalidate handles that may point into the tree */
+    sconf_generation_bump(owner);
+
+    sconf_arena_reset(arena);
+
+    struct SConfNode *node = sconf_node_create_in(arena, type, data, err);
+    if (!node) {
+        sconf_arena_destroy(arena);
+        return NULL;
+    }
+
+    node->flags |= SCONF_NODE_FLAG_ARENA_OWNER;
+
+    return node;
+}
+
+/**
+ * @internal
+ * @brief Replace value of existing scalar config node.
+ *
+ * @param node The config node.
+ * @param data Data used when replacing value (NULL keeps the value).
+ * @param err  Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int sconf_node_replace(struct SConfNode *node, void *data,
+                              struct SConfErr *err)
+{
+    assert(node);
+
+    if (!data) {
+        return 0;
+    }
+
+    switch (node->type)
+    {
+        case SCONF_TYPE_STR:
+            return sconf_node_str_init(node, data, err);
+        case SCONF_TYPE_INT:
+            return sconf_node_int_init(node, data);
+        case SCONF_TYPE_BOOL:
+            return sconf_node_bool_init(node, data);
+        case SCONF_TYPE_FLOAT:
+            return sconf_node_float_init(node, data);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Get child node in parent, or create it if it does not exist.
+ *
+ * @param parent   Pointer to the parent (dictionary or array).
+ * @param name     Name of node if parent is a dictionary (not null
+ *                 terminated).
+ * @param name_len Length of name.
+ * @param index    Index of node if parent is an array.
+ * @param type     The type of the config node.
+ * @param data     Data used when creating node or replacing its value.
+ * @param err      Pointer to the error struct.
+ *
+ * @return Pointer to node on success, NULL otherwise.
+ */
+struct SConfNode *sconf_node_child_set(struct SConfNode *parent,
+                                       const char *name, uint32_t name_len,
+                                       uint32_t index, uint8_t type,
+                                       void *data, struct SConfErr *err)
+{
+    assert(parent);
+
+    if (parent->flags & SCONF_NODE_FLAG_FROZEN) {
+        sconf_err_set(err, "config node is frozen");
+        return NULL;
     }
 
+    struct SConfNode *node = NULL;
+
     switch (parent->type)
     {
         case SCONF_TYPE_DICT:
-            r = sconf_node_dict_search(name, parent, &node, err);
+            assert(name);
+            node = sconf_node_dict_lookup(parent, name, name_len);
             break;
         case SCONF_TYPE_ARRAY:
-            r = sconf_node_array_search(index, parent, &node, err);
+            if (parent->array->packed) {
+                /* New values are only added to arrays of nodes */
+                if (index >= parent->array->size) {
+                    if (sconf_node_array_unpack(parent, err) == -1) {
+                        return NULL;
+                    }
+                }
+                else if (!sconf_array_view(parent->array, err)) {
+                    return NULL;
+                }
+            }
+            node = sconf_node_array_lookup(parent, index);
             break;
         default:
             sconf_err_set(err, "parent node must be dict or array");
             return NULL;
     }
 
-    if (r == -1) {
-        return NULL;
-    }
-
     if (node) {
         if (node->type != type) {
-            sconf_err_set(err, "node '%s' already exist, but types does not "
-                          "match ('%s' != '%s')", name, sconf_type_to_str(type),
-                          sconf_type_to_str(node->type));
+            if (parent->type == SCONF_TYPE_DICT) {
+                sconf_err_set(err, "node '%.*s' already exist, but types does "
+                              "not match ('%s' != '%s')", (int)name_len, name,
+                              sconf_type_to_str(type),
+                              sconf_type_to_str(node->type));
+            }
+            else {
+                sconf_err_set(err, "node '[%" PRIu32 "]' already exist, but "
+                              "types does not match ('%s' != '%s')", index,
+                              sconf_type_to_str(type),
+                              sconf_type_to_str(node->type));
+            }
             return NULL;
         }
 
-        /* Replace value of node */
-        switch (type)
-        {
-            case SCONF_TYPE_STR:
-                r = sconf_node_str_init(node, data, err);
-                break;
-            case SCONF_TYPE_INT:
-                r = sconf_node_int_init(node, data);
-                break;
-            case SCONF_TYPE_BOOL:
-                r = sconf_node_bool_init(node, data);
-                break;
-            case SCONF_TYPE_FLOAT:
-                r = sconf_node_float_init(node, data);
-                break;
+        if (node->flags & SCONF_NODE_FLAG_PACKED) {
+            sconf_array_pack_set(parent->array, index, data);
         }
-
-        if (r == -1) {
+        else if (sconf_node_replace(node, data, err) == -1) {
             return NULL;
         }
 
+        sconf_generation_bump(parent);
+
         return node;
     }
 
     /* Node does not exist, so create it */
-    node = sconf_node_create(type, data, err);
+    node = sconf_node_create_in(parent->arena, type, data, err);
     if (!node) {
         return NULL;
     }
 
+    int r = 0;
+
     switch (parent->type)
     {
         case SCONF_TYPE_DICT:
-            r = sconf_node_dict_insert(name, parent, node, err);
+            r = sconf_node_dict_add(parent, name, name_len, node, err);
             break;
         case SCONF_TYPE_ARRAY:
-            r = sconf_node_array_insert(index, parent, node, err);
+            r = sconf_array_insert(parent->array, index, node, err);
+            if (r == 0) {
+                sconf_generation_bump(parent);
+            }
             break;
     }
 
@@ -981,285 +1430,1112 @@ struct SConfNode *sconf_node_create_and_insert(const char *name, uint8_t type,
 }
 
 /**
- * @brief Get config node based on path.
+ * @brief Create config node if it does not exist.
  *
- * @param root Pointer to root config node.
- * @param path The path to the config node to get.
- * @param node Pointer to node, if found.
- * @param err  Pointer to error struct.
+ * @param name   The name of the config node.
+ * @param type   The type of the config node.
+ * @param parent Pointer to the parent.
+ * @param index  Index to use if parent is an array.
+ * @param data   Data used when creating node.
+ * @param err    Pointer to the error struct.
  *
- * @return 1 on found, 0 on not found, -1 on error.
+ * @return Pointer to node created on success, NULL otherwise.
  */
-int sconf_get(struct SConfNode *root, const char *path, struct SConfNode **node,
-              struct SConfErr *err)
+struct SConfNode *sconf_node_create_and_insert(const char *name, uint8_t type,
+                                               struct SConfNode *parent,
+                                               uint32_t index, void *data,
+                                               struct SConfErr *err)
 {
-    if (!root) {
-        sconf_err_set(err, "no root was specified");
-        return -1;
-    }
+    assert(parent);
 
-    if (!path) {
-        sconf_err_set(err, "no path was provided");
-        return -1;
-    }
+    uint32_t name_len = name ? (uint32_t)strlen(name) : 0;
 
-    char *copy = strdup(path);
-    if (!copy) {
-        sconf_err_set(err, "failed to copy path string");
-        return -1;
+    if (parent->type == SCONF_TYPE_DICT && !name) {
+        sconf_err_set(err, "name was not specified");
+        return NULL;
     }
 
-    struct SConfNode *parent = root;
-    uint32_t parent_index = 0;
-
-    int r = 0;
-    char *save_ptr = NULL;
-    char *next = strtok_r(copy, SCONF_PATH_DELIMITER, &save_ptr);
-    char *curr = NULL;
-
-    while (next != NULL)
-    {
-       if (curr) {
-            if (curr[0] == '[' && parent->type != SCONF_TYPE_ARRAY) {
-                /* Not found */
-                free(copy);
-                return 0;
-            }
+    if (name && name[0] == '[' && parent->type == SCONF_TYPE_ARRAY) {
+        if (sconf_path_index_parse(name, name_len, &index, err) == -1) {
+            return NULL;
+        }
+    }
 
-            struct SConfNode *tmp = NULL;
+    return sconf_node_child_set(parent, name, name_len, index, type, data,
+                                err);
+}
 
-            switch (parent->type)
-            {
-                case SCONF_TYPE_DICT:
-                    r = sconf_node_dict_search(curr, parent, &tmp, err);
-                    break;
-                case SCONF_TYPE_ARRAY:
-                    r = sconf_node_array_search(parent_index, parent, &tmp,
-                                                err);
-                    break;
-                default:
-                    sconf_err_set(err, "parent node must be dict or array");
-                    free(copy);
-                    return -1;
-            }
+/**
+ * @brief Set scalar value at index in array.
+ *
+ * Integers, floats and booleans appended to an empty array, or to an array
+ * already packed with values of the same type, are stored in the packed
+ * array instead of in nodes of their own. Arrays allocated from an arena are
+ * never packed.
+ *
+ * @param array The array node.
+ * @param index Index of the value.
+ * @param type  The type of the value.
+ * @param data  Data used when creating node or replacing its value.
+ * @param err   Pointer to the error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sconf_node_array_set_value(struct SConfNode *array, uint32_t index,
+                               uint8_t type, void *data,
+                               struct SConfErr *err)
+{
+    assert(array);
+    assert(array->type == SCONF_TYPE_ARRAY);
 
-            if (r == -1) {
-                free(copy);
-                return -1;
-            }
+    struct SConfArray *values = array->array;
 
-            parent = tmp;
+    bool pack = false;
 
-            if (parent == NULL) {
-                /* Not found */
-                free(copy);
-                return 0;
-            }
+    if ((type == SCONF_TYPE_INT || type == SCONF_TYPE_FLOAT ||
+            type == SCONF_TYPE_BOOL) && !array->arena &&
+            !(array->flags & SCONF_NODE_FLAG_FROZEN)) {
+        if (values->packed) {
+            pack = values->packed == type && index == values->size;
         }
-
-        if (parent->type == SCONF_TYPE_ARRAY && next[0] == '[') {
-            /* Used for the next node when inserting into the array */
-            r = sconf_array_get_index_from_string(next, &parent_index, err);
-            if (r == -1) {
-                free(copy);
-                return -1;
-            }
+        else {
+            pack = index == 0 && sconf_array_is_empty(values);
         }
-
-        curr = next;
-        next = strtok_r(NULL, SCONF_PATH_DELIMITER, &save_ptr);
     }
 
-    struct SConfNode *found = NULL;
-
-    switch (parent->type)
-    {
-        case SCONF_TYPE_DICT:
-            r = sconf_node_dict_search(curr, parent, &found, err);
-            break;
-        case SCONF_TYPE_ARRAY:
-            r = sconf_node_array_search(parent_index, parent, &found, err);
-            break;
-        default:
-            sconf_err_set(err, "parent node must be dict or array");
-            free(copy);
+    if (pack) {
+        if (sconf_array_pack_append(values, type, data, err) == -1) {
             return -1;
-    }
+        }
 
-    free(copy);
+        /* Handles may have cached that the index does not exist */
+        sconf_generation_bump(array);
 
-    if (r == -1) {
-        return -1;
+        return 0;
     }
 
-    if (found) {
-        *node = found;
-        return 1;
+    if (!sconf_node_child_set(array, NULL, 0, index, type, data, err)) {
+        return -1;
     }
 
     return 0;
 }
 
 /**
- * @brief Get config string based on path.
+ * @internal
+ * @brief Parse path string, setting error if path is missing.
  *
- * @param root Pointer to root config node.
- * @param path The path to the config node to get.
- * @param str  Pointer to string, if found.
- * @param err  Pointer to error struct.
+ * The segments point into the path string, nothing is copied.
  *
- * @return 1 on found, 0 on not found, -1 on error.
+ * @param parsed Parsed path to fill in.
+ * @param path   The path string (not null terminated).
+ * @param len    Length of path.
+ * @param err    Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
  */
-int sconf_get_str(struct SConfNode *root, const char *path, const char **str,
-                  struct SConfErr *err)
+static int sconf_path_from_string(struct SConfPath *parsed, const char *path,
+                                  size_t len, struct SConfErr *err)
 {
-    struct SConfNode *node = NULL;
-    int r = sconf_get(root, path, &node, err);
-    if (r != 1) {
-        return r;
-    }
-
-    if (node == NULL) {
-        sconf_err_set(err, "node found but node is NULL");
-        return -1;
-    }
-
-    if (node->type != SCONF_TYPE_STR) {
-        sconf_err_set(err, "config node '%s' is %s not %s",
-                      path, sconf_type_to_str(node->type),
-                      sconf_type_to_str(SCONF_TYPE_STR));
+    if (!path) {
+        sconf_err_set(err, "no path was provided");
         return -1;
     }
 
-    *str = node->string;
-
-    return 1;
+    return sconf_path_parse(parsed, path, len, err);
 }
 
 /**
- * @brief Get config integer based on path.
+ * @internal
+ * @brief Look up full path in the path index of a snapshot.
+ *
+ * @param root Pointer to root config node.
+ * @param path The path (not null terminated).
+ * @param len  Length of path.
+ * @param node Pointer to node, if found.
+ *
+ * @return true if found, false if the tree must be walked instead.
+ */
+static inline bool sconf_get_indexed(const struct SConfNode *root,
+                                     const char *path, size_t len,
+                                     struct SConfNode **node)
+{
+    if (!(root->flags & SCONF_NODE_FLAG_INDEXED)) {
+        return false;
+    }
+
+    struct SConfNode *found = sconf_index_lookup(sconf_snapshot(root)->index,
+                                                 path, len);
+    if (!found) {
+        /* Missing or not in canonical form, the walk tells which */
+        return false;
+    }
+
+    *node = found;
+
+    return true;
+}
+
+/**
+ * @internal
+ * @brief Step from a node to its child for one path segment.
+ *
+ * @param curr    The parent node, replaced with the child if found.
+ * @param segment The path segment naming the child.
+ * @param last    Whether the segment is the last in the path.
+ * @param err     Pointer to error struct.
+ *
+ * @return 1 on found, 0 on not found, -1 on error.
+ */
+static int sconf_node_step(struct SConfNode **curr,
+                           const struct SConfPathSegment *segment, bool last,
+                           struct SConfErr *err)
+{
+    struct SConfNode *parent = *curr;
+    struct SConfNode *child = NULL;
+
+    switch (parent->type)
+    {
+        case SCONF_TYPE_DICT:
+            if (!last && segment->name[0] == '[') {
+                /* Array index used on dict, so not found */
+                return 0;
+            }
+            child = sconf_node_dict_lookup(parent, segment->name,
+                                           segment->len);
+            break;
+        case SCONF_TYPE_ARRAY:
+            if (!segment->is_index) {
+                if (segment->name[0] != '[') {
+                    /* Dict key used on array, so not found */
+                    return 0;
+                }
+                uint32_t unused;
+                return sconf_path_index_parse(segment->name, segment->len,
+                                              &unused, err);
+            }
+            if (parent->array->packed &&
+                    !sconf_array_view(parent->array, err)) {
+                return -1;
+            }
+            child = sconf_node_array_lookup(parent, segment->index);
+            break;
+        default:
+            sconf_err_set(err, "parent node must be dict or array");
+            return -1;
+    }
+
+    if (!child) {
+        return 0;
+    }
+
+    *curr = child;
+
+    return 1;
+}
+
+/**
+ * @internal
+ * @brief Walk the tree to the node at path.
+ *
+ * @param root Pointer to root config node.
+ * @param path The parsed path to the config node to get.
+ * @param node Pointer to node, if found.
+ * @param err  Pointer to error struct.
+ *
+ * @return 1 on found, 0 on not found, -1 on error.
+ */
+static int sconf_node_walk(struct SConfNode *root,
+                           const struct SConfPath *path,
+                           struct SConfNode **node, struct SConfErr *err)
+{
+    struct SConfNode *curr = root;
+
+    for (uint32_t i = 0; i < path->depth; i++)
+    {
+        int r = sconf_node_step(&curr, &path->segments[i],
+                                i + 1 == path->depth, err);
+        if (r != 1) {
+            return r;
+        }
+    }
+
+    *node = curr;
+
+    return 1;
+}
+
+/**
+ * @internal
+ * @brief Get node at parsed path, using the path index of snapshots and
+ * falling back to the base of overlays.
+ *
+ * @param root Pointer to root config node.
+ * @param path The parsed path to the config node to get.
+ * @param node Pointer to node, if found.
+ * @param err  Pointer to error struct.
+ *
+ * @return 1 on found, 0 on not found, -1 on error.
+ */
+static int sconf_node_get(struct SConfNode *root, const struct SConfPath *path,
+                          struct SConfNode **node, struct SConfErr *err)
+{
+    if (sconf_get_indexed(root, path->string, path->len, node)) {
+        return 1;
+    }
+
+    int r = sconf_node_walk(root, path, node, err);
+    if (r == 0 && (root->flags & SCONF_NODE_FLAG_OVERLAY)) {
+        return sconf_node_get(sconf_overlay_base(root), path, node, err);
+    }
+
+    return r;
+}
+
+/**
+ * @brief Get config node set in an overlay itself, without falling back to
+ * the base.
+ *
+ * @param overlay Pointer to overlay (or plain) root config node.
+ * @param path    The path to the config node to get.
+ * @param node    Pointer to node, if found.
+ * @param err     Pointer to error struct.
+ *
+ * @return 1 on found, 0 on not found, -1 on error.
+ */
+int sconf_overlay_get_own(struct SConfNode *overlay, const char *path,
+                          struct SConfNode **node, struct SConfErr *err)
+{
+    struct SConfPath parsed;
+
+    if (sconf_path_from_string(&parsed, path, path ? strlen(path) : 0,
+                               err) == -1) {
+        return -1;
+    }
+
+    if (sconf_get_indexed(overlay, parsed.string, parsed.len, node)) {
+        return 1;
+    }
+
+    return sconf_node_walk(overlay, &parsed, node, err);
+}
+
+/**
+ * @brief Get config node based on compiled path.
+ *
+ * @param root Pointer to root config node.
+ * @param path The compiled path to the config node to get.
+ * @param node Pointer to node, if found.
+ * @param err  Pointer to error struct.
+ *
+ * @return 1 on found, 0 on not found, -1 on error.
+ */
+int sconf_get_p(struct SConfNode *root, const struct SConfPath *path,
+                struct SConfNode **node, struct SConfErr *err)
+{
+    if (!root) {
+        sconf_err_set(err, "no root was specified");
+        return -1;
+    }
+
+    if (!path) {
+        sconf_err_set(err, "no path was provided");
+        return -1;
+    }
+
+    return sconf_node_get(root, path, node, err);
+}
+
+/**
+ * @brief Get config node based on path.
+ *
+ * @param root Pointer to root config node.
+ * @param path The path to the config node to get.
+ * @param node Pointer to node, if found.
+ * @param err  Pointer to error struct.
+ *
+ * @return 1 on found, 0 on not found, -1 on error.
+ */
+int sconf_get(struct SConfNode *root, const char *path, struct SConfNode **node,
+              struct SConfErr *err)
+{
+    return sconf_get_n(root, path, path ? strlen(path) : 0, node, err);
+}
+
+/**
+ * @brief Get config node based on path of given length.
+ *
+ * @param root Pointer to root config node.
+ * @param path The path to the config node to get (not null terminated).
+ * @param len  Length of path.
+ * @param node Pointer to node, if found.
+ * @param err  Pointer to error struct.
+ *
+ * @return 1 on found, 0 on not found, -1 on error.
+ */
+int sconf_get_n(struct SConfNode *root, const char *path, size_t len,
+                struct SConfNode **node, struct SConfErr *err)
+{
+    if (!root) {
+        sconf_err_set(err, "no root was specified");
+        return -1;
+    }
+
+    if (path && sconf_get_indexed(root, path, len, node)) {
+        return 1;
+    }
+
+    struct SConfPath parsed;
+    if (sconf_path_from_string(&parsed, path, len, err) == -1) {
+        return -1;
+    }
+
+    if (root->flags & SCONF_NODE_FLAG_OVERLAY) {
+        return sconf_node_get(root, &parsed, node, err);
+    }
+
+    return sconf_node_walk(root, &parsed, node, err);
+}
+
+/* Number of slots in the parent cache of sconf_get_many, must be a power
+   of two. At most half of them are used, later parents are not cached. */
+#define SCONF_GET_MANY_CACHE_SIZE 128
+
+/* Parent node cached by sconf_get_many, keyed by the path up to the last
+   segment */
+struct SConfGetManyParent {
+    const char *prefix;
+    size_t len;
+    uint64_t hash;
+
+    /* NULL if the parent was not found */
+    struct SConfNode *node;
+};
+
+/**
+ * @internal
+ * @brief Split path into parent prefix and last segment without parsing
+ * all of it.
+ *
+ * @param path    The path.
+ * @param len     Length of path.
+ * @param prefix  Length of the path up to the end of the next to last
+ *                segment (0 if there is only one segment).
+ * @param segment The last segment.
+ *
+ * @return true if there is a last segment, false if the path is empty.
+ */
+static bool sconf_path_split_last(const char *path, size_t len,
+                                  size_t *prefix,
+                                  struct SConfPathSegment *segment)
+{
+    size_t end = len;
+    while (end > 0 && path[end - 1] == '.')
+    {
+        end--;
+    }
+
+    size_t start = end;
+    while (start > 0 && path[start - 1] != '.')
+    {
+        start--;
+    }
+
+    if (start == end || end - start > UINT32_MAX) {
+        return false;
+    }
+
+    size_t before = start;
+    while (before > 0 && path[before - 1] == '.')
+    {
+        before--;
+    }
+
+    *prefix = before;
+    segment->name = path + start;
+    segment->len = (uint32_t)(end - start);
+    segment->is_index = path[start] == '[' &&
+                        sconf_path_index_parse(segment->name, segment->len,
+                                               &segment->index, NULL) == 0;
+
+    return true;
+}
+
+/**
+ * @brief Get config nodes for many paths at once.
+ *
+ * The parent of each path (the path up to its last segment) is looked up
+ * once and cached, so paths sharing a parent only look up their last
+ * segment.
+ *
+ * @param root    Pointer to root config node.
+ * @param paths   The paths to the config nodes to get.
+ * @param n       Number of paths.
+ * @param results Result for each path, in the same order as the paths.
+ * @param err     Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sconf_get_many(struct SConfNode *root, const char *const *paths, size_t n,
+                   struct SConfGetResult *results, struct SConfErr *err)
+{
+    if (!root) {
+        sconf_err_set(err, "no root was specified");
+        return -1;
+    }
+
+    if (n == 0) {
+        return 0;
+    }
+
+    if (!paths) {
+        sconf_err_set(err, "no paths were provided");
+        return -1;
+    }
+
+    if (!results) {
+        sconf_err_set(err, "no results were provided");
+        return -1;
+    }
+
+    if (root->flags & SCONF_NODE_FLAG_OVERLAY) {
+        /* Parents may be in the overlay, the base or both */
+        for (size_t i = 0; i < n; i++)
+        {
+            results[i].node = NULL;
+            int r = sconf_get(root, paths[i], &results[i].node, err);
+            if (r == -1) {
+                return -1;
+            }
+            results[i].found = r == 1;
+        }
+        return 0;
+    }
+
+    struct SConfGetManyParent cache[SCONF_GET_MANY_CACHE_SIZE];
+    memset(cache, 0, sizeof(cache));
+
+    uint32_t cached = 0;
+
+    /* Parent of the previous path, checked before the cache since paths
+       with the same parent are usually listed together */
+    struct SConfGetManyParent prev = {0};
+
+    for (size_t i = 0; i < n; i++)
+    {
+        const char *path = paths[i];
+        struct SConfGetResult *result = &results[i];
+
+        result->node = NULL;
+        result->found = false;
+
+        if (!path) {
+            sconf_err_set(err, "no path was provided");
+            return -1;
+        }
+
+        size_t len = strlen(path);
+
+        if (sconf_get_indexed(root, path, len, &result->node)) {
+            result->found = true;
+            continue;
+        }
+
+        size_t prefix = 0;
+        struct SConfPathSegment last;
+        if (!sconf_path_split_last(path, len, &prefix, &last)) {
+            sconf_err_set(err, "path '%s' is empty", path);
+            return -1;
+        }
+
+        struct SConfNode *parent = root;
+
+        if (prefix > 0 && prev.prefix && prev.len == prefix &&
+                memcmp(prev.prefix, path, prefix) == 0) {
+            parent = prev.node;
+        }
+        else if (prefix > 0) {
+            uint64_t hash = sconf_index_hash(0, path, prefix);
+            uint32_t slot = hash & (SCONF_GET_MANY_CACHE_SIZE - 1);
+
+            while (cache[slot].prefix &&
+                   (cache[slot].hash != hash || cache[slot].len != prefix ||
+                    memcmp(cache[slot].prefix, path, prefix) != 0))
+            {
+                slot = (slot + 1) & (SCONF_GET_MANY_CACHE_SIZE - 1);
+            }
+
+            if (cache[slot].prefix) {
+                parent = cache[slot].node;
+            }
+            else {
+                /* Walk to the parent, with the same checks as sconf_get */
+                struct SConfPath parsed;
+                if (sconf_path_parse(&parsed, path, len, err) == -1) {
+                    return -1;
+                }
+
+                int r = 1;
+                for (uint32_t j = 0; j + 1 < parsed.depth && r == 1; j++)
+                {
+                    r = sconf_node_step(&parent, &parsed.segments[j], false,
+                                        err);
+                }
+                if (r == -1) {
+                    return -1;
+                }
+                if (r == 0) {
+                    parent = NULL;
+                }
+
+                if (cached < SCONF_GET_MANY_CACHE_SIZE / 2) {
+                    cache[slot].prefix = path;
+                    cache[slot].len = prefix;
+                    cache[slot].hash = hash;
+                    cache[slot].node = parent;
+                    cached++;
+                }
+            }
+
+            prev.prefix = path;
+            prev.len = prefix;
+            prev.node = parent;
+        }
+
+        if (!parent) {
+            continue;
+        }
+
+        int r = sconf_node_step(&parent, &last, true, err);
+        if (r == -1) {
+            return -1;
+        }
+
+        if (r == 1) {
+            result->node = parent;
+            result->found = true;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Check that a config node found at path is of the expected type.
+ *
+ * @param node The config node.
+ * @param path The path used to find the node (used in error message).
+ * @param len  Length of path.
+ * @param type The expected type of the config node.
+ * @param err  Pointer to error struct.
+ *
+ * @return 1 if the type matches, -1 otherwise.
+ */
+static int sconf_node_type_check(const struct SConfNode *node,
+                                 const char *path, size_t len, uint8_t type,
+                                 struct SConfErr *err)
+{
+    if (node->type != type) {
+        sconf_err_set(err, "config node '%.*s' is %s not %s", (int)len, path,
+                      sconf_type_to_str(node->type), sconf_type_to_str(type));
+        return -1;
+    }
+
+    return 1;
+}
+
+/**
+ * @internal
+ * @brief Get config node of specific type based on compiled path.
+ *
+ * @param root Pointer to root config node.
+ * @param path The compiled path to the config node to get.
+ * @param type The expected type of the config node.
+ * @param node Pointer to node, if found.
+ * @param err  Pointer to error struct.
+ *
+ * @return 1 on found, 0 on not found, -1 on error.
+ */
+static int sconf_get_typed_p(struct SConfNode *root,
+                             const struct SConfPath *path, uint8_t type,
+                             struct SConfNode **node, struct SConfErr *err)
+{
+    int r = sconf_get_p(root, path, node, err);
+    if (r != 1) {
+        return r;
+    }
+
+    return sconf_node_type_check(*node, path->string, path->len, type, err);
+}
+
+/**
+ * @internal
+ * @brief Get config node of specific type based on path.
+ *
+ * @param root Pointer to root config node.
+ * @param path The path to the config node to get.
+ * @param type The expected type of the config node.
+ * @param node Pointer to node, if found.
+ * @param err  Pointer to error struct.
+ *
+ * @return 1 on found, 0 on not found, -1 on error.
+ */
+static int sconf_get_typed(struct SConfNode *root, const char *path,
+                           uint8_t type, struct SConfNode **node,
+                           struct SConfErr *err)
+{
+    size_t len = path ? strlen(path) : 0;
+
+    int r = sconf_get_n(root, path, len, node, err);
+    if (r != 1) {
+        return r;
+    }
+
+    return sconf_node_type_check(*node, path, len, type, err);
+}
+
+/**
+ * @brief Get config string based on compiled path.
+ *
+ * @param root Pointer to root config node.
+ * @param path The compiled path to the config node to get.
+ * @param str  Pointer to string, if found.
+ * @param err  Pointer to error struct.
+ *
+ * @return 1 on found, 0 on not found, -1 on error.
+ */
+int sconf_get_str_p(struct SConfNode *root, const struct SConfPath *path,
+                    const char **str, struct SConfErr *err)
+{
+    struct SConfNode *node = NULL;
+    int r = sconf_get_typed_p(root, path, SCONF_TYPE_STR, &node, err);
+    if (r != 1) {
+        return r;
+    }
+
+    *str = sconf_node_str(node);
+
+    return 1;
+}
+
+/**
+ * @brief Get config integer based on compiled path.
+ *
+ * @param root    Pointer to root config node.
+ * @param path    The compiled path to the config node to get.
+ * @param integer Pointer to integer, if found.
+ * @param err     Pointer to error struct.
+ *
+ * @return 1 on found, 0 on not found, -1 on error.
+ */
+int sconf_get_int_p(struct SConfNode *root, const struct SConfPath *path,
+                    const int64_t **integer, struct SConfErr *err)
+{
+    struct SConfNode *node = NULL;
+    int r = sconf_get_typed_p(root, path, SCONF_TYPE_INT, &node, err);
+    if (r != 1) {
+        return r;
+    }
+
+    *integer = &node->integer;
+
+    return 1;
+}
+
+/**
+ * @brief Get config boolean based on compiled path.
+ *
+ * @param root    Pointer to root config node.
+ * @param path    The compiled path to the config node to get.
+ * @param boolean Pointer to boolean, if found.
+ * @param err     Pointer to error struct.
+ *
+ * @return 1 on found, 0 on not found, -1 on error.
+ */
+int sconf_get_bool_p(struct SConfNode *root, const struct SConfPath *path,
+                     const bool **boolean, struct SConfErr *err)
+{
+    struct SConfNode *node = NULL;
+    int r = sconf_get_typed_p(root, path, SCONF_TYPE_BOOL, &node, err);
+    if (r != 1) {
+        return r;
+    }
+
+    *boolean = &node->boolean;
+
+    return 1;
+}
+
+/**
+ * @brief Get config floating point number based on compiled path.
+ *
+ * @param root Pointer to root config node.
+ * @param path The compiled path to the config node to get.
+ * @param fp   Pointer to floating point number, if found.
+ * @param err  Pointer to error struct.
+ *
+ * @return 1 on found, 0 on not found, -1 on error.
+ */
+int sconf_get_float_p(struct SConfNode *root, const struct SConfPath *path,
+                      const double **fp, struct SConfErr *err)
+{
+    struct SConfNode *node = NULL;
+    int r = sconf_get_typed_p(root, path, SCONF_TYPE_FLOAT, &node, err);
+    if (r != 1) {
+        return r;
+    }
+
+    *fp = &node->fp;
+
+    return 1;
+}
+
+/**
+ * @brief Get config string based on path.
+ *
+ * @param root Pointer to root config node.
+ * @param path The path to the config node to get.
+ * @param str  Pointer to string, if found.
+ * @param err  Pointer to error struct.
+ *
+ * @return 1 on found, 0 on not found, -1 on error.
+ */
+int sconf_get_str(struct SConfNode *root, const char *path, const char **str,
+                  struct SConfErr *err)
+{
+    struct SConfNode *node = NULL;
+    int r = sconf_get_typed(root, path, SCONF_TYPE_STR, &node, err);
+    if (r != 1) {
+        return r;
+    }
+
+    *str = sconf_node_str(node);
+
+    return 1;
+}
+
+/**
+ * @brief Get config string and its length based on path.
+ *
+ * @param root Pointer to root config node.
+ * @param path The path to the config node to get.
+ * @param str  Pointer to string, if found.
+ * @param len  Pointer to length of string, if found.
+ * @param err  Pointer to error struct.
+ *
+ * @return 1 on found, 0 on not found, -1 on error.
+ */
+int sconf_get_str_n(struct SConfNode *root, const char *path,
+                    const char **str, size_t *len, struct SConfErr *err)
+{
+    struct SConfNode *node = NULL;
+    int r = sconf_get_typed(root, path, SCONF_TYPE_STR, &node, err);
+    if (r != 1) {
+        return r;
+    }
+
+    *str = sconf_node_str(node);
+    *len = node->len;
+
+    return 1;
+}
+
+/**
+ * @brief Get config integer based on path.
  *
  * @param root    Pointer to root config node.
  * @param path    The path to the config node to get.
  * @param integer Pointer to integer, if found.
  * @param err     Pointer to error struct.
  *
- * @return 0 on success, -1 otherwise.
+ * @return 1 on found, 0 on not found, -1 on error.
  */
 int sconf_get_int(struct SConfNode *root, const char *path,
                   const int64_t **integer, struct SConfErr *err)
 {
     struct SConfNode *node = NULL;
+    int r = sconf_get_typed(root, path, SCONF_TYPE_INT, &node, err);
+    if (r != 1) {
+        return r;
+    }
+
+    *integer = &node->integer;
+
+    return 1;
+}
+
+/**
+ * @brief Get config boolean based on path.
+ *
+ * @param root    Pointer to root config node.
+ * @param path    The path to the config node to get.
+ * @param boolean Pointer to boolean, if found.
+ * @param err     Pointer to error struct.
+ *
+ * @return 1 on found, 0 on not found, -1 on error.
+ */
+int sconf_get_bool(struct SConfNode *root, const char *path,
+                   const bool **boolean, struct SConfErr *err)
+{
+    struct SConfNode *node = NULL;
+    int r = sconf_get_typed(root, path, SCONF_TYPE_BOOL, &node, err);
+    if (r != 1) {
+        return r;
+    }
+
+    *boolean = &node->boolean;
+
+    return 1;
+}
+
+/**
+ * @brief Get config floating point number based on path.
+ *
+ * @param root Pointer to root config node.
+ * @param path The path to the config node to get.
+ * @param fp   Pointer to floating point number, if found.
+ * @param err  Pointer to error struct.
+ *
+ * @return 1 on found, 0 on not found, -1 on error.
+ */
+int sconf_get_float(struct SConfNode *root, const char *path,
+                    const double **fp, struct SConfErr *err)
+{
+    struct SConfNode *node = NULL;
+    int r = sconf_get_typed(root, path, SCONF_TYPE_FLOAT, &node, err);
+    if (r != 1) {
+        return r;
+    }
 
-    int r = sconf_get(root, path, &node, err);
+    *fp = &node->fp;
+
+    return 1;
+}
+
+/**
+ * @internal
+ * @brief Get values of packed array based on path.
+ *
+ * @param root   Pointer to root config node.
+ * @param path   The path to the array to get.
+ * @param type   The type of the packed values.
+ * @param values Pointer to the values, if found (NULL if array is empty).
+ * @param len    Pointer to the number of values, if found.
+ * @param err    Pointer to error struct.
+ *
+ * @return 1 on found, 0 on not found, -1 on error.
+ */
+static int sconf_get_packed(struct SConfNode *root, const char *path,
+                            uint8_t type, const void **values, size_t *len,
+                            struct SConfErr *err)
+{
+    struct SConfNode *node = NULL;
+    int r = sconf_get_typed(root, path, SCONF_TYPE_ARRAY, &node, err);
     if (r != 1) {
         return r;
     }
 
-    if (node == NULL) {
-        sconf_err_set(err, "node found but node is NULL");
-        return -1;
-    }
+    const struct SConfArray *array = node->array;
+
+    if (array->packed == type) {
+        *values = array->bits;
+        *len = array->size;
+        return 1;
+    }
+
+    if (!array->packed && sconf_array_is_empty(array)) {
+        *values = NULL;
+        *len = 0;
+        return 1;
+    }
+
+    sconf_err_set(err, "config node '%s' is not a packed %s array", path,
+                  sconf_type_to_str(type));
+    return -1;
+}
+
+/**
+ * @brief Get packed config integers based on path.
+ *
+ * @param root     Pointer to root config node.
+ * @param path     The path to the array to get.
+ * @param integers Pointer to the integers, if found.
+ * @param len      Pointer to the number of integers, if found.
+ * @param err      Pointer to error struct.
+ *
+ * @return 1 on found, 0 on not found, -1 on error.
+ */
+int sconf_get_int_array(struct SConfNode *root, const char *path,
+                        const int64_t **integers, size_t *len,
+                        struct SConfErr *err)
+{
+    return sconf_get_packed(root, path, SCONF_TYPE_INT,
+                            (const void **)integers, len, err);
+}
+
+/**
+ * @brief Get packed config floating point numbers based on path.
+ *
+ * @param root Pointer to root config node.
+ * @param path The path to the array to get.
+ * @param fps  Pointer to the floating point numbers, if found.
+ * @param len  Pointer to the number of floating point numbers, if found.
+ * @param err  Pointer to error struct.
+ *
+ * @return 1 on found, 0 on not found, -1 on error.
+ */
+int sconf_get_float_array(struct SConfNode *root, const char *path,
+                          const double **fps, size_t *len,
+                          struct SConfErr *err)
+{
+    return sconf_get_packed(root, path, SCONF_TYPE_FLOAT, (const void **)fps,
+                            len, err);
+}
+
+/**
+ * @brief Get packed config booleans based on path.
+ *
+ * @param root Pointer to root config node.
+ * @param path The path to the array to get.
+ * @param bits Pointer to the booleans as a bitset, if found.
+ * @param len  Pointer to the number of booleans, if found.
+ * @param err  Pointer to error struct.
+ *
+ * @return 1 on found, 0 on not found, -1 on error.
+ */
+int sconf_get_bool_array(struct SConfNode *root, const char *path,
+                         const uint64_t **bits, size_t *len,
+                         struct SConfErr *err)
+{
+    return sconf_get_packed(root, path, SCONF_TYPE_BOOL, (const void **)bits,
+                            len, err);
+}
+
+/**
+ * @internal
+ * @brief Get or create the child node a path segment refers to.
+ *
+ * @param parent  Pointer to the parent (dictionary or array).
+ * @param segment The path segment.
+ * @param type    The type of the config node.
+ * @param data    Data used when creating node or replacing its value.
+ * @param err     Pointer to the error struct.
+ *
+ * @return Pointer to node on success, NULL otherwise.
+ */
+static struct SConfNode *sconf_node_segment_set(
+        struct SConfNode *parent, const struct SConfPathSegment *segment,
+        uint8_t type, void *data, struct SConfErr *err)
+{
+    assert(parent);
+    assert(segment);
+
+    uint32_t index = 0;
 
-    if (node->type != SCONF_TYPE_INT) {
-        sconf_err_set(err, "config node '%s' is %s not %s",
-                      path, sconf_type_to_str(node->type),
-                      sconf_type_to_str(SCONF_TYPE_INT));
-        return -1;
+    if (parent->type == SCONF_TYPE_ARRAY) {
+        if (!segment->is_index) {
+            /* Set the error message */
+            sconf_path_index_parse(segment->name, segment->len, &index, err);
+            return NULL;
+        }
+        index = segment->index;
     }
 
-    *integer = &node->integer;
-
-    return 1;
+    return sconf_node_child_set(parent, segment->name, segment->len, index,
+                                type, data, err);
 }
 
 /**
- * @brief Get config boolean based on path.
+ * @internal
+ * @brief Check that a value set in an overlay has the type of the value it
+ * hides in the base, as when setting it in a copy of the base.
  *
- * @param root    Pointer to root config node.
- * @param path    The path to the config node to get.
- * @param boolean Pointer to boolean, if found.
+ * @param overlay The overlay root node.
+ * @param path    The parsed path to the config node to set.
+ * @param type    The type of node to set.
  * @param err     Pointer to error struct.
  *
- * @return 1 on found, 0 on not found, -1 on error.
+ * @return 0 on success, -1 otherwise.
  */
-int sconf_get_bool(struct SConfNode *root, const char *path,
-                   const bool **boolean, struct SConfErr *err)
+static int sconf_overlay_set_check(struct SConfNode *overlay,
+                                   const struct SConfPath *path, uint8_t type,
+                                   struct SConfErr *err)
 {
     struct SConfNode *node = NULL;
 
-    int r = sconf_get(root, path, &node, err);
-    if (r != 1) {
-        return r;
-    }
-
-    if (node == NULL) {
-        sconf_err_set(err, "node found but node is NULL");
+    int r = sconf_node_get(sconf_overlay_base(overlay), path, &node, err);
+    if (r == -1) {
         return -1;
     }
 
-    if (node->type != SCONF_TYPE_BOOL) {
-        sconf_err_set(err, "config node '%s' is %s not %s",
-                      path, sconf_type_to_str(node->type),
-                      sconf_type_to_str(SCONF_TYPE_BOOL));
+    if (r == 1 && node->type != type) {
+        sconf_err_set(err, "node '%.*s' already exist in base, but types does "
+                      "not match ('%s' != '%s')", (int)path->len, path->string,
+                      sconf_type_to_str(type), sconf_type_to_str(node->type));
         return -1;
     }
 
-    *boolean = &node->boolean;
-
-    return 1;
+    return 0;
 }
 
 /**
- * @brief Get config floating point number based on path.
+ * @internal
+ * @brief Set config node at parsed path, creating any missing parents.
  *
- * @param root Pointer to root config node.
- * @param path The path to the config node to get.
- * @param fp   Pointer to floating point number, if found.
- * @param err  Pointer to error struct.
+ * @param root  Pointer to root config node.
+ * @param path  The parsed path to the config node to set.
+ * @param type  The type of node to set.
+ * @param value The value to set the config node to.
+ * @param err   Pointer to error struct.
  *
- * @return 1 on found, 0 on not found, -1 on error.
+ * @return Pointer to node on success, NULL otherwise.
  */
-int sconf_get_float(struct SConfNode *root, const char *path,
-                    const double **fp, struct SConfErr *err)
+static struct SConfNode *sconf_node_path_set(struct SConfNode *root,
+                                             const struct SConfPath *path,
+                                             uint8_t type, void *value,
+                                             struct SConfErr *err)
 {
-    struct SConfNode *node = NULL;
+    struct SConfNode *parent = root;
 
-    int r = sconf_get(root, path, &node, err);
-    if (r != 1) {
-        return r;
+    if ((root->flags & SCONF_NODE_FLAG_OVERLAY) &&
+            sconf_overlay_set_check(root, path, type, err) == -1) {
+        return NULL;
     }
 
-    if (node == NULL) {
-        sconf_err_set(err, "node found but node is NULL");
-        return -1;
-    }
+    /* Create all the parent nodes in the path */
+    for (uint32_t i = 0; i + 1 < path->depth; i++)
+    {
+        uint8_t parent_type = SCONF_TYPE_DICT;
 
-    if (node->type != SCONF_TYPE_FLOAT) {
-        sconf_err_set(err, "config node '%s' is %s not %s",
-                      path, sconf_type_to_str(node->type),
-                      sconf_type_to_str(SCONF_TYPE_FLOAT));
-        return -1;
-    }
+        if (path->segments[i + 1].name[0] == '[') {
+            parent_type = SCONF_TYPE_ARRAY;
+        }
 
-    *fp = &node->fp;
+        parent = sconf_node_segment_set(parent, &path->segments[i],
+                                        parent_type, NULL, err);
+        if (!parent) {
+            return NULL;
+        }
+    }
 
-    return 1;
+    return sconf_node_segment_set(parent, &path->segments[path->depth - 1],
+                                  type, value, err);
 }
 
 /**
- * @brief Set config value based on path.
+ * @brief Set config value based on compiled path.
  *
  * @param root  Pointer to root config node.
- * @param path  The path to the config node to set.
+ * @param path  The compiled path to the config node to set.
  * @param type  The type of node to set.
  * @param value The value to set the config node to.
  * @param err   Pointer to error struct.
  *
  * @return 0 on success, -1 otherwise.
  */
-int sconf_set(struct SConfNode *root, const char *path, uint8_t type,
-              void *value, struct SConfErr *err)
+int sconf_set_p(struct SConfNode *root, const struct SConfPath *path,
+                uint8_t type, void *value, struct SConfErr *err)
 {
     if (!root) {
         sconf_err_set(err, "no root was specified");
@@ -1276,60 +2552,125 @@ int sconf_set(struct SConfNode *root, const char *path, uint8_t type,
         return -1;
     }
 
-    char *copy = strdup(path);
-    if (!copy) {
-        sconf_err_set(err, "failed to copy path string");
+    if (!sconf_node_path_set(root, path, type, value, err)) {
         return -1;
     }
 
-    struct SConfNode *parent = root;
-    int parent_index = 0;
+    return 0;
+}
 
-    int depth = 1;
-    char *save_ptr = NULL;
-    char *next = strtok_r(copy, SCONF_PATH_DELIMITER, &save_ptr);
-    char *curr = NULL;
+/**
+ * @brief Set config string based on compiled path.
+ *
+ * @param root Pointer to root config node.
+ * @param path The compiled path to the config node to set.
+ * @param str  The string to set.
+ * @param err  Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sconf_set_str_p(struct SConfNode *root, const struct SConfPath *path,
+                    const char *str, struct SConfErr *err)
+{
+   return sconf_set_p(root, path, SCONF_TYPE_STR, (void *)str, err);
+}
 
-    /* Create all the parent nodes in the path */
-    while (next != NULL)
-    {
-        if (curr) {
-            uint8_t curr_type = SCONF_TYPE_DICT; 
+/**
+ * @brief Set config integer based on compiled path.
+ *
+ * @param root    Pointer to root config node.
+ * @param path    The compiled path to the config node to set.
+ * @param integer The integer to set.
+ * @param err     Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sconf_set_int_p(struct SConfNode *root, const struct SConfPath *path,
+                    int64_t integer, struct SConfErr *err)
+{
+   return sconf_set_p(root, path, SCONF_TYPE_INT, &integer, err);
+}
 
-            if (next[0] == '[') {
-                curr_type = SCONF_TYPE_ARRAY;
-            }
-            
-            parent = sconf_node_create_and_insert(curr, curr_type, parent,
-                                                  parent_index, NULL, err);
-            if (parent == NULL) {
-                free(copy);
-                return -1;
-            }
-        }
+/**
+ * @brief Set config boolean based on compiled path.
+ *
+ * @param root    Pointer to root config node.
+ * @param path    The compiled path to the config node to set.
+ * @param boolean The boolean value to set.
+ * @param err     Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sconf_set_bool_p(struct SConfNode *root, const struct SConfPath *path,
+                     bool boolean, struct SConfErr *err)
+{
+   return sconf_set_p(root, path, SCONF_TYPE_BOOL, &boolean, err);
+}
 
-        if (depth >= SCONF_MAX_DEPTH) {
-            sconf_err_set(err, "maximum depth reached when adding '%s'", path);
-	    free(copy);
-            return -1;
-        }
-        depth++;
+/**
+ * @brief Set floating point number based on compiled path.
+ *
+ * @param root Pointer to root config node.
+ * @param path The compiled path to the config node to set.
+ * @param fp   The floating point number to set.
+ * @param err  Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sconf_set_float_p(struct SConfNode *root, const struct SConfPath *path,
+                      double fp, struct SConfErr *err)
+{
+   return sconf_set_p(root, path, SCONF_TYPE_FLOAT, &fp, err);
+}
+
+/**
+ * @brief Set config value based on path.
+ *
+ * @param root  Pointer to root config node.
+ * @param path  The path to the config node to set.
+ * @param type  The type of node to set.
+ * @param value The value to set the config node to.
+ * @param err   Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sconf_set(struct SConfNode *root, const char *path, uint8_t type,
+              void *value, struct SConfErr *err)
+{
+    return sconf_set_n(root, path, path ? strlen(path) : 0, type, value, err);
+}
 
-        curr = next;
-        next = strtok_r(NULL, SCONF_PATH_DELIMITER, &save_ptr);
+/**
+ * @brief Set config value based on path of given length.
+ *
+ * @param root  Pointer to root config node.
+ * @param path  The path to the config node to set (not null terminated).
+ * @param len   Length of path.
+ * @param type  The type of node to set.
+ * @param value The value to set the config node to.
+ * @param err   Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sconf_set_n(struct SConfNode *root, const char *path, size_t len,
+                uint8_t type, void *value, struct SConfErr *err)
+{
+    if (!root) {
+        sconf_err_set(err, "no root was specified");
+        return -1;
     }
 
-    struct SConfNode *node = sconf_node_create_and_insert(curr, type, parent,
-                                                          parent_index, value,
-                                                          err);
-    if (!node) {
-        free(copy);
+    if (!value) {
+        sconf_err_set(err, "no value was specified");
         return -1;
     }
 
-    free(copy);
+    struct SConfPath parsed;
+    if (sconf_path_from_string(&parsed, path, len, err) == -1) {
+        return -1;
+    }
 
-    return 0;
+    return sconf_set_p(root, &parsed, type, value, err);
 }
 
 /**
@@ -1348,6 +2689,50 @@ int sconf_set_str(struct SConfNode *root, const char *path, const char *str,
    return sconf_set(root, path, SCONF_TYPE_STR, (void *)str, err);
 }
 
+/**
+ * @brief Set config string based on path, both of given length.
+ *
+ * The string may contain null bytes, but is stored null terminated.
+ *
+ * @param root     Pointer to root config node.
+ * @param path     The path to the config node to set (not null terminated).
+ * @param path_len Length of path.
+ * @param str      The string to set (not null terminated).
+ * @param str_len  Length of string.
+ * @param err      Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sconf_set_str_n(struct SConfNode *root, const char *path, size_t path_len,
+                    const char *str, size_t str_len, struct SConfErr *err)
+{
+    if (!root) {
+        sconf_err_set(err, "no root was specified");
+        return -1;
+    }
+
+    if (!str) {
+        sconf_err_set(err, "no value was specified");
+        return -1;
+    }
+
+    struct SConfPath parsed;
+    if (sconf_path_from_string(&parsed, path, path_len, err) == -1) {
+        return -1;
+    }
+
+    /* Find the node, or create it with an empty string, without touching an
+       existing value, since str may point into it. The string is then copied
+       once, which handles the aliasing */
+    struct SConfNode *node = sconf_node_path_set(root, &parsed, SCONF_TYPE_STR,
+                                                 NULL, err);
+    if (!node) {
+        return -1;
+    }
+
+    return sconf_node_str_set(node, str, str_len, err);
+}
+
 /**
  * @brief Set config integer based on path.
  *
@@ -1396,6 +2781,127 @@ int sconf_set_float(struct SConfNode *root, const char *path, double fp,
    return sconf_set(root, path, SCONF_TYPE_FLOAT, &fp, err);
 }
 
+/**
+ * @internal
+ * @brief Get existing config node of specific type to update atomically.
+ *
+ * @param root Pointer to root config node.
+ * @param path The path to the config node.
+ * @param type The expected type of the config node.
+ * @param err  Pointer to error struct.
+ *
+ * @return Pointer to node on success, NULL otherwise.
+ */
+static struct SConfNode *sconf_node_atomic_get(struct SConfNode *root,
+                                               const char *path, uint8_t type,
+                                               struct SConfErr *err)
+{
+    struct SConfNode *node = NULL;
+
+    int r = sconf_get_typed(root, path, type, &node, err);
+    if (r == 0) {
+        sconf_err_set(err, "config node '%s' does not exist", path);
+        return NULL;
+    }
+    if (r == -1) {
+        return NULL;
+    }
+
+    if (node->flags & SCONF_NODE_FLAG_FROZEN) {
+        sconf_err_set(err, "config node is frozen");
+        return NULL;
+    }
+
+    if (node->flags & SCONF_NODE_FLAG_PACKED) {
+        sconf_err_set(err, "config node '%s' is in a packed array", path);
+        return NULL;
+    }
+
+    if (root->flags & SCONF_NODE_FLAG_OVERLAY) {
+        /* The base is shared, only values set in the overlay are updated */
+        struct SConfNode *own = NULL;
+        if (sconf_overlay_get_own(root, path, &own, err) != 1 || own != node) {
+            sconf_err_set(err, "config node '%s' is not set in overlay", path);
+            return NULL;
+        }
+    }
+
+    return node;
+}
+
+/**
+ * @brief Update existing config integer in place, using an atomic store.
+ *
+ * @param root    Pointer to root config node.
+ * @param path    The path to the config node to update.
+ * @param integer The integer to set.
+ * @param err     Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sconf_set_int_atomic(struct SConfNode *root, const char *path,
+                         int64_t integer, struct SConfErr *err)
+{
+    struct SConfNode *node = sconf_node_atomic_get(root, path, SCONF_TYPE_INT,
+                                                   err);
+    if (!node) {
+        return -1;
+    }
+
+    __atomic_store_n(&node->integer, integer, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+/**
+ * @brief Update existing config boolean in place, using an atomic store.
+ *
+ * @param root    Pointer to root config node.
+ * @param path    The path to the config node to update.
+ * @param boolean The boolean value to set.
+ * @param err     Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sconf_set_bool_atomic(struct SConfNode *root, const char *path,
+                          bool boolean, struct SConfErr *err)
+{
+    struct SConfNode *node = sconf_node_atomic_get(root, path,
+                                                   SCONF_TYPE_BOOL, err);
+    if (!node) {
+        return -1;
+    }
+
+    __atomic_store_n(&node->boolean, boolean, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+/**
+ * @brief Update existing floating point number in place, using an atomic
+ *        store.
+ *
+ * @param root Pointer to root config node.
+ * @param path The path to the config node to update.
+ * @param fp   The floating point number to set.
+ * @param err  Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sconf_set_float_atomic(struct SConfNode *root, const char *path,
+                           double fp, struct SConfErr *err)
+{
+    struct SConfNode *node = sconf_node_atomic_get(root, path,
+                                                   SCONF_TYPE_FLOAT, err);
+    if (!node) {
+        return -1;
+    }
+
+    __atomic_store(&node->fp, &fp, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
 /**
  * @brief Create a complete config tree based on config map.
  *
@@ -1,558 +1,886 @@
 #include <assert.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include <yaml.h>
 
 #include "convert.h"
 #include "sconf_private.h"
+#include "yaml_native.h"
 
-enum {
-    SCONF_YAML_STATE_START,
-    SCONF_YAML_STATE_STOP,
-    SCONF_YAML_STATE_STREAM,
-    SCONF_YAML_STATE_DOCUMENT,
-    SCONF_YAML_STATE_BLOCK,
-    SCONF_YAML_STATE_BLOCK_CONTENT,
-    SCONF_YAML_STATE_SEQUENCE,
+/* Parser used when neither SCONF_YAML_NATIVE nor SCONF_YAML_LIBYAML is set
+   (see the SCONF_ENABLE_NATIVE_YAML build option) */
+#ifndef SCONF_NATIVE_YAML_DEFAULT
+#define SCONF_NATIVE_YAML_DEFAULT 0
+#endif
+
+#define SCONF_YAML_FLAGS \
+    (SCONF_YAML_NATIVE | SCONF_YAML_LIBYAML | SCONF_YAML_NO_FALLBACK)
+
+/* Documents read by sconf_yaml_read_stream, each into a root of its own
+   which is handed to the callback */
+struct SConfYAMLStream {
+    int (*cb)(struct SConfNode *root, void *user, struct SConfErr *err);
+    void *user;
+
+    /* Arena-backed root of the last document, reset for the next one */
+    struct SConfNode *root;
 };
 
-struct SConfYAMLParent {
-    struct SConfNode *parent;
-    uint32_t curr_index;
-    struct SConfYAMLParent *next;
+/* Source of YAML events, either libyaml or the native parser */
+struct SConfYAMLReader {
+    yaml_parser_t *parser;
+    struct SConfYAMLNative *native;
+    struct SConfYAMLStream *stream;
 };
 
-struct SConfYAMLState {
-    uint8_t state;
-    int depth;
-    char *curr_key;
-    struct SConfYAMLParent *curr_parent;
+/* YAML event from either parser. The value of a scalar is null terminated,
+   except for keys from the native parser. */
+struct SConfYAMLEvent {
+    yaml_event_type_t type;
+    yaml_scalar_style_t style;
+    const char *value;
+    size_t length;
+    yaml_event_t event;
 };
 
+static int sconf_yaml_read_mapping(struct SConfYAMLReader *reader,
+                                   struct SConfNode *dict, int depth,
+                                   struct SConfErr *err);
+static int sconf_yaml_read_sequence(struct SConfYAMLReader *reader,
+                                    struct SConfNode *array, int depth,
+                                    struct SConfErr *err);
+
 /**
  * @internal
- * @brief Push parent onto parent stack.
+ * @brief Get next event from YAML parser.
  *
- * @param parent Pointer to parent.
- * @param state  State of the YAML parser.
+ * @param reader The source of YAML events.
+ * @param event  The event, must be deleted by the caller on success.
+ * @param key    true if the event is a mapping key, which does not need to
+ *               be null terminated.
  * @param err    Pointer to error struct.
  *
  * @return 0 on success, -1 otherwise.
  */
-static int sconf_yaml_parent_stack_push(struct SConfNode *parent,
-                                        struct SConfYAMLState *state,
-                                        struct SConfErr *err)
+static int sconf_yaml_next(struct SConfYAMLReader *reader,
+                           struct SConfYAMLEvent *event, bool key,
+                           struct SConfErr *err)
 {
-    assert(parent);
-    assert(state);
+    if (reader->native) {
+        struct SConfYAMLToken token;
+        if (sconf_yaml_native_next(reader->native, &token) != 0) {
+            sconf_err_set(err, "error parsing YAML");
+            return -1;
+        }
 
-    if (state->depth >= SCONF_MAX_DEPTH - 1) {
-        sconf_err_set(err, "maximum depth reached when reading YAML file");
-        return -1;
+        event->type = token.type;
+        event->style = token.style;
+        event->value = token.value;
+        event->length = token.length;
+
+        if (token.type == YAML_SCALAR_EVENT && !key) {
+            event->value = sconf_yaml_native_str(reader->native, &token);
+            if (!event->value) {
+                sconf_err_set(err, "failed to allocate memory for YAML "
+                              "scalar");
+                return -1;
+            }
+        }
+
+        return 0;
     }
-    state->depth++;
 
-    struct SConfYAMLParent *p = calloc(1, sizeof(struct SConfYAMLParent));
-    if (!p) {
-        sconf_err_set(err, "failed to allocate memory for YAML parent");
+    if (!yaml_parser_parse(reader->parser, &event->event)) {
+        sconf_err_set(err, "error parsing YAML");
         return -1;
     }
 
-    p->parent = parent;
-    p->next = state->curr_parent;
-    state->curr_parent = p;
+    event->type = event->event.type;
+    if (event->type == YAML_SCALAR_EVENT) {
+        event->style = event->event.data.scalar.style;
+        event->value = (const char *)event->event.data.scalar.value;
+        event->length = event->event.data.scalar.length;
+    }
 
     return 0;
 }
 
 /**
  * @internal
- * @brief Pop parent from parent stack.
+ * @brief Delete event from YAML parser.
+ *
+ * @param reader The source of YAML events.
+ * @param event  The event.
+ */
+static void sconf_yaml_event_delete(struct SConfYAMLReader *reader,
+                                    struct SConfYAMLEvent *event)
+{
+    if (!reader->native) {
+        yaml_event_delete(&event->event);
+    }
+}
+
+/**
+ * @internal
+ * @brief Set error for event that is not expected.
  *
- * @param state State of the YAML parser.
+ * @param event The YAML event.
+ * @param what  What was expected.
  * @param err   Pointer to error struct.
  *
- * @return 0 on success, -1 otherwise.
+ * @return -1.
  */
-static int sconf_yaml_parent_stack_pop(struct SConfYAMLState *state,
-                                       struct SConfErr *err)
+static int sconf_yaml_unexpected(const struct SConfYAMLEvent *event, const char *what,
+                                 struct SConfErr *err)
 {
-    assert(state);
-
-    struct SConfYAMLParent *p = state->curr_parent;
+    sconf_err_set(err, "Unexpected event %d, expected %s", event->type, what);
+    return -1;
+}
 
-    if (!p) {
-        sconf_err_set(err, "parent stack is empty");
+/**
+ * @internal
+ * @brief Add scalar to dict or array.
+ *
+ * Quoted and empty scalars are strings, others are converted to integer,
+ * floating point number or boolean if possible.
+ *
+ * @param parent   The dict or array.
+ * @param name     Key of the scalar if parent is a dict (not null
+ *                 terminated).
+ * @param name_len Length of name.
+ * @param index    Index of the scalar if parent is an array.
+ * @param event    The scalar event.
+ * @param err      Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int sconf_yaml_scalar_add(struct SConfNode *parent, const char *name,
+                                 uint32_t name_len, uint32_t index,
+                                 const struct SConfYAMLEvent *event,
+                                 struct SConfErr *err)
+{
+    struct SConfScalar scalar = {
+        .type = SCONF_TYPE_STR,
+    };
+    void *data = (void *)event->value;
+
+    if (event->style != YAML_DOUBLE_QUOTED_SCALAR_STYLE &&
+            event->style != YAML_SINGLE_QUOTED_SCALAR_STYLE &&
+            event->length > 0 &&
+            sconf_string_to_scalar(event->value, event->length, &scalar,
+                                   err) == -1) {
         return -1;
     }
 
-    state->depth--;
-    state->curr_parent = p->next;
+    switch (scalar.type)
+    {
+        case SCONF_TYPE_INT:
+            data = &scalar.integer;
+            break;
+        case SCONF_TYPE_FLOAT:
+            data = &scalar.fp;
+            break;
+        case SCONF_TYPE_BOOL:
+            data = &scalar.boolean;
+            break;
+    }
 
-    free(p);
+    uint8_t type = scalar.type;
+
+    if (parent->type == SCONF_TYPE_ARRAY) {
+        /* Packs sequences of integers, floats or booleans */
+        return sconf_node_array_set_value(parent, index, type, data, err);
+    }
+
+    if (!sconf_node_child_set(parent, name, name_len, 0, type, data, err)) {
+        return -1;
+    }
 
     return 0;
 }
 
 /**
  * @internal
- * @brief Destroy YAML parsing state.
+ * @brief Read value starting with event into dict or array.
+ *
+ * @param reader   The source of YAML events.
+ * @param parent   The dict or array.
+ * @param name     Key of the value if parent is a dict (not null
+ *                 terminated).
+ * @param name_len Length of name.
+ * @param index    Index of the value if parent is an array.
+ * @param event    First event of the value, deleted by the caller.
+ * @param depth    Number of mappings and sequences parent is nested in,
+ *                 including parent.
+ * @param err      Pointer to error struct.
  *
- * @param state State of the YAML parser.
+ * @return 0 on success, -1 otherwise.
  */
-static void sconf_yaml_state_destroy(struct SConfYAMLState *state)
+static int sconf_yaml_read_value(struct SConfYAMLReader *reader,
+                                 struct SConfNode *parent, const char *name,
+                                 uint32_t name_len, uint32_t index,
+                                 const struct SConfYAMLEvent *event, int depth,
+                                 struct SConfErr *err)
 {
-    assert(state);
+    uint8_t type;
 
-    while (state->curr_parent)
+    switch (event->type)
     {
-        sconf_yaml_parent_stack_pop(state, NULL);
+        case YAML_SCALAR_EVENT:
+            return sconf_yaml_scalar_add(parent, name, name_len, index, event,
+                                         err);
+        case YAML_MAPPING_START_EVENT:
+            type = SCONF_TYPE_DICT;
+            break;
+        case YAML_SEQUENCE_START_EVENT:
+            type = SCONF_TYPE_ARRAY;
+            break;
+        default:
+            return sconf_yaml_unexpected(event, "scalar, mapping or sequence",
+                                         err);
     }
 
-    if (state->curr_key) {
-        free(state->curr_key);
+    if (depth >= SCONF_MAX_DEPTH - 1) {
+        sconf_err_set(err, "maximum depth reached when reading YAML file");
+        return -1;
+    }
+
+    /* Existing dicts and arrays are read into */
+    struct SConfNode *node = sconf_node_child_set(parent, name, name_len,
+                                                  index, type, NULL, err);
+    if (!node) {
+        return -1;
+    }
+
+    if (type == SCONF_TYPE_DICT) {
+        return sconf_yaml_read_mapping(reader, node, depth + 1, err);
     }
+
+    return sconf_yaml_read_sequence(reader, node, depth + 1, err);
 }
 
+
 /**
  * @internal
- * @brief Add parent to YAML state.
+ * @brief Read YAML mapping into dict, after the mapping start event.
  *
- * @param state State of the YAML parser.
- * @param type  Type of parent to add.
- * @param err   Pointer to error struct.
+ * Keys are inserted straight from the key events, which are kept until the
+ * value is read.
+ *
+ * @param reader The source of YAML events.
+ * @param dict   The dict.
+ * @param depth  Number of mappings and sequences dict is nested in,
+ *               including dict.
+ * @param err    Pointer to error struct.
  *
  * @return 0 on success, -1 otherwise.
  */
-static int sconf_yaml_parent_add(struct SConfYAMLState *state, uint8_t type,
-                                 struct SConfErr *err)
+static int sconf_yaml_read_mapping(struct SConfYAMLReader *reader,
+                                   struct SConfNode *dict, int depth,
+                                   struct SConfErr *err)
 {
-    assert(state);
-    assert(type == SCONF_TYPE_DICT || type == SCONF_TYPE_ARRAY);
+    for (;;)
+    {
+        struct SConfYAMLEvent key;
+        if (sconf_yaml_next(reader, &key, true, err) == -1) {
+            return -1;
+        }
 
-    struct SConfYAMLParent *p = state->curr_parent;
-    if (!p) {
-        sconf_err_set(err, "parent stack is empty");
-        return -1;
-    }
+        if (key.type == YAML_MAPPING_END_EVENT) {
+            sconf_yaml_event_delete(reader, &key);
+            return 0;
+        }
 
-    if (p->parent->type == SCONF_TYPE_DICT && !state->curr_key) {
-        sconf_err_set(err, "parent is dict, but key is not set");
-        return -1;
+        if (key.type != YAML_SCALAR_EVENT) {
+            sconf_yaml_unexpected(&key, "scalar key", err);
+            sconf_yaml_event_delete(reader, &key);
+            return -1;
+        }
+
+        if (key.length > UINT32_MAX - 1) {
+            sconf_err_set(err, "key is too long");
+            sconf_yaml_event_delete(reader, &key);
+            return -1;
+        }
+
+        struct SConfYAMLEvent value;
+        if (sconf_yaml_next(reader, &value, false, err) == -1) {
+            sconf_yaml_event_delete(reader, &key);
+            return -1;
+        }
+
+        int r = sconf_yaml_read_value(reader, dict, key.value,
+                                      (uint32_t)key.length, 0, &value, depth,
+                                      err);
+        sconf_yaml_event_delete(reader, &value);
+        sconf_yaml_event_delete(reader, &key);
+        if (r == -1) {
+            return -1;
+        }
     }
+}
 
-    struct SConfNode *parent = sconf_node_create_and_insert(state->curr_key,
-                                                     type,
-                                                     p->parent, p->curr_index,
-                                                     NULL, err);
-    if (parent == NULL) {
-        return -1;
+/**
+ * @internal
+ * @brief Read YAML sequence into array, after the sequence start event.
+ *
+ * @param reader The source of YAML events.
+ * @param array  The array.
+ * @param depth  Number of mappings and sequences array is nested in,
+ *               including array.
+ * @param err    Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int sconf_yaml_read_sequence(struct SConfYAMLReader *reader,
+                                    struct SConfNode *array, int depth,
+                                    struct SConfErr *err)
+{
+    for (uint32_t index = 0;; index++)
+    {
+        struct SConfYAMLEvent event;
+        if (sconf_yaml_next(reader, &event, false, err) == -1) {
+            return -1;
+        }
+
+        if (event.type == YAML_SEQUENCE_END_EVENT) {
+            sconf_yaml_event_delete(reader, &event);
+            return 0;
+        }
+
+        int r = sconf_yaml_read_value(reader, array, NULL, 0, index, &event,
+                                      depth, err);
+        sconf_yaml_event_delete(reader, &event);
+        if (r == -1) {
+            return -1;
+        }
     }
+}
 
-    if (sconf_yaml_parent_stack_push(parent, state, err) != 0) {
+/**
+ * @internal
+ * @brief Read YAML document into config, after the document start event.
+ *
+ * @param reader The source of YAML events.
+ * @param root   The config root node.
+ * @param err    Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int sconf_yaml_read_document(struct SConfYAMLReader *reader,
+                                    struct SConfNode *root,
+                                    struct SConfErr *err)
+{
+    struct SConfYAMLEvent event;
+    if (sconf_yaml_next(reader, &event, false, err) == -1) {
         return -1;
     }
 
-    if (p->parent->type == SCONF_TYPE_ARRAY) {
-        p->curr_index++;
-    }
-    else if (p->parent->type == SCONF_TYPE_DICT) {
-        free(state->curr_key);
-        state->curr_key = NULL;
+    int r = 0;
+
+    switch (event.type)
+    {
+        case YAML_MAPPING_START_EVENT:
+            /* The root mapping is read into the config root */
+            r = sconf_yaml_read_mapping(reader, root, 1, err);
+            sconf_yaml_event_delete(reader, &event);
+            if (r == -1 ||
+                    sconf_yaml_next(reader, &event, false, err) == -1) {
+                return -1;
+            }
+            if (event.type != YAML_DOCUMENT_END_EVENT) {
+                r = sconf_yaml_unexpected(&event, "document end", err);
+            }
+            break;
+
+        case YAML_DOCUMENT_END_EVENT:
+            break;
+
+        default:
+            r = sconf_yaml_unexpected(&event, "mapping", err);
+            break;
     }
 
-    return 0;
+    sconf_yaml_event_delete(reader, &event);
+
+    return r;
 }
 
 /**
  * @internal
- * @brief Remove parent from YAML state.
+ * @brief Read YAML document into a root of its own and hand it to the
+ * stream callback, after the document start event.
  *
- * @param state State of the YAML parser.
- * @param type  Expected type of parent to remove.
- * @param err   Pointer to error struct.
+ * The arena of the previous document is reused, so reading documents of
+ * similar size does not allocate.
+ *
+ * @param reader The source of YAML events, with stream set.
+ * @param err    Pointer to error struct.
  *
  * @return 0 on success, -1 otherwise.
  */
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wunused-parameter"
-static int sconf_yaml_parent_remove(struct SConfYAMLState *state, uint8_t type,
-                                    struct SConfErr *err)
+static int sconf_yaml_read_stream_document(struct SConfYAMLReader *reader,
+                                           struct SConfErr *err)
 {
-    assert(state);
-    assert(type == SCONF_TYPE_DICT || type == SCONF_TYPE_ARRAY);
+    struct SConfYAMLStream *stream = reader->stream;
 
-    struct SConfYAMLParent *p = state->curr_parent;
-    if (!p) {
-        sconf_err_set(err, "parent stack is empty");
+    if (stream->root) {
+        stream->root = sconf_node_arena_reset(stream->root, SCONF_TYPE_DICT,
+                                              NULL, err);
+    }
+    else {
+        stream->root = SCONF_ROOT_ARENA(err);
+    }
+
+    if (!stream->root ||
+            sconf_yaml_read_document(reader, stream->root, err) == -1) {
         return -1;
     }
 
-    if (sconf_yaml_parent_stack_pop(state, err) != 0) {
+    if (stream->cb(stream->root, stream->user, err) != 0) {
         return -1;
     }
 
     return 0;
 }
-#pragma GCC diagnostic pop
 
 /**
  * @internal
- * @brief Add node to config.
+ * @brief Parse YAML from reader into config.
+ *
+ * All documents in the stream are read into the same root, unless the
+ * reader has a stream set.
+ *
+ * @param root   The config root node.
+ * @param reader The source of YAML events, with input set.
+ * @param err    Pointer to error struct.
  *
- * @param state       State of the YAML parser.
- * @param parent_type Expected parent type.
- * @param event       The YAML event.
- * @param err         Pointer to error struct.
+ * @return 0 on success, -1 otherwise.
  */
-static int sconf_yaml_node_add(struct SConfYAMLState *state,
-                               uint8_t parent_type, yaml_event_t *event,
-                               struct SConfErr *err)
+static int sconf_yaml_parse(struct SConfNode *root,
+                            struct SConfYAMLReader *reader,
+                            struct SConfErr *err)
 {
-    assert(state);
-    assert(event);
-    assert(parent_type == SCONF_TYPE_DICT || parent_type == SCONF_TYPE_ARRAY);
-
-    struct SConfYAMLParent *p = state->curr_parent;
-    if (!p) {
-        sconf_err_set(err, "parent stack is empty");
+    struct SConfYAMLEvent event;
+    if (sconf_yaml_next(reader, &event, false, err) == -1) {
         return -1;
     }
 
-    char *value_str = (char *)event->data.scalar.value;
-
-    if (parent_type != p->parent->type) {
-        sconf_err_set(err, "expected parent type '%d' but got '%d'",
-                      parent_type, p->parent->type);
+    if (event.type != YAML_STREAM_START_EVENT) {
+        sconf_yaml_unexpected(&event, "stream start", err);
+        sconf_yaml_event_delete(reader, &event);
         return -1;
     }
+    sconf_yaml_event_delete(reader, &event);
 
-    void *data = value_str;
-    uint8_t type = SCONF_TYPE_STR;
-    int64_t integer;
-    bool boolean;
-    double fp;
-    int r = 0;
+    for (;;)
+    {
+        if (sconf_yaml_next(reader, &event, false, err) == -1) {
+            return -1;
+        }
 
-    if (event->data.scalar.style == YAML_DOUBLE_QUOTED_SCALAR_STYLE ||
-            event->data.scalar.style == YAML_SINGLE_QUOTED_SCALAR_STYLE ||
-            strlen(value_str) == 0) {
-        data = value_str;
-        type = SCONF_TYPE_STR;
-    }
-    else if ((r = sconf_string_to_integer(value_str, &integer, err))) {
-        data = &integer;
-        type = SCONF_TYPE_INT;
-    }
-    else if ((r = sconf_string_to_float(value_str, &fp, err))) {
-        data = &fp;
-        type = SCONF_TYPE_FLOAT;
-    }
-    else if ((r = sconf_string_to_bool(value_str, &boolean))) {
-        data = &boolean;
-        type = SCONF_TYPE_BOOL;
+        yaml_event_type_t type = event.type;
+        if (type != YAML_DOCUMENT_START_EVENT &&
+                type != YAML_STREAM_END_EVENT) {
+            sconf_yaml_unexpected(&event, "document start", err);
+        }
+        sconf_yaml_event_delete(reader, &event);
+
+        if (type == YAML_STREAM_END_EVENT) {
+            return 0;
+        }
+        if (type != YAML_DOCUMENT_START_EVENT) {
+            return -1;
+        }
+
+        int r = reader->stream ?
+                sconf_yaml_read_stream_document(reader, err) :
+                sconf_yaml_read_document(reader, root, err);
+        if (r == -1) {
+            return -1;
+        }
     }
+}
+
+/**
+ * @internal
+ * @brief Parse YAML with libyaml into config.
+ *
+ * @param root   The config root node, NULL if stream is set.
+ * @param stream The documents to hand out one by one, or NULL.
+ * @param parser The initialized YAML parser, with input set.
+ * @param err    Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int sconf_yaml_parse_libyaml(struct SConfNode *root,
+                                    struct SConfYAMLStream *stream,
+                                    yaml_parser_t *parser,
+                                    struct SConfErr *err)
+{
+    struct SConfYAMLReader reader = {
+        .parser = parser,
+        .stream = stream,
+    };
 
+    return sconf_yaml_parse(root, &reader, err);
+}
+
+/**
+ * @internal
+ * @brief Parse YAML with the native parser into config.
+ *
+ * The input is checked before anything is read, YAML outside of the subset
+ * of the native parser is left to libyaml unless fallback is disabled.
+ *
+ * @param root   The config root node, NULL if stream is set.
+ * @param stream The documents to hand out one by one, or NULL.
+ * @param data   The YAML document(s), not necessarily null terminated.
+ * @param len    Length of data.
+ * @param flags  Flags given to the read function.
+ * @param err    Pointer to error struct.
+ *
+ * @return 0 on success, 1 if libyaml should read the input, -1 otherwise.
+ */
+static int sconf_yaml_parse_native(struct SConfNode *root,
+                                   struct SConfYAMLStream *stream,
+                                   const char *data, size_t len, int flags,
+                                   struct SConfErr *err)
+{
+    int r = sconf_yaml_native_check(data, len);
     if (r == -1) {
+        sconf_err_set(err, "failed to allocate memory for YAML parser");
         return -1;
     }
 
-    struct SConfNode *node = sconf_node_create_and_insert(state->curr_key, type,
-                                                          p->parent,
-                                                          p->curr_index, data,
-                                                          err);
-    if (!node) {
+    if (r == SCONF_YAML_NATIVE_UNSUPPORTED) {
+        if (flags & SCONF_YAML_NO_FALLBACK) {
+            sconf_err_set(err, "YAML is not supported by the native parser");
+            return -1;
+        }
+        return 1;
+    }
+
+    struct SConfYAMLNative native;
+    sconf_yaml_native_init(&native, data, len);
+
+    struct SConfYAMLReader reader = {
+        .native = &native,
+        .stream = stream,
+    };
+
+    r = sconf_yaml_parse(root, &reader, err);
+
+    sconf_yaml_native_release(&native);
+
+    return r;
+}
+
+/**
+ * @internal
+ * @brief Check flags given to a read function.
+ *
+ * @param flags The flags.
+ * @param err   Pointer to error struct.
+ *
+ * @return 1 if the native parser should be used, 0 for libyaml, -1 if flags
+ * are not valid.
+ */
+static int sconf_yaml_flags_check(int flags, struct SConfErr *err)
+{
+    if (flags & ~SCONF_YAML_FLAGS) {
+        sconf_err_set(err, "unknown YAML read flags %#x", flags);
         return -1;
     }
 
-    if (parent_type == SCONF_TYPE_ARRAY) {
-        p->curr_index++;
+    if ((flags & SCONF_YAML_NATIVE) && (flags & SCONF_YAML_LIBYAML)) {
+        sconf_err_set(err, "YAML read flags select more than one parser");
+        return -1;
     }
-    else if (parent_type == SCONF_TYPE_DICT) {
-        free(state->curr_key);
-        state->curr_key = NULL;
+
+    if (flags & SCONF_YAML_NATIVE) {
+        return 1;
     }
- 
-    return 0;
+
+    return !(flags & SCONF_YAML_LIBYAML) && SCONF_NATIVE_YAML_DEFAULT;
 }
 
 /**
  * @internal
- * @brief Consume event from YAML parser.
- *
- * FUTURE: it would make more sense to implement this as a recursive
- * decent parser. Then all the parent stack code could be removed.
+ * @brief Read config from YAML in memory buffer, into root or document by
+ * document into stream.
  *
- * @param root  The config node root.
- * @param event The YAML event.
- * @param state State of the YAML parser.
- * @param err   Pointer to error struct.
+ * @param root   The config root node, NULL if stream is set.
+ * @param stream The documents to hand out one by one, or NULL.
+ * @param data   The YAML document(s), not necessarily null terminated.
+ * @param len    Length of data.
+ * @param flags  Selects the parser (e.g SCONF_YAML_NATIVE).
+ * @param err    Pointer to error struct.
  *
- * @return 1 on success, 0 otherwise.
+ * @return 0 on success, -1 otherwise.
  */
-static int sconf_yaml_consume_event(struct SConfNode *root, yaml_event_t *event,
-                                    struct SConfYAMLState *state,
-                                    struct SConfErr *err)
+static int sconf_yaml_read_data(struct SConfNode *root,
+                                struct SConfYAMLStream *stream,
+                                const char *data, size_t len, int flags,
+                                struct SConfErr *err)
 {
-    assert(root);
-    assert(event);
-    assert(state);
+    if (!data && len > 0) {
+        sconf_err_set(err, "no YAML data was provided");
+        return -1;
+    }
 
-    switch (state->state)
-    {
-        case SCONF_YAML_STATE_START:
-            switch (event->type)
-            {
-                case YAML_STREAM_START_EVENT:
-                    state->state = SCONF_YAML_STATE_STREAM;
-                    break;
-
-                default:
-                    sconf_err_set(err, "Unexpected event %d in state %d",
-                                  event->type, state->state);
-                    return 0;
-            } 
-            break;
+    int native = sconf_yaml_flags_check(flags, err);
+    if (native == -1) {
+        return -1;
+    }
 
-        case SCONF_YAML_STATE_STREAM:
-            switch (event->type)
-            {
-                case YAML_DOCUMENT_START_EVENT:
-                    state->state = SCONF_YAML_STATE_DOCUMENT;
-                    break;
-
-                case YAML_STREAM_END_EVENT:
-                    state->state = SCONF_YAML_STATE_STOP;
-                    break;
-
-                default:
-                    sconf_err_set(err, "Unexpected event %d in state %d",
-                                  event->type, state->state);
-                    return 0;
-            }
-            break;
+    if (native) {
+        int r = sconf_yaml_parse_native(root, stream, data, len, flags,
+                                        err);
+        if (r != 1) {
+            return r;
+        }
+    }
 
-        case SCONF_YAML_STATE_DOCUMENT:
-            switch (event->type)
-            {
-                case YAML_MAPPING_START_EVENT:
-                    if (sconf_yaml_parent_stack_push(root, state, err) == -1) {
-                        return 0;
-                    }
-                    state->state = SCONF_YAML_STATE_BLOCK;
-                    break;
-
-                case YAML_DOCUMENT_END_EVENT:
-                    state->state = SCONF_YAML_STATE_STREAM;
-                    break;
-
-                default:
-                    sconf_err_set(err, "Unexpected event %d in state %d",
-                                  event->type, state->state);
-                    return 0;
-            }
-            break;
+    yaml_parser_t parser;
+    if (!yaml_parser_initialize(&parser)) {
+        sconf_err_set(err, "failed to initialize YAML parser");
+        return -1;
+    }
 
-        case SCONF_YAML_STATE_BLOCK:
-            switch (event->type)
-            {
-                case YAML_SCALAR_EVENT:
-                    if (state->curr_key) {
-                        sconf_err_set(err, "key is already set to '%s'",
-                                      state->curr_key);
-                        free(state->curr_key);
-                        state->curr_key = NULL;
-                        return 0;
-                    }
-                    state->curr_key = strdup((char *)event->data.scalar.value);
-                    if (!state->curr_key) {
-                        sconf_err_set(err, "could not allocate memory for key");
-                        return 0;
-                    }
-                    state->state = SCONF_YAML_STATE_BLOCK_CONTENT;
-                    break;
-
-                case YAML_SEQUENCE_END_EVENT:
-                    if (sconf_yaml_parent_remove(state, SCONF_TYPE_ARRAY,
-                                                 err) != 0) {
-                        return 0;
-                    }
-                    break;
-
-                case YAML_MAPPING_END_EVENT:
-                    if (sconf_yaml_parent_remove(state, SCONF_TYPE_DICT,
-                                                 err) != 0) {
-                        return 0;
-                    }
-                    if (state->curr_parent &&
-                            state->curr_parent->parent->type == SCONF_TYPE_ARRAY) {
-                        state->state = SCONF_YAML_STATE_SEQUENCE;
-                    }
-                    break;
-
-                case YAML_MAPPING_START_EVENT:
-                    if (sconf_yaml_parent_add(state, SCONF_TYPE_DICT,
-                                              err) != 0) {
-                        return 0;
-                    }
-                    break;
-
-                case YAML_DOCUMENT_END_EVENT:
-                    state->state = SCONF_YAML_STATE_STREAM;
-                    break;
-
-                default:
-                    sconf_err_set(err, "Unexpected event %d in state %d",
-                                  event->type, state->state);
-                    return 0;
-            }
-            break;
+    const unsigned char *input = (const unsigned char *)(data ? data : "");
+    yaml_parser_set_input_string(&parser, input, len);
 
-        case SCONF_YAML_STATE_BLOCK_CONTENT:
-            switch (event->type)
-            {
-                case YAML_SCALAR_EVENT:
-                    if (sconf_yaml_node_add(state, SCONF_TYPE_DICT, event,
-                                            err) != 0) {
-                        return 0;
-                    }
-                    state->state = SCONF_YAML_STATE_BLOCK;
-                    break;
-
-                case YAML_MAPPING_START_EVENT:
-                    if (sconf_yaml_parent_add(state, SCONF_TYPE_DICT,
-                                              err) != 0) {
-                        return 0;
-                    }
-                    state->state = SCONF_YAML_STATE_BLOCK;
-                    break;
-
-                case YAML_SEQUENCE_START_EVENT:
-                    if (sconf_yaml_parent_add(state, SCONF_TYPE_ARRAY,
-                                              err) != 0) {
-                        return 0;
-                    }
-                    state->state = SCONF_YAML_STATE_SEQUENCE;
-                    break;
-
-                default:
-                    sconf_err_set(err, "Unexpected event %d in state %d",
-                                  event->type, state->state);
-                    return 0;
-            }
-            break;
+    int r = sconf_yaml_parse_libyaml(root, stream, &parser, err);
 
-        case SCONF_YAML_STATE_SEQUENCE:
-            switch (event->type)
-            {
-                case YAML_SCALAR_EVENT:
-                    if (sconf_yaml_node_add(state, SCONF_TYPE_ARRAY, event,
-                                            err) != 0) {
-                        return 0;
-                    }
-                    break;
-
-                case YAML_MAPPING_START_EVENT:
-                    if (sconf_yaml_parent_add(state, SCONF_TYPE_DICT,
-                                              err) != 0) {
-                        return 0;
-                    }
-                    state->state = SCONF_YAML_STATE_BLOCK;
-                    break;
-
-                case YAML_SEQUENCE_START_EVENT:
-                    if (sconf_yaml_parent_add(state, SCONF_TYPE_ARRAY,
-                                              err) != 0) {
-                        return 0;
-                    }
-                    state->state = SCONF_YAML_STATE_SEQUENCE;
-                    break;
-
-                case YAML_SEQUENCE_END_EVENT:
-                    if (sconf_yaml_parent_remove(state, SCONF_TYPE_ARRAY,
-                                                 err) != 0) {
-                        return 0;
-                    }
-                    state->state = SCONF_YAML_STATE_BLOCK;
-                    break;
-
-                default:
-                    sconf_err_set(err, "Unexpected event %d in state %d",
-                                  event->type, state->state);
-                    return 0;
-            }
-            break;
+    yaml_parser_delete(&parser);
+
+    return r;
+}
+
+/**
+ * @brief Read config from YAML in memory buffer.
+ *
+ * @param root  The config root node.
+ * @param data  The YAML document(s), not necessarily null terminated.
+ * @param len   Length of data.
+ * @param flags Selects the parser (e.g SCONF_YAML_NATIVE).
+ * @param err   Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sconf_yaml_read_buffer_flags(struct SConfNode *root, const char *data,
+                                 size_t len, int flags, struct SConfErr *err)
+{
+    if (!root) {
+        sconf_err_set(err, "root config node is NULL");
+        return -1;
     }
 
-    return 1;
+    return sconf_yaml_read_data(root, NULL, data, len, flags, err);
 }
 
 /**
- * @brief Read config from YAML file.
+ * @brief Read config from YAML in memory buffer, with the parser selected
+ * at build time.
  *
- * @param root     The config root node.
- * @param filename Path to YAML file to read.
+ * @param root The config root node.
+ * @param data The YAML document(s), not necessarily null terminated.
+ * @param len  Length of data.
+ * @param err  Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sconf_yaml_read_buffer(struct SConfNode *root, const char *data,
+                           size_t len, struct SConfErr *err)
+{
+    return sconf_yaml_read_buffer_flags(root, data, len, SCONF_YAML_DEFAULT,
+                                        err);
+}
+
+/**
+ * @internal
+ * @brief Read config from YAML file through stdio, used for files that can
+ * not be mapped (e.g pipes).
+ *
+ * @param root     The config root node, NULL if stream is set.
+ * @param stream   The documents to hand out one by one, or NULL.
+ * @param fd       File descriptor of the open file, closed when done.
+ * @param filename Path to YAML file, used in error messages.
  * @param err      Pointer to error struct.
  *
  * @return 0 on success, -1 otherwise.
  */
-int sconf_yaml_read(struct SConfNode *root, const char *filename,
-                    struct SConfErr *err)
+static int sconf_yaml_read_stdio(struct SConfNode *root,
+                                 struct SConfYAMLStream *stream, int fd,
+                                 const char *filename, struct SConfErr *err)
 {
-    FILE *fp = fopen(filename, "r");
+    FILE *fp = fdopen(fd, "r");
     if (!fp) {
         sconf_err_set(err, "could not open file '%s': %s", filename,
                       strerror(errno));
+        close(fd);
         return -1;
     }
 
-    struct SConfYAMLState state = {0};
-    state.state = SCONF_YAML_STATE_START;
-
     int return_code = 0;
 
     yaml_parser_t parser;
     if (!yaml_parser_initialize(&parser)) {
         sconf_err_set(err, "failed to initialize YAML parser");
         return_code = -1;
-        goto end;
+    }
+    else {
+        yaml_parser_set_input_file(&parser, fp);
+        return_code = sconf_yaml_parse_libyaml(root, stream, &parser, err);
+        yaml_parser_delete(&parser);
     }
 
-    yaml_parser_set_input_file(&parser, fp);
+    if (fclose(fp) == EOF) {
+        sconf_err_set(err, "error closing file '%s': %s\n", filename,
+                      strerror(errno));
+        return_code = -1;
+    }
 
-    do {
-        yaml_event_t event;
+    return return_code;
+}
 
-        uint8_t success = yaml_parser_parse(&parser, &event);
-        if (!success) {
-            sconf_err_set(err, "error parsing YAML");
-            return_code = -1;
-            goto end;
-        }
+/**
+ * @internal
+ * @brief Read config from YAML file, into root or document by document into
+ * stream.
+ *
+ * Regular files are mapped into memory and parsed in place, other files
+ * (e.g pipes) are read through stdio with libyaml.
+ *
+ * @param root     The config root node, NULL if stream is set.
+ * @param stream   The documents to hand out one by one, or NULL.
+ * @param filename Path to YAML file to read.
+ * @param flags    Selects the parser (e.g SCONF_YAML_NATIVE).
+ * @param err      Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int sconf_yaml_read_file(struct SConfNode *root,
+                                struct SConfYAMLStream *stream,
+                                const char *filename, int flags,
+                                struct SConfErr *err)
+{
+    if (sconf_yaml_flags_check(flags, err) == -1) {
+        return -1;
+    }
 
-        success = sconf_yaml_consume_event(root, &event, &state, err);
-        yaml_event_delete(&event);
-        if (!success) {
-            return_code = -1;
-            goto end;
-        }
+    int fd = open(filename, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        sconf_err_set(err, "could not open file '%s': %s", filename,
+                      strerror(errno));
+        return -1;
+    }
 
-    } while (state.state != SCONF_YAML_STATE_STOP);
+    struct stat st;
+    if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode) ||
+            (uint64_t)st.st_size > SIZE_MAX) {
+        return sconf_yaml_read_stdio(root, stream, fd, filename, err);
+    }
 
-end:
-    sconf_yaml_state_destroy(&state);
-    yaml_parser_delete(&parser);
+    size_t len = (size_t)st.st_size;
+    if (len == 0) {
+        close(fd);
+        return sconf_yaml_read_data(root, stream, NULL, 0, flags, err);
+    }
 
-    if (fclose(fp) == EOF) {
-        sconf_err_set(err, "error closing file '%s': %s\n", filename,
-                      strerror(errno));
-        return_code = -1;
+    void *data = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        return sconf_yaml_read_stdio(root, stream, fd, filename, err);
     }
 
-    return return_code;
+    /* The mapping keeps the file open */
+    close(fd);
+
+    madvise(data, len, MADV_SEQUENTIAL);
+
+    int r = sconf_yaml_read_data(root, stream, data, len, flags, err);
+
+    munmap(data, len);
+
+    return r;
+}
+
+/**
+ * @brief Read config from YAML file.
+ *
+ * @param root     The config root node.
+ * @param filename Path to YAML file to read.
+ * @param flags    Selects the parser (e.g SCONF_YAML_NATIVE).
+ * @param err      Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sconf_yaml_read_flags(struct SConfNode *root, const char *filename,
+                          int flags, struct SConfErr *err)
+{
+    if (!root) {
+        sconf_err_set(err, "root config node is NULL");
+        return -1;
+    }
+
+    return sconf_yaml_read_file(root, NULL, filename, flags, err);
+}
+
+/**
+ * @brief Read config from YAML file, with the parser selected at build
+ * time.
+ *
+ * @param root     The config root node.
+ * @param filename Path to YAML file to read.
+ * @param err      Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sconf_yaml_read(struct SConfNode *root, const char *filename,
+                    struct SConfErr *err)
+{
+    return sconf_yaml_read_flags(root, filename, SCONF_YAML_DEFAULT, err);
 }
 
+/**
+ * @brief Read YAML file document by document, each into a root of its own
+ * that is handed to a callback.
+ *
+ * @param filename Path to YAML file to read.
+ * @param cb       Callback function, called with the root of each document.
+ * @param user     User-supplied data passed to callback function.
+ * @param err      Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sconf_yaml_read_stream(const char *filename,
+                           int (*cb)(struct SConfNode *root, void *user,
+                                     struct SConfErr *err),
+                           void *user, struct SConfErr *err)
+{
+    if (!cb) {
+        sconf_err_set(err, "callback function must be specified");
+        return -1;
+    }
+
+    struct SConfYAMLStream stream = {
+        .cb = cb,
+        .user = user,
+    };
+
+    int r = sconf_yaml_read_file(NULL, &stream, filename, SCONF_YAML_DEFAULT,
+                                 err);
+
+    sconf_node_destroy(stream.root);
+
+    return r;
+}
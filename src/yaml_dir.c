@@ -0,0 +1,379 @@
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "sconf_private.h"
+
+/* Number of files the list of files in a directory starts with */
+#define SCONF_YAML_DIR_MIN_FILES 16
+
+/* YAML file in a directory, and the tree it is read into */
+struct SConfYAMLDirFile {
+    char *path;
+    struct SConfNode *root;
+    struct SConfErr err;
+    int r;
+};
+
+/* Files shared by the worker threads, each takes the next file not yet
+   taken until all are read */
+struct SConfYAMLDirJobs {
+    struct SConfYAMLDirFile *files;
+    size_t count;
+    size_t next;
+};
+
+/**
+ * @internal
+ * @brief Compare files by path, for sorting with qsort.
+ */
+static int sconf_yaml_dir_cmp(const void *a, const void *b)
+{
+    const struct SConfYAMLDirFile *fa = a;
+    const struct SConfYAMLDirFile *fb = b;
+
+    return strcmp(fa->path, fb->path);
+}
+
+/**
+ * @internal
+ * @brief Free list of files and the trees they were read into.
+ *
+ * @param files The files.
+ * @param count Number of files.
+ */
+static void sconf_yaml_dir_free(struct SConfYAMLDirFile *files, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        free(files[i].path);
+        sconf_node_destroy(files[i].root);
+    }
+
+    free(files);
+}
+
+/**
+ * @internal
+ * @brief Check if directory entry is a file matching pattern.
+ *
+ * Hidden files (e.g editor swap files) only match patterns starting with
+ * '.', and directories never match.
+ *
+ * @param fd      File descriptor of the directory.
+ * @param entry   The directory entry.
+ * @param pattern Shell wildcard pattern (e.g "*.yaml").
+ *
+ * @return true if the entry should be read, false otherwise.
+ */
+static bool sconf_yaml_dir_match(int fd, const struct dirent *entry,
+                                 const char *pattern)
+{
+    if (fnmatch(pattern, entry->d_name, FNM_PERIOD) != 0) {
+        return false;
+    }
+
+    if (entry->d_type != DT_UNKNOWN && entry->d_type != DT_LNK) {
+        return entry->d_type != DT_DIR;
+    }
+
+    /* Follows symbolic links, as opening the file does */
+    struct stat st;
+    return fstatat(fd, entry->d_name, &st, 0) == 0 && !S_ISDIR(st.st_mode);
+}
+
+/**
+ * @internal
+ * @brief List files in directory matching pattern, sorted by name.
+ *
+ * @param dir     Path to directory.
+ * @param pattern Shell wildcard pattern (e.g "*.yaml").
+ * @param files   Pointer to store the files in, freed by the caller.
+ * @param count   Pointer to store the number of files in.
+ * @param err     Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int sconf_yaml_dir_list(const char *dir, const char *pattern,
+                               struct SConfYAMLDirFile **files, size_t *count,
+                               struct SConfErr *err)
+{
+    *files = NULL;
+    *count = 0;
+
+    DIR *d = opendir(dir);
+    if (!d) {
+        sconf_err_set(err, "could not open directory '%s': %s", dir,
+                      strerror(errno));
+        return -1;
+    }
+
+    size_t size = 0;
+    int r = 0;
+
+    for (;;)
+    {
+        errno = 0;
+        struct dirent *entry = readdir(d);
+        if (!entry) {
+            if (errno != 0) {
+                sconf_err_set(err, "could not read directory '%s': %s", dir,
+                              strerror(errno));
+                r = -1;
+            }
+            break;
+        }
+
+        if (!sconf_yaml_dir_match(dirfd(d), entry, pattern)) {
+            continue;
+        }
+
+        if (*count == size) {
+            size = size ? size * 2 : SCONF_YAML_DIR_MIN_FILES;
+            struct SConfYAMLDirFile *new = realloc(*files, size *
+                                                   sizeof(**files));
+            if (!new) {
+                sconf_err_set(err, "failed to allocate memory for files in "
+                              "directory");
+                r = -1;
+                break;
+            }
+            *files = new;
+        }
+
+        size_t len = strlen(dir) + 1 + strlen(entry->d_name) + 1;
+        char *path = malloc(len);
+        if (!path) {
+            sconf_err_set(err, "failed to allocate memory for file path");
+            r = -1;
+            break;
+        }
+        snprintf(path, len, "%s/%s", dir, entry->d_name);
+
+        (*files)[(*count)++] = (struct SConfYAMLDirFile) {
+            .path = path,
+        };
+    }
+
+    closedir(d);
+
+    if (r == -1) {
+        sconf_yaml_dir_free(*files, *count);
+        *files = NULL;
+        *count = 0;
+        return -1;
+    }
+
+    /* Byte order, the same in every locale */
+    if (*count > 1) {
+        qsort(*files, *count, sizeof(**files), &sconf_yaml_dir_cmp);
+    }
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Read file into a tree of its own.
+ *
+ * @param file  The file.
+ * @param arena Arena to allocate the tree from, or NULL to use the heap.
+ */
+static void sconf_yaml_dir_read_file(struct SConfYAMLDirFile *file,
+                                     struct SConfArena *arena)
+{
+    file->root = sconf_node_create_in(arena, SCONF_TYPE_DICT, NULL,
+                                      &file->err);
+    file->r = file->root ?
+              sconf_yaml_read(file->root, file->path, &file->err) : -1;
+}
+
+/**
+ * @internal
+ * @brief Worker thread, reads files into trees of their own until no file
+ * is left.
+ *
+ * @param arg The files to read (struct SConfYAMLDirJobs).
+ *
+ * @return NULL.
+ */
+static void *sconf_yaml_dir_worker(void *arg)
+{
+    struct SConfYAMLDirJobs *jobs = arg;
+
+    for (;;)
+    {
+        size_t i = __atomic_fetch_add(&jobs->next, 1, __ATOMIC_RELAXED);
+        if (i >= jobs->count) {
+            return NULL;
+        }
+
+        sconf_yaml_dir_read_file(&jobs->files[i], NULL);
+    }
+}
+
+/**
+ * @internal
+ * @brief Get number of threads to read files with.
+ *
+ * @param nthreads Number of threads asked for, 0 for one per CPU.
+ * @param count    Number of files.
+ *
+ * @return number of threads, including the calling thread.
+ */
+static size_t sconf_yaml_dir_threads(int nthreads, size_t count)
+{
+    long n = nthreads;
+    if (n == 0) {
+        n = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+
+    if (n < 1) {
+        n = 1;
+    }
+
+    return (size_t)n < count ? (size_t)n : count;
+}
+
+/**
+ * @internal
+ * @brief Read files in parallel, each into a tree of its own.
+ *
+ * The calling thread reads files as well. If threads can not be started,
+ * the files are read by the threads that are running.
+ *
+ * @param files    The files.
+ * @param count    Number of files.
+ * @param nthreads Number of threads to use, including the calling thread.
+ */
+static void sconf_yaml_dir_read(struct SConfYAMLDirFile *files, size_t count,
+                                size_t nthreads)
+{
+    struct SConfYAMLDirJobs jobs = {
+        .files = files,
+        .count = count,
+    };
+
+    pthread_t *threads = calloc(nthreads - 1, sizeof(pthread_t));
+    size_t started = 0;
+
+    while (threads && started < nthreads - 1)
+    {
+        if (pthread_create(&threads[started], NULL, &sconf_yaml_dir_worker,
+                           &jobs) != 0) {
+            break;
+        }
+        started++;
+    }
+
+    sconf_yaml_dir_worker(&jobs);
+
+    for (size_t i = 0; i < started; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+
+    free(threads);
+}
+
+/**
+ * @brief Read config from YAML files in directory (e.g conf.d fragments).
+ *
+ * @param root     The config root node.
+ * @param dir      Path to directory.
+ * @param pattern  Shell wildcard pattern files must match (e.g "*.yaml"),
+ *                 NULL for all files.
+ * @param nthreads Number of threads to read files with, 0 for one per CPU.
+ * @param err      Pointer to error struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int sconf_yaml_read_dir(struct SConfNode *root, const char *dir,
+                        const char *pattern, int nthreads,
+                        struct SConfErr *err)
+{
+    if (!root) {
+        sconf_err_set(err, "root config node is NULL");
+        return -1;
+    }
+
+    if (!dir) {
+        sconf_err_set(err, "no directory was specified");
+        return -1;
+    }
+
+    if (nthreads < 0) {
+        sconf_err_set(err, "invalid number of threads %d", nthreads);
+        return -1;
+    }
+
+    struct SConfYAMLDirFile *files;
+    size_t count;
+    if (sconf_yaml_dir_list(dir, pattern ? pattern : "*", &files, &count,
+                            err) == -1) {
+        return -1;
+    }
+
+    int r = 0;
+    size_t threads = sconf_yaml_dir_threads(nthreads, count);
+
+    /* Overlays can not be merged into, so files are read into them one by
+       one whatever the number of threads */
+    if (root->flags & SCONF_NODE_FLAG_OVERLAY) {
+        for (size_t i = 0; i < count && r == 0; i++)
+        {
+            r = sconf_yaml_read(root, files[i].path, err);
+        }
+
+        sconf_yaml_dir_free(files, count);
+
+        return r;
+    }
+
+    /* Trees from the heap can only be merged into a root on the heap, so
+       files for other roots (e.g arena-backed) are read on the calling
+       thread, each just before it is merged. They are still read into a
+       tree of their own, so a file that fails leaves root as it was. */
+    bool serial = threads <= 1 || root->arena;
+    if (!serial) {
+        sconf_yaml_dir_read(files, count, threads);
+    }
+
+    /* In order, so later files override earlier ones as when read one by
+       one, stopping at the first file that could not be read */
+    for (size_t i = 0; i < count; i++)
+    {
+        if (serial) {
+            sconf_yaml_dir_read_file(&files[i], root->arena);
+        }
+
+        if (files[i].r == -1) {
+            if (err) {
+                *err = files[i].err;
+            }
+            r = -1;
+            break;
+        }
+
+        r = sconf_merge(root, files[i].root, SCONF_MERGE_ERROR, err);
+        if (r == -1) {
+            break;
+        }
+
+        /* Nodes not moved into root are no longer needed */
+        sconf_node_destroy(files[i].root);
+        files[i].root = NULL;
+    }
+
+    sconf_yaml_dir_free(files, count);
+
+    return r;
+}
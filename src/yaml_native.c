@@ -0,0 +1,902 @@
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "yaml_native.h"
+
+/* Characters that can not start a plain scalar ('-' is handled separately,
+   it starts a plain scalar unless followed by a blank) */
+#define SCONF_YAML_NATIVE_INDICATORS "?:,[]{}#&*!|>'\"%@`"
+
+/**
+ * @internal
+ * @brief Check that input only contains printable ASCII characters and line
+ * feeds.
+ *
+ * Tabs, carriage returns, control characters and non-ASCII characters (e.g a
+ * byte order mark) are left to libyaml.
+ *
+ * @param p   Start of input.
+ * @param end End of input.
+ *
+ * @return true if input is plain ASCII, false otherwise.
+ */
+static bool sconf_yaml_native_is_plain(const char *p, const char *end)
+{
+#if defined(__SSE2__)
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i del = _mm_set1_epi8(0x7f);
+
+    while (end - p >= 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        /* Signed compare, bytes >= 0x80 are less than space as well */
+        __m128i bad = _mm_andnot_si128(_mm_cmpeq_epi8(v, newline),
+                                       _mm_cmplt_epi8(v, space));
+        bad = _mm_or_si128(bad, _mm_cmpeq_epi8(v, del));
+        if (_mm_movemask_epi8(bad)) {
+            return false;
+        }
+        p += 16;
+    }
+#endif
+
+    for (; p < end; p++)
+    {
+        unsigned char c = (unsigned char)*p;
+        if ((c < ' ' && c != '\n') || c >= 0x7f) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @internal
+ * @brief Find next character that can end a plain scalar in block context.
+ *
+ * @param p   Start of scan.
+ * @param end End of input.
+ *
+ * @return pointer to first ':', '#' or line feed, or end if there is none.
+ */
+static const char *sconf_yaml_native_scan(const char *p, const char *end)
+{
+#if defined(__SSE2__)
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i colon = _mm_set1_epi8(':');
+    const __m128i hash = _mm_set1_epi8('#');
+
+    while (end - p >= 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        __m128i m = _mm_or_si128(_mm_cmpeq_epi8(v, newline),
+                                 _mm_cmpeq_epi8(v, colon));
+        m = _mm_or_si128(m, _mm_cmpeq_epi8(v, hash));
+        int mask = _mm_movemask_epi8(m);
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+#endif
+
+    while (p < end && *p != '\n' && *p != ':' && *p != '#')
+    {
+        p++;
+    }
+
+    return p;
+}
+
+/**
+ * @internal
+ * @brief Check if position is at a space, line feed or end of input.
+ */
+static inline bool sconf_yaml_native_blank(const char *p, const char *end)
+{
+    return p == end || *p == ' ' || *p == '\n';
+}
+
+/**
+ * @internal
+ * @brief Skip spaces.
+ */
+static inline const char *sconf_yaml_native_skip(const char *p,
+                                                 const char *end)
+{
+    while (p < end && *p == ' ')
+    {
+        p++;
+    }
+
+    return p;
+}
+
+/**
+ * @internal
+ * @brief Queue event.
+ *
+ * @param native The native parser.
+ * @param type   The event type.
+ * @param style  Style of scalar.
+ * @param value  Value of scalar (not null terminated).
+ * @param length Length of value.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int sconf_yaml_native_emit(struct SConfYAMLNative *native,
+                                  yaml_event_type_t type,
+                                  yaml_scalar_style_t style,
+                                  const char *value, size_t length)
+{
+    if (native->count == native->size) {
+        size_t size = native->size ? native->size * 2 : 16;
+        struct SConfYAMLToken *tokens = realloc(native->tokens,
+                                                size * sizeof(*tokens));
+        if (!tokens) {
+            return -1;
+        }
+        native->tokens = tokens;
+        native->size = size;
+    }
+
+    native->tokens[native->count++] = (struct SConfYAMLToken) {
+        .type = type,
+        .style = style,
+        .value = value,
+        .length = length,
+    };
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Queue empty plain scalar, the value of a key or sequence entry
+ * without one.
+ */
+static int sconf_yaml_native_emit_empty(struct SConfYAMLNative *native)
+{
+    native->pending = false;
+
+    return sconf_yaml_native_emit(native, YAML_SCALAR_EVENT,
+                                  YAML_PLAIN_SCALAR_STYLE, "", 0);
+}
+
+/**
+ * @internal
+ * @brief Open block mapping or sequence.
+ *
+ * @param native The native parser.
+ * @param type   YAML_MAPPING_START_EVENT or YAML_SEQUENCE_START_EVENT.
+ * @param indent Column the entries of the block start at.
+ *
+ * @return 0 on success, SCONF_YAML_NATIVE_UNSUPPORTED if nested too deep,
+ * -1 otherwise.
+ */
+static int sconf_yaml_native_open(struct SConfYAMLNative *native,
+                                  yaml_event_type_t type, size_t indent)
+{
+    if (native->depth == SCONF_MAX_DEPTH) {
+        return SCONF_YAML_NATIVE_UNSUPPORTED;
+    }
+
+    native->blocks[native->depth++] = (struct SConfYAMLBlock) {
+        .type = type,
+        .indent = indent,
+    };
+
+    return sconf_yaml_native_emit(native, type, YAML_ANY_SCALAR_STYLE, NULL,
+                                  0);
+}
+
+/**
+ * @internal
+ * @brief Close innermost block mapping or sequence.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int sconf_yaml_native_close(struct SConfYAMLNative *native)
+{
+    yaml_event_type_t type = native->blocks[--native->depth].type;
+
+    return sconf_yaml_native_emit(native,
+                                  type == YAML_MAPPING_START_EVENT ?
+                                  YAML_MAPPING_END_EVENT :
+                                  YAML_SEQUENCE_END_EVENT,
+                                  YAML_ANY_SCALAR_STYLE, NULL, 0);
+}
+
+/**
+ * @internal
+ * @brief Finish line after the last token on it.
+ *
+ * Only spaces and a comment may follow, the next line is read after it.
+ *
+ * @param native The native parser.
+ * @param p      Position after the last token.
+ *
+ * @return 0 on success, SCONF_YAML_NATIVE_UNSUPPORTED if anything else
+ * follows.
+ */
+static int sconf_yaml_native_line_end(struct SConfYAMLNative *native,
+                                      const char *p)
+{
+    const char *end = native->end;
+
+    p = sconf_yaml_native_skip(p, end);
+
+    /* Comments must be separated from tokens by a space */
+    if (p < end && *p == '#' && p[-1] == ' ') {
+        p = memchr(p, '\n', end - p);
+        if (!p) {
+            p = end;
+        }
+    }
+
+    if (p < end && *p != '\n') {
+        return SCONF_YAML_NATIVE_UNSUPPORTED;
+    }
+
+    native->pos = p < end ? p + 1 : end;
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Read single or double quoted scalar without escapes.
+ *
+ * @param p     Position of the opening quote.
+ * @param end   End of input.
+ * @param token The scalar event.
+ * @param next  Position after the closing quote.
+ *
+ * @return 0 on success, SCONF_YAML_NATIVE_UNSUPPORTED if the scalar has
+ * escapes or spans several lines.
+ */
+static int sconf_yaml_native_quoted(const char *p, const char *end,
+                                    struct SConfYAMLToken *token,
+                                    const char **next)
+{
+    char quote = *p;
+    const char *value = p + 1;
+
+    const char *close = memchr(value, quote, end - value);
+    if (!close || memchr(value, '\n', close - value)) {
+        return SCONF_YAML_NATIVE_UNSUPPORTED;
+    }
+
+    if (quote == '"' ? memchr(value, '\\', close - value) != NULL :
+            (close + 1 < end && close[1] == '\'')) {
+        return SCONF_YAML_NATIVE_UNSUPPORTED;
+    }
+
+    *token = (struct SConfYAMLToken) {
+        .type = YAML_SCALAR_EVENT,
+        .style = quote == '"' ? YAML_DOUBLE_QUOTED_SCALAR_STYLE :
+                                YAML_SINGLE_QUOTED_SCALAR_STYLE,
+        .value = value,
+        .length = close - value,
+    };
+    *next = close + 1;
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Check if a plain scalar can start at position.
+ */
+static bool sconf_yaml_native_plain_start(const char *p, const char *end)
+{
+    if (*p == '-') {
+        return !sconf_yaml_native_blank(p + 1, end);
+    }
+
+    return !strchr(SCONF_YAML_NATIVE_INDICATORS, *p);
+}
+
+/**
+ * @internal
+ * @brief Read scalar in block context, which is a key if followed by ':'.
+ *
+ * @param p     Start of scalar (not a blank).
+ * @param end   End of input.
+ * @param token The scalar event.
+ * @param key   Set to true if the scalar is a key.
+ * @param next  Position after the scalar, or after ':' if it is a key.
+ *
+ * @return 0 on success, SCONF_YAML_NATIVE_UNSUPPORTED if outside of the
+ * subset.
+ */
+static int sconf_yaml_native_scalar(const char *p, const char *end,
+                                    struct SConfYAMLToken *token, bool *key,
+                                    const char **next)
+{
+    const char *q = NULL;
+
+    *key = false;
+
+    if (*p == '"' || *p == '\'') {
+        if (sconf_yaml_native_quoted(p, end, token, &q)) {
+            return SCONF_YAML_NATIVE_UNSUPPORTED;
+        }
+
+        const char *s = sconf_yaml_native_skip(q, end);
+        if (s < end && *s == ':' && sconf_yaml_native_blank(s + 1, end)) {
+            *key = true;
+            q = s + 1;
+        }
+        *next = q;
+        return 0;
+    }
+
+    if (!sconf_yaml_native_plain_start(p, end)) {
+        return SCONF_YAML_NATIVE_UNSUPPORTED;
+    }
+
+    /* Ends at a line feed, a comment or a ':' followed by a blank */
+    for (q = p;; q++)
+    {
+        q = sconf_yaml_native_scan(q, end);
+        if (q == end || *q == '\n') {
+            break;
+        }
+        if (*q == ':' && sconf_yaml_native_blank(q + 1, end)) {
+            *key = true;
+            break;
+        }
+        if (*q == '#' && q[-1] == ' ') {
+            break;
+        }
+    }
+
+    const char *s = q;
+    while (s > p && s[-1] == ' ')
+    {
+        s--;
+    }
+
+    *token = (struct SConfYAMLToken) {
+        .type = YAML_SCALAR_EVENT,
+        .style = YAML_PLAIN_SCALAR_STYLE,
+        .value = p,
+        .length = s - p,
+    };
+    *next = *key ? q + 1 : q;
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Read flow sequence of scalars on a single line.
+ *
+ * @param native The native parser.
+ * @param p      Position of '['.
+ *
+ * @return 0 on success, SCONF_YAML_NATIVE_UNSUPPORTED if outside of the
+ * subset, -1 otherwise.
+ */
+static int sconf_yaml_native_flow(struct SConfYAMLNative *native,
+                                  const char *p)
+{
+    const char *end = native->end;
+
+    if (sconf_yaml_native_emit(native, YAML_SEQUENCE_START_EVENT,
+                               YAML_ANY_SCALAR_STYLE, NULL, 0) == -1) {
+        return -1;
+    }
+
+    p = sconf_yaml_native_skip(p + 1, end);
+
+    while (p == end || *p != ']')
+    {
+        if (p == end || *p == '\n') {
+            return SCONF_YAML_NATIVE_UNSUPPORTED;
+        }
+
+        struct SConfYAMLToken token;
+
+        if (*p == '"' || *p == '\'') {
+            if (sconf_yaml_native_quoted(p, end, &token, &p)) {
+                return SCONF_YAML_NATIVE_UNSUPPORTED;
+            }
+        }
+        else {
+            if (!sconf_yaml_native_plain_start(p, end)) {
+                return SCONF_YAML_NATIVE_UNSUPPORTED;
+            }
+
+            const char *value = p;
+            for (; p < end && *p != ',' && *p != ']' && *p != '\n'; p++)
+            {
+                switch (*p)
+                {
+                    case ':':
+                    case '#':
+                    case '[':
+                    case '{':
+                    case '}':
+                        return SCONF_YAML_NATIVE_UNSUPPORTED;
+                }
+            }
+
+            const char *s = p;
+            while (s[-1] == ' ')
+            {
+                s--;
+            }
+
+            token = (struct SConfYAMLToken) {
+                .type = YAML_SCALAR_EVENT,
+                .style = YAML_PLAIN_SCALAR_STYLE,
+                .value = value,
+                .length = s - value,
+            };
+        }
+
+        if (sconf_yaml_native_emit(native, token.type, token.style,
+                                   token.value, token.length) == -1) {
+            return -1;
+        }
+
+        p = sconf_yaml_native_skip(p, end);
+        if (p < end && *p == ',') {
+            p = sconf_yaml_native_skip(p + 1, end);
+            if (p < end && *p == ']') {
+                /* Trailing comma */
+                return SCONF_YAML_NATIVE_UNSUPPORTED;
+            }
+        }
+        else if (p == end || *p != ']') {
+            return SCONF_YAML_NATIVE_UNSUPPORTED;
+        }
+    }
+
+    if (sconf_yaml_native_emit(native, YAML_SEQUENCE_END_EVENT,
+                               YAML_ANY_SCALAR_STYLE, NULL, 0) == -1) {
+        return -1;
+    }
+
+    return sconf_yaml_native_line_end(native, p + 1);
+}
+
+/**
+ * @internal
+ * @brief Read value after a key or sequence entry indicator.
+ *
+ * Without a value on the line, the value is the block on the following
+ * lines, or an empty scalar.
+ *
+ * @param native The native parser.
+ * @param p      Position after ':' or '-'.
+ *
+ * @return 0 on success, SCONF_YAML_NATIVE_UNSUPPORTED if outside of the
+ * subset, -1 otherwise.
+ */
+static int sconf_yaml_native_value(struct SConfYAMLNative *native,
+                                   const char *p)
+{
+    const char *end = native->end;
+
+    p = sconf_yaml_native_skip(p, end);
+
+    if (p == end || *p == '\n' || *p == '#') {
+        native->pending = true;
+        return sconf_yaml_native_line_end(native, p);
+    }
+
+    if (*p == '[') {
+        return sconf_yaml_native_flow(native, p);
+    }
+
+    struct SConfYAMLToken token;
+    const char *next = NULL;
+    bool key = false;
+
+    if (sconf_yaml_native_scalar(p, end, &token, &key, &next) || key) {
+        return SCONF_YAML_NATIVE_UNSUPPORTED;
+    }
+
+    if (sconf_yaml_native_emit(native, token.type, token.style, token.value,
+                               token.length) == -1) {
+        return -1;
+    }
+
+    return sconf_yaml_native_line_end(native, next);
+}
+
+/**
+ * @internal
+ * @brief Read key and value of mapping entry.
+ *
+ * @param native The native parser.
+ * @param key    The key.
+ * @param p      Position after ':'.
+ *
+ * @return 0 on success, SCONF_YAML_NATIVE_UNSUPPORTED if outside of the
+ * subset, -1 otherwise.
+ */
+static int sconf_yaml_native_mapping_entry(struct SConfYAMLNative *native,
+                                           const struct SConfYAMLToken *key,
+                                           const char *p)
+{
+    if (sconf_yaml_native_emit(native, key->type, key->style, key->value,
+                               key->length) == -1) {
+        return -1;
+    }
+
+    return sconf_yaml_native_value(native, p);
+}
+
+/**
+ * @internal
+ * @brief Read sequence entry, which may start a compact mapping
+ * ("- key: value").
+ *
+ * @param native The native parser.
+ * @param line   Start of line.
+ * @param p      Position after '-'.
+ *
+ * @return 0 on success, SCONF_YAML_NATIVE_UNSUPPORTED if outside of the
+ * subset, -1 otherwise.
+ */
+static int sconf_yaml_native_sequence_entry(struct SConfYAMLNative *native,
+                                            const char *line, const char *p)
+{
+    const char *end = native->end;
+
+    p = sconf_yaml_native_skip(p, end);
+
+    if (p == end || *p == '\n' || *p == '#' || *p == '[') {
+        return sconf_yaml_native_value(native, p);
+    }
+
+    struct SConfYAMLToken token;
+    const char *next = NULL;
+    bool key = false;
+
+    if (sconf_yaml_native_scalar(p, end, &token, &key, &next)) {
+        return SCONF_YAML_NATIVE_UNSUPPORTED;
+    }
+
+    if (!key) {
+        if (sconf_yaml_native_emit(native, token.type, token.style,
+                                   token.value, token.length) == -1) {
+            return -1;
+        }
+        return sconf_yaml_native_line_end(native, next);
+    }
+
+    /* Keys of the compact mapping start at the column of the first key */
+    int r = sconf_yaml_native_open(native, YAML_MAPPING_START_EVENT,
+                                   p - line);
+    if (r != 0) {
+        return r;
+    }
+
+    return sconf_yaml_native_mapping_entry(native, &token, next);
+}
+
+/**
+ * @internal
+ * @brief Close blocks that end before a line with a key or sequence entry,
+ * and open the block the entry belongs to if it starts one.
+ *
+ * @param native   The native parser.
+ * @param indent   Column of the entry.
+ * @param sequence true for a sequence entry, false for a key.
+ *
+ * @return 0 on success, SCONF_YAML_NATIVE_UNSUPPORTED if the entry does not
+ * fit the open blocks, -1 otherwise.
+ */
+static int sconf_yaml_native_enter(struct SConfYAMLNative *native,
+                                   size_t indent, bool sequence)
+{
+    yaml_event_type_t type = sequence ? YAML_SEQUENCE_START_EVENT :
+                                        YAML_MAPPING_START_EVENT;
+
+    if (!native->document) {
+        if (sconf_yaml_native_emit(native, YAML_DOCUMENT_START_EVENT,
+                                   YAML_ANY_SCALAR_STYLE, NULL, 0) == -1) {
+            return -1;
+        }
+        native->document = true;
+    }
+
+    if (native->pending) {
+        const struct SConfYAMLBlock *top = &native->blocks[native->depth - 1];
+
+        /* Value on the following lines, a sequence may also be at the
+           indentation of the key it is the value of */
+        if (indent > top->indent || (indent == top->indent && sequence &&
+                                     top->type == YAML_MAPPING_START_EVENT)) {
+            native->pending = false;
+            return sconf_yaml_native_open(native, type, indent);
+        }
+
+        if (sconf_yaml_native_emit_empty(native) == -1) {
+            return -1;
+        }
+    }
+
+    while (native->depth > 0)
+    {
+        const struct SConfYAMLBlock *top = &native->blocks[native->depth - 1];
+        if (top->indent < indent || (top->indent == indent &&
+                                     (sequence ||
+                                      top->type == YAML_MAPPING_START_EVENT))) {
+            break;
+        }
+        if (sconf_yaml_native_close(native) == -1) {
+            return -1;
+        }
+    }
+
+    if (native->depth == 0) {
+        /* The root of a document must be a mapping */
+        if (native->content || sequence) {
+            return SCONF_YAML_NATIVE_UNSUPPORTED;
+        }
+        native->content = true;
+        return sconf_yaml_native_open(native, type, indent);
+    }
+
+    const struct SConfYAMLBlock *top = &native->blocks[native->depth - 1];
+    if (top->indent != indent || top->type != type) {
+        return SCONF_YAML_NATIVE_UNSUPPORTED;
+    }
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief End current document, if any.
+ *
+ * @return 0 on success, SCONF_YAML_NATIVE_UNSUPPORTED if the document is
+ * empty, -1 otherwise.
+ */
+static int sconf_yaml_native_document_end(struct SConfYAMLNative *native)
+{
+    if (!native->document) {
+        return 0;
+    }
+
+    if (!native->content) {
+        return SCONF_YAML_NATIVE_UNSUPPORTED;
+    }
+
+    if (native->pending && sconf_yaml_native_emit_empty(native) == -1) {
+        return -1;
+    }
+
+    while (native->depth > 0)
+    {
+        if (sconf_yaml_native_close(native) == -1) {
+            return -1;
+        }
+    }
+
+    native->document = false;
+    native->content = false;
+
+    return sconf_yaml_native_emit(native, YAML_DOCUMENT_END_EVENT,
+                                  YAML_ANY_SCALAR_STYLE, NULL, 0);
+}
+
+/**
+ * @internal
+ * @brief Read next line and queue its events.
+ *
+ * @param native The native parser.
+ *
+ * @return 0 on success, SCONF_YAML_NATIVE_UNSUPPORTED if the line is
+ * outside of the subset, -1 otherwise.
+ */
+static int sconf_yaml_native_line(struct SConfYAMLNative *native)
+{
+    const char *line = native->pos;
+    const char *end = native->end;
+    const char *p = sconf_yaml_native_skip(line, end);
+
+    /* Blank line or comment */
+    if (p == end || *p == '\n' || *p == '#') {
+        p = memchr(p, '\n', end - p);
+        native->pos = p ? p + 1 : end;
+        return 0;
+    }
+
+    size_t indent = p - line;
+
+    if (indent == 0 && end - p >= 3 &&
+            sconf_yaml_native_blank(p + 3, end)) {
+        if (memcmp(p, "---", 3) == 0) {
+            int r = sconf_yaml_native_document_end(native);
+            if (r != 0) {
+                return r;
+            }
+            if (sconf_yaml_native_emit(native, YAML_DOCUMENT_START_EVENT,
+                                       YAML_ANY_SCALAR_STYLE, NULL,
+                                       0) == -1) {
+                return -1;
+            }
+            native->document = true;
+            return sconf_yaml_native_line_end(native, p + 3);
+        }
+        if (memcmp(p, "...", 3) == 0) {
+            return SCONF_YAML_NATIVE_UNSUPPORTED;
+        }
+    }
+
+    bool sequence = *p == '-' && sconf_yaml_native_blank(p + 1, end);
+
+    struct SConfYAMLToken key;
+    const char *next = NULL;
+
+    if (!sequence) {
+        /* Lines with only a scalar continue a multi-line scalar */
+        bool is_key = false;
+        if (sconf_yaml_native_scalar(p, end, &key, &is_key, &next) ||
+                !is_key) {
+            return SCONF_YAML_NATIVE_UNSUPPORTED;
+        }
+    }
+
+    int r = sconf_yaml_native_enter(native, indent, sequence);
+    if (r != 0) {
+        return r;
+    }
+
+    if (sequence) {
+        return sconf_yaml_native_sequence_entry(native, line, p + 1);
+    }
+
+    return sconf_yaml_native_mapping_entry(native, &key, next);
+}
+
+/**
+ * @brief Initialize native parser.
+ *
+ * @param native The native parser.
+ * @param data   The YAML document(s), not necessarily null terminated.
+ * @param len    Length of data.
+ */
+void sconf_yaml_native_init(struct SConfYAMLNative *native, const char *data,
+                            size_t len)
+{
+    memset(native, 0, sizeof(*native));
+
+    native->data = data ? data : "";
+    native->pos = native->data;
+    native->end = native->data + len;
+    native->plain = sconf_yaml_native_is_plain(native->pos, native->end);
+}
+
+/**
+ * @brief Free memory held by native parser.
+ *
+ * @param native The native parser.
+ */
+void sconf_yaml_native_release(struct SConfYAMLNative *native)
+{
+    free(native->tokens);
+    free(native->scratch);
+    native->tokens = NULL;
+    native->scratch = NULL;
+}
+
+/**
+ * @brief Get next event from native parser.
+ *
+ * @param native The native parser.
+ * @param token  The event.
+ *
+ * @return 0 on success, SCONF_YAML_NATIVE_UNSUPPORTED if the input is
+ * outside of the subset, -1 otherwise.
+ */
+int sconf_yaml_native_next(struct SConfYAMLNative *native,
+                           struct SConfYAMLToken *token)
+{
+    while (native->next == native->count)
+    {
+        if (!native->plain || native->done) {
+            return SCONF_YAML_NATIVE_UNSUPPORTED;
+        }
+
+        native->count = 0;
+        native->next = 0;
+
+        int r = 0;
+
+        if (!native->started) {
+            native->started = true;
+            r = sconf_yaml_native_emit(native, YAML_STREAM_START_EVENT,
+                                       YAML_ANY_SCALAR_STYLE, NULL, 0);
+        }
+        else if (native->pos == native->end) {
+            native->done = true;
+            r = sconf_yaml_native_document_end(native);
+            if (r == 0) {
+                r = sconf_yaml_native_emit(native, YAML_STREAM_END_EVENT,
+                                           YAML_ANY_SCALAR_STYLE, NULL, 0);
+            }
+        }
+        else {
+            r = sconf_yaml_native_line(native);
+        }
+
+        if (r != 0) {
+            return r;
+        }
+    }
+
+    *token = native->tokens[native->next++];
+
+    return 0;
+}
+
+/**
+ * @brief Get value of scalar event as null terminated string.
+ *
+ * @param native The native parser.
+ * @param token  The scalar event.
+ *
+ * @return the value, valid until the next call, or NULL if out of memory.
+ */
+const char *sconf_yaml_native_str(struct SConfYAMLNative *native,
+                                  const struct SConfYAMLToken *token)
+{
+    if (token->length >= native->scratch_size) {
+        size_t size = token->length + 64;
+        char *scratch = realloc(native->scratch, size);
+        if (!scratch) {
+            return NULL;
+        }
+        native->scratch = scratch;
+        native->scratch_size = size;
+    }
+
+    memcpy(native->scratch, token->value, token->length);
+    native->scratch[token->length] = '\0';
+
+    return native->scratch;
+}
+
+/**
+ * @brief Check if YAML can be read by the native parser.
+ *
+ * The whole input is checked up front, so that falling back to libyaml
+ * never leaves a partially read config behind.
+ *
+ * @param data The YAML document(s), not necessarily null terminated.
+ * @param len  Length of data.
+ *
+ * @return 0 if supported, SCONF_YAML_NATIVE_UNSUPPORTED if not, -1 on
+ * error.
+ */
+int sconf_yaml_native_check(const char *data, size_t len)
+{
+    struct SConfYAMLNative native;
+    struct SConfYAMLToken token;
+    int r;
+
+    sconf_yaml_native_init(&native, data, len);
+
+    do
+    {
+        r = sconf_yaml_native_next(&native, &token);
+    } while (r == 0 && token.type != YAML_STREAM_END_EVENT);
+
+    sconf_yaml_native_release(&native);
+
+    return r;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <yaml.h>
+
+#include "sconf.h"
+
+/* Returned by the native parser for YAML outside of the subset it reads */
+#define SCONF_YAML_NATIVE_UNSUPPORTED 1
+
+/* Event produced by the native parser, using the libyaml event types. The
+   value of a scalar is a slice of the input (not null terminated). */
+struct SConfYAMLToken {
+    yaml_event_type_t type;
+    yaml_scalar_style_t style;
+    const char *value;
+    size_t length;
+};
+
+/* Open block mapping or sequence, and the column its entries start at */
+struct SConfYAMLBlock {
+    yaml_event_type_t type;
+    size_t indent;
+};
+
+/* Line based parser for the subset of YAML that is used in config files:
+   block mappings and sequences, flow sequences of scalars, and single line
+   plain or quoted scalars without escapes. Events for a line are queued and
+   handed out one at a time. */
+struct SConfYAMLNative {
+    const char *data;
+    const char *pos;
+    const char *end;
+    struct SConfYAMLBlock blocks[SCONF_MAX_DEPTH];
+    int depth;
+    bool pending;
+    bool document;
+    bool content;
+    bool started;
+    bool done;
+    bool plain;
+    struct SConfYAMLToken *tokens;
+    size_t count;
+    size_t next;
+    size_t size;
+    char *scratch;
+    size_t scratch_size;
+};
+
+void sconf_yaml_native_init(struct SConfYAMLNative *native, const char *data,
+                            size_t len);
+void sconf_yaml_native_release(struct SConfYAMLNative *native);
+int sconf_yaml_native_next(struct SConfYAMLNative *native,
+                           struct SConfYAMLToken *token);
+const char *sconf_yaml_native_str(struct SConfYAMLNative *native,
+                                  const struct SConfYAMLToken *token);
+int sconf_yaml_native_check(const char *data, size_t len);
@@ -0,0 +1,382 @@
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <cmocka.h>
+
+#include "sconf.h"
+
+struct db {
+    const char *host;
+    uint16_t port;
+};
+
+struct config {
+    int max_conns;
+    double timeout;
+    float ratio;
+    bool verbose;
+    int8_t level;
+    struct db db;
+    int64_t weights[8];
+    size_t weights_count;
+    double point[2];
+};
+
+static const struct SConfBinding db_bindings[] = {
+    {
+        .path = "host",
+        .type = SCONF_TYPE_STR,
+        .required = true,
+        SCONF_FIELD(struct db, host),
+    },
+    {
+        .path = "port",
+        .type = SCONF_TYPE_INT,
+        .default_value = "5432",
+        .range = true, .min = 1, .max = 65535,
+        SCONF_FIELD_UNSIGNED(struct db, port),
+    },
+    {0}
+};
+
+static const struct SConfBinding bindings[] = {
+    {
+        .path = "max-conns",
+        .type = SCONF_TYPE_INT,
+        .default_value = "1024",
+        SCONF_FIELD(struct config, max_conns),
+    },
+    {
+        .path = "timeout",
+        .type = SCONF_TYPE_FLOAT,
+        .default_value = "2.5",
+        SCONF_FIELD(struct config, timeout),
+    },
+    {
+        .path = "ratio",
+        .type = SCONF_TYPE_FLOAT,
+        .range = true, .min_float = 0, .max_float = 1,
+        SCONF_FIELD(struct config, ratio),
+    },
+    {
+        .path = "log.verbose",
+        .type = SCONF_TYPE_BOOL,
+        .default_value = "true",
+        SCONF_FIELD(struct config, verbose),
+    },
+    {
+        .path = "log.level",
+        .type = SCONF_TYPE_INT,
+        SCONF_FIELD(struct config, level),
+    },
+    {
+        .path = "db",
+        .type = SCONF_TYPE_DICT,
+        .fields = db_bindings,
+        SCONF_FIELD(struct config, db),
+    },
+    {
+        .path = "weights",
+        .type = SCONF_TYPE_ARRAY,
+        .element_type = SCONF_TYPE_INT,
+        .element_size = sizeof(int64_t),
+        SCONF_FIELD(struct config, weights),
+        SCONF_COUNT(struct config, weights_count),
+    },
+    {
+        .path = "point",
+        .type = SCONF_TYPE_ARRAY,
+        .element_type = SCONF_TYPE_FLOAT,
+        .element_size = sizeof(double),
+        SCONF_FIELD(struct config, point),
+    },
+    {0}
+};
+
+static void test_sconf_bind(void **unused)
+{
+    struct SConfErr err = {0};
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    assert_int_equal(sconf_set_int(root, "max-conns", 16, &err), 0);
+    assert_int_equal(sconf_set_float(root, "ratio", 0.25, &err), 0);
+    assert_int_equal(sconf_set_int(root, "log.level", -3, &err), 0);
+    assert_int_equal(sconf_set_str(root, "db.host", "localhost", &err), 0);
+    assert_int_equal(sconf_set_int(root, "db.port", 6543, &err), 0);
+    assert_int_equal(sconf_set_int(root, "weights.[0]", 10, &err), 0);
+    assert_int_equal(sconf_set_int(root, "weights.[1]", 20, &err), 0);
+    assert_int_equal(sconf_set_int(root, "weights.[2]", 30, &err), 0);
+    assert_int_equal(sconf_set_float(root, "point.[0]", 1.5, &err), 0);
+    assert_int_equal(sconf_set_float(root, "point.[1]", -1.5, &err), 0);
+
+    struct config config = {0};
+    assert_int_equal(sconf_bind(root, bindings, &config, &err), 0);
+
+    assert_int_equal(config.max_conns, 16);
+    assert_float_equal(config.timeout, 2.5, 0);
+    assert_float_equal(config.ratio, 0.25, 0);
+    assert_true(config.verbose);
+    assert_int_equal(config.level, -3);
+    assert_string_equal(config.db.host, "localhost");
+    assert_int_equal(config.db.port, 6543);
+    assert_int_equal(config.weights_count, 3);
+    assert_int_equal(config.weights[0], 10);
+    assert_int_equal(config.weights[1], 20);
+    assert_int_equal(config.weights[2], 30);
+    assert_float_equal(config.point[0], 1.5, 0);
+    assert_float_equal(config.point[1], -1.5, 0);
+
+    /* Same values from a frozen snapshot, with packed arrays */
+    struct SConfNode *frozen = sconf_freeze(root, &err);
+    assert_non_null(frozen);
+
+    struct config snapshot = {0};
+    assert_int_equal(sconf_bind(frozen, bindings, &snapshot, &err), 0);
+    assert_string_equal(snapshot.db.host, "localhost");
+    assert_int_equal(snapshot.weights_count, 3);
+    assert_int_equal(snapshot.weights[2], 30);
+    assert_float_equal(snapshot.point[1], -1.5, 0);
+
+    sconf_node_destroy(frozen);
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_bind_defaults(void **unused)
+{
+    struct SConfErr err = {0};
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    assert_int_equal(sconf_set_str(root, "db.host", "localhost", &err), 0);
+    assert_int_equal(sconf_set_float(root, "point.[0]", 1, &err), 0);
+    assert_int_equal(sconf_set_float(root, "point.[1]", 2, &err), 0);
+
+    /* Fields without a default value are left untouched */
+    struct config config = {.ratio = 0.5, .level = 7, .weights_count = 9};
+    assert_int_equal(sconf_bind(root, bindings, &config, &err), 0);
+
+    assert_int_equal(config.max_conns, 1024);
+    assert_float_equal(config.timeout, 2.5, 0);
+    assert_float_equal(config.ratio, 0.5, 0);
+    assert_true(config.verbose);
+    assert_int_equal(config.level, 7);
+    assert_int_equal(config.db.port, 5432);
+    assert_int_equal(config.weights_count, 0);
+
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_bind_errors(void **unused)
+{
+    struct SConfErr err = {0};
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+    struct config config = {0};
+
+    /* Missing required node in nested struct */
+    assert_int_equal(sconf_bind(root, bindings, &config, &err), -1);
+    assert_string_equal(err.msg, "config node 'db.host' is required");
+
+    assert_int_equal(sconf_set_str(root, "db.host", "localhost", &err), 0);
+    assert_int_equal(sconf_set_float(root, "point.[0]", 1, &err), 0);
+    assert_int_equal(sconf_set_float(root, "point.[1]", 2, &err), 0);
+    assert_int_equal(sconf_bind(root, bindings, &config, &err), 0);
+
+    /* Out of range */
+    assert_int_equal(sconf_set_int(root, "db.port", 65536, &err), 0);
+    assert_int_equal(sconf_bind(root, bindings, &config, &err), -1);
+    assert_int_equal(sconf_set_int(root, "db.port", 80, &err), 0);
+
+    assert_int_equal(sconf_set_float(root, "ratio", 1.5, &err), 0);
+    assert_int_equal(sconf_bind(root, bindings, &config, &err), -1);
+    assert_int_equal(sconf_set_float(root, "ratio", 1, &err), 0);
+
+    /* Does not fit in field */
+    assert_int_equal(sconf_set_int(root, "log.level", 256, &err), 0);
+    assert_int_equal(sconf_bind(root, bindings, &config, &err), -1);
+    assert_int_equal(sconf_set_int(root, "log.level", 255, &err), 0);
+    assert_int_equal(sconf_bind(root, bindings, &config, &err), -1);
+    assert_int_equal(sconf_set_int(root, "log.level", -129, &err), 0);
+    assert_int_equal(sconf_bind(root, bindings, &config, &err), -1);
+    assert_int_equal(sconf_set_int(root, "log.level", -128, &err), 0);
+    assert_int_equal(sconf_bind(root, bindings, &config, &err), 0);
+    assert_int_equal(config.level, -128);
+
+    /* Fixed size array with too many elements */
+    assert_int_equal(sconf_set_float(root, "point.[2]", 3, &err), 0);
+    assert_int_equal(sconf_bind(root, bindings, &config, &err), -1);
+
+    /* Counted array with too many elements */
+    for (int i = 0; i < 9; i++)
+    {
+        char path[16];
+        snprintf(path, sizeof(path), "weights.[%d]", i);
+        assert_int_equal(sconf_set_int(root, path, i, &err), 0);
+    }
+    assert_int_equal(sconf_bind(root, bindings, &config, &err), -1);
+
+    /* Invalid arguments */
+    assert_int_equal(sconf_bind(NULL, bindings, &config, &err), -1);
+    assert_int_equal(sconf_bind(root, NULL, &config, &err), -1);
+    assert_int_equal(sconf_bind(root, bindings, NULL, &err), -1);
+
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_bind_type(void **unused)
+{
+    struct SConfErr err = {0};
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+    struct config config = {0};
+
+    assert_int_equal(sconf_set_str(root, "timeout", "soon", &err), 0);
+    assert_int_equal(sconf_bind(root, bindings, &config, &err), -1);
+    assert_string_equal(err.msg, "config node 'timeout' is string not "
+                        "floating-point number");
+
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_bind_invalid_bindings(void **unused)
+{
+    struct SConfErr err = {0};
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+    struct config config = {0};
+
+    const struct SConfBinding size[] = {
+        {
+            .path = "timeout",
+            .type = SCONF_TYPE_FLOAT,
+            SCONF_FIELD(struct config, level),
+        },
+        {0}
+    };
+    assert_int_equal(sconf_bind(root, size, &config, &err), -1);
+
+    const struct SConfBinding fallback[] = {
+        {
+            .path = "max-conns",
+            .type = SCONF_TYPE_INT,
+            .default_value = "many",
+            SCONF_FIELD(struct config, max_conns),
+        },
+        {0}
+    };
+    assert_int_equal(sconf_bind(root, fallback, &config, &err), -1);
+
+    const struct SConfBinding fields[] = {
+        {
+            .path = "db",
+            .type = SCONF_TYPE_DICT,
+            SCONF_FIELD(struct config, db),
+        },
+        {0}
+    };
+    assert_int_equal(sconf_bind(root, fields, &config, &err), -1);
+
+    /* Fixed size array with too few elements */
+    assert_int_equal(sconf_set_str(root, "db.host", "localhost", &err), 0);
+    assert_int_equal(sconf_set_float(root, "point.[0]", 1, &err), 0);
+    assert_int_equal(sconf_bind(root, bindings, &config, &err), -1);
+    assert_string_equal(err.msg, "config node 'point' has 1 elements, "
+                        "expected 2");
+
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_bind_int_limits(void **unused)
+{
+    struct limits {
+        int i;
+        uint16_t u16;
+        uint64_t u64;
+        uint8_t bytes[2];
+    } limits = {0};
+
+    const struct SConfBinding limit_bindings[] = {
+        {
+            .path = "i",
+            .type = SCONF_TYPE_INT,
+            SCONF_FIELD(struct limits, i),
+        },
+        {
+            .path = "u16",
+            .type = SCONF_TYPE_INT,
+            SCONF_FIELD_UNSIGNED(struct limits, u16),
+        },
+        {
+            .path = "u64",
+            .type = SCONF_TYPE_INT,
+            SCONF_FIELD_UNSIGNED(struct limits, u64),
+        },
+        {
+            .path = "bytes",
+            .type = SCONF_TYPE_ARRAY,
+            .element_type = SCONF_TYPE_INT,
+            .element_size = sizeof(uint8_t),
+            SCONF_FIELD_UNSIGNED(struct limits, bytes),
+        },
+        {0}
+    };
+
+    struct SConfErr err = {0};
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    assert_int_equal(sconf_set_int(root, "i", INT32_MIN, &err), 0);
+    assert_int_equal(sconf_set_int(root, "u16", UINT16_MAX, &err), 0);
+    assert_int_equal(sconf_set_int(root, "u64", INT64_MAX, &err), 0);
+    assert_int_equal(sconf_set_int(root, "bytes.[0]", 0, &err), 0);
+    assert_int_equal(sconf_set_int(root, "bytes.[1]", 255, &err), 0);
+    assert_int_equal(sconf_bind(root, limit_bindings, &limits, &err), 0);
+    assert_int_equal(limits.i, INT32_MIN);
+    assert_int_equal(limits.u16, UINT16_MAX);
+    assert_true(limits.u64 == INT64_MAX);
+    assert_int_equal(limits.bytes[1], 255);
+
+    /* Too large for a signed int */
+    assert_int_equal(sconf_set_int(root, "i", 3000000000, &err), 0);
+    assert_int_equal(sconf_bind(root, limit_bindings, &limits, &err), -1);
+    assert_string_equal(err.msg, "config node 'i' is 3000000000, which does "
+                        "not fit in 4 byte signed integer");
+    assert_int_equal(sconf_set_int(root, "i", 0, &err), 0);
+
+    /* Negative numbers in unsigned fields */
+    assert_int_equal(sconf_set_int(root, "u16", -1, &err), 0);
+    assert_int_equal(sconf_bind(root, limit_bindings, &limits, &err), -1);
+    assert_string_equal(err.msg, "config node 'u16' is -1, which does not "
+                        "fit in 2 byte unsigned integer");
+    assert_int_equal(sconf_set_int(root, "u16", 0, &err), 0);
+
+    assert_int_equal(sconf_set_int(root, "u64", -1, &err), 0);
+    assert_int_equal(sconf_bind(root, limit_bindings, &limits, &err), -1);
+    assert_int_equal(sconf_set_int(root, "u64", 0, &err), 0);
+
+    assert_int_equal(sconf_set_int(root, "bytes.[0]", -1, &err), 0);
+    assert_int_equal(sconf_bind(root, limit_bindings, &limits, &err), -1);
+    assert_int_equal(sconf_set_int(root, "bytes.[0]", 256, &err), 0);
+    assert_int_equal(sconf_bind(root, limit_bindings, &limits, &err), -1);
+
+    sconf_node_destroy(root);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_sconf_bind),
+        cmocka_unit_test(test_sconf_bind_defaults),
+        cmocka_unit_test(test_sconf_bind_errors),
+        cmocka_unit_test(test_sconf_bind_type),
+        cmocka_unit_test(test_sconf_bind_invalid_bindings),
+        cmocka_unit_test(test_sconf_bind_int_limits),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,252 @@
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <cmocka.h>
+
+#include "sconf.h"
+
+static struct SConfNode *create_tree(void)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+
+    assert_int_equal(sconf_set_str(root, "server.host", "localhost", &err), 0);
+    assert_int_equal(sconf_set_int(root, "server.port", 8080, &err), 0);
+    assert_int_equal(sconf_set_bool(root, "server.tls", true, &err), 0);
+    assert_int_equal(sconf_set_float(root, "server.load", 0.75, &err), 0);
+    assert_int_equal(sconf_set_str(root, "upstream.[0].host", "a", &err), 0);
+    assert_int_equal(sconf_set_str(root, "upstream.[2].host", "c", &err), 0);
+    assert_int_equal(sconf_set_int(root, "upstream.[2].weight", 3, &err), 0);
+
+    return root;
+}
+
+static void test_sconf_freeze_get(void **unused)
+{
+    struct SConfNode *root = create_tree();
+
+    struct SConfErr err = {0};
+
+    struct SConfNode *frozen = sconf_freeze(root, &err);
+    assert_non_null(frozen);
+
+    /* The snapshot does not depend on the original tree */
+    sconf_node_destroy(root);
+
+    const char *string = NULL;
+    assert_int_equal(sconf_get_str(frozen, "server.host", &string, &err), 1);
+    assert_string_equal(string, "localhost");
+
+    const int64_t *integer = NULL;
+    assert_int_equal(sconf_get_int(frozen, "server.port", &integer, &err), 1);
+    assert_int_equal(*integer, 8080);
+
+    const bool *boolean = NULL;
+    assert_int_equal(sconf_get_bool(frozen, "server.tls", &boolean, &err), 1);
+    assert_true(*boolean);
+
+    const double *fp = NULL;
+    assert_int_equal(sconf_get_float(frozen, "server.load", &fp, &err), 1);
+    assert_true(*fp == 0.75);
+
+    assert_int_equal(sconf_get_str(frozen, "upstream.[0].host", &string,
+                                   &err), 1);
+    assert_string_equal(string, "a");
+    assert_int_equal(sconf_get_str(frozen, "upstream.[2].host", &string,
+                                   &err), 1);
+    assert_string_equal(string, "c");
+    assert_int_equal(sconf_get_int(frozen, "upstream.[2].weight", &integer,
+                                   &err), 1);
+    assert_int_equal(*integer, 3);
+
+    /* Not found */
+    assert_int_equal(sconf_get_str(frozen, "upstream.[1].host", &string,
+                                   &err), 0);
+    assert_int_equal(sconf_get_str(frozen, "server.hos", &string, &err), 0);
+    assert_int_equal(sconf_get_str(frozen, "server.hostt", &string, &err), 0);
+    assert_int_equal(sconf_get_str(frozen, "a", &string, &err), 0);
+    assert_int_equal(sconf_get_str(frozen, "z", &string, &err), 0);
+
+    /* Wrong type */
+    assert_int_equal(sconf_get_str(frozen, "server.port", &string, &err), -1);
+
+    sconf_node_destroy(frozen);
+}
+
+static int collect_cb(const unsigned char *name, struct SConfNode *node,
+                      void *user, struct SConfErr *err)
+{
+    strcat((char *)user, (const char *)name);
+    strcat((char *)user, ",");
+
+    return 0;
+}
+
+static int count_cb(uint32_t index, struct SConfNode *node, void *user,
+                    struct SConfErr *err)
+{
+    *(int *)user += 1;
+
+    return 0;
+}
+
+static void test_sconf_freeze_foreach(void **unused)
+{
+    struct SConfNode *root = create_tree();
+
+    struct SConfErr err = {0};
+
+    struct SConfNode *frozen = sconf_freeze(root, &err);
+    assert_non_null(frozen);
+
+    char original[128] = {0};
+    char names[128] = {0};
+
+    struct SConfNode *dict = NULL;
+    assert_int_equal(sconf_get(root, "server", &dict, &err), 1);
+    assert_int_equal(sconf_node_dict_foreach(dict, collect_cb, original,
+                                             &err), 0);
+    assert_int_equal(sconf_get(frozen, "server", &dict, &err), 1);
+    assert_int_equal(sconf_node_dict_foreach(dict, collect_cb, names, &err),
+                     0);
+
+    /* Same order as the original tree */
+    assert_string_equal(names, "host,load,port,tls,");
+    assert_string_equal(names, original);
+
+    struct SConfNode *array = NULL;
+    assert_int_equal(sconf_get(frozen, "upstream", &array, &err), 1);
+    int count = 0;
+    assert_int_equal(sconf_node_array_foreach(array, count_cb, &count, &err),
+                     0);
+    assert_int_equal(count, 2);
+
+    sconf_node_destroy(root);
+    sconf_node_destroy(frozen);
+}
+
+static void test_sconf_freeze_read_only(void **unused)
+{
+    struct SConfNode *root = create_tree();
+
+    struct SConfErr err = {0};
+
+    struct SConfNode *frozen = sconf_freeze(root, &err);
+    assert_non_null(frozen);
+
+    assert_int_equal(sconf_set_int(frozen, "server.port", 1, &err), -1);
+    assert_string_equal(sconf_strerror(&err), "config node is frozen");
+    assert_int_equal(sconf_set_int(frozen, "new", 1, &err), -1);
+    assert_int_equal(sconf_set_int(frozen, "upstream.[1].weight", 1, &err),
+                     -1);
+
+    struct SConfNode *node = sconf_node_create(SCONF_TYPE_INT, &(int64_t){1},
+                                               &err);
+    assert_non_null(node);
+    assert_int_equal(sconf_node_dict_insert("new", frozen, node, &err), -1);
+    sconf_node_destroy(node);
+
+    /* Frozen nodes can not be moved into other trees */
+    struct SConfNode *server = NULL;
+    assert_int_equal(sconf_get(frozen, "server", &server, &err), 1);
+    assert_int_equal(sconf_node_dict_insert("server", root, server, &err), -1);
+
+    /* Destroying a node inside the snapshot does nothing */
+    sconf_node_destroy(server);
+
+    const int64_t *integer = NULL;
+    assert_int_equal(sconf_get_int(frozen, "server.port", &integer, &err), 1);
+    assert_int_equal(*integer, 8080);
+
+    sconf_node_destroy(root);
+    sconf_node_destroy(frozen);
+}
+
+static void test_sconf_freeze_handle(void **unused)
+{
+    struct SConfNode *root = create_tree();
+
+    struct SConfErr err = {0};
+
+    struct SConfNode *frozen = sconf_freeze(root, &err);
+    assert_non_null(frozen);
+    sconf_node_destroy(root);
+
+    struct SConfHandle *handle = sconf_handle_create(frozen, "server.port",
+                                                     &err);
+    assert_non_null(handle);
+
+    const int64_t *integer = NULL;
+    assert_int_equal(sconf_handle_int(handle, &integer, &err), 1);
+    assert_int_equal(*integer, 8080);
+
+    sconf_handle_destroy(handle);
+    sconf_node_destroy(frozen);
+}
+
+static void test_sconf_freeze_frozen_and_empty(void **unused)
+{
+    struct SConfErr err = {0};
+
+    assert_null(sconf_freeze(NULL, &err));
+
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfNode *frozen = sconf_freeze(root, &err);
+    assert_non_null(frozen);
+
+    const char *string = NULL;
+    assert_int_equal(sconf_get_str(frozen, "a", &string, &err), 0);
+
+    /* Freezing a snapshot makes a copy */
+    struct SConfNode *copy = sconf_freeze(frozen, &err);
+    assert_non_null(copy);
+
+    sconf_node_destroy(root);
+    sconf_node_destroy(frozen);
+    sconf_node_destroy(copy);
+}
+
+static void test_sconf_freeze_yaml(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+
+    assert_int_equal(sconf_yaml_read(root, "yaml/test_array.yaml", &err), 0);
+
+    struct SConfNode *frozen = sconf_freeze(root, &err);
+    assert_non_null(frozen);
+    sconf_node_destroy(root);
+
+    const char *string = NULL;
+    assert_int_equal(sconf_get_str(frozen, "a.[0]", &string, &err), 1);
+    assert_string_equal(string, "foobar");
+    assert_int_equal(sconf_get_str(frozen, "b.a.[0].c", &string, &err), 1);
+    assert_string_equal(string, "rofl");
+
+    sconf_node_destroy(frozen);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_sconf_freeze_get),
+        cmocka_unit_test(test_sconf_freeze_foreach),
+        cmocka_unit_test(test_sconf_freeze_read_only),
+        cmocka_unit_test(test_sconf_freeze_handle),
+        cmocka_unit_test(test_sconf_freeze_frozen_and_empty),
+        cmocka_unit_test(test_sconf_freeze_yaml),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
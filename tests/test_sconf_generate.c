@@ -0,0 +1,103 @@
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmocka.h>
+
+#include "app_config.h"
+
+static void test_sconf_generate(void **unused)
+{
+    struct SConfErr err = {0};
+    struct SConfNode *root = SCONF_ROOT(&err);
+    assert_non_null(root);
+
+    char *argv[] = {"test", "-m", "16", "--log-dir", "/tmp", NULL};
+    int argc = 5;
+
+    assert_int_equal(sconf_set_str(root, "db.host", "localhost", &err), 0);
+    assert_int_equal(sconf_set_int(root, "weights.[0]", 3, &err), 0);
+    assert_int_equal(sconf_set_int(root, "weights.[1]", 4, &err), 0);
+    assert_int_equal(sconf_set_float(root, "origin.[0]", 1.5, &err), 0);
+    assert_int_equal(sconf_set_float(root, "origin.[1]", -1.5, &err), 0);
+
+    struct app_config config = {0};
+    assert_int_equal(app_config_initialize(root, argc, argv, &config, &err),
+                     0);
+
+    assert_int_equal(app_config_max_conns(&config), 16);
+    assert_string_equal(app_config_log_dir(&config), "/tmp");
+    assert_false(app_config_log_verbose(&config));
+    assert_float_equal(app_config_timeout(&config), 2.5, 0);
+    assert_string_equal(app_config_db_host(&config), "localhost");
+    assert_int_equal(app_config_db_port(&config), 5432);
+    assert_int_equal(app_config_weights_count(&config), 2);
+    assert_int_equal(app_config_weights(&config, 1), 4);
+    assert_int_equal(app_config_origin_count(&config), 2);
+    assert_float_equal(app_config_origin(&config, 1), -1.5, 0);
+
+    /* Fields have the C types from the schema */
+    assert_int_equal(sizeof(config.db.port), sizeof(uint16_t));
+    assert_int_equal(sizeof(config.origin[0]), sizeof(float));
+
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_generate_errors(void **unused)
+{
+    struct SConfErr err = {0};
+    struct SConfNode *root = SCONF_ROOT(&err);
+    assert_non_null(root);
+
+    struct app_config config = {0};
+
+    /* Missing required db.host */
+    assert_int_equal(app_config_load(root, &config, &err), -1);
+
+    assert_int_equal(sconf_set_str(root, "db.host", "localhost", &err), 0);
+    assert_int_equal(sconf_set_float(root, "origin.[0]", 0, &err), 0);
+    assert_int_equal(sconf_set_float(root, "origin.[1]", 0, &err), 0);
+    assert_int_equal(app_config_load(root, &config, &err), 0);
+
+    /* Out of range */
+    assert_int_equal(sconf_set_int(root, "max-conns", 0, &err), 0);
+    assert_int_equal(app_config_load(root, &config, &err), -1);
+
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_generate_map(void **unused)
+{
+    size_t count = 0;
+    const struct SConfMap *usage = NULL;
+
+    for (const struct SConfMap *entry = app_config_map; entry->type; entry++)
+    {
+        if (entry->type == SCONF_TYPE_USAGE) {
+            usage = entry;
+        }
+        count++;
+    }
+
+    /* Arrays are bound directly and not in the config map */
+    assert_int_equal(count, 8);
+    assert_non_null(usage);
+    assert_string_equal(usage->usage_desc,
+                        "Test \"app\" using generated config.");
+    assert_string_equal(app_config_map[1].path, "log.dir");
+    assert_string_equal(app_config_map[1].default_value, "/var/log/app");
+    assert_int_equal(app_config_map[1].opts_short, 'l');
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_sconf_generate),
+        cmocka_unit_test(test_sconf_generate_errors),
+        cmocka_unit_test(test_sconf_generate_map),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,163 @@
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmocka.h>
+
+#include "sconf.h"
+
+static const char *paths[] = {
+    "db.primary.port",
+    "http.listeners.[1].port",
+    "db.primary.host",
+    "db.primary",
+    "db.replica.host",
+    "db.primary.user.name",
+    "http.listeners.[0].port",
+    "http.listeners.[0].host",
+    "http.listeners.[5].host",
+    "http.listeners.[1]",
+    "db.primary.port",
+    "db",
+    "dict.[0]",
+    "dict.[0].x",
+    "weights.[2]",
+    "weights.[3]",
+    "weights",
+    "missing.key",
+};
+
+#define PATHS (sizeof(paths) / sizeof(paths[0]))
+
+static struct SConfNode *create_tree(void)
+{
+    struct SConfErr err = {0};
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    assert_int_equal(sconf_set_str(root, "db.primary.host", "a", &err), 0);
+    assert_int_equal(sconf_set_int(root, "db.primary.port", 5432, &err), 0);
+    assert_int_equal(sconf_set_str(root, "db.replica.host", "b", &err), 0);
+    assert_int_equal(sconf_set_str(root, "http.listeners.[0].host", "c", &err),
+                     0);
+    assert_int_equal(sconf_set_int(root, "http.listeners.[0].port", 80, &err),
+                     0);
+    assert_int_equal(sconf_set_int(root, "http.listeners.[1].port", 443, &err),
+                     0);
+    assert_int_equal(sconf_set_int(root, "weights.[0]", 1, &err), 0);
+    assert_int_equal(sconf_set_int(root, "weights.[1]", 2, &err), 0);
+    assert_int_equal(sconf_set_int(root, "weights.[2]", 3, &err), 0);
+
+    /* Dictionary key that looks like an array index */
+    struct SConfNode *dict = NULL;
+    struct SConfNode *node = sconf_node_create(SCONF_TYPE_INT, &(int64_t){7},
+                                               &err);
+    assert_non_null(node);
+    assert_int_equal(sconf_set(root, "dict.x", SCONF_TYPE_INT, &(int64_t){0},
+                               &err), 0);
+    assert_int_equal(sconf_get(root, "dict", &dict, &err), 1);
+    assert_int_equal(sconf_node_dict_insert("[0]", dict, node, &err), 0);
+
+    return root;
+}
+
+static void assert_same_as_get(struct SConfNode *root)
+{
+    struct SConfErr err = {0};
+    struct SConfGetResult results[PATHS];
+
+    assert_int_equal(sconf_get_many(root, paths, PATHS, results, &err), 0);
+
+    for (size_t i = 0; i < PATHS; i++)
+    {
+        struct SConfNode *node = NULL;
+        int r = sconf_get(root, paths[i], &node, &err);
+        assert_int_not_equal(r, -1);
+        assert_int_equal(results[i].found, r == 1);
+        if (r == 1) {
+            assert_ptr_equal(results[i].node, node);
+        }
+        else {
+            assert_null(results[i].node);
+        }
+    }
+}
+
+static void test_sconf_get_many(void **unused)
+{
+    struct SConfNode *root = create_tree();
+
+    assert_same_as_get(root);
+
+    struct SConfErr err = {0};
+    struct SConfGetResult results[PATHS];
+    assert_int_equal(sconf_get_many(root, paths, PATHS, results, &err), 0);
+
+    assert_true(results[0].found);
+    assert_int_equal(sconf_int(results[0].node), 5432);
+    assert_true(results[1].found);
+    assert_int_equal(sconf_int(results[1].node), 443);
+    assert_true(results[12].found);
+    assert_int_equal(sconf_int(results[12].node), 7);
+    assert_false(results[13].found);
+    assert_false(results[17].found);
+
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_get_many_frozen(void **unused)
+{
+    struct SConfNode *root = create_tree();
+    struct SConfErr err = {0};
+
+    struct SConfNode *frozen = sconf_freeze(root, &err);
+    assert_non_null(frozen);
+    sconf_node_destroy(root);
+
+    assert_same_as_get(frozen);
+
+    assert_int_equal(sconf_index_paths(frozen, &err), 0);
+    assert_same_as_get(frozen);
+
+    sconf_node_destroy(frozen);
+}
+
+static void test_sconf_get_many_errors(void **unused)
+{
+    struct SConfNode *root = create_tree();
+    struct SConfErr err = {0};
+    struct SConfGetResult results[3];
+
+    const char *invalid[] = {"db.primary.host", "weights.[x]", "db"};
+    assert_int_equal(sconf_get_many(root, invalid, 3, results, &err), -1);
+
+    /* Same error as sconf_get for a path through a string */
+    invalid[1] = "db.primary.host.x";
+    assert_int_equal(sconf_get_many(root, invalid, 3, results, &err), -1);
+
+    const char *empty[] = {"db", ""};
+    assert_int_equal(sconf_get_many(root, empty, 2, results, &err), -1);
+
+    const char *null[] = {"db", NULL};
+    assert_int_equal(sconf_get_many(root, null, 2, results, &err), -1);
+
+    assert_int_equal(sconf_get_many(NULL, paths, 1, results, &err), -1);
+    assert_int_equal(sconf_get_many(root, NULL, 1, results, &err), -1);
+    assert_int_equal(sconf_get_many(root, paths, 1, NULL, &err), -1);
+    assert_int_equal(sconf_get_many(root, NULL, 0, NULL, &err), 0);
+
+    sconf_node_destroy(root);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_sconf_get_many),
+        cmocka_unit_test(test_sconf_get_many_frozen),
+        cmocka_unit_test(test_sconf_get_many_errors),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
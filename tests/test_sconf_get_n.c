@@ -0,0 +1,265 @@
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <cmocka.h>
+
+#include "sconf.h"
+
+#define LONG_STR "a string that is too long to be stored in the node itself"
+
+/* Request buffer with paths and values that are not null terminated */
+static const char request[] = "servers.[1].portXservers.[1].hostXlocalhostX"
+                              "upstream.weightX" LONG_STR "X";
+
+static void test_sconf_get_n(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+    struct SConfNode *node = NULL;
+
+    assert_int_equal(sconf_set_int(root, "servers.[1].port", 8080, &err), 0);
+
+    assert_int_equal(sconf_get_n(root, request, 16, &node, &err), 1);
+    assert_int_equal(sconf_int(node), 8080);
+
+    /* Prefix of the path */
+    assert_int_equal(sconf_get_n(root, request, 11, &node, &err), 1);
+    assert_int_equal(sconf_type(node), SCONF_TYPE_DICT);
+    assert_int_equal(sconf_get_n(root, request, 15, &node, &err), 0);
+
+    /* Path without a null terminator is not read past its length */
+    assert_int_equal(sconf_get_n(root, request + 17, 16, &node, &err), 0);
+
+    assert_int_equal(sconf_get_n(root, request, 0, &node, &err), -1);
+    assert_int_equal(sconf_get_n(root, NULL, 0, &node, &err), -1);
+    assert_int_equal(sconf_get_n(NULL, request, 16, &node, &err), -1);
+
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_set_n(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+    int64_t integer = 3;
+
+    assert_int_equal(sconf_set_n(root, request + 44, 15, SCONF_TYPE_INT,
+                                 &integer, &err), 0);
+
+    const int64_t *weight = NULL;
+    assert_int_equal(sconf_get_int(root, "upstream.weight", &weight, &err), 1);
+    assert_int_equal(*weight, 3);
+
+    assert_int_equal(sconf_set_n(root, request, 0, SCONF_TYPE_INT, &integer,
+                                 &err), -1);
+    assert_int_equal(sconf_set_n(root, request, 16, SCONF_TYPE_INT, NULL,
+                                 &err), -1);
+
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_set_str_n(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+    const char *str = NULL;
+    size_t len = 0;
+
+    assert_int_equal(sconf_set_str_n(root, request + 17, 16, request + 34, 9,
+                                     &err), 0);
+    assert_int_equal(sconf_get_str_n(root, "servers.[1].host", &str, &len,
+                                     &err), 1);
+    assert_int_equal(len, 9);
+    assert_string_equal(str, "localhost");
+
+    /* Long string, overwriting the short one */
+    assert_int_equal(sconf_set_str_n(root, request + 17, 16, request + 60,
+                                     strlen(LONG_STR), &err), 0);
+    assert_int_equal(sconf_get_str_n(root, "servers.[1].host", &str, &len,
+                                     &err), 1);
+    assert_int_equal(len, strlen(LONG_STR));
+    assert_string_equal(str, LONG_STR);
+
+    /* Null bytes are kept */
+    assert_int_equal(sconf_set_str_n(root, "bin", 3, "a\0b", 3, &err), 0);
+    struct SConfNode *node = NULL;
+    assert_int_equal(sconf_get(root, "bin", &node, &err), 1);
+    assert_int_equal(sconf_str_len(node), 3);
+    assert_memory_equal(sconf_str(node), "a\0b", 4);
+
+    /* Empty string */
+    assert_int_equal(sconf_set_str_n(root, "empty", 5, request, 0, &err), 0);
+    assert_int_equal(sconf_get_str_n(root, "empty", &str, &len, &err), 1);
+    assert_int_equal(len, 0);
+    assert_string_equal(str, "");
+
+    assert_int_equal(sconf_set_str_n(root, "x", 1, NULL, 0, &err), -1);
+    assert_int_equal(sconf_set_str_n(NULL, "x", 1, "y", 1, &err), -1);
+
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_set_str_n_arena(void **unused)
+{
+    struct SConfErr err = {0};
+    struct SConfNode *root = SCONF_ROOT_ARENA(&err);
+    assert_non_null(root);
+
+    const char *str = NULL;
+    size_t len = 0;
+
+    assert_int_equal(sconf_set_str_n(root, "a", 1, request + 60,
+                                     strlen(LONG_STR), &err), 0);
+    assert_int_equal(sconf_set_str_n(root, "b", 1, request + 60,
+                                     strlen(LONG_STR), &err), 0);
+    assert_int_equal(sconf_get_str_n(root, "a", &str, &len, &err), 1);
+    assert_int_equal(len, strlen(LONG_STR));
+    assert_string_equal(str, LONG_STR);
+
+    struct SConfNode *a = NULL;
+    struct SConfNode *b = NULL;
+    assert_int_equal(sconf_get(root, "a", &a, &err), 1);
+    assert_int_equal(sconf_get(root, "b", &b, &err), 1);
+    assert_ptr_equal(sconf_str(a), sconf_str(b));
+
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_set_str_n_from_itself(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+    const char *str = NULL;
+    size_t len = 0;
+
+    /* Inline string set from its own value, and from a suffix of it */
+    assert_int_equal(sconf_set_str_n(root, "a", 1, "localhost", 9, &err), 0);
+    assert_int_equal(sconf_get_str_n(root, "a", &str, &len, &err), 1);
+    assert_int_equal(sconf_set_str_n(root, "a", 1, str, len, &err), 0);
+    assert_int_equal(sconf_get_str_n(root, "a", &str, &len, &err), 1);
+    assert_string_equal(str, "localhost");
+    assert_int_equal(sconf_set_str_n(root, "a", 1, str + 5, 4, &err), 0);
+    assert_int_equal(sconf_get_str_n(root, "a", &str, &len, &err), 1);
+    assert_string_equal(str, "host");
+
+    /* Heap string set from its own value keeps the buffer */
+    assert_int_equal(sconf_set_str_n(root, "b", 1, LONG_STR, strlen(LONG_STR),
+                                     &err), 0);
+    assert_int_equal(sconf_get_str_n(root, "b", &str, &len, &err), 1);
+    const char *buf = str;
+    assert_int_equal(sconf_set_str_n(root, "b", 1, str, len, &err), 0);
+    assert_int_equal(sconf_get_str_n(root, "b", &str, &len, &err), 1);
+    assert_ptr_equal(str, buf);
+    assert_string_equal(str, LONG_STR);
+    assert_int_equal(sconf_set_str_n(root, "b", 1, str + 1, len - 1, &err), 0);
+    assert_int_equal(sconf_get_str_n(root, "b", &str, &len, &err), 1);
+    assert_ptr_equal(str, buf);
+    assert_string_equal(str, LONG_STR + 1);
+
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_node_dict_n(void **unused)
+{
+    struct SConfNode *dict = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(dict);
+
+    struct SConfErr err = {0};
+    struct SConfNode *found = NULL;
+
+    int64_t integer = 1;
+    struct SConfNode *node = sconf_node_create(SCONF_TYPE_INT, &integer, &err);
+    assert_non_null(node);
+
+    assert_int_equal(sconf_node_dict_insert_n("hostXport", 4, dict, node,
+                                              &err), 0);
+
+    assert_int_equal(sconf_node_dict_search_n("hostname", 4, dict, &found,
+                                              &err), 0);
+    assert_ptr_equal(found, node);
+    assert_int_equal(sconf_node_dict_search("host", dict, &found, &err), 0);
+    assert_ptr_equal(found, node);
+    assert_int_equal(sconf_node_dict_search_n("hostname", 5, dict, &found,
+                                              &err), 0);
+    assert_null(found);
+
+    /* Names are null terminated when iterating, so null bytes are refused */
+    node = sconf_node_create(SCONF_TYPE_INT, &integer, &err);
+    assert_non_null(node);
+    assert_int_equal(sconf_node_dict_insert_n("a\0b", 3, dict, node, &err),
+                     -1);
+    assert_int_equal(sconf_set_n(dict, "a\0b", 3, SCONF_TYPE_INT, &integer,
+                                 &err), -1);
+    sconf_node_destroy(node);
+
+    assert_int_equal(sconf_node_dict_insert_n(NULL, 0, dict, node, &err), -1);
+    assert_int_equal(sconf_node_dict_search_n(NULL, 0, dict, &found, &err),
+                     -1);
+
+    sconf_node_destroy(dict);
+}
+
+static void test_sconf_get_n_frozen(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+    struct SConfNode *node = NULL;
+
+    assert_int_equal(sconf_set_int(root, "servers.[1].port", 8080, &err), 0);
+    assert_int_equal(sconf_set_str(root, "servers.[1].host", "a", &err), 0);
+
+    struct SConfNode *frozen = sconf_freeze(root, &err);
+    assert_non_null(frozen);
+    sconf_node_destroy(root);
+
+    assert_int_equal(sconf_get_n(frozen, request, 16, &node, &err), 1);
+    assert_int_equal(sconf_int(node), 8080);
+
+    /* Through the path index */
+    assert_int_equal(sconf_index_paths(frozen, &err), 0);
+    assert_int_equal(sconf_get_n(frozen, request, 16, &node, &err), 1);
+    assert_int_equal(sconf_int(node), 8080);
+    assert_int_equal(sconf_get_n(frozen, request + 17, 16, &node, &err), 1);
+    assert_string_equal(sconf_str(node), "a");
+
+    struct SConfPath *path = sconf_path_compile_n(request, 16, &err);
+    assert_non_null(path);
+    const int64_t *port = NULL;
+    assert_int_equal(sconf_get_int_p(frozen, path, &port, &err), 1);
+    assert_int_equal(*port, 8080);
+    sconf_path_destroy(path);
+
+    assert_null(sconf_path_compile_n(NULL, 0, &err));
+    assert_null(sconf_path_compile_n(request, 0, &err));
+
+    sconf_node_destroy(frozen);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_sconf_get_n),
+        cmocka_unit_test(test_sconf_set_n),
+        cmocka_unit_test(test_sconf_set_str_n),
+        cmocka_unit_test(test_sconf_set_str_n_arena),
+        cmocka_unit_test(test_sconf_set_str_n_from_itself),
+        cmocka_unit_test(test_sconf_node_dict_n),
+        cmocka_unit_test(test_sconf_get_n_frozen),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
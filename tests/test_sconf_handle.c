@@ -0,0 +1,256 @@
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <cmocka.h>
+
+#include "sconf.h"
+
+static void test_sconf_handle_get(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+
+    assert_int_equal(sconf_set_int(root, "server.port", 8080, &err), 0);
+    assert_int_equal(sconf_set_str(root, "server.host", "localhost", &err), 0);
+    assert_int_equal(sconf_set_bool(root, "server.tls", true, &err), 0);
+    assert_int_equal(sconf_set_float(root, "server.load", 0.5, &err), 0);
+
+    struct SConfHandle *port = sconf_handle_create(root, "server.port", &err);
+    assert_non_null(port);
+    struct SConfHandle *host = sconf_handle_create(root, "server.host", &err);
+    assert_non_null(host);
+    struct SConfHandle *tls = sconf_handle_create(root, "server.tls", &err);
+    assert_non_null(tls);
+    struct SConfHandle *load = sconf_handle_create(root, "server.load", &err);
+    assert_non_null(load);
+
+    /* Read twice, the second read uses the cached node */
+    for (int i = 0; i < 2; i++)
+    {
+        const int64_t *integer = NULL;
+        assert_int_equal(sconf_handle_int(port, &integer, &err), 1);
+        assert_int_equal(*integer, 8080);
+
+        const char *string = NULL;
+        assert_int_equal(sconf_handle_str(host, &string, &err), 1);
+        assert_string_equal(string, "localhost");
+
+        const bool *boolean = NULL;
+        assert_int_equal(sconf_handle_bool(tls, &boolean, &err), 1);
+        assert_true(*boolean);
+
+        const double *fp = NULL;
+        assert_int_equal(sconf_handle_float(load, &fp, &err), 1);
+        assert_true(*fp == 0.5);
+    }
+
+    struct SConfNode *node = NULL;
+    assert_int_equal(sconf_handle_get(port, &node, &err), 1);
+    assert_int_equal(sconf_type(node), SCONF_TYPE_INT);
+
+    sconf_handle_destroy(port);
+    sconf_handle_destroy(host);
+    sconf_handle_destroy(tls);
+    sconf_handle_destroy(load);
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_handle_set_updates_value(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+
+    assert_int_equal(sconf_set_str(root, "a.b", "first", &err), 0);
+
+    struct SConfHandle *handle = sconf_handle_create(root, "a.b", &err);
+    assert_non_null(handle);
+
+    const char *string = NULL;
+    assert_int_equal(sconf_handle_str(handle, &string, &err), 1);
+    assert_string_equal(string, "first");
+
+    assert_int_equal(sconf_set_str(root, "a.b", "second", &err), 0);
+
+    assert_int_equal(sconf_handle_str(handle, &string, &err), 1);
+    assert_string_equal(string, "second");
+
+    sconf_handle_destroy(handle);
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_handle_not_found_then_inserted(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+
+    struct SConfHandle *handle = sconf_handle_create(root, "x.[1]", &err);
+    assert_non_null(handle);
+
+    const int64_t *integer = NULL;
+    assert_int_equal(sconf_handle_int(handle, &integer, &err), 0);
+    assert_int_equal(sconf_handle_int(handle, &integer, &err), 0);
+
+    assert_int_equal(sconf_set_int(root, "x.[1]", 42, &err), 0);
+
+    assert_int_equal(sconf_handle_int(handle, &integer, &err), 1);
+    assert_int_equal(*integer, 42);
+
+    sconf_handle_destroy(handle);
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_handle_invalidated_by_yaml_read(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+
+    assert_int_equal(sconf_set_int(root, "a", 1, &err), 0);
+
+    struct SConfHandle *a = sconf_handle_create(root, "a", &err);
+    assert_non_null(a);
+    struct SConfHandle *e = sconf_handle_create(root, "e", &err);
+    assert_non_null(e);
+
+    const int64_t *integer = NULL;
+    assert_int_equal(sconf_handle_int(a, &integer, &err), 1);
+    assert_int_equal(*integer, 1);
+    assert_int_equal(sconf_handle_int(e, &integer, &err), 0);
+
+    assert_int_equal(sconf_yaml_read(root, "yaml/test_integer.yaml", &err), 0);
+
+    assert_int_equal(sconf_handle_int(a, &integer, &err), 1);
+    assert_int_equal(*integer, 1234567890);
+    assert_int_equal(sconf_handle_int(e, &integer, &err), 1);
+    assert_int_equal(*integer, -1234567890);
+
+    sconf_handle_destroy(a);
+    sconf_handle_destroy(e);
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_handle_arena_and_overlay(void **unused)
+{
+    struct SConfErr err = {0};
+
+    struct SConfNode *base = sconf_node_create_arena(SCONF_TYPE_DICT, NULL,
+                                                     &err);
+    assert_non_null(base);
+    assert_int_equal(sconf_set_int(base, "a", 1, &err), 0);
+
+    struct SConfNode *overlay = sconf_overlay_create(base, &err);
+    assert_non_null(overlay);
+
+    struct SConfHandle *a = sconf_handle_create(base, "a", &err);
+    assert_non_null(a);
+    struct SConfHandle *b = sconf_handle_create(base, "b", &err);
+    assert_non_null(b);
+    struct SConfHandle *over = sconf_handle_create(overlay, "b", &err);
+    assert_non_null(over);
+
+    const int64_t *integer = NULL;
+    assert_int_equal(sconf_handle_int(a, &integer, &err), 1);
+    assert_int_equal(*integer, 1);
+    assert_int_equal(sconf_handle_int(b, &integer, &err), 0);
+    assert_int_equal(sconf_handle_int(over, &integer, &err), 0);
+
+    /* Changes to the arena-backed base are seen through both */
+    assert_int_equal(sconf_set_int(base, "b", 2, &err), 0);
+    assert_int_equal(sconf_handle_int(b, &integer, &err), 1);
+    assert_int_equal(*integer, 2);
+    assert_int_equal(sconf_handle_int(over, &integer, &err), 1);
+    assert_int_equal(*integer, 2);
+
+    /* And so are changes to the overlay itself */
+    assert_int_equal(sconf_set_int(overlay, "b", 3, &err), 0);
+    assert_int_equal(sconf_handle_int(over, &integer, &err), 1);
+    assert_int_equal(*integer, 3);
+    assert_int_equal(sconf_handle_int(b, &integer, &err), 1);
+    assert_int_equal(*integer, 2);
+
+    /* Changes to other trees leave the cached nodes valid */
+    struct SConfNode *other = sconf_node_create(SCONF_TYPE_DICT, NULL, &err);
+    assert_non_null(other);
+    assert_int_equal(sconf_set_int(other, "a", 4, &err), 0);
+    sconf_node_destroy(other);
+
+    assert_int_equal(sconf_handle_int(a, &integer, &err), 1);
+    assert_int_equal(*integer, 1);
+
+    sconf_handle_destroy(a);
+    sconf_handle_destroy(b);
+    sconf_handle_destroy(over);
+    sconf_node_destroy(overlay);
+    sconf_node_destroy(base);
+}
+
+static void test_sconf_handle_wrong_type(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+
+    assert_int_equal(sconf_set_int(root, "a", 1, &err), 0);
+
+    struct SConfHandle *handle = sconf_handle_create(root, "a", &err);
+    assert_non_null(handle);
+
+    const char *string = NULL;
+    assert_int_equal(sconf_handle_str(handle, &string, &err), -1);
+    assert_string_equal(sconf_strerror(&err),
+                        "config node 'a' is integer not string");
+
+    /* Cached node still type checked */
+    assert_int_equal(sconf_handle_str(handle, &string, &err), -1);
+
+    sconf_handle_destroy(handle);
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_handle_invalid(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+
+    assert_null(sconf_handle_create(NULL, "a", &err));
+    assert_null(sconf_handle_create(root, NULL, &err));
+    assert_null(sconf_handle_create(root, "", &err));
+
+    const int64_t *integer = NULL;
+    assert_int_equal(sconf_handle_int(NULL, &integer, &err), -1);
+
+    struct SConfNode *node = NULL;
+    assert_int_equal(sconf_handle_get(NULL, &node, &err), -1);
+
+    sconf_handle_destroy(NULL);
+    sconf_node_destroy(root);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_sconf_handle_get),
+        cmocka_unit_test(test_sconf_handle_set_updates_value),
+        cmocka_unit_test(test_sconf_handle_not_found_then_inserted),
+        cmocka_unit_test(test_sconf_handle_invalidated_by_yaml_read),
+        cmocka_unit_test(test_sconf_handle_arena_and_overlay),
+        cmocka_unit_test(test_sconf_handle_wrong_type),
+        cmocka_unit_test(test_sconf_handle_invalid),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,218 @@
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <cmocka.h>
+
+#include "sconf.h"
+
+static struct SConfNode *create_indexed(struct SConfNode *root)
+{
+    struct SConfErr err = {0};
+
+    struct SConfNode *frozen = sconf_freeze(root, &err);
+    assert_non_null(frozen);
+    assert_int_equal(sconf_index_paths(frozen, &err), 0);
+
+    return frozen;
+}
+
+static void test_sconf_index_paths_get(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+
+    assert_int_equal(sconf_set_str(root, "logging.log-dir", "/var/log", &err),
+                     0);
+    assert_int_equal(sconf_set_str(root, "servers.[2].host", "c", &err), 0);
+    assert_int_equal(sconf_set_int(root, "servers.[2].port", 80, &err), 0);
+    assert_int_equal(sconf_set_bool(root, "enabled", true, &err), 0);
+
+    struct SConfNode *frozen = create_indexed(root);
+    sconf_node_destroy(root);
+
+    const char *string = NULL;
+    assert_int_equal(sconf_get_str(frozen, "logging.log-dir", &string, &err),
+                     1);
+    assert_string_equal(string, "/var/log");
+    assert_int_equal(sconf_get_str(frozen, "servers.[2].host", &string, &err),
+                     1);
+    assert_string_equal(string, "c");
+
+    const int64_t *integer = NULL;
+    assert_int_equal(sconf_get_int(frozen, "servers.[2].port", &integer,
+                                   &err), 1);
+    assert_int_equal(*integer, 80);
+
+    const bool *boolean = NULL;
+    assert_int_equal(sconf_get_bool(frozen, "enabled", &boolean, &err), 1);
+    assert_true(*boolean);
+
+    struct SConfNode *node = NULL;
+    assert_int_equal(sconf_get(frozen, "servers", &node, &err), 1);
+    assert_int_equal(sconf_type(node), SCONF_TYPE_ARRAY);
+
+    /* Not in canonical form, found by walking the tree */
+    assert_int_equal(sconf_get_str(frozen, "logging..log-dir", &string, &err),
+                     1);
+    assert_string_equal(string, "/var/log");
+
+    /* Compiled paths use the index as well */
+    struct SConfPath *path = sconf_path_compile("servers.[2].port", &err);
+    assert_non_null(path);
+    assert_int_equal(sconf_get_int_p(frozen, path, &integer, &err), 1);
+    assert_int_equal(*integer, 80);
+    sconf_path_destroy(path);
+
+    sconf_node_destroy(frozen);
+}
+
+static void test_sconf_index_paths_missing(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+
+    assert_int_equal(sconf_set_int(root, "a.b", 1, &err), 0);
+    assert_int_equal(sconf_set_int(root, "arr.[0]", 1, &err), 0);
+
+    struct SConfNode *frozen = create_indexed(root);
+    sconf_node_destroy(root);
+
+    struct SConfNode *node = NULL;
+    assert_int_equal(sconf_get(frozen, "a.c", &node, &err), 0);
+    assert_int_equal(sconf_get(frozen, "b", &node, &err), 0);
+    assert_int_equal(sconf_get(frozen, "arr.[1]", &node, &err), 0);
+
+    /* Same errors as without the index */
+    assert_int_equal(sconf_get(frozen, "a.b.c", &node, &err), -1);
+    assert_int_equal(sconf_get(frozen, "arr.[-1]", &node, &err), -1);
+
+    const char *string = NULL;
+    assert_int_equal(sconf_get_str(frozen, "a.b", &string, &err), -1);
+    assert_string_equal(sconf_strerror(&err),
+                        "config node 'a.b' is integer not string");
+
+    sconf_node_destroy(frozen);
+}
+
+static void test_sconf_index_paths_many(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+    char path[64];
+
+    for (int i = 0; i < 5000; i++)
+    {
+        snprintf(path, sizeof(path), "section-%d.key-%d", i % 97, i);
+        assert_int_equal(sconf_set_int(root, path, i, &err), 0);
+    }
+
+    struct SConfNode *frozen = create_indexed(root);
+    sconf_node_destroy(root);
+
+    const int64_t *integer = NULL;
+    for (int i = 0; i < 5000; i++)
+    {
+        snprintf(path, sizeof(path), "section-%d.key-%d", i % 97, i);
+        assert_int_equal(sconf_get_int(frozen, path, &integer, &err), 1);
+        assert_int_equal(*integer, i);
+
+        snprintf(path, sizeof(path), "section-%d.key-%d", i % 97 + 1, i);
+        assert_int_equal(sconf_get_int(frozen, path, &integer, &err), 0);
+    }
+
+    sconf_node_destroy(frozen);
+}
+
+static void test_sconf_index_paths_special_keys(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+
+    /* Key with a dot can not be reached using a path */
+    struct SConfNode *dict = sconf_node_create(SCONF_TYPE_DICT, NULL, &err);
+    assert_non_null(dict);
+    assert_int_equal(sconf_node_dict_insert("x", root, dict, &err), 0);
+    struct SConfNode *node = sconf_node_create(SCONF_TYPE_INT, &(int64_t){1},
+                                               &err);
+    assert_non_null(node);
+    assert_int_equal(sconf_node_dict_insert("a.b", dict, node, &err), 0);
+    assert_int_equal(sconf_set_int(root, "x.a.b", 2, &err), 0);
+
+    /* Dictionary key looking like an array index */
+    assert_int_equal(sconf_set_int(root, "y.[0]", 3, &err), 0);
+    node = sconf_node_create(SCONF_TYPE_INT, &(int64_t){4}, &err);
+    assert_non_null(node);
+    assert_int_equal(sconf_node_dict_insert("[1]", dict, node, &err), 0);
+
+    struct SConfNode *frozen = create_indexed(root);
+    sconf_node_destroy(root);
+
+    const int64_t *integer = NULL;
+    assert_int_equal(sconf_get_int(frozen, "x.a.b", &integer, &err), 1);
+    assert_int_equal(*integer, 2);
+    assert_int_equal(sconf_get_int(frozen, "y.[0]", &integer, &err), 1);
+    assert_int_equal(*integer, 3);
+    assert_int_equal(sconf_get_int(frozen, "x.[1]", &integer, &err), 1);
+    assert_int_equal(*integer, 4);
+
+    sconf_node_destroy(frozen);
+}
+
+static void test_sconf_index_paths_invalid(void **unused)
+{
+    struct SConfErr err = {0};
+
+    assert_int_equal(sconf_index_paths(NULL, &err), -1);
+
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+    assert_int_equal(sconf_set_int(root, "a.b", 1, &err), 0);
+
+    /* Only snapshots can be indexed */
+    assert_int_equal(sconf_index_paths(root, &err), -1);
+
+    struct SConfNode *frozen = create_indexed(root);
+
+    struct SConfNode *a = NULL;
+    assert_int_equal(sconf_get(frozen, "a", &a, &err), 1);
+    assert_int_equal(sconf_index_paths(a, &err), -1);
+
+    /* Indexing twice does nothing */
+    assert_int_equal(sconf_index_paths(frozen, &err), 0);
+
+    /* Empty snapshot */
+    struct SConfNode *empty = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(empty);
+    struct SConfNode *frozen_empty = create_indexed(empty);
+    assert_int_equal(sconf_get(frozen_empty, "a", &a, &err), 0);
+
+    sconf_node_destroy(frozen_empty);
+    sconf_node_destroy(empty);
+    sconf_node_destroy(frozen);
+    sconf_node_destroy(root);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_sconf_index_paths_get),
+        cmocka_unit_test(test_sconf_index_paths_missing),
+        cmocka_unit_test(test_sconf_index_paths_many),
+        cmocka_unit_test(test_sconf_index_paths_special_keys),
+        cmocka_unit_test(test_sconf_index_paths_invalid),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
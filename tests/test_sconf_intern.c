@@ -0,0 +1,185 @@
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <cmocka.h>
+
+#include "sconf.h"
+#include "sconf_private.h"
+
+#define ZONE_A "zone-a.region-1.datacenter.example.com"
+#define ZONE_B "zone-b.region-1.datacenter.example.com"
+#define SHORT_STR "enabled"
+
+#define ENTRIES 100
+
+static struct SConfNode *get_node(struct SConfNode *root, const char *path)
+{
+    struct SConfErr err = {0};
+    struct SConfNode *node = NULL;
+
+    assert_int_equal(sconf_get(root, path, &node, &err), 1);
+
+    return node;
+}
+
+static void set_entries(struct SConfNode *root)
+{
+    struct SConfErr err = {0};
+    char path[64];
+
+    for (int i = 0; i < ENTRIES; i++)
+    {
+        snprintf(path, sizeof(path), "servers.[%d].zone", i);
+        assert_int_equal(sconf_set_str(root, path, i % 2 ? ZONE_B : ZONE_A,
+                                       &err), 0);
+        snprintf(path, sizeof(path), "servers.[%d].state", i);
+        assert_int_equal(sconf_set_str(root, path, SHORT_STR, &err), 0);
+        snprintf(path, sizeof(path), "servers.[%d].port", i);
+        assert_int_equal(sconf_set_int(root, path, 8000 + i, &err), 0);
+    }
+}
+
+static void test_sconf_intern_arena(void **unused)
+{
+    struct SConfErr err = {0};
+    struct SConfNode *root = SCONF_ROOT_ARENA(&err);
+    assert_non_null(root);
+
+    set_entries(root);
+
+    struct SConfNode *a = get_node(root, "servers.[0].zone");
+    struct SConfNode *b = get_node(root, "servers.[1].zone");
+    assert_string_equal(sconf_str(a), ZONE_A);
+    assert_string_equal(sconf_str(b), ZONE_B);
+    assert_ptr_not_equal(sconf_str(a), sconf_str(b));
+    assert_false(sconf_str_equal(a, b));
+
+    /* Every equal string shares one copy */
+    char path[64];
+    for (int i = 2; i < ENTRIES; i++)
+    {
+        snprintf(path, sizeof(path), "servers.[%d].zone", i);
+        struct SConfNode *node = get_node(root, path);
+        assert_ptr_equal(sconf_str(node), sconf_str(i % 2 ? b : a));
+        assert_true(sconf_str_equal(node, i % 2 ? b : a));
+    }
+
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_intern_arena_overwrite(void **unused)
+{
+    struct SConfErr err = {0};
+    struct SConfNode *root = SCONF_ROOT_ARENA(&err);
+    assert_non_null(root);
+
+    set_entries(root);
+
+    /* Overwriting a shared string leaves the other nodes alone */
+    assert_int_equal(sconf_set_str(root, "servers.[0].zone", ZONE_B, &err), 0);
+    assert_int_equal(sconf_set_str(root, "servers.[2].zone", SHORT_STR, &err),
+                     0);
+    assert_int_equal(sconf_set_str(root, "servers.[4].zone",
+                                   ZONE_A ".local", &err), 0);
+
+    assert_ptr_equal(sconf_str(get_node(root, "servers.[0].zone")),
+                     sconf_str(get_node(root, "servers.[1].zone")));
+    assert_string_equal(sconf_str(get_node(root, "servers.[2].zone")),
+                        SHORT_STR);
+    assert_string_equal(sconf_str(get_node(root, "servers.[4].zone")),
+                        ZONE_A ".local");
+    assert_string_equal(sconf_str(get_node(root, "servers.[6].zone")), ZONE_A);
+
+    /* Back to a string that is already interned */
+    assert_int_equal(sconf_set_str(root, "servers.[2].zone", ZONE_A, &err), 0);
+    assert_ptr_equal(sconf_str(get_node(root, "servers.[2].zone")),
+                     sconf_str(get_node(root, "servers.[6].zone")));
+
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_intern_heap(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+
+    assert_int_equal(sconf_set_str(root, "a", ZONE_A, &err), 0);
+    assert_int_equal(sconf_set_str(root, "b", ZONE_A, &err), 0);
+    assert_int_equal(sconf_set_str(root, "c", ZONE_B, &err), 0);
+    assert_int_equal(sconf_set_str(root, "d", SHORT_STR, &err), 0);
+    assert_int_equal(sconf_set_str(root, "e", SHORT_STR, &err), 0);
+
+    /* Heap nodes own their strings, equal strings are compared by value */
+    struct SConfNode *a = get_node(root, "a");
+    struct SConfNode *b = get_node(root, "b");
+    assert_ptr_not_equal(sconf_str(a), sconf_str(b));
+    assert_true(sconf_str_equal(a, b));
+    assert_false(sconf_str_equal(a, get_node(root, "c")));
+    assert_false(sconf_str_equal(a, get_node(root, "d")));
+    assert_true(sconf_str_equal(get_node(root, "d"), get_node(root, "e")));
+
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_intern_freeze(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+
+    set_entries(root);
+
+    struct SConfNode *frozen = sconf_freeze(root, &err);
+    assert_non_null(frozen);
+    sconf_node_destroy(root);
+
+    /* Keys and long strings are stored once in the snapshot */
+    struct SConfNode *first = get_node(frozen, "servers.[0]");
+    char path[64];
+    for (int i = 1; i < ENTRIES; i++)
+    {
+        snprintf(path, sizeof(path), "servers.[%d]", i);
+        struct SConfNode *server = get_node(frozen, path);
+        assert_int_equal(server->frozen.count, first->frozen.count);
+        for (uint32_t j = 0; j < server->frozen.count; j++)
+        {
+            assert_ptr_equal(server->frozen.keys[j].name,
+                             first->frozen.keys[j].name);
+        }
+
+        snprintf(path, sizeof(path), "servers.[%d].zone", i);
+        struct SConfNode *zone = get_node(frozen, path);
+        assert_string_equal(sconf_str(zone), i % 2 ? ZONE_B : ZONE_A);
+        assert_true(sconf_str_equal(zone, get_node(frozen, i % 2 ?
+                                                   "servers.[1].zone" :
+                                                   "servers.[0].zone")));
+        if (i > 1) {
+            assert_ptr_equal(sconf_str(zone),
+                             sconf_str(get_node(frozen, i % 2 ?
+                                                "servers.[1].zone" :
+                                                "servers.[0].zone")));
+        }
+    }
+
+    sconf_node_destroy(frozen);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_sconf_intern_arena),
+        cmocka_unit_test(test_sconf_intern_arena_overwrite),
+        cmocka_unit_test(test_sconf_intern_heap),
+        cmocka_unit_test(test_sconf_intern_freeze),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,259 @@
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <cmocka.h>
+
+#include "sconf.h"
+
+static struct SConfMap map[] = {
+    {
+        .path = "log.level",
+        .type = SCONF_TYPE_INT,
+        .opts_short = 'l',
+        .opts_long = "level",
+        .env = "SCONF_TEST_LEVEL",
+        .default_value = "1",
+    },
+    {
+        .path = "db.host",
+        .type = SCONF_TYPE_STR,
+        .env = "SCONF_TEST_HOST",
+        .default_value = "localhost",
+    },
+    {
+        .path = "db.port",
+        .type = SCONF_TYPE_INT,
+        .default_value = "5432",
+    },
+    {
+        .path = "foo",
+        .type = SCONF_TYPE_STR,
+        .default_value = "default",
+    },
+    {
+        .path = "config",
+        .type = SCONF_TYPE_YAML_FILE,
+        .opts_short = 'c',
+        .default_value = "yaml/test_nested_dicts.yaml",
+    },
+    {0}
+};
+
+static void assert_source(struct SConfLayers *layers, const char *path,
+                          int expected)
+{
+    struct SConfErr err = {0};
+    struct SConfNode *node = NULL;
+    int source = -1;
+
+    assert_int_equal(sconf_layers_get(layers, path, &node, &source, &err), 1);
+    assert_int_equal(source, expected);
+}
+
+static void test_sconf_layers(void **unused)
+{
+    struct SConfErr err = {0};
+
+    assert_int_equal(setenv("SCONF_TEST_LEVEL", "2", 1), 0);
+    assert_int_equal(setenv("SCONF_TEST_HOST", "db.example.com", 1), 0);
+
+    struct SConfLayers *layers = sconf_layers_create(&err);
+    assert_non_null(layers);
+
+    char *argv[] = { "test/test_sconf_layers", "--level", "3", "-c",
+                     "yaml/test_string.yaml" };
+    assert_int_equal(sconf_layers_initialize(layers, map, 5, argv, NULL,
+                                             &err), 0);
+
+    /* Values resolve by precedence */
+    struct SConfNode *root = sconf_layers_root(layers);
+    const int64_t *integer = NULL;
+    const char *str = NULL;
+    assert_int_equal(sconf_get_int(root, "log.level", &integer, &err), 1);
+    assert_int_equal(*integer, 3);
+    assert_int_equal(sconf_get_str(root, "db.host", &str, &err), 1);
+    assert_string_equal(str, "db.example.com");
+    assert_int_equal(sconf_get_int(root, "db.port", &integer, &err), 1);
+    assert_int_equal(*integer, 5432);
+    assert_int_equal(sconf_get_str(root, "foo", &str, &err), 1);
+    assert_string_equal(str, "123");
+    assert_int_equal(sconf_get_str(root, "lol", &str, &err), 1);
+    assert_string_equal(str, "rofl");
+
+    assert_source(layers, "log.level", SCONF_SOURCE_OPTS);
+    assert_source(layers, "config", SCONF_SOURCE_OPTS);
+    assert_source(layers, "db.host", SCONF_SOURCE_ENV);
+    assert_source(layers, "foo", SCONF_SOURCE_FILE);
+    assert_source(layers, "db.port", SCONF_SOURCE_DEFAULTS);
+
+    /* Lower layers keep their own values */
+    struct SConfNode *env = sconf_layers_source(layers, SCONF_SOURCE_ENV);
+    struct SConfNode *defaults = sconf_layers_source(layers,
+                                                     SCONF_SOURCE_DEFAULTS);
+    assert_int_equal(sconf_get_int(env, "log.level", &integer, &err), 1);
+    assert_int_equal(*integer, 2);
+    assert_int_equal(sconf_get_int(defaults, "log.level", &integer, &err), 1);
+    assert_int_equal(*integer, 1);
+
+    /* Default YAML file is not read, the path is set by an option */
+    struct SConfNode *node = NULL;
+    assert_int_equal(sconf_get(root, "a.b.c.d.e", &node, &err), 0);
+    assert_int_equal(sconf_layers_get(layers, "missing", &node, NULL, &err),
+                     0);
+
+    sconf_layers_destroy(layers);
+
+    unsetenv("SCONF_TEST_LEVEL");
+    unsetenv("SCONF_TEST_HOST");
+}
+
+static void test_sconf_layers_flatten(void **unused)
+{
+    struct SConfErr err = {0};
+
+    assert_int_equal(setenv("SCONF_TEST_HOST", "db.example.com", 1), 0);
+
+    struct SConfLayers *layers = sconf_layers_create(&err);
+    assert_non_null(layers);
+
+    char *argv[] = { "test/test_sconf_layers", "-l", "4" };
+    assert_int_equal(sconf_layers_initialize(layers, map, 3, argv, NULL,
+                                             &err), 0);
+
+    struct SConfNode *root = sconf_layers_flatten(layers, &err);
+    assert_non_null(root);
+    sconf_layers_destroy(layers);
+
+    const int64_t *integer = NULL;
+    const char *str = NULL;
+    assert_int_equal(sconf_get_int(root, "log.level", &integer, &err), 1);
+    assert_int_equal(*integer, 4);
+    assert_int_equal(sconf_get_str(root, "db.host", &str, &err), 1);
+    assert_string_equal(str, "db.example.com");
+    assert_int_equal(sconf_get_int(root, "db.port", &integer, &err), 1);
+    assert_int_equal(*integer, 5432);
+    assert_int_equal(sconf_get_str(root, "foo", &str, &err), 1);
+    assert_string_equal(str, "default");
+    assert_int_equal(sconf_get_str(root, "config", &str, &err), 1);
+    assert_string_equal(str, "yaml/test_nested_dicts.yaml");
+    assert_int_equal(sconf_get_str(root, "a.b.c.d.e", &str, &err), 1);
+    assert_string_equal(str, "foo");
+
+    sconf_node_destroy(root);
+
+    unsetenv("SCONF_TEST_HOST");
+}
+
+static int64_t level_eager(int argc, char **argv)
+{
+    struct SConfErr err = {0};
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, &err);
+    assert_non_null(root);
+    assert_int_equal(sconf_initialize(root, map, argc, argv, NULL, &err), 0);
+
+    const int64_t *integer = NULL;
+    assert_int_equal(sconf_get_int(root, "log.level", &integer, &err), 1);
+    int64_t level = *integer;
+
+    sconf_node_destroy(root);
+
+    return level;
+}
+
+static int64_t level_layered(int argc, char **argv)
+{
+    struct SConfErr err = {0};
+    struct SConfLayers *layers = sconf_layers_create(&err);
+    assert_non_null(layers);
+    assert_int_equal(sconf_layers_initialize(layers, map, argc, argv, NULL,
+                                             &err), 0);
+
+    /* The flattened tree resolves the same as the root */
+    struct SConfNode *flat = sconf_layers_flatten(layers, &err);
+    assert_non_null(flat);
+
+    const int64_t *integer = NULL;
+    assert_int_equal(sconf_get_int(sconf_layers_root(layers), "log.level",
+                                   &integer, &err), 1);
+    int64_t level = *integer;
+    assert_int_equal(sconf_get_int(flat, "log.level", &integer, &err), 1);
+    assert_int_equal(*integer, level);
+
+    sconf_node_destroy(flat);
+    sconf_layers_destroy(layers);
+
+    return level;
+}
+
+static void test_sconf_layers_precedence(void **unused)
+{
+    char *opt_first[] = { "test/test_sconf_layers", "--level", "3", "-c",
+                          "yaml/test_layers_level.yaml" };
+    char *file_first[] = { "test/test_sconf_layers", "-c",
+                           "yaml/test_layers_level.yaml", "--level", "3" };
+    char *file_only[] = { "test/test_sconf_layers", "-c",
+                          "yaml/test_layers_level.yaml" };
+
+    /* Same result when each value is only set by one source */
+    assert_int_equal(level_eager(3, file_only), 4);
+    assert_int_equal(level_layered(3, file_only), 4);
+    assert_int_equal(level_eager(1, file_only), 1);
+    assert_int_equal(level_layered(1, file_only), 1);
+
+    /* sconf_initialize reads options and YAML files in command-line order,
+       layers always give options precedence over YAML files */
+    assert_int_equal(level_eager(5, opt_first), 4);
+    assert_int_equal(level_layered(5, opt_first), 3);
+    assert_int_equal(level_eager(5, file_first), 3);
+    assert_int_equal(level_layered(5, file_first), 3);
+
+    /* sconf_initialize lets environment variables override options and YAML
+       files, layers give options precedence over environment variables */
+    assert_int_equal(setenv("SCONF_TEST_LEVEL", "2", 1), 0);
+
+    assert_int_equal(level_eager(3, file_only), 2);
+    assert_int_equal(level_layered(3, file_only), 2);
+    assert_int_equal(level_eager(5, file_first), 2);
+    assert_int_equal(level_layered(5, file_first), 3);
+
+    unsetenv("SCONF_TEST_LEVEL");
+}
+
+static void test_sconf_layers_errors(void **unused)
+{
+    struct SConfErr err = {0};
+
+    assert_null(sconf_layers_root(NULL));
+    assert_null(sconf_layers_flatten(NULL, &err));
+    assert_int_equal(sconf_layers_initialize(NULL, map, 0, NULL, NULL, &err),
+                     -1);
+
+    struct SConfLayers *layers = sconf_layers_create(&err);
+    assert_non_null(layers);
+
+    assert_int_equal(sconf_layers_initialize(layers, NULL, 0, NULL, NULL,
+                                             &err), -1);
+    assert_null(sconf_layers_source(layers, SCONF_SOURCE_MAX));
+    assert_string_equal(sconf_source_to_str(SCONF_SOURCE_ENV),
+                        "environment variable");
+    assert_string_equal(sconf_source_to_str(-1), "unknown");
+
+    sconf_layers_destroy(layers);
+    sconf_layers_destroy(NULL);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_sconf_layers),
+        cmocka_unit_test(test_sconf_layers_flatten),
+        cmocka_unit_test(test_sconf_layers_precedence),
+        cmocka_unit_test(test_sconf_layers_errors),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,339 @@
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <cmocka.h>
+
+#include "sconf.h"
+
+static struct SConfNode *create_dst(void)
+{
+    struct SConfErr err = {0};
+    struct SConfNode *dst = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(dst);
+
+    assert_int_equal(sconf_set_str(dst, "db.host", "primary", &err), 0);
+    assert_int_equal(sconf_set_int(dst, "db.port", 5432, &err), 0);
+    assert_int_equal(sconf_set_int(dst, "listeners.[0].port", 80, &err), 0);
+    assert_int_equal(sconf_set_int(dst, "weights.[0]", 1, &err), 0);
+    assert_int_equal(sconf_set_int(dst, "weights.[1]", 2, &err), 0);
+    assert_int_equal(sconf_set_str(dst, "name", "dst", &err), 0);
+
+    return dst;
+}
+
+static struct SConfNode *create_src(void)
+{
+    struct SConfErr err = {0};
+    struct SConfNode *src = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(src);
+
+    assert_int_equal(sconf_set_int(src, "db.port", 6543, &err), 0);
+    assert_int_equal(sconf_set_str(src, "db.user", "admin", &err), 0);
+    assert_int_equal(sconf_set_int(src, "listeners.[1].port", 443, &err), 0);
+    assert_int_equal(sconf_set_int(src, "weights.[0]", 10, &err), 0);
+    assert_int_equal(sconf_set_int(src, "weights.[1]", 20, &err), 0);
+    assert_int_equal(sconf_set_int(src, "weights.[2]", 30, &err), 0);
+    assert_int_equal(sconf_set_str(src, "name", "src", &err), 0);
+    assert_int_equal(sconf_set_bool(src, "verbose", true, &err), 0);
+
+    return src;
+}
+
+static int count_cb(const unsigned char *name, struct SConfNode *node,
+                    void *user, struct SConfErr *err)
+{
+    (*(int *)user)++;
+    return 0;
+}
+
+static void assert_empty(struct SConfNode *root)
+{
+    struct SConfErr err = {0};
+    int count = 0;
+
+    assert_int_equal(sconf_node_dict_foreach(root, &count_cb, &count, &err),
+                     0);
+    assert_int_equal(count, 0);
+}
+
+static void assert_common(struct SConfNode *dst)
+{
+    struct SConfErr err = {0};
+    const char *str = NULL;
+    const int64_t *integer = NULL;
+    const bool *boolean = NULL;
+
+    /* Only in one of the trees */
+    assert_int_equal(sconf_get_str(dst, "db.host", &str, &err), 1);
+    assert_string_equal(str, "primary");
+    assert_int_equal(sconf_get_str(dst, "db.user", &str, &err), 1);
+    assert_string_equal(str, "admin");
+    assert_int_equal(sconf_get_int(dst, "listeners.[0].port", &integer, &err),
+                     1);
+    assert_int_equal(*integer, 80);
+    assert_int_equal(sconf_get_int(dst, "listeners.[1].port", &integer, &err),
+                     1);
+    assert_int_equal(*integer, 443);
+    assert_int_equal(sconf_get_int(dst, "weights.[2]", &integer, &err), 1);
+    assert_int_equal(*integer, 30);
+    assert_int_equal(sconf_get_bool(dst, "verbose", &boolean, &err), 1);
+    assert_true(*boolean);
+}
+
+static void test_sconf_merge(void **unused)
+{
+    struct SConfErr err = {0};
+    struct SConfNode *dst = create_dst();
+    struct SConfNode *src = create_src();
+
+    struct SConfHandle *handle = sconf_handle_create(dst, "db.port", &err);
+    assert_non_null(handle);
+
+    assert_int_equal(sconf_merge(dst, src, SCONF_MERGE_OVERWRITE, &err), 0);
+    assert_empty(src);
+    sconf_node_destroy(src);
+
+    assert_common(dst);
+
+    const char *str = NULL;
+    const int64_t *integer = NULL;
+    assert_int_equal(sconf_get_str(dst, "name", &str, &err), 1);
+    assert_string_equal(str, "src");
+    assert_int_equal(sconf_get_int(dst, "db.port", &integer, &err), 1);
+    assert_int_equal(*integer, 6543);
+
+    assert_int_equal(sconf_get_int(dst, "weights.[0]", &integer, &err), 1);
+    assert_int_equal(*integer, 10);
+
+    /* Handles see the merged value */
+    assert_int_equal(sconf_handle_int(handle, &integer, &err), 1);
+    assert_int_equal(*integer, 6543);
+
+    sconf_handle_destroy(handle);
+    sconf_node_destroy(dst);
+}
+
+static void test_sconf_merge_keep(void **unused)
+{
+    struct SConfErr err = {0};
+    struct SConfNode *dst = create_dst();
+    struct SConfNode *src = create_src();
+
+    /* Type differs, dst is kept */
+    assert_int_equal(sconf_set_int(src, "db.host", 1, &err), 0);
+
+    assert_int_equal(sconf_merge(dst, src, SCONF_MERGE_KEEP, &err), 0);
+    assert_empty(src);
+    sconf_node_destroy(src);
+
+    assert_common(dst);
+
+    const char *str = NULL;
+    const int64_t *integer = NULL;
+    assert_int_equal(sconf_get_str(dst, "name", &str, &err), 1);
+    assert_string_equal(str, "dst");
+    assert_int_equal(sconf_get_int(dst, "db.port", &integer, &err), 1);
+    assert_int_equal(*integer, 5432);
+    assert_int_equal(sconf_get_int(dst, "weights.[0]", &integer, &err), 1);
+    assert_int_equal(*integer, 1);
+
+    sconf_node_destroy(dst);
+}
+
+static void test_sconf_merge_type_mismatch(void **unused)
+{
+    struct SConfErr err = {0};
+    struct SConfNode *dst = create_dst();
+    struct SConfNode *src = create_src();
+
+    assert_int_equal(sconf_set_str(src, "listeners.[0].name", "http", &err),
+                     0);
+    assert_int_equal(sconf_set_int(dst, "listeners.[0].name", 1, &err), 0);
+
+    /* Nothing is moved */
+    assert_int_equal(sconf_merge(dst, src, SCONF_MERGE_ERROR, &err), -1);
+    assert_string_equal(err.msg, "node 'name' already exist, but types does "
+                        "not match ('string' != 'integer')");
+
+    struct SConfNode *node = NULL;
+    assert_int_equal(sconf_get(dst, "db.user", &node, &err), 0);
+    assert_int_equal(sconf_get(src, "db.user", &node, &err), 1);
+
+    /* Replaced */
+    assert_int_equal(sconf_merge(dst, src, SCONF_MERGE_OVERWRITE, &err), 0);
+    sconf_node_destroy(src);
+
+    assert_common(dst);
+
+    const char *str = NULL;
+    assert_int_equal(sconf_get_str(dst, "listeners.[0].name", &str, &err), 1);
+    assert_string_equal(str, "http");
+
+    sconf_node_destroy(dst);
+}
+
+static struct SConfNode *read_packed(void)
+{
+    struct SConfErr err = {0};
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    assert_int_equal(sconf_yaml_read(root, "yaml/test_packed_array.yaml",
+                                     &err), 0);
+
+    return root;
+}
+
+static void test_sconf_merge_packed(void **unused)
+{
+    struct SConfErr err = {0};
+    struct SConfNode *dst = read_packed();
+    struct SConfNode *src = read_packed();
+
+    /* Packed with the same type */
+    assert_int_equal(sconf_set_int(src, "ports.[1]", 8443, &err), 0);
+    assert_int_equal(sconf_set_bool(src, "flags.[1]", true, &err), 0);
+    assert_int_equal(sconf_merge(dst, src, SCONF_MERGE_ERROR, &err), 0);
+    sconf_node_destroy(src);
+
+    const int64_t *ports = NULL;
+    size_t len = 0;
+    assert_int_equal(sconf_get_int_array(dst, "ports", &ports, &len, &err), 1);
+    assert_int_equal(len, 3);
+    assert_int_equal(ports[0], 80);
+    assert_int_equal(ports[1], 8443);
+    assert_int_equal(ports[2], 8080);
+
+    const uint64_t *flags = NULL;
+    assert_int_equal(sconf_get_bool_array(dst, "flags", &flags, &len, &err),
+                     1);
+    assert_int_equal(flags[0], 0x7);
+
+    /* Longer array, kept values */
+    src = read_packed();
+    assert_int_equal(sconf_set_float(src, "ratios.[1]", 9, &err), 0);
+    assert_int_equal(sconf_set_float(src, "ratios.[2]", 2.5, &err), 0);
+    assert_int_equal(sconf_merge(dst, src, SCONF_MERGE_KEEP, &err), 0);
+    sconf_node_destroy(src);
+
+    const int64_t *integer = NULL;
+    assert_int_equal(sconf_get_int(dst, "ports.[1]", &integer, &err), 1);
+    assert_int_equal(*integer, 8443);
+    const double *fp = NULL;
+    assert_int_equal(sconf_get_float(dst, "ratios.[1]", &fp, &err), 1);
+    assert_float_equal(*fp, 1.5, 0);
+    assert_int_equal(sconf_get_float(dst, "ratios.[2]", &fp, &err), 1);
+    assert_float_equal(*fp, 2.5, 0);
+
+    sconf_node_destroy(dst);
+}
+
+static void test_sconf_merge_large(void **unused)
+{
+    struct SConfErr err = {0};
+    struct SConfNode *dst = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    struct SConfNode *small = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    struct SConfNode *large = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(dst);
+    assert_non_null(small);
+    assert_non_null(large);
+
+    char path[32];
+    for (int i = 0; i < 100; i++)
+    {
+        snprintf(path, sizeof(path), "key%d", i);
+        assert_int_equal(sconf_set_int(dst, path, i, &err), 0);
+        assert_int_equal(sconf_set_int(large, path, i * 2, &err), 0);
+        snprintf(path, sizeof(path), "new%d", i);
+        assert_int_equal(sconf_set_int(large, path, i, &err), 0);
+    }
+    assert_int_equal(sconf_set_int(small, "key42", -1, &err), 0);
+    assert_int_equal(sconf_set_int(small, "new", -2, &err), 0);
+
+    /* Searched in dst */
+    assert_int_equal(sconf_merge(dst, small, SCONF_MERGE_ERROR, &err), 0);
+    sconf_node_destroy(small);
+
+    const int64_t *integer = NULL;
+    assert_int_equal(sconf_get_int(dst, "key42", &integer, &err), 1);
+    assert_int_equal(*integer, -1);
+    assert_int_equal(sconf_get_int(dst, "new", &integer, &err), 1);
+    assert_int_equal(*integer, -2);
+
+    /* Walked together with dst */
+    assert_int_equal(sconf_merge(dst, large, SCONF_MERGE_ERROR, &err), 0);
+    assert_empty(large);
+    sconf_node_destroy(large);
+
+    for (int i = 0; i < 100; i++)
+    {
+        snprintf(path, sizeof(path), "key%d", i);
+        assert_int_equal(sconf_get_int(dst, path, &integer, &err), 1);
+        assert_int_equal(*integer, i * 2);
+        snprintf(path, sizeof(path), "new%d", i);
+        assert_int_equal(sconf_get_int(dst, path, &integer, &err), 1);
+        assert_int_equal(*integer, i);
+    }
+
+    sconf_node_destroy(dst);
+}
+
+static void test_sconf_merge_invalid(void **unused)
+{
+    struct SConfErr err = {0};
+    struct SConfNode *dst = create_dst();
+    struct SConfNode *src = create_src();
+
+    assert_int_equal(sconf_merge(NULL, src, SCONF_MERGE_KEEP, &err), -1);
+    assert_int_equal(sconf_merge(dst, NULL, SCONF_MERGE_KEEP, &err), -1);
+    assert_int_equal(sconf_merge(dst, dst, SCONF_MERGE_KEEP, &err), -1);
+    assert_int_equal(sconf_merge(dst, src, 42, &err), -1);
+
+    struct SConfNode *node = NULL;
+    assert_int_equal(sconf_get(src, "db", &node, &err), 1);
+    assert_int_equal(sconf_merge(dst, node, SCONF_MERGE_KEEP, &err), 0);
+    assert_int_equal(sconf_get(dst, "user", &node, &err), 1);
+
+    struct SConfNode *frozen = sconf_freeze(src, &err);
+    assert_non_null(frozen);
+    assert_int_equal(sconf_merge(dst, frozen, SCONF_MERGE_KEEP, &err), -1);
+    sconf_node_destroy(frozen);
+
+    struct SConfNode *arena = SCONF_ROOT_ARENA(&err);
+    assert_non_null(arena);
+    assert_int_equal(sconf_merge(dst, arena, SCONF_MERGE_KEEP, &err), -1);
+    sconf_node_destroy(arena);
+
+    /* Overlays only hold the values set in them, not the base */
+    struct SConfNode *overlay = sconf_overlay_create(dst, &err);
+    assert_non_null(overlay);
+    assert_int_equal(sconf_merge(overlay, src, SCONF_MERGE_ERROR, &err), -1);
+    assert_int_equal(sconf_merge(overlay, src, SCONF_MERGE_OVERWRITE, &err),
+                     -1);
+    assert_int_equal(sconf_get(src, "name", &node, &err), 1);
+    sconf_node_destroy(overlay);
+
+    assert_int_equal(sconf_get(src, "name", &node, &err), 1);
+    assert_int_equal(sconf_merge(dst, node, SCONF_MERGE_KEEP, &err), -1);
+
+    sconf_node_destroy(src);
+    sconf_node_destroy(dst);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_sconf_merge),
+        cmocka_unit_test(test_sconf_merge_keep),
+        cmocka_unit_test(test_sconf_merge_type_mismatch),
+        cmocka_unit_test(test_sconf_merge_packed),
+        cmocka_unit_test(test_sconf_merge_large),
+        cmocka_unit_test(test_sconf_merge_invalid),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -163,13 +163,96 @@ static void test_sconf_set_array_index_out_of_bounds(void **unused)
     struct SConfNode *array = sconf_node_create(SCONF_TYPE_ARRAY, NULL, &err);
     assert_non_null(array);
 
+    /* Index 4294967295 would need one more element than the maximum */
     char *string = "meh";
-    int r = sconf_set_str(array, "[65536]", string, &err);
+    int r = sconf_set_str(array, "[4294967295]", string, &err);
     assert_int_equal(r, -1);
 
     sconf_node_destroy(array);
 }
 
+static void test_sconf_set_array_large_index(void **unused)
+{
+    struct SConfErr err = {0};
+
+    struct SConfNode *array = sconf_node_create(SCONF_TYPE_ARRAY, NULL, &err);
+    assert_non_null(array);
+
+    /* Arrays used to be limited to 65536 elements */
+    int r = sconf_set_str(array, "[65536]", "meh", &err);
+    assert_int_equal(r, 0);
+
+    const char *string = NULL;
+    r = sconf_get_str(array, "[65536]", &string, &err);
+    assert_int_equal(r, 1);
+    assert_string_equal(string, "meh");
+
+    struct SConfNode *node = NULL;
+    r = sconf_node_array_search(65535, array, &node, &err);
+    assert_int_equal(r, 0);
+    assert_null(node);
+
+    sconf_node_destroy(array);
+}
+
+static void test_sconf_array_append(void **unused)
+{
+    struct SConfErr err = {0};
+
+    struct SConfNode *array = sconf_node_create(SCONF_TYPE_ARRAY, NULL, &err);
+    assert_non_null(array);
+
+    assert_int_equal(sconf_node_array_reserve(array, 1000, &err), 0);
+
+    for (int64_t i = 0; i < 100000; i++)
+    {
+        struct SConfNode *node = sconf_node_create(SCONF_TYPE_INT, &i, &err);
+        assert_non_null(node);
+        assert_int_equal(sconf_node_array_append(array, node, &err), 0);
+    }
+
+    /* Appended after the highest index in use */
+    int64_t integer = -1;
+    struct SConfNode *node = sconf_node_create(SCONF_TYPE_INT, &integer, &err);
+    assert_non_null(node);
+    assert_int_equal(sconf_node_array_insert(100005, array, node, &err), 0);
+
+    node = sconf_node_create(SCONF_TYPE_INT, &integer, &err);
+    assert_non_null(node);
+    assert_int_equal(sconf_node_array_append(array, node, &err), 0);
+
+    const int64_t *value = NULL;
+    assert_int_equal(sconf_get_int(array, "[0]", &value, &err), 1);
+    assert_int_equal(*value, 0);
+    assert_int_equal(sconf_get_int(array, "[99999]", &value, &err), 1);
+    assert_int_equal(*value, 99999);
+    assert_int_equal(sconf_get_int(array, "[100000]", &value, &err), 0);
+    assert_int_equal(sconf_get_int(array, "[100006]", &value, &err), 1);
+    assert_int_equal(*value, -1);
+
+    sconf_node_destroy(array);
+}
+
+static void test_sconf_array_append_and_reserve_invalid(void **unused)
+{
+    struct SConfErr err = {0};
+
+    struct SConfNode *dict = sconf_node_create(SCONF_TYPE_DICT, NULL, &err);
+    assert_non_null(dict);
+
+    int64_t integer = 1;
+    struct SConfNode *node = sconf_node_create(SCONF_TYPE_INT, &integer, &err);
+    assert_non_null(node);
+
+    assert_int_equal(sconf_node_array_append(NULL, node, &err), -1);
+    assert_int_equal(sconf_node_array_append(dict, node, &err), -1);
+    assert_int_equal(sconf_node_array_reserve(NULL, 10, &err), -1);
+    assert_int_equal(sconf_node_array_reserve(dict, 10, &err), -1);
+
+    sconf_node_destroy(node);
+    sconf_node_destroy(dict);
+}
+
 int main(void)
 {
     const struct CMUnitTest tests[] = {
@@ -183,6 +266,9 @@ int main(void)
         cmocka_unit_test(test_sconf_set_with_array_as_root),
         cmocka_unit_test(test_sconf_get_with_array_as_root),
         cmocka_unit_test(test_sconf_set_array_index_out_of_bounds),
+        cmocka_unit_test(test_sconf_set_array_large_index),
+        cmocka_unit_test(test_sconf_array_append),
+        cmocka_unit_test(test_sconf_array_append_and_reserve_invalid),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
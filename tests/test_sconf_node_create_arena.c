@@ -0,0 +1,134 @@
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <cmocka.h>
+
+#include "sconf.h"
+
+static void test_sconf_arena_set_and_get(void **unused)
+{
+    struct SConfErr err = {0};
+
+    struct SConfNode *root = SCONF_ROOT_ARENA(&err);
+    assert_non_null(root);
+
+    int r = sconf_set_str(root, "a.b.c", "foobar", &err);
+    assert_int_equal(r, 0);
+
+    r = sconf_set_int(root, "a.list.[3]", 42, &err);
+    assert_int_equal(r, 0);
+
+    r = sconf_set_str(root, "a.b.c", "a somewhat longer string", &err);
+    assert_int_equal(r, 0);
+
+    const char *string = NULL;
+    r = sconf_get_str(root, "a.b.c", &string, &err);
+    assert_int_equal(r, 1);
+    assert_string_equal(string, "a somewhat longer string");
+
+    const int64_t *integer = NULL;
+    r = sconf_get_int(root, "a.list.[3]", &integer, &err);
+    assert_int_equal(r, 1);
+    assert_int_equal(*integer, 42);
+
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_arena_many_nodes(void **unused)
+{
+    struct SConfErr err = {0};
+
+    struct SConfNode *root = SCONF_ROOT_ARENA(&err);
+    assert_non_null(root);
+
+    char path[64];
+    for (int i = 0; i < 5000; i++)
+    {
+        snprintf(path, sizeof(path), "section-%d.key-%d", i % 50, i);
+        int r = sconf_set_int(root, path, i, &err);
+        assert_int_equal(r, 0);
+    }
+
+    for (int i = 0; i < 5000; i++)
+    {
+        const int64_t *integer = NULL;
+        snprintf(path, sizeof(path), "section-%d.key-%d", i % 50, i);
+        int r = sconf_get_int(root, path, &integer, &err);
+        assert_int_equal(r, 1);
+        assert_int_equal(*integer, i);
+    }
+
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_arena_yaml_read(void **unused)
+{
+    struct SConfErr err = {0};
+
+    struct SConfNode *root = SCONF_ROOT_ARENA(&err);
+    assert_non_null(root);
+
+    int r = sconf_yaml_read(root, "yaml/test_nested_dicts.yaml", &err);
+    assert_int_equal(r, 0);
+
+    const char *string = NULL;
+    r = sconf_get_str(root, "a.b.c.d.e", &string, &err);
+    assert_int_equal(r, 1);
+    assert_string_equal(string, "foo");
+
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_arena_insert_heap_node(void **unused)
+{
+    struct SConfErr err = {0};
+
+    struct SConfNode *root = SCONF_ROOT_ARENA(&err);
+    assert_non_null(root);
+
+    int64_t integer = 1;
+    struct SConfNode *node = sconf_node_create(SCONF_TYPE_INT, &integer, &err);
+    assert_non_null(node);
+
+    int r = sconf_node_dict_insert("heap", root, node, &err);
+    assert_int_equal(r, -1);
+
+    sconf_node_destroy(node);
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_arena_array_root(void **unused)
+{
+    struct SConfErr err = {0};
+
+    struct SConfNode *array = sconf_node_create_arena(SCONF_TYPE_ARRAY, NULL,
+                                                      &err);
+    assert_non_null(array);
+
+    int r = sconf_set_str(array, "[10]", "meh", &err);
+    assert_int_equal(r, 0);
+
+    const char *string = NULL;
+    r = sconf_get_str(array, "[10]", &string, &err);
+    assert_int_equal(r, 1);
+    assert_string_equal(string, "meh");
+
+    sconf_node_destroy(array);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_sconf_arena_set_and_get),
+        cmocka_unit_test(test_sconf_arena_many_nodes),
+        cmocka_unit_test(test_sconf_arena_yaml_read),
+        cmocka_unit_test(test_sconf_arena_insert_heap_node),
+        cmocka_unit_test(test_sconf_arena_array_root),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
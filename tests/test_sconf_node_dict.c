@@ -4,10 +4,87 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 
 #include <cmocka.h>
 
 #include "sconf.h"
+#include "sconf_private.h"
+
+/* Keys in sorted order, inserted in a different order. "a" is a prefix of
+   "ab" and "abc", which must still be ordered first. */
+static const char *sorted_keys[] = {
+    "a", "ab", "abc", "b", "ba", "c", "d", "e", "f", "g", "h", "i", "j"
+};
+static const int insert_order[] = { 7, 1, 12, 3, 0, 9, 5, 11, 2, 8, 4, 10, 6 };
+
+#define KEYS (sizeof(sorted_keys) / sizeof(sorted_keys[0]))
+
+struct KeyOrder {
+    const char **keys;
+    size_t count;
+};
+
+static int key_order_cb(const unsigned char *name, struct SConfNode *node,
+                        void *user, struct SConfErr *err)
+{
+    struct KeyOrder *order = (struct KeyOrder *)user;
+    order->keys[order->count++] = (const char *)name;
+
+    return 0;
+}
+
+/* Insert the first n keys in insert_order, and check that lookups and
+   iteration order are the same for small dictionaries and ARTs */
+static void check_dict_with_keys(struct SConfNode *root, size_t n)
+{
+    struct SConfErr err = {0};
+
+    for (size_t i = 0; i < n; i++)
+    {
+        /* The keys contain no dots, so they are paths as well */
+        assert_int_equal(sconf_set_int(root, sorted_keys[insert_order[i]],
+                                       insert_order[i], &err), 0);
+    }
+
+    for (size_t i = 0; i < KEYS; i++)
+    {
+        struct SConfNode *node = NULL;
+        assert_int_equal(sconf_node_dict_search(sorted_keys[i], root, &node,
+                                                &err), 0);
+
+        bool inserted = false;
+        for (size_t j = 0; j < n; j++)
+        {
+            inserted |= (size_t)insert_order[j] == i;
+        }
+
+        if (inserted) {
+            assert_non_null(node);
+            assert_int_equal(sconf_int(node), i);
+        }
+        else {
+            assert_null(node);
+        }
+    }
+
+    const char *keys[KEYS];
+    struct KeyOrder order = { keys, 0 };
+    assert_int_equal(sconf_node_dict_foreach(root, key_order_cb, &order, &err),
+                     0);
+    assert_int_equal(order.count, n);
+
+    size_t next = 0;
+    for (size_t i = 0; i < KEYS; i++)
+    {
+        for (size_t j = 0; j < n; j++)
+        {
+            if ((size_t)insert_order[j] == i) {
+                assert_string_equal(keys[next++], sorted_keys[i]);
+            }
+        }
+    }
+}
 
 static void test_sconf_dict_insert_and_search_successful(void **unused)
 {
@@ -135,6 +212,96 @@ static void test_sconf_dict_search_parent_type_not_dict(void **unused)
     sconf_node_destroy(parent);
 }
 
+static void test_sconf_dict_small_and_tree(void **unused)
+{
+    for (size_t n = 1; n <= KEYS; n++)
+    {
+        struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL,
+                                                   NULL);
+        assert_non_null(root);
+
+        check_dict_with_keys(root, n);
+
+        /* Small dictionaries move to an ART when they grow */
+        assert_int_equal(!!(root->flags & SCONF_NODE_FLAG_DICT_TREE), n > 8);
+
+        sconf_node_destroy(root);
+    }
+}
+
+static void test_sconf_dict_small_and_tree_arena(void **unused)
+{
+    for (size_t n = 1; n <= KEYS; n++)
+    {
+        struct SConfErr err = {0};
+        struct SConfNode *root = SCONF_ROOT_ARENA(&err);
+        assert_non_null(root);
+
+        check_dict_with_keys(root, n);
+
+        sconf_node_destroy(root);
+    }
+}
+
+static void test_sconf_dict_insert_duplicate(void **unused)
+{
+    for (int keys = 1; keys <= 12; keys += 11)
+    {
+        struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL,
+                                                   NULL);
+        assert_non_null(root);
+
+        struct SConfErr err = {0};
+        for (int i = 0; i < keys; i++)
+        {
+            char name[8];
+            snprintf(name, sizeof(name), "k%d", i);
+            assert_int_equal(sconf_set_int(root, name, i, &err), 0);
+        }
+
+        struct SConfNode *node = sconf_node_create(SCONF_TYPE_STR, "x", NULL);
+        assert_non_null(node);
+
+        assert_int_equal(sconf_node_dict_insert("k0", root, node, &err), -1);
+        sconf_node_destroy(node);
+
+        /* The node already in the dictionary is left alone */
+        const int64_t *integer = NULL;
+        assert_int_equal(sconf_get_int(root, "k0", &integer, &err), 1);
+        assert_int_equal(*integer, 0);
+
+        sconf_node_destroy(root);
+    }
+}
+
+static void test_sconf_dict_small_freeze(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+    assert_int_equal(sconf_set_int(root, "small.b", 2, &err), 0);
+    assert_int_equal(sconf_set_int(root, "small.a", 1, &err), 0);
+    for (int i = 0; i < 20; i++)
+    {
+        char path[16];
+        snprintf(path, sizeof(path), "tree.k%d", i);
+        assert_int_equal(sconf_set_int(root, path, i, &err), 0);
+    }
+
+    struct SConfNode *frozen = sconf_freeze(root, &err);
+    assert_non_null(frozen);
+    sconf_node_destroy(root);
+
+    const int64_t *integer = NULL;
+    assert_int_equal(sconf_get_int(frozen, "small.a", &integer, &err), 1);
+    assert_int_equal(*integer, 1);
+    assert_int_equal(sconf_get_int(frozen, "tree.k17", &integer, &err), 1);
+    assert_int_equal(*integer, 17);
+
+    sconf_node_destroy(frozen);
+}
+
 int main(void)
 {
     const struct CMUnitTest tests[] = {
@@ -147,6 +314,10 @@ int main(void)
         cmocka_unit_test(test_sconf_dict_search_name_missing),
         cmocka_unit_test(test_sconf_dict_search_parent_missing),
         cmocka_unit_test(test_sconf_dict_search_parent_type_not_dict),
+        cmocka_unit_test(test_sconf_dict_small_and_tree),
+        cmocka_unit_test(test_sconf_dict_small_and_tree_arena),
+        cmocka_unit_test(test_sconf_dict_insert_duplicate),
+        cmocka_unit_test(test_sconf_dict_small_freeze),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
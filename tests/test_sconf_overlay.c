@@ -0,0 +1,206 @@
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmocka.h>
+
+#include "sconf.h"
+
+static struct SConfNode *create_base(void)
+{
+    struct SConfErr err = {0};
+    struct SConfNode *base = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(base);
+
+    assert_int_equal(sconf_set_str(base, "db.host", "primary", &err), 0);
+    assert_int_equal(sconf_set_int(base, "db.port", 5432, &err), 0);
+    assert_int_equal(sconf_set_int(base, "upstream.timeout", 30, &err), 0);
+    assert_int_equal(sconf_set_int(base, "listeners.[0].port", 80, &err), 0);
+    assert_int_equal(sconf_set_int(base, "listeners.[1].port", 443, &err), 0);
+
+    return base;
+}
+
+static void assert_overlay(struct SConfNode *overlay)
+{
+    struct SConfErr err = {0};
+    const char *str = NULL;
+    const int64_t *integer = NULL;
+
+    /* Values set in the overlay hide the ones in the base */
+    assert_int_equal(sconf_get_int(overlay, "upstream.timeout", &integer,
+                                   &err), 1);
+    assert_int_equal(*integer, 5);
+    assert_int_equal(sconf_get_int(overlay, "listeners.[1].port", &integer,
+                                   &err), 1);
+    assert_int_equal(*integer, 8443);
+
+    /* Others come from the base, also next to overridden values */
+    assert_int_equal(sconf_get_str(overlay, "db.host", &str, &err), 1);
+    assert_string_equal(str, "primary");
+    assert_int_equal(sconf_get_int(overlay, "listeners.[0].port", &integer,
+                                   &err), 1);
+    assert_int_equal(*integer, 80);
+
+    /* Only in the overlay */
+    assert_int_equal(sconf_get_str(overlay, "tenant", &str, &err), 1);
+    assert_string_equal(str, "acme");
+
+    struct SConfNode *node = NULL;
+    assert_int_equal(sconf_get(overlay, "missing", &node, &err), 0);
+
+    const char *paths[] = {"db.port", "upstream.timeout", "tenant", "x.y"};
+    struct SConfGetResult results[4];
+    assert_int_equal(sconf_get_many(overlay, paths, 4, results, &err), 0);
+    assert_int_equal(sconf_int(results[0].node), 5432);
+    assert_int_equal(sconf_int(results[1].node), 5);
+    assert_string_equal(sconf_str(results[2].node), "acme");
+    assert_false(results[3].found);
+}
+
+static void set_overrides(struct SConfNode *overlay)
+{
+    struct SConfErr err = {0};
+
+    assert_int_equal(sconf_set_int(overlay, "upstream.timeout", 5, &err), 0);
+    assert_int_equal(sconf_set_int(overlay, "listeners.[1].port", 8443, &err),
+                     0);
+    assert_int_equal(sconf_set_str(overlay, "tenant", "acme", &err), 0);
+}
+
+static void test_sconf_overlay(void **unused)
+{
+    struct SConfErr err = {0};
+    struct SConfNode *base = create_base();
+
+    struct SConfNode *overlay = sconf_overlay_create(base, &err);
+    assert_non_null(overlay);
+
+    set_overrides(overlay);
+    assert_overlay(overlay);
+
+    /* Base is not changed */
+    const int64_t *integer = NULL;
+    struct SConfNode *node = NULL;
+    assert_int_equal(sconf_get_int(base, "upstream.timeout", &integer, &err),
+                     1);
+    assert_int_equal(*integer, 30);
+    assert_int_equal(sconf_get_int(base, "listeners.[1].port", &integer,
+                                   &err), 1);
+    assert_int_equal(*integer, 443);
+    assert_int_equal(sconf_get(base, "tenant", &node, &err), 0);
+
+    /* Changes to the base show through */
+    assert_int_equal(sconf_set_int(base, "db.port", 6543, &err), 0);
+    assert_int_equal(sconf_get_int(overlay, "db.port", &integer, &err), 1);
+    assert_int_equal(*integer, 6543);
+
+    sconf_node_destroy(overlay);
+    sconf_node_destroy(base);
+}
+
+static void test_sconf_overlay_frozen(void **unused)
+{
+    struct SConfErr err = {0};
+    struct SConfNode *base = create_base();
+
+    struct SConfNode *frozen = sconf_freeze(base, &err);
+    assert_non_null(frozen);
+    sconf_node_destroy(base);
+    assert_int_equal(sconf_index_paths(frozen, &err), 0);
+
+    struct SConfNode *overlay = sconf_overlay_create(frozen, &err);
+    assert_non_null(overlay);
+    set_overrides(overlay);
+    assert_overlay(overlay);
+
+    /* Overlay on an overlay */
+    struct SConfNode *nested = sconf_overlay_create(overlay, &err);
+    assert_non_null(nested);
+    assert_overlay(nested);
+    assert_int_equal(sconf_set_str(nested, "db.host", "replica", &err), 0);
+
+    const char *str = NULL;
+    assert_int_equal(sconf_get_str(nested, "db.host", &str, &err), 1);
+    assert_string_equal(str, "replica");
+    assert_int_equal(sconf_get_str(overlay, "db.host", &str, &err), 1);
+    assert_string_equal(str, "primary");
+
+    sconf_node_destroy(nested);
+    sconf_node_destroy(overlay);
+    sconf_node_destroy(frozen);
+}
+
+static void test_sconf_overlay_handle(void **unused)
+{
+    struct SConfErr err = {0};
+    struct SConfNode *base = create_base();
+
+    struct SConfNode *overlay = sconf_overlay_create(base, &err);
+    assert_non_null(overlay);
+
+    struct SConfHandle *handle = sconf_handle_create(overlay,
+                                                     "upstream.timeout", &err);
+    assert_non_null(handle);
+
+    const int64_t *integer = NULL;
+    assert_int_equal(sconf_handle_int(handle, &integer, &err), 1);
+    assert_int_equal(*integer, 30);
+
+    /* Setting the value in the overlay hides the cached base value */
+    assert_int_equal(sconf_set_int(overlay, "upstream.timeout", 5, &err), 0);
+    assert_int_equal(sconf_handle_int(handle, &integer, &err), 1);
+    assert_int_equal(*integer, 5);
+
+    sconf_handle_destroy(handle);
+    sconf_node_destroy(overlay);
+    sconf_node_destroy(base);
+}
+
+static void test_sconf_overlay_errors(void **unused)
+{
+    struct SConfErr err = {0};
+    struct SConfNode *base = create_base();
+
+    struct SConfNode *overlay = sconf_overlay_create(base, &err);
+    assert_non_null(overlay);
+
+    /* Same type as in the base */
+    assert_int_equal(sconf_set_str(overlay, "db.port", "x", &err), -1);
+    assert_int_equal(sconf_set_int(overlay, "db.host.x", 1, &err), -1);
+
+    /* Atomic updates only of values set in the overlay */
+    assert_int_equal(sconf_set_int_atomic(overlay, "db.port", 1, &err), -1);
+    const int64_t *integer = NULL;
+    assert_int_equal(sconf_get_int(base, "db.port", &integer, &err), 1);
+    assert_int_equal(*integer, 5432);
+
+    assert_int_equal(sconf_set_int(overlay, "db.port", 1, &err), 0);
+    assert_int_equal(sconf_set_int_atomic(overlay, "db.port", 2, &err), 0);
+    assert_int_equal(sconf_get_int(overlay, "db.port", &integer, &err), 1);
+    assert_int_equal(*integer, 2);
+
+    assert_null(sconf_freeze(overlay, &err));
+
+    assert_null(sconf_overlay_create(NULL, &err));
+    struct SConfNode *node = NULL;
+    assert_int_equal(sconf_get(base, "db.port", &node, &err), 1);
+    assert_null(sconf_overlay_create(node, &err));
+
+    sconf_node_destroy(overlay);
+    sconf_node_destroy(base);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_sconf_overlay),
+        cmocka_unit_test(test_sconf_overlay_frozen),
+        cmocka_unit_test(test_sconf_overlay_handle),
+        cmocka_unit_test(test_sconf_overlay_errors),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,390 @@
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#include <cmocka.h>
+
+#include "sconf.h"
+#include "sconf_private.h"
+
+static int count_cb(uint32_t index, struct SConfNode *node, void *user,
+                    struct SConfErr *err)
+{
+    (*(uint32_t *)user)++;
+
+    return 0;
+}
+
+static struct SConfNode *read_yaml(void)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+    assert_int_equal(sconf_yaml_read(root, "yaml/test_packed_array.yaml",
+                                     &err), 0);
+
+    return root;
+}
+
+static void test_sconf_packed_array(void **unused)
+{
+    struct SConfNode *root = read_yaml();
+    struct SConfErr err = {0};
+
+    const int64_t *ports = NULL;
+    size_t len = 0;
+    assert_int_equal(sconf_get_int_array(root, "ports", &ports, &len, &err), 1);
+    assert_int_equal(len, 3);
+    assert_int_equal(ports[0], 80);
+    assert_int_equal(ports[1], 443);
+    assert_int_equal(ports[2], 8080);
+
+    const double *ratios = NULL;
+    assert_int_equal(sconf_get_float_array(root, "ratios", &ratios, &len,
+                                           &err), 1);
+    assert_int_equal(len, 2);
+    assert_float_equal(ratios[0], 0.5, 0.0);
+    assert_float_equal(ratios[1], 1.5, 0.0);
+
+    const uint64_t *flags = NULL;
+    assert_int_equal(sconf_get_bool_array(root, "flags", &flags, &len, &err),
+                     1);
+    assert_int_equal(len, 3);
+    assert_int_equal(flags[0], 0x5);
+
+    /* Empty arrays can be read as any packed type */
+    assert_int_equal(sconf_get_int_array(root, "empty", &ports, &len, &err),
+                     1);
+    assert_null(ports);
+    assert_int_equal(len, 0);
+
+    /* Wrong packed type, or not an array */
+    assert_int_equal(sconf_get_float_array(root, "ports", &ratios, &len,
+                                           &err), -1);
+    assert_int_equal(sconf_get_int_array(root, "ports.[0]", &ports, &len,
+                                         &err), -1);
+    assert_int_equal(sconf_get_int_array(root, "nope", &ports, &len, &err), 0);
+
+    /* Elements of different types are stored as nodes */
+    assert_int_equal(sconf_get_int_array(root, "mixed", &ports, &len, &err),
+                     -1);
+
+    const int64_t *integer = NULL;
+    const double *fp = NULL;
+    assert_int_equal(sconf_get_int(root, "mixed.[0]", &integer, &err), 1);
+    assert_int_equal(*integer, 1);
+    assert_int_equal(sconf_get_float(root, "mixed.[1]", &fp, &err), 1);
+    assert_float_equal(*fp, 2.5, 0.0);
+
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_packed_array_nodes(void **unused)
+{
+    struct SConfNode *root = read_yaml();
+    struct SConfErr err = {0};
+
+    /* Packed values can still be accessed as nodes */
+    const int64_t *integer = NULL;
+    assert_int_equal(sconf_get_int(root, "ports.[1]", &integer, &err), 1);
+    assert_int_equal(*integer, 443);
+    assert_int_equal(sconf_get_int(root, "ports.[3]", &integer, &err), 0);
+
+    const bool *boolean = NULL;
+    assert_int_equal(sconf_get_bool(root, "flags.[1]", &boolean, &err), 1);
+    assert_false(*boolean);
+
+    struct SConfNode *ports = NULL;
+    assert_int_equal(sconf_get(root, "ports", &ports, &err), 1);
+
+    uint32_t count = 0;
+    assert_int_equal(sconf_node_array_foreach(ports, count_cb, &count, &err),
+                     0);
+    assert_int_equal(count, 3);
+
+    struct SConfNode *node = NULL;
+    uint32_t next = 0;
+    count = 0;
+    while (sconf_node_array_next(ports, &node, &next, &err) == 1)
+    {
+        assert_int_equal(node->type, SCONF_TYPE_INT);
+        count++;
+    }
+    assert_int_equal(count, 3);
+
+    node = NULL;
+    assert_int_equal(sconf_node_array_search(2, ports, &node, &err), 0);
+    assert_non_null(node);
+    assert_int_equal(node->integer, 8080);
+
+    /* Atomic updates are not supported for packed values */
+    assert_int_equal(sconf_set_int_atomic(root, "ports.[0]", 1, &err), -1);
+
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_packed_array_set(void **unused)
+{
+    struct SConfNode *root = read_yaml();
+    struct SConfErr err = {0};
+
+    const int64_t *ports = NULL;
+    size_t len = 0;
+    assert_int_equal(sconf_get_int_array(root, "ports", &ports, &len, &err), 1);
+
+    /* Replacing a value keeps the array packed */
+    assert_int_equal(sconf_set_int(root, "ports.[1]", 8443, &err), 0);
+    assert_int_equal(ports[1], 8443);
+
+    const int64_t *integer = NULL;
+    assert_int_equal(sconf_get_int(root, "ports.[1]", &integer, &err), 1);
+    assert_int_equal(*integer, 8443);
+
+    assert_int_equal(sconf_set_bool(root, "flags.[0]", false, &err), 0);
+    const uint64_t *flags = NULL;
+    assert_int_equal(sconf_get_bool_array(root, "flags", &flags, &len, &err),
+                     1);
+    assert_int_equal(flags[0], 0x4);
+
+    /* Changing the type of a value is still an error */
+    assert_int_equal(sconf_set_str(root, "ports.[0]", "http", &err), -1);
+
+    /* Adding a value turns it into an array of nodes */
+    assert_int_equal(sconf_set_str(root, "ports.[3]", "http", &err), 0);
+    assert_int_equal(sconf_get_int_array(root, "ports", &ports, &len, &err),
+                     -1);
+
+    assert_int_equal(sconf_get_int(root, "ports.[0]", &integer, &err), 1);
+    assert_int_equal(*integer, 80);
+    assert_int_equal(sconf_get_int(root, "ports.[1]", &integer, &err), 1);
+    assert_int_equal(*integer, 8443);
+    assert_int_equal(sconf_get_int(root, "ports.[2]", &integer, &err), 1);
+    assert_int_equal(*integer, 8080);
+
+    const char *str = NULL;
+    assert_int_equal(sconf_get_str(root, "ports.[3]", &str, &err), 1);
+    assert_string_equal(str, "http");
+
+    /* Inserting a node does the same */
+    struct SConfNode *ratios = NULL;
+    assert_int_equal(sconf_get(root, "ratios", &ratios, &err), 1);
+
+    double fp = 2.5;
+    struct SConfNode *node = sconf_node_create(SCONF_TYPE_FLOAT, &fp, &err);
+    assert_non_null(node);
+    assert_int_equal(sconf_node_array_insert(2, ratios, node, &err), 0);
+
+    const double *value = NULL;
+    assert_int_equal(sconf_get_float(root, "ratios.[0]", &value, &err), 1);
+    assert_float_equal(*value, 0.5, 0.0);
+    assert_int_equal(sconf_get_float(root, "ratios.[2]", &value, &err), 1);
+    assert_float_equal(*value, 2.5, 0.0);
+
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_packed_array_stable(void **unused)
+{
+    struct SConfNode *root = read_yaml();
+    struct SConfErr err = {0};
+
+    const int64_t *ports = NULL;
+    size_t len = 0;
+
+    /* Nodes handed out for packed values outlive appends */
+    struct SConfNode *first = NULL;
+    assert_int_equal(sconf_get(root, "ports.[0]", &first, &err), 1);
+    const int64_t *last = NULL;
+    assert_int_equal(sconf_get_int(root, "ports.[2]", &last, &err), 1);
+
+    struct SConfNode *src = sconf_node_create(SCONF_TYPE_DICT, NULL, &err);
+    assert_non_null(src);
+    const char *yaml = "ports: [81, 443, 8081, 9]";
+    assert_int_equal(sconf_yaml_read_buffer(src, yaml, strlen(yaml), &err),
+                     0);
+    assert_int_equal(sconf_merge(root, src, SCONF_MERGE_OVERWRITE, &err), 0);
+    sconf_node_destroy(src);
+
+    assert_int_equal(sconf_get_int_array(root, "ports", &ports, &len, &err), 1);
+    assert_int_equal(len, 4);
+    assert_int_equal(sconf_int(first), 81);
+    assert_int_equal(*last, 8081);
+
+    yaml = "ports: [82, 443, 8082, 9, 10, 11, 12, 13, 14]";
+    assert_int_equal(sconf_yaml_read_buffer(root, yaml, strlen(yaml), &err),
+                     0);
+
+    assert_int_equal(sconf_get_int_array(root, "ports", &ports, &len, &err), 1);
+    assert_int_equal(len, 9);
+    assert_int_equal(sconf_int(first), 82);
+    assert_int_equal(*last, 8082);
+
+    /* A value of another type turns the nodes into entries of the array */
+    assert_int_equal(sconf_set_str(root, "ports.[9]", "http", &err), 0);
+    assert_int_equal(sconf_get_int_array(root, "ports", &ports, &len, &err),
+                     -1);
+    assert_int_equal(sconf_int(first), 82);
+    assert_int_equal(*last, 8082);
+
+    struct SConfNode *node = NULL;
+    assert_int_equal(sconf_get(root, "ports.[0]", &node, &err), 1);
+    assert_ptr_equal(node, first);
+
+    assert_int_equal(sconf_set_int(root, "ports.[0]", 83, &err), 0);
+    assert_int_equal(sconf_int(first), 83);
+
+    /* Appending to a packed array through a path does the same */
+    struct SConfNode *ratio = NULL;
+    assert_int_equal(sconf_get(root, "ratios.[1]", &ratio, &err), 1);
+    assert_int_equal(sconf_set_float(root, "ratios.[2]", 2.5, &err), 0);
+    assert_float_equal(sconf_float(ratio), 1.5, 0.0);
+
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_packed_array_bits(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+    struct SConfNode *array = sconf_node_create_and_insert("bits",
+                                                           SCONF_TYPE_ARRAY,
+                                                           root, 0, NULL, &err);
+    assert_non_null(array);
+
+    for (uint32_t i = 0; i < 100; i++)
+    {
+        bool boolean = i % 3 == 0;
+        assert_int_equal(sconf_node_array_set_value(array, i, SCONF_TYPE_BOOL,
+                                                    &boolean, &err), 0);
+    }
+
+    const uint64_t *bits = NULL;
+    size_t len = 0;
+    assert_int_equal(sconf_get_bool_array(root, "bits", &bits, &len, &err), 1);
+    assert_int_equal(len, 100);
+
+    for (uint32_t i = 0; i < 100; i++)
+    {
+        assert_int_equal((bits[i / 64] >> (i % 64)) & 1, i % 3 == 0);
+    }
+
+    const bool *boolean = NULL;
+    assert_int_equal(sconf_get_bool(root, "bits.[99]", &boolean, &err), 1);
+    assert_true(*boolean);
+    assert_int_equal(sconf_get_bool(root, "bits.[98]", &boolean, &err), 1);
+    assert_false(*boolean);
+
+    sconf_node_destroy(root);
+}
+
+static void *read_ports(void *user)
+{
+    struct SConfNode *root = (struct SConfNode *)user;
+    const int64_t *integer = NULL;
+
+    if (sconf_get_int(root, "ports.[2]", &integer, NULL) != 1 ||
+            *integer != 8080) {
+        return (void *)1;
+    }
+
+    return NULL;
+}
+
+static void test_sconf_packed_array_concurrent(void **unused)
+{
+    struct SConfNode *root = read_yaml();
+
+    /* Readers race to create the view of the packed values */
+    pthread_t threads[4];
+    for (int i = 0; i < 4; i++)
+    {
+        assert_int_equal(pthread_create(&threads[i], NULL, read_ports, root),
+                         0);
+    }
+
+    for (int i = 0; i < 4; i++)
+    {
+        void *failed = NULL;
+        pthread_join(threads[i], &failed);
+        assert_null(failed);
+    }
+
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_packed_array_freeze(void **unused)
+{
+    struct SConfNode *root = read_yaml();
+    struct SConfErr err = {0};
+
+    struct SConfNode *frozen = sconf_freeze(root, &err);
+    assert_non_null(frozen);
+    sconf_node_destroy(root);
+
+    const int64_t *ports = NULL;
+    size_t len = 0;
+    assert_int_equal(sconf_get_int_array(frozen, "ports", &ports, &len, &err),
+                     1);
+    assert_int_equal(len, 3);
+    assert_int_equal(ports[2], 8080);
+
+    assert_int_equal(sconf_index_paths(frozen, &err), 0);
+
+    const int64_t *integer = NULL;
+    assert_int_equal(sconf_get_int(frozen, "ports.[2]", &integer, &err), 1);
+    assert_int_equal(*integer, 8080);
+
+    const uint64_t *flags = NULL;
+    assert_int_equal(sconf_get_bool_array(frozen, "flags", &flags, &len, &err),
+                     1);
+    assert_int_equal(flags[0], 0x5);
+
+    assert_int_equal(sconf_set_int(frozen, "ports.[0]", 1, &err), -1);
+
+    sconf_node_destroy(frozen);
+}
+
+static void test_sconf_packed_array_arena(void **unused)
+{
+    struct SConfErr err = {0};
+    struct SConfNode *root = SCONF_ROOT_ARENA(&err);
+    assert_non_null(root);
+
+    assert_int_equal(sconf_yaml_read(root, "yaml/test_packed_array.yaml",
+                                     &err), 0);
+
+    /* Arrays in arena-backed trees are not packed */
+    const int64_t *ports = NULL;
+    size_t len = 0;
+    assert_int_equal(sconf_get_int_array(root, "ports", &ports, &len, &err),
+                     -1);
+
+    const int64_t *integer = NULL;
+    assert_int_equal(sconf_get_int(root, "ports.[1]", &integer, &err), 1);
+    assert_int_equal(*integer, 443);
+
+    sconf_node_destroy(root);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_sconf_packed_array),
+        cmocka_unit_test(test_sconf_packed_array_nodes),
+        cmocka_unit_test(test_sconf_packed_array_set),
+        cmocka_unit_test(test_sconf_packed_array_stable),
+        cmocka_unit_test(test_sconf_packed_array_bits),
+        cmocka_unit_test(test_sconf_packed_array_concurrent),
+        cmocka_unit_test(test_sconf_packed_array_freeze),
+        cmocka_unit_test(test_sconf_packed_array_arena),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
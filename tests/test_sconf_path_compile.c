@@ -0,0 +1,210 @@
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <cmocka.h>
+
+#include "sconf.h"
+#include "sconf_private.h"
+
+static void test_sconf_path_compile_set_and_get(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+
+    struct SConfPath *str = sconf_path_compile("a.b.c", &err);
+    assert_non_null(str);
+    struct SConfPath *integer = sconf_path_compile("a.[0].[1]", &err);
+    assert_non_null(integer);
+    struct SConfPath *boolean = sconf_path_compile("b", &err);
+    assert_non_null(boolean);
+    struct SConfPath *fp = sconf_path_compile("c.d", &err);
+    assert_non_null(fp);
+
+    assert_int_equal(sconf_set_str_p(root, str, "foop", &err), 0);
+    assert_int_equal(sconf_set_int_p(root, integer, 1814, &err), -1);
+    assert_int_equal(sconf_set_bool_p(root, boolean, true, &err), 0);
+    assert_int_equal(sconf_set_float_p(root, fp, 1.5, &err), 0);
+
+    const char *s = NULL;
+    assert_int_equal(sconf_get_str_p(root, str, &s, &err), 1);
+    assert_string_equal(s, "foop");
+
+    const bool *b = NULL;
+    assert_int_equal(sconf_get_bool_p(root, boolean, &b, &err), 1);
+    assert_true(*b);
+
+    const double *f = NULL;
+    assert_int_equal(sconf_get_float_p(root, fp, &f, &err), 1);
+    assert_true(*f == 1.5);
+
+    /* Compiled paths and string paths refer to the same nodes */
+    assert_int_equal(sconf_get_str(root, "a.b.c", &s, &err), 1);
+    assert_string_equal(s, "foop");
+
+    sconf_path_destroy(str);
+    sconf_path_destroy(integer);
+    sconf_path_destroy(boolean);
+    sconf_path_destroy(fp);
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_path_compile_array(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+
+    struct SConfPath *path = sconf_path_compile("w.[0].[2].p", &err);
+    assert_non_null(path);
+
+    assert_int_equal(sconf_set_int_p(root, path, 1814, &err), 0);
+
+    const int64_t *integer = NULL;
+    assert_int_equal(sconf_get_int_p(root, path, &integer, &err), 1);
+    assert_int_equal(*integer, 1814);
+
+    struct SConfNode *node = NULL;
+    assert_int_equal(sconf_get(root, "w.[0]", &node, &err), 1);
+    assert_int_equal(node->type, SCONF_TYPE_ARRAY);
+
+    sconf_path_destroy(path);
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_path_compile_reuse_across_roots(void **unused)
+{
+    struct SConfErr err = {0};
+
+    struct SConfPath *path = sconf_path_compile("x.y", &err);
+    assert_non_null(path);
+
+    struct SConfNode *first = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(first);
+    struct SConfNode *second = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(second);
+
+    assert_int_equal(sconf_set_str_p(first, path, "first", &err), 0);
+
+    const char *s = NULL;
+    assert_int_equal(sconf_get_str_p(first, path, &s, &err), 1);
+    assert_string_equal(s, "first");
+    assert_int_equal(sconf_get_str_p(second, path, &s, &err), 0);
+
+    sconf_path_destroy(path);
+    sconf_node_destroy(first);
+    sconf_node_destroy(second);
+}
+
+static void test_sconf_path_compile_not_found(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+
+    struct SConfPath *path = sconf_path_compile("d.o.e.s.n.o.t.e.x.i.s.t",
+                                                &err);
+    assert_non_null(path);
+
+    struct SConfNode *node = NULL;
+    assert_int_equal(sconf_get_p(root, path, &node, &err), 0);
+
+    sconf_path_destroy(path);
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_path_compile_wrong_type(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+
+    struct SConfPath *path = sconf_path_compile("a", &err);
+    assert_non_null(path);
+
+    assert_int_equal(sconf_set_int_p(root, path, 1, &err), 0);
+
+    const char *s = NULL;
+    assert_int_equal(sconf_get_str_p(root, path, &s, &err), -1);
+    assert_string_equal(sconf_strerror(&err), "config node 'a' is integer not string");
+
+    sconf_path_destroy(path);
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_path_compile_invalid(void **unused)
+{
+    struct SConfErr err = {0};
+
+    assert_null(sconf_path_compile(NULL, &err));
+    assert_null(sconf_path_compile("", &err));
+    assert_null(sconf_path_compile("...", &err));
+    assert_null(sconf_path_compile("a.b.c.d.e.f.g.h.i.j.k.l.m.n.o.p.q.r.s.t",
+                                   &err));
+
+    struct SConfPath *path = sconf_path_compile("a.b.c.d.e.f.g.h.i.j.k.l.m.n."
+                                                "o.p.q.r.s", &err);
+    assert_non_null(path);
+    sconf_path_destroy(path);
+}
+
+static void test_sconf_path_compile_invalid_index(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+
+    struct SConfPath *path = sconf_path_compile("arr.[-1]", &err);
+    assert_non_null(path);
+
+    assert_int_equal(sconf_set_str_p(root, path, "x", &err), -1);
+
+    sconf_path_destroy(path);
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_path_compile_without_root_or_path(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+
+    struct SConfPath *path = sconf_path_compile("a", &err);
+    assert_non_null(path);
+
+    struct SConfNode *node = NULL;
+    assert_int_equal(sconf_get_p(NULL, path, &node, &err), -1);
+    assert_int_equal(sconf_get_p(root, NULL, &node, &err), -1);
+    assert_int_equal(sconf_set_str_p(NULL, path, "x", &err), -1);
+    assert_int_equal(sconf_set_str_p(root, NULL, "x", &err), -1);
+    assert_int_equal(sconf_set_str_p(root, path, NULL, &err), -1);
+
+    sconf_path_destroy(path);
+    sconf_node_destroy(root);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_sconf_path_compile_set_and_get),
+        cmocka_unit_test(test_sconf_path_compile_array),
+        cmocka_unit_test(test_sconf_path_compile_reuse_across_roots),
+        cmocka_unit_test(test_sconf_path_compile_not_found),
+        cmocka_unit_test(test_sconf_path_compile_wrong_type),
+        cmocka_unit_test(test_sconf_path_compile_invalid),
+        cmocka_unit_test(test_sconf_path_compile_invalid_index),
+        cmocka_unit_test(test_sconf_path_compile_without_root_or_path),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,212 @@
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <pthread.h>
+
+#include <cmocka.h>
+
+#include "sconf.h"
+
+#define READERS 4
+#define PUBLISHES 500
+
+static struct SConfNode *create_tree(int64_t value)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+
+    assert_int_equal(sconf_set_int(root, "a.value", value, &err), 0);
+    assert_int_equal(sconf_set_int(root, "b.copy", value, &err), 0);
+
+    return root;
+}
+
+static void test_sconf_registry_publish(void **unused)
+{
+    struct SConfErr err = {0};
+
+    struct SConfRegistry *registry = sconf_registry_create(create_tree(1),
+                                                           &err);
+    assert_non_null(registry);
+
+    struct SConfReader *reader = sconf_registry_reader_create(registry, &err);
+    assert_non_null(reader);
+
+    const int64_t *value = NULL;
+
+    struct SConfNode *root = sconf_registry_read_begin(reader);
+    assert_int_equal(sconf_get_int(root, "a.value", &value, &err), 1);
+    assert_int_equal(*value, 1);
+
+    /* The old tree stays valid until the reader is done */
+    assert_int_equal(sconf_registry_publish(registry, create_tree(2), &err),
+                     0);
+    assert_int_equal(sconf_get_int(root, "a.value", &value, &err), 1);
+    assert_int_equal(*value, 1);
+
+    sconf_registry_read_end(reader);
+
+    root = sconf_registry_read_begin(reader);
+    assert_int_equal(sconf_get_int(root, "a.value", &value, &err), 1);
+    assert_int_equal(*value, 2);
+    sconf_registry_read_end(reader);
+
+    sconf_registry_synchronize(registry);
+
+    sconf_registry_reader_destroy(reader);
+    sconf_registry_destroy(registry);
+}
+
+static void test_sconf_registry_empty(void **unused)
+{
+    struct SConfErr err = {0};
+
+    struct SConfRegistry *registry = sconf_registry_create(NULL, &err);
+    assert_non_null(registry);
+
+    struct SConfReader *reader = sconf_registry_reader_create(registry, &err);
+    assert_non_null(reader);
+
+    assert_null(sconf_registry_read_begin(reader));
+    sconf_registry_read_end(reader);
+
+    assert_int_equal(sconf_registry_publish(registry, create_tree(1), &err),
+                     0);
+    assert_non_null(sconf_registry_read_begin(reader));
+    sconf_registry_read_end(reader);
+
+    sconf_registry_reader_destroy(reader);
+    sconf_registry_destroy(registry);
+}
+
+static void test_sconf_registry_reader_reuse(void **unused)
+{
+    struct SConfErr err = {0};
+
+    struct SConfRegistry *registry = sconf_registry_create(NULL, &err);
+    assert_non_null(registry);
+
+    struct SConfReader *first = sconf_registry_reader_create(registry, &err);
+    assert_non_null(first);
+    struct SConfReader *second = sconf_registry_reader_create(registry, &err);
+    assert_non_null(second);
+    assert_ptr_not_equal(first, second);
+
+    sconf_registry_reader_destroy(first);
+
+    struct SConfReader *third = sconf_registry_reader_create(registry, &err);
+    assert_ptr_equal(first, third);
+
+    sconf_registry_reader_destroy(second);
+    sconf_registry_reader_destroy(third);
+    sconf_registry_destroy(registry);
+}
+
+static void test_sconf_registry_invalid(void **unused)
+{
+    struct SConfErr err = {0};
+
+    assert_int_equal(sconf_registry_publish(NULL, NULL, &err), -1);
+    assert_null(sconf_registry_reader_create(NULL, &err));
+
+    sconf_registry_synchronize(NULL);
+    sconf_registry_reader_destroy(NULL);
+    sconf_registry_destroy(NULL);
+}
+
+struct ReaderArgs {
+    struct SConfRegistry *registry;
+    bool stop;
+    bool failed;
+};
+
+static void *reader_thread(void *data)
+{
+    struct ReaderArgs *args = data;
+    struct SConfErr err = {0};
+
+    struct SConfReader *reader = sconf_registry_reader_create(args->registry,
+                                                              &err);
+    if (!reader) {
+        __atomic_store_n(&args->failed, true, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    int64_t last = 0;
+
+    while (!__atomic_load_n(&args->stop, __ATOMIC_RELAXED))
+    {
+        struct SConfNode *root = sconf_registry_read_begin(reader);
+
+        const int64_t *value = NULL;
+        const int64_t *copy = NULL;
+
+        /* Both values come from the same tree, and trees only get newer */
+        if (sconf_get_int(root, "a.value", &value, &err) != 1 ||
+                sconf_get_int(root, "b.copy", &copy, &err) != 1 ||
+                *value != *copy || *value < last) {
+            __atomic_store_n(&args->failed, true, __ATOMIC_RELAXED);
+        }
+        else {
+            last = *value;
+        }
+
+        sconf_registry_read_end(reader);
+    }
+
+    sconf_registry_reader_destroy(reader);
+
+    return NULL;
+}
+
+static void test_sconf_registry_concurrent_readers(void **unused)
+{
+    struct SConfErr err = {0};
+
+    struct ReaderArgs args = {0};
+    args.registry = sconf_registry_create(create_tree(0), &err);
+    assert_non_null(args.registry);
+
+    pthread_t threads[READERS];
+    for (int i = 0; i < READERS; i++)
+    {
+        assert_int_equal(pthread_create(&threads[i], NULL, reader_thread,
+                                        &args), 0);
+    }
+
+    for (int64_t i = 1; i <= PUBLISHES; i++)
+    {
+        assert_int_equal(sconf_registry_publish(args.registry, create_tree(i),
+                                                &err), 0);
+    }
+
+    __atomic_store_n(&args.stop, true, __ATOMIC_RELAXED);
+
+    for (int i = 0; i < READERS; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+
+    assert_false(args.failed);
+
+    sconf_registry_synchronize(args.registry);
+    sconf_registry_destroy(args.registry);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_sconf_registry_publish),
+        cmocka_unit_test(test_sconf_registry_empty),
+        cmocka_unit_test(test_sconf_registry_reader_reuse),
+        cmocka_unit_test(test_sconf_registry_invalid),
+        cmocka_unit_test(test_sconf_registry_concurrent_readers),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
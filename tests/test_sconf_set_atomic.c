@@ -0,0 +1,176 @@
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <pthread.h>
+
+#include <cmocka.h>
+
+#include "sconf.h"
+
+#define READERS 4
+#define UPDATES 200000
+
+/* Values differing in both halves, so torn writes would be noticed */
+#define INT_A ((int64_t)0x1111111122222222)
+#define INT_B ((int64_t)-1)
+#define FLOAT_A 0.1
+#define FLOAT_B 12345.678
+
+static void test_sconf_set_atomic(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+
+    assert_int_equal(sconf_set_int(root, "limits.rate", 10, &err), 0);
+    assert_int_equal(sconf_set_float(root, "tracing.ratio", 0.5, &err), 0);
+    assert_int_equal(sconf_set_bool(root, "tracing.enabled", false, &err), 0);
+
+    struct SConfNode *rate = NULL;
+    struct SConfNode *ratio = NULL;
+    struct SConfNode *enabled = NULL;
+    assert_int_equal(sconf_get(root, "limits.rate", &rate, &err), 1);
+    assert_int_equal(sconf_get(root, "tracing.ratio", &ratio, &err), 1);
+    assert_int_equal(sconf_get(root, "tracing.enabled", &enabled, &err), 1);
+
+    assert_int_equal(sconf_set_int_atomic(root, "limits.rate", 1000, &err), 0);
+    assert_int_equal(sconf_set_float_atomic(root, "tracing.ratio", 0.25,
+                                            &err), 0);
+    assert_int_equal(sconf_set_bool_atomic(root, "tracing.enabled", true,
+                                           &err), 0);
+
+    assert_int_equal(sconf_int_atomic(rate), 1000);
+    assert_true(sconf_float_atomic(ratio) == 0.25);
+    assert_true(sconf_bool_atomic(enabled));
+
+    /* Same nodes, so the regular getters see the new values as well */
+    const int64_t *integer = NULL;
+    assert_int_equal(sconf_get_int(root, "limits.rate", &integer, &err), 1);
+    assert_int_equal(*integer, 1000);
+
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_set_atomic_must_exist(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+
+    assert_int_equal(sconf_set_int_atomic(root, "limits.rate", 1, &err), -1);
+    assert_string_equal(sconf_strerror(&err),
+                        "config node 'limits.rate' does not exist");
+
+    assert_int_equal(sconf_set_str(root, "limits.rate", "many", &err), 0);
+    assert_int_equal(sconf_set_int_atomic(root, "limits.rate", 1, &err), -1);
+    assert_int_equal(sconf_set_float_atomic(root, "limits.rate", 1, &err), -1);
+    assert_int_equal(sconf_set_bool_atomic(root, "limits.rate", 1, &err), -1);
+
+    assert_int_equal(sconf_set_int_atomic(NULL, "a", 1, &err), -1);
+    assert_int_equal(sconf_set_int_atomic(root, NULL, 1, &err), -1);
+
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_set_atomic_frozen(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+
+    assert_int_equal(sconf_set_int(root, "a", 1, &err), 0);
+
+    struct SConfNode *frozen = sconf_freeze(root, &err);
+    assert_non_null(frozen);
+
+    assert_int_equal(sconf_set_int_atomic(frozen, "a", 2, &err), -1);
+    assert_string_equal(sconf_strerror(&err), "config node is frozen");
+
+    sconf_node_destroy(frozen);
+    sconf_node_destroy(root);
+}
+
+struct StressArgs {
+    struct SConfNode *integer;
+    struct SConfNode *fp;
+    bool stop;
+    bool torn;
+};
+
+static void *reader_thread(void *data)
+{
+    struct StressArgs *args = data;
+
+    while (!__atomic_load_n(&args->stop, __ATOMIC_RELAXED))
+    {
+        int64_t integer = sconf_int_atomic(args->integer);
+        double fp = sconf_float_atomic(args->fp);
+
+        if ((integer != INT_A && integer != INT_B) ||
+                (fp != FLOAT_A && fp != FLOAT_B)) {
+            __atomic_store_n(&args->torn, true, __ATOMIC_RELAXED);
+        }
+    }
+
+    return NULL;
+}
+
+static void test_sconf_set_atomic_concurrent(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+
+    assert_int_equal(sconf_set_int(root, "integer", INT_A, &err), 0);
+    assert_int_equal(sconf_set_float(root, "fp", FLOAT_A, &err), 0);
+
+    struct StressArgs args = {0};
+    assert_int_equal(sconf_get(root, "integer", &args.integer, &err), 1);
+    assert_int_equal(sconf_get(root, "fp", &args.fp, &err), 1);
+
+    pthread_t threads[READERS];
+    for (int i = 0; i < READERS; i++)
+    {
+        assert_int_equal(pthread_create(&threads[i], NULL, reader_thread,
+                                        &args), 0);
+    }
+
+    for (int i = 0; i < UPDATES; i++)
+    {
+        assert_int_equal(sconf_set_int_atomic(root, "integer",
+                                              i % 2 ? INT_A : INT_B, &err), 0);
+        assert_int_equal(sconf_set_float_atomic(root, "fp",
+                                                i % 2 ? FLOAT_A : FLOAT_B,
+                                                &err), 0);
+    }
+
+    __atomic_store_n(&args.stop, true, __ATOMIC_RELAXED);
+
+    for (int i = 0; i < READERS; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+
+    assert_false(args.torn);
+
+    sconf_node_destroy(root);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_sconf_set_atomic),
+        cmocka_unit_test(test_sconf_set_atomic_must_exist),
+        cmocka_unit_test(test_sconf_set_atomic_frozen),
+        cmocka_unit_test(test_sconf_set_atomic_concurrent),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,166 @@
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <cmocka.h>
+
+#include "sconf.h"
+#include "sconf_private.h"
+
+#define SHORT_STR "localhost"
+#define STR_31 "0123456789012345678901234567890"
+#define STR_32 "01234567890123456789012345678901"
+#define LONG_STR "a string that is too long to be stored in the node itself"
+
+static void assert_str_n(struct SConfNode *root, const char *path,
+                         const char *expected)
+{
+    struct SConfErr err = {0};
+    const char *str = NULL;
+    size_t len = 0;
+
+    assert_int_equal(sconf_get_str_n(root, path, &str, &len, &err), 1);
+    assert_int_equal(len, strlen(expected));
+    assert_string_equal(str, expected);
+}
+
+static void test_sconf_str_inline(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+    struct SConfNode *node = NULL;
+
+    assert_int_equal(sconf_set_str(root, "short", SHORT_STR, &err), 0);
+    assert_int_equal(sconf_set_str(root, "empty", "", &err), 0);
+    assert_int_equal(sconf_set_str(root, "str31", STR_31, &err), 0);
+    assert_int_equal(sconf_set_str(root, "str32", STR_32, &err), 0);
+    assert_int_equal(sconf_set_str(root, "long", LONG_STR, &err), 0);
+
+    assert_int_equal(sconf_get(root, "short", &node, &err), 1);
+    assert_true(node->flags & SCONF_NODE_FLAG_STR_INLINE);
+    assert_int_equal(sconf_get(root, "empty", &node, &err), 1);
+    assert_true(node->flags & SCONF_NODE_FLAG_STR_INLINE);
+    assert_int_equal(sconf_get(root, "str31", &node, &err), 1);
+    assert_true(node->flags & SCONF_NODE_FLAG_STR_INLINE);
+    assert_int_equal(sconf_get(root, "str32", &node, &err), 1);
+    assert_false(node->flags & SCONF_NODE_FLAG_STR_INLINE);
+    assert_int_equal(sconf_get(root, "long", &node, &err), 1);
+    assert_false(node->flags & SCONF_NODE_FLAG_STR_INLINE);
+
+    assert_str_n(root, "short", SHORT_STR);
+    assert_str_n(root, "empty", "");
+    assert_str_n(root, "str31", STR_31);
+    assert_str_n(root, "str32", STR_32);
+    assert_str_n(root, "long", LONG_STR);
+
+    const char *str = NULL;
+    assert_int_equal(sconf_get_str(root, "short", &str, &err), 1);
+    assert_string_equal(str, SHORT_STR);
+
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_str_inline_overwrite(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+    struct SConfNode *node = NULL;
+
+    /* Short to long */
+    assert_int_equal(sconf_set_str(root, "a", SHORT_STR, &err), 0);
+    assert_int_equal(sconf_set_str(root, "a", LONG_STR, &err), 0);
+    assert_str_n(root, "a", LONG_STR);
+
+    /* Long to a shorter long string reuses the buffer */
+    assert_int_equal(sconf_get(root, "a", &node, &err), 1);
+    const char *buffer = node->string;
+    assert_int_equal(sconf_set_str(root, "a", STR_32, &err), 0);
+    assert_int_equal(sconf_get(root, "a", &node, &err), 1);
+    assert_ptr_equal(node->string, buffer);
+    assert_str_n(root, "a", STR_32);
+
+    /* Long to short */
+    assert_int_equal(sconf_set_str(root, "a", SHORT_STR, &err), 0);
+    assert_int_equal(sconf_get(root, "a", &node, &err), 1);
+    assert_true(node->flags & SCONF_NODE_FLAG_STR_INLINE);
+    assert_str_n(root, "a", SHORT_STR);
+
+    /* Short to long again */
+    assert_int_equal(sconf_set_str(root, "a", LONG_STR, &err), 0);
+    assert_str_n(root, "a", LONG_STR);
+
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_str_inline_arena(void **unused)
+{
+    struct SConfErr err = {0};
+    struct SConfNode *root = SCONF_ROOT_ARENA(&err);
+    assert_non_null(root);
+
+    assert_int_equal(sconf_set_str(root, "short", SHORT_STR, &err), 0);
+    assert_int_equal(sconf_set_str(root, "long", LONG_STR, &err), 0);
+    assert_int_equal(sconf_set_str(root, "long", STR_32, &err), 0);
+    assert_int_equal(sconf_set_str(root, "short", LONG_STR, &err), 0);
+
+    assert_str_n(root, "short", LONG_STR);
+    assert_str_n(root, "long", STR_32);
+
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_str_inline_freeze(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+
+    assert_int_equal(sconf_set_str(root, "short", SHORT_STR, &err), 0);
+    assert_int_equal(sconf_set_str(root, "long", LONG_STR, &err), 0);
+
+    struct SConfNode *frozen = sconf_freeze(root, &err);
+    assert_non_null(frozen);
+    sconf_node_destroy(root);
+
+    assert_str_n(frozen, "short", SHORT_STR);
+    assert_str_n(frozen, "long", LONG_STR);
+
+    sconf_node_destroy(frozen);
+}
+
+static void test_sconf_str_inline_wrong_type(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+    const char *str = NULL;
+    size_t len = 0;
+
+    assert_int_equal(sconf_set_int(root, "a", 1, &err), 0);
+    assert_int_equal(sconf_get_str_n(root, "a", &str, &len, &err), -1);
+    assert_int_equal(sconf_get_str_n(root, "b", &str, &len, &err), 0);
+
+    sconf_node_destroy(root);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_sconf_str_inline),
+        cmocka_unit_test(test_sconf_str_inline_overwrite),
+        cmocka_unit_test(test_sconf_str_inline_arena),
+        cmocka_unit_test(test_sconf_str_inline_freeze),
+        cmocka_unit_test(test_sconf_str_inline_wrong_type),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,367 @@
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cmocka.h>
+
+#include "sconf.h"
+
+static const char *corpus[] = {
+    "yaml/test_array.yaml",
+    "yaml/test_boolean.yaml",
+    "yaml/test_empty.yaml",
+    "yaml/test_float.yaml",
+    "yaml/test_float_overflow.yaml",
+    "yaml/test_float_underflow.yaml",
+    "yaml/test_integer.yaml",
+    "yaml/test_integer_overflow.yaml",
+    "yaml/test_integer_underflow.yaml",
+    "yaml/test_max_depth.yaml",
+    "yaml/test_multiple_documents.yaml",
+    "yaml/test_nested_dicts.yaml",
+    "yaml/test_packed_array.yaml",
+    "yaml/test_string.yaml",
+};
+
+/* Read by the native parser */
+static const char *supported[] = {
+    "a: 1\nb: -2\nc: 0x1f\nd: 1.5\ne: yes\nf: text with spaces  \n",
+    "# comment\n\na: 1 # comment\n  # indented comment\nb: a#b\n",
+    "a: \"quoted: #text\"\nb: 'single'\nc: ''\n\"d e\": 1\n'f' : 2\n",
+    "a:\nb:\n  c:\nd: 1\n",
+    "a:\n- 1\n- 2\nb:\n  - x\n  -\n  - y\n",
+    "a:\n  - b: 1\n    c: 2\n  - d:\n      e: 3\n  - f:\n    - 4\n    - 5\n",
+    "a:\n  -\n    b: 1\n  -\n    - 2\n",
+    "a: [1, 2.5, \"3\", 'x', y z]\nb: []\nc: [ true ,false ]\n",
+    "  a: 1\n  b:\n    c: 2\n",
+    "---\na: 1\n---\na: 2\nb: 3\n",
+    "a: http://example.com:8080/x\nb: 10.0.0.1\nc: -x\n",
+    "a: 1",
+    "a:",
+    "",
+    "# only a comment\n",
+    "a:\n  b: 1\n---\na:\n  c: 2\n",
+    "a: 1\nb: [1, 2]\nc:\n  - 3\n  - 4\na: 5\n",
+};
+
+/* Read by libyaml (escapes, block scalars, anchors, flow mappings, ...) */
+static const char *unsupported[] = {
+    "a: \"esc\\tape\"\n",
+    "a: 'it''s'\n",
+    "a: |\n  literal\n",
+    "a: >\n  folded\n  text\n",
+    "a: &x 1\n",
+    "a: {b: 1}\n",
+    "a: [[1, 2], [3]]\n",
+    "a: [1,\n  2]\n",
+    "a: plain\n  continued\n",
+    "a:\tb\n",
+    "a: 1\r\nb: 2\r\n",
+    "a: caf\xc3\xa9\n",
+    "%YAML 1.1\n---\na: 1\n",
+    "a: !!str 1\n",
+    "? a\n: 1\n",
+    "a:\n  - - 1\n",
+    "a: 1\n...\n",
+    "a: [1, 2, ]\n",
+};
+
+/* Errors with both parsers */
+static const char *invalid[] = {
+    "- 1\n- 2\n",
+    "a\n",
+    "a: 1\n  b: 2\n",
+    "a: b: c\n",
+    "a: 1\nb\n",
+    "---\n",
+    "a: \"unterminated\n",
+    "a: [1, 2\n",
+    "a:\n  b: 1\n c: 2\n",
+    "a: 1\n---\n---\nb: 2\n",
+    "a: 1\nb: [1, 2]\nb:\n  c: 1\n",
+    "a: [1, 2] x\n",
+    "a: \"x\" y\n",
+};
+
+static int count_cb(const unsigned char *name, struct SConfNode *node,
+                    void *user, struct SConfErr *err)
+{
+    (*(size_t *)user)++;
+    return 0;
+}
+
+static int count_array_cb(uint32_t index, struct SConfNode *node, void *user,
+                          struct SConfErr *err)
+{
+    (*(size_t *)user)++;
+    return 0;
+}
+
+static void assert_tree_equal(struct SConfNode *a, struct SConfNode *b);
+
+static int compare_cb(const unsigned char *name, struct SConfNode *node,
+                      void *user, struct SConfErr *err)
+{
+    struct SConfNode *other = NULL;
+
+    assert_int_equal(sconf_node_dict_search((const char *)name, user, &other,
+                                            err), 0);
+    assert_non_null(other);
+    assert_tree_equal(node, other);
+
+    return 0;
+}
+
+static int compare_array_cb(uint32_t index, struct SConfNode *node,
+                            void *user, struct SConfErr *err)
+{
+    struct SConfNode *other = NULL;
+
+    assert_int_equal(sconf_node_array_search(index, user, &other, err), 0);
+    assert_non_null(other);
+    assert_tree_equal(node, other);
+
+    return 0;
+}
+
+static void assert_tree_equal(struct SConfNode *a, struct SConfNode *b)
+{
+    struct SConfErr err = {0};
+    size_t count_a = 0;
+    size_t count_b = 0;
+
+    assert_int_equal(sconf_type(a), sconf_type(b));
+
+    switch (sconf_type(a))
+    {
+        case SCONF_TYPE_DICT:
+            sconf_node_dict_foreach(a, &count_cb, &count_a, &err);
+            sconf_node_dict_foreach(b, &count_cb, &count_b, &err);
+            assert_int_equal(count_a, count_b);
+            assert_int_equal(sconf_node_dict_foreach(a, &compare_cb, b, &err),
+                             0);
+            break;
+        case SCONF_TYPE_ARRAY:
+            sconf_node_array_foreach(a, &count_array_cb, &count_a, &err);
+            sconf_node_array_foreach(b, &count_array_cb, &count_b, &err);
+            assert_int_equal(count_a, count_b);
+            assert_int_equal(sconf_node_array_foreach(a, &compare_array_cb, b,
+                                                      &err), 0);
+            break;
+        case SCONF_TYPE_STR:
+            assert_string_equal(sconf_str(a), sconf_str(b));
+            break;
+        case SCONF_TYPE_INT:
+            assert_int_equal(sconf_int(a), sconf_int(b));
+            break;
+        case SCONF_TYPE_BOOL:
+            assert_int_equal(sconf_bool(a), sconf_bool(b));
+            break;
+        case SCONF_TYPE_FLOAT:
+            assert_true(sconf_float(a) == sconf_float(b));
+            break;
+    }
+}
+
+/* Read YAML with both parsers and compare the results */
+static int assert_same_buffer(const char *data, int native_flags)
+{
+    struct SConfErr err = {0};
+
+    struct SConfNode *expected = SCONF_ROOT(&err);
+    struct SConfNode *actual = SCONF_ROOT(&err);
+    assert_non_null(expected);
+    assert_non_null(actual);
+
+    size_t len = strlen(data);
+    int r = sconf_yaml_read_buffer_flags(expected, data, len,
+                                         SCONF_YAML_LIBYAML, &err);
+    int r_native = sconf_yaml_read_buffer_flags(actual, data, len,
+                                                native_flags, &err);
+    assert_int_equal(r, r_native);
+    if (r == 0) {
+        assert_tree_equal(expected, actual);
+    }
+
+    sconf_node_destroy(expected);
+    sconf_node_destroy(actual);
+
+    return r;
+}
+
+static void test_sconf_yaml_native_corpus(void **unused)
+{
+    for (size_t i = 0; i < sizeof(corpus) / sizeof(corpus[0]); i++)
+    {
+        struct SConfErr err = {0};
+
+        struct SConfNode *expected = SCONF_ROOT(&err);
+        struct SConfNode *actual = SCONF_ROOT(&err);
+        assert_non_null(expected);
+        assert_non_null(actual);
+
+        int r = sconf_yaml_read_flags(expected, corpus[i], SCONF_YAML_LIBYAML,
+                                      &err);
+        assert_int_equal(sconf_yaml_read_flags(actual, corpus[i],
+                                               SCONF_YAML_NATIVE, &err), r);
+        if (r == 0) {
+            assert_tree_equal(expected, actual);
+        }
+
+        sconf_node_destroy(expected);
+        sconf_node_destroy(actual);
+    }
+}
+
+static void test_sconf_yaml_native_corpus_no_fallback(void **unused)
+{
+    /* Everything but the block scalars in test_string.yaml is read by the
+       native parser */
+    for (size_t i = 0; i < sizeof(corpus) / sizeof(corpus[0]); i++)
+    {
+        struct SConfErr err = {0};
+
+        struct SConfNode *expected = SCONF_ROOT(&err);
+        struct SConfNode *actual = SCONF_ROOT(&err);
+        assert_non_null(expected);
+        assert_non_null(actual);
+
+        int r = sconf_yaml_read_flags(expected, corpus[i], SCONF_YAML_LIBYAML,
+                                      &err);
+        int r_native = sconf_yaml_read_flags(actual, corpus[i],
+                                             SCONF_YAML_NATIVE |
+                                             SCONF_YAML_NO_FALLBACK, &err);
+        if (strcmp(corpus[i], "yaml/test_string.yaml") == 0) {
+            assert_int_equal(r, 0);
+            assert_int_equal(r_native, -1);
+        }
+        else {
+            assert_int_equal(r_native, r);
+            if (r == 0) {
+                assert_tree_equal(expected, actual);
+            }
+        }
+
+        sconf_node_destroy(expected);
+        sconf_node_destroy(actual);
+    }
+}
+
+static void test_sconf_yaml_native_supported(void **unused)
+{
+    for (size_t i = 0; i < sizeof(supported) / sizeof(supported[0]); i++)
+    {
+        assert_int_equal(assert_same_buffer(supported[i], SCONF_YAML_NATIVE |
+                                            SCONF_YAML_NO_FALLBACK), 0);
+    }
+}
+
+static void test_sconf_yaml_native_fallback(void **unused)
+{
+    for (size_t i = 0; i < sizeof(unsupported) / sizeof(unsupported[0]); i++)
+    {
+        struct SConfErr err = {0};
+
+        assert_int_equal(assert_same_buffer(unsupported[i],
+                                            SCONF_YAML_NATIVE), 0);
+
+        struct SConfNode *root = SCONF_ROOT(&err);
+        assert_non_null(root);
+        assert_int_equal(sconf_yaml_read_buffer_flags(root, unsupported[i],
+                                                      strlen(unsupported[i]),
+                                                      SCONF_YAML_NATIVE |
+                                                      SCONF_YAML_NO_FALLBACK,
+                                                      &err), -1);
+        sconf_node_destroy(root);
+    }
+}
+
+static void test_sconf_yaml_native_invalid(void **unused)
+{
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++)
+    {
+        assert_int_equal(assert_same_buffer(invalid[i], SCONF_YAML_NATIVE),
+                         -1);
+    }
+}
+
+static void test_sconf_yaml_native_values(void **unused)
+{
+    struct SConfErr err = {0};
+    const char data[] =
+        "list:\n"
+        "  - name: \"first\"\n"
+        "    ports: [80, 443]\n"
+        "  - name: second\n"
+        "empty:\n";
+
+    struct SConfNode *root = SCONF_ROOT(&err);
+    assert_non_null(root);
+    assert_int_equal(sconf_yaml_read_buffer_flags(root, data,
+                                                  sizeof(data) - 1,
+                                                  SCONF_YAML_NATIVE |
+                                                  SCONF_YAML_NO_FALLBACK,
+                                                  &err), 0);
+
+    const char *str = NULL;
+    const int64_t *integer = NULL;
+    assert_int_equal(sconf_get_str(root, "list.[0].name", &str, &err), 1);
+    assert_string_equal(str, "first");
+    assert_int_equal(sconf_get_int(root, "list.[0].ports.[1]", &integer,
+                                   &err), 1);
+    assert_int_equal(*integer, 443);
+    assert_int_equal(sconf_get_str(root, "list.[1].name", &str, &err), 1);
+    assert_string_equal(str, "second");
+    assert_int_equal(sconf_get_str(root, "empty", &str, &err), 1);
+    assert_string_equal(str, "");
+
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_yaml_native_flags(void **unused)
+{
+    struct SConfErr err = {0};
+
+    struct SConfNode *root = SCONF_ROOT(&err);
+    assert_non_null(root);
+
+    assert_int_equal(sconf_yaml_read_buffer_flags(root, "a: 1", 4,
+                                                  SCONF_YAML_NATIVE |
+                                                  SCONF_YAML_LIBYAML, &err),
+                     -1);
+    assert_int_equal(sconf_yaml_read_buffer_flags(root, "a: 1", 4, 1 << 8,
+                                                  &err), -1);
+    assert_int_equal(sconf_yaml_read_flags(root, "yaml/test_boolean.yaml",
+                                           SCONF_YAML_NATIVE |
+                                           SCONF_YAML_LIBYAML, &err), -1);
+    assert_int_equal(sconf_yaml_read_buffer_flags(NULL, "a: 1", 4,
+                                                  SCONF_YAML_NATIVE, &err),
+                     -1);
+    assert_int_equal(sconf_yaml_read_buffer_flags(root, NULL, 1,
+                                                  SCONF_YAML_NATIVE, &err),
+                     -1);
+    assert_int_equal(sconf_yaml_read_buffer_flags(root, NULL, 0,
+                                                  SCONF_YAML_NATIVE, &err),
+                     0);
+
+    sconf_node_destroy(root);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_sconf_yaml_native_corpus),
+        cmocka_unit_test(test_sconf_yaml_native_corpus_no_fallback),
+        cmocka_unit_test(test_sconf_yaml_native_supported),
+        cmocka_unit_test(test_sconf_yaml_native_fallback),
+        cmocka_unit_test(test_sconf_yaml_native_invalid),
+        cmocka_unit_test(test_sconf_yaml_native_values),
+        cmocka_unit_test(test_sconf_yaml_native_flags),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -1,3 +1,4 @@
+#include <math.h>
 #include <setjmp.h>
 #include <stdbool.h>
 #include <stdarg.h>
@@ -263,6 +264,69 @@ static void test_valid_yaml_array(void **unused)
     sconf_node_destroy(root);
 }
 
+static void test_valid_yaml_nested_sequences(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+
+    int r = sconf_yaml_read(root, "yaml/test_nested_sequences.yaml", &err);
+    printf("err: %s\n", sconf_strerror(&err));
+    assert_int_equal(r, 0);
+
+    const char *string = NULL;
+    const int64_t *integer;
+    struct SConfNode *node = NULL;
+
+    /* Test block sequence -> flow sequence -> int */
+    r = sconf_get_int(root, "a.[0].[1]", &integer, NULL);
+    assert_int_equal(r, 1);
+    assert_int_equal(*integer, 2);
+
+    /* Test sequence following a nested sequence */
+    r = sconf_get_int(root, "a.[1].[0]", &integer, NULL);
+    assert_int_equal(r, 1);
+    assert_int_equal(*integer, 3);
+
+    r = sconf_get(root, "a.[2]", &node, NULL);
+    assert_int_equal(r, 1);
+    assert_int_equal(sconf_type(node), SCONF_TYPE_ARRAY);
+
+    /* Test block sequence -> flow sequence -> flow sequence -> int */
+    r = sconf_get_int(root, "a.[3].[0].[1]", &integer, NULL);
+    assert_int_equal(r, 1);
+    assert_int_equal(*integer, 5);
+
+    r = sconf_get_str(root, "a.[3].[1].b", &string, NULL);
+    assert_int_equal(r, 1);
+    assert_string_equal(string, "six");
+
+    r = sconf_get_int(root, "c.[0].[1].[0]", &integer, NULL);
+    assert_int_equal(r, 1);
+    assert_int_equal(*integer, 2);
+
+    r = sconf_get_int(root, "c.[1].d", &integer, NULL);
+    assert_int_equal(r, 1);
+    assert_int_equal(*integer, 7);
+
+    /* Test block sequence -> block sequence */
+    const char yaml[] = "e:\n  - - x\n    - y\n  - - z\n";
+    r = sconf_yaml_read_buffer(root, yaml, sizeof(yaml) - 1, &err);
+    printf("err: %s\n", sconf_strerror(&err));
+    assert_int_equal(r, 0);
+
+    r = sconf_get_str(root, "e.[0].[1]", &string, NULL);
+    assert_int_equal(r, 1);
+    assert_string_equal(string, "y");
+
+    r = sconf_get_str(root, "e.[1].[0]", &string, NULL);
+    assert_int_equal(r, 1);
+    assert_string_equal(string, "z");
+
+    sconf_node_destroy(root);
+}
+
 static void test_valid_yaml_multiple_documents(void **unused)
 {
     struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
@@ -391,6 +455,236 @@ static void test_invalid_yaml_max_depth(void **unused)
     sconf_node_destroy(root);
 }
 
+static void test_valid_yaml_buffer(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+
+    /* Not null terminated, the rest of the buffer is not read */
+    const char data[] = "a:\n  b: 42\n  c: [1, 2.5]\nd: foo\ne: bar";
+    int r = sconf_yaml_read_buffer(root, data, sizeof(data) - 1 - 7, &err);
+    printf("err: %s\n", sconf_strerror(&err));
+    assert_int_equal(r, 0);
+
+    const int64_t *integer;
+    r = sconf_get_int(root, "a.b", &integer, NULL);
+    assert_int_equal(r, 1);
+    assert_int_equal(*integer, 42);
+
+    const double *fp;
+    r = sconf_get_float(root, "a.c.[1]", &fp, NULL);
+    assert_int_equal(r, 1);
+    assert_float_equal(*fp, 2.5, 0.0);
+
+    const char *string = NULL;
+    r = sconf_get_str(root, "d", &string, NULL);
+    assert_int_equal(r, 1);
+    assert_string_equal(string, "foo");
+
+    struct SConfNode *node = NULL;
+    r = sconf_get(root, "e", &node, NULL);
+    assert_int_equal(r, 0);
+
+    /* Empty buffer */
+    r = sconf_yaml_read_buffer(root, NULL, 0, &err);
+    assert_int_equal(r, 0);
+
+    sconf_node_destroy(root);
+}
+
+static void test_invalid_yaml_buffer(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+
+    const char data[] = "a: [1, 2\n";
+    int r = sconf_yaml_read_buffer(root, data, sizeof(data) - 1, &err);
+    assert_int_equal(r, -1);
+
+    r = sconf_yaml_read_buffer(root, NULL, 1, &err);
+    assert_int_equal(r, -1);
+
+    r = sconf_yaml_read_buffer(NULL, data, sizeof(data) - 1, &err);
+    assert_int_equal(r, -1);
+
+    sconf_node_destroy(root);
+}
+
+static void test_valid_yaml_scalars(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+
+    const char data[] =
+        "int: -9223372036854775808\n"
+        "hex: 0x7fffffffffffffff\n"
+        "octal: 0777\n"
+        "not_octal: 09\n"
+        "exact: 9007199254740993\n"
+        "exponent: 1.7976931348623157e308\n"
+        "fraction: 0.1e-5\n"
+        "digits: 3.14159265358979323846264338327950288\n"
+        "inf: -inf\n"
+        "yes: yesterday\n"
+        "word: 12ab\n";
+    int r = sconf_yaml_read_buffer(root, data, sizeof(data) - 1, &err);
+    printf("err: %s\n", sconf_strerror(&err));
+    assert_int_equal(r, 0);
+
+    const int64_t *integer;
+    r = sconf_get_int(root, "int", &integer, NULL);
+    assert_int_equal(r, 1);
+    assert_true(*integer == INT64_MIN);
+
+    r = sconf_get_int(root, "hex", &integer, NULL);
+    assert_int_equal(r, 1);
+    assert_true(*integer == INT64_MAX);
+
+    r = sconf_get_int(root, "octal", &integer, NULL);
+    assert_int_equal(r, 1);
+    assert_int_equal(*integer, 511);
+
+    r = sconf_get_int(root, "exact", &integer, NULL);
+    assert_int_equal(r, 1);
+    assert_true(*integer == 9007199254740993);
+
+    const double *fp;
+    r = sconf_get_float(root, "not_octal", &fp, NULL);
+    assert_int_equal(r, 1);
+    assert_true(*fp == 9.0);
+
+    /* Floating point numbers are correctly rounded */
+    r = sconf_get_float(root, "exponent", &fp, NULL);
+    assert_int_equal(r, 1);
+    assert_true(*fp == 1.7976931348623157e308);
+
+    r = sconf_get_float(root, "fraction", &fp, NULL);
+    assert_int_equal(r, 1);
+    assert_true(*fp == 0.1e-5);
+
+    r = sconf_get_float(root, "digits", &fp, NULL);
+    assert_int_equal(r, 1);
+    assert_true(*fp == 3.14159265358979323846264338327950288);
+
+    r = sconf_get_float(root, "inf", &fp, NULL);
+    assert_int_equal(r, 1);
+    assert_true(isinf(*fp) && *fp < 0);
+
+    const bool *boolean;
+    r = sconf_get_bool(root, "yes", &boolean, NULL);
+    assert_int_equal(r, 1);
+    assert_true(*boolean);
+
+    const char *string = NULL;
+    r = sconf_get_str(root, "word", &string, NULL);
+    assert_int_equal(r, 1);
+    assert_string_equal(string, "12ab");
+
+    sconf_node_destroy(root);
+}
+
+struct StreamDocuments {
+    int count;
+    char names[4][2];
+};
+
+static int stream_document_cb(struct SConfNode *root, void *user,
+                              struct SConfErr *err)
+{
+    struct StreamDocuments *documents = user;
+
+    /* Each document has a root of its own, with a single key */
+    const char *keys[] = {"a", "c", "e"};
+    const char *string = NULL;
+    int i = documents->count;
+    for (int j = 0; j < 3; j++)
+    {
+        int r = sconf_get_str(root, keys[j], &string, NULL);
+        assert_int_equal(r, i == j);
+        if (r == 1) {
+            documents->names[i][0] = string[0];
+        }
+    }
+
+    documents->count++;
+
+    return 0;
+}
+
+static int stream_stop_cb(struct SConfNode *root, void *user,
+                          struct SConfErr *err)
+{
+    int *count = user;
+    *count += 1;
+    sconf_err_set(err, "stop");
+    return -1;
+}
+
+static void test_valid_yaml_stream(void **unused)
+{
+    struct SConfErr err = {0};
+
+    struct StreamDocuments documents = {0};
+    int r = sconf_yaml_read_stream("yaml/test_multiple_documents.yaml",
+                                   &stream_document_cb, &documents, &err);
+    printf("err: %s\n", sconf_strerror(&err));
+    assert_int_equal(r, 0);
+    assert_int_equal(documents.count, 3);
+    assert_string_equal(documents.names[0], "b");
+    assert_string_equal(documents.names[1], "d");
+    assert_string_equal(documents.names[2], "f");
+
+    /* Empty stream has no documents */
+    documents.count = 0;
+    r = sconf_yaml_read_stream("yaml/test_empty.yaml", &stream_document_cb,
+                               &documents, &err);
+    assert_int_equal(r, 0);
+    assert_int_equal(documents.count, 0);
+}
+
+static void test_invalid_yaml_stream(void **unused)
+{
+    struct SConfErr err = {0};
+
+    /* Callback stops reading after the first document */
+    int count = 0;
+    int r = sconf_yaml_read_stream("yaml/test_multiple_documents.yaml",
+                                   &stream_stop_cb, &count, &err);
+    assert_int_equal(r, -1);
+    assert_int_equal(count, 1);
+    assert_string_equal(sconf_strerror(&err), "stop");
+
+    r = sconf_yaml_read_stream("yaml/test_multiple_documents.yaml", NULL,
+                               NULL, &err);
+    assert_int_equal(r, -1);
+
+    r = sconf_yaml_read_stream("yaml/does_not_exist.yaml", &stream_stop_cb,
+                               &count, &err);
+    assert_int_equal(r, -1);
+    assert_int_equal(count, 1);
+}
+
+static void test_valid_yaml_not_regular_file(void **unused)
+{
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    struct SConfErr err = {0};
+
+    /* Can not be mapped, read through stdio */
+    int r = sconf_yaml_read(root, "/dev/null", &err);
+    printf("err: %s\n", sconf_strerror(&err));
+    assert_int_equal(r, 0);
+
+    sconf_node_destroy(root);
+}
+
 int main(void)
 {
     const struct CMUnitTest tests[] = {
@@ -400,6 +694,7 @@ int main(void)
         cmocka_unit_test(test_valid_yaml_float),
         cmocka_unit_test(test_valid_yaml_nested_dicts),
         cmocka_unit_test(test_valid_yaml_array),
+        cmocka_unit_test(test_valid_yaml_nested_sequences),
         cmocka_unit_test(test_valid_yaml_multiple_documents),
         cmocka_unit_test(test_invalid_yaml_missing_file),
         cmocka_unit_test(test_invalid_yaml_integer_overflow),
@@ -409,6 +704,12 @@ int main(void)
         cmocka_unit_test(test_invalid_yaml_float_underflow),
         cmocka_unit_test(test_valid_yaml_empty_file),
         cmocka_unit_test(test_invalid_yaml_max_depth),
+        cmocka_unit_test(test_valid_yaml_buffer),
+        cmocka_unit_test(test_invalid_yaml_buffer),
+        cmocka_unit_test(test_valid_yaml_scalars),
+        cmocka_unit_test(test_valid_yaml_stream),
+        cmocka_unit_test(test_invalid_yaml_stream),
+        cmocka_unit_test(test_valid_yaml_not_regular_file),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
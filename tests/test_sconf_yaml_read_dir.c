@@ -0,0 +1,192 @@
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <cmocka.h>
+
+#include "sconf.h"
+
+/* Files in yaml/conf.d matching "*.yaml", in byte order */
+static const char *fragments[] = {
+    "yaml/conf.d/10-base.yaml",
+    "yaml/conf.d/20-db.yaml",
+    "yaml/conf.d/30-name.yaml",
+    "yaml/conf.d/9-late.yaml",
+};
+
+static void assert_conf_d(struct SConfNode *root)
+{
+    const char *string = NULL;
+    const int64_t *integer;
+    const bool *boolean;
+
+    assert_int_equal(sconf_get_str(root, "db.host", &string, NULL), 1);
+    assert_string_equal(string, "primary");
+    assert_int_equal(sconf_get_int(root, "db.port", &integer, NULL), 1);
+    assert_int_equal(*integer, 6543);
+    assert_int_equal(sconf_get_str(root, "db.user", &string, NULL), 1);
+    assert_string_equal(string, "admin");
+
+    /* Arrays are overridden index by index */
+    assert_int_equal(sconf_get_int(root, "weights.[0]", &integer, NULL), 1);
+    assert_int_equal(*integer, 10);
+    assert_int_equal(sconf_get_int(root, "weights.[1]", &integer, NULL), 1);
+    assert_int_equal(*integer, 20);
+    assert_int_equal(sconf_get_int(root, "weights.[2]", &integer, NULL), 1);
+    assert_int_equal(*integer, 3);
+    assert_int_equal(sconf_get_int(root, "weights.[3]", &integer, NULL), 0);
+    assert_int_equal(sconf_get_int(root, "listeners.[0].port", &integer,
+                                   NULL), 1);
+    assert_int_equal(*integer, 8080);
+    assert_int_equal(sconf_get_int(root, "listeners.[1].port", &integer,
+                                   NULL), 1);
+    assert_int_equal(*integer, 443);
+
+    /* Last file wins, hidden files, directories and README are skipped */
+    assert_int_equal(sconf_get_str(root, "name", &string, NULL), 1);
+    assert_string_equal(string, "late");
+    assert_int_equal(sconf_get_bool(root, "verbose", &boolean, NULL), 1);
+    assert_true(*boolean);
+}
+
+static void test_sconf_yaml_read_dir(void **unused)
+{
+    int nthreads[] = {1, 2, 4, 0};
+
+    for (size_t i = 0; i < sizeof(nthreads) / sizeof(nthreads[0]); i++)
+    {
+        struct SConfErr err = {0};
+        struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL,
+                                                   NULL);
+        assert_non_null(root);
+
+        int r = sconf_yaml_read_dir(root, "yaml/conf.d", "*.yaml",
+                                    nthreads[i], &err);
+        printf("err: %s\n", sconf_strerror(&err));
+        assert_int_equal(r, 0);
+        assert_conf_d(root);
+
+        sconf_node_destroy(root);
+    }
+}
+
+static void test_sconf_yaml_read_dir_serial(void **unused)
+{
+    struct SConfErr err = {0};
+
+    /* Same result as reading the files one by one */
+    struct SConfNode *expected = sconf_node_create(SCONF_TYPE_DICT, NULL,
+                                                   NULL);
+    assert_non_null(expected);
+    for (size_t i = 0; i < sizeof(fragments) / sizeof(fragments[0]); i++)
+    {
+        assert_int_equal(sconf_yaml_read(expected, fragments[i], &err), 0);
+    }
+    assert_conf_d(expected);
+    sconf_node_destroy(expected);
+
+    /* Files for arena-backed roots are parsed on the calling thread */
+    struct SConfNode *root = sconf_node_create_arena(SCONF_TYPE_DICT, NULL,
+                                                     NULL);
+    assert_non_null(root);
+    int r = sconf_yaml_read_dir(root, "yaml/conf.d", "*.yaml", 4, &err);
+    assert_int_equal(r, 0);
+    assert_conf_d(root);
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_yaml_read_dir_pattern(void **unused)
+{
+    struct SConfErr err = {0};
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    const char *string = NULL;
+
+    /* All files, README is read last */
+    int r = sconf_yaml_read_dir(root, "yaml/conf.d", NULL, 2, &err);
+    assert_int_equal(r, 0);
+    assert_int_equal(sconf_get_str(root, "name", &string, NULL), 1);
+    assert_string_equal(string, "readme");
+
+    /* Hidden files match patterns starting with '.' */
+    r = sconf_yaml_read_dir(root, "yaml/conf.d", ".*.yaml", 2, &err);
+    assert_int_equal(r, 0);
+    assert_int_equal(sconf_get_str(root, "name", &string, NULL), 1);
+    assert_string_equal(string, "hidden");
+
+    /* No file matches */
+    r = sconf_yaml_read_dir(root, "yaml/conf.d", "*.yml", 2, &err);
+    assert_int_equal(r, 0);
+    assert_int_equal(sconf_get_str(root, "name", &string, NULL), 1);
+    assert_string_equal(string, "hidden");
+
+    sconf_node_destroy(root);
+}
+
+static void test_sconf_yaml_read_dir_invalid(void **unused)
+{
+    /* Same result on one thread, several threads and arena-backed roots */
+    int nthreads[] = {1, 4, 1, 4};
+
+    for (size_t i = 0; i < sizeof(nthreads) / sizeof(nthreads[0]); i++)
+    {
+        struct SConfErr err = {0};
+        struct SConfNode *root = i < 2 ?
+            sconf_node_create(SCONF_TYPE_DICT, NULL, NULL) :
+            sconf_node_create_arena(SCONF_TYPE_DICT, NULL, NULL);
+        assert_non_null(root);
+
+        /* Stops at the file that can not be merged, leaving none of it
+           applied */
+        int r = sconf_yaml_read_dir(root, "yaml/conf.d.invalid", "*.yaml",
+                                    nthreads[i], &err);
+        printf("err: %s\n", sconf_strerror(&err));
+        assert_int_equal(r, -1);
+
+        const int64_t *integer;
+        assert_int_equal(sconf_get_int(root, "a.b", &integer, NULL), 1);
+        assert_int_equal(*integer, 1);
+        assert_int_equal(sconf_get_int(root, "x", &integer, NULL), 1);
+        assert_int_equal(*integer, 1);
+        assert_int_equal(sconf_get_int(root, "y.[0]", &integer, NULL), 1);
+        assert_int_equal(*integer, 1);
+        assert_int_equal(sconf_get_int(root, "c", &integer, NULL), 0);
+
+        sconf_node_destroy(root);
+    }
+
+    struct SConfErr err = {0};
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, NULL);
+    assert_non_null(root);
+
+    int r = sconf_yaml_read_dir(root, "yaml/does_not_exist", "*.yaml", 2,
+                                &err);
+    assert_int_equal(r, -1);
+
+    r = sconf_yaml_read_dir(root, NULL, "*.yaml", 2, &err);
+    assert_int_equal(r, -1);
+
+    r = sconf_yaml_read_dir(root, "yaml/conf.d", "*.yaml", -1, &err);
+    assert_int_equal(r, -1);
+
+    r = sconf_yaml_read_dir(NULL, "yaml/conf.d", "*.yaml", 2, &err);
+    assert_int_equal(r, -1);
+
+    sconf_node_destroy(root);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_sconf_yaml_read_dir),
+        cmocka_unit_test(test_sconf_yaml_read_dir_serial),
+        cmocka_unit_test(test_sconf_yaml_read_dir_pattern),
+        cmocka_unit_test(test_sconf_yaml_read_dir_invalid),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
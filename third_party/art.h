@@ -1,3 +1,4 @@
+#include <stddef.h>
 #include <stdint.h>
 #ifndef ART_H
 #define ART_H
@@ -83,12 +84,23 @@ typedef struct {
     unsigned char key[];
 } art_leaf;
 
+/**
+ * Custom allocator used for nodes and leafs.
+ * The calloc hook must return zeroed memory.
+ */
+typedef struct {
+    void* (*calloc)(void *ctx, size_t size);
+    void (*free)(void *ctx, void *ptr);
+    void *ctx;
+} art_allocator;
+
 /**
  * Main struct, points to root.
  */
 typedef struct {
     art_node *root;
     uint64_t size;
+    const art_allocator *alloc;
 } art_tree;
 
 /**
@@ -97,6 +109,13 @@ typedef struct {
  */
 int art_tree_init(art_tree *t);
 
+/**
+ * Initializes an ART tree using a custom allocator.
+ * The allocator must outlive the tree.
+ * @return 0 on success.
+ */
+int art_tree_init_allocator(art_tree *t, const art_allocator *alloc);
+
 /**
  * DEPRECATED
  * Initializes an ART tree
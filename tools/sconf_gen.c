@@ -0,0 +1,1716 @@
+/* Generate a config struct, typed accessors, a config map and a loader from
+   a YAML schema. See usage() for the schema format. */
+
+#include <ctype.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sconf.h>
+
+/* Field in a generated struct, either a config value or a nested struct */
+struct GenField {
+    /* Dictionary key of the node and the C identifier made from it */
+    char *key;
+    char *ident;
+
+    /* Full path of the node (e.g "db.port") */
+    char *path;
+
+    /* Nested struct, NULL for values */
+    struct GenStruct *child;
+
+    /* Schema entry of a value */
+    struct SConfNode *entry;
+    uint8_t type;
+    uint8_t element_type;
+    const struct GenCType *ctype;
+    char *default_value;
+    bool required;
+    bool range;
+    int64_t min;
+    int64_t max;
+    double min_float;
+    double max_float;
+    int64_t count;
+    bool counted;
+};
+
+/* Generated struct, one per dictionary in the schema paths */
+struct GenStruct {
+    /* Struct tag and accessor prefix (e.g "app_config_db") */
+    char *name;
+
+    struct GenField *fields;
+    size_t count;
+    size_t capacity;
+};
+
+/* Config types used in schema */
+struct GenType {
+    const char *name;
+    uint8_t type;
+    const char *constant;
+};
+
+static const struct GenType types[] = {
+    {"string", SCONF_TYPE_STR, "SCONF_TYPE_STR"},
+    {"int", SCONF_TYPE_INT, "SCONF_TYPE_INT"},
+    {"bool", SCONF_TYPE_BOOL, "SCONF_TYPE_BOOL"},
+    {"float", SCONF_TYPE_FLOAT, "SCONF_TYPE_FLOAT"},
+    {"array", SCONF_TYPE_ARRAY, "SCONF_TYPE_ARRAY"},
+    {"dict", SCONF_TYPE_DICT, "SCONF_TYPE_DICT"},
+    {"yaml-file", SCONF_TYPE_YAML_FILE, "SCONF_TYPE_YAML_FILE"},
+    {"usage", SCONF_TYPE_USAGE, "SCONF_TYPE_USAGE"},
+    {0}
+};
+
+/* C types a config value can be stored in */
+struct GenCType {
+    uint8_t type;
+    const char *name;
+    bool is_unsigned;
+
+    /* Range of integer types, and the constants written for it */
+    int64_t min;
+    int64_t max;
+    const char *min_constant;
+    const char *max_constant;
+};
+
+#define GEN_LIMITS(min, max) min, max, #min, #max
+
+/* Config integers are int64_t, so unsigned types wider than 63 bits are
+   limited to INT64_MAX */
+static const struct GenCType ctypes[] = {
+    {SCONF_TYPE_STR, "const char *", false},
+    {SCONF_TYPE_INT, "int64_t", false, GEN_LIMITS(INT64_MIN, INT64_MAX)},
+    {SCONF_TYPE_INT, "int32_t", false, GEN_LIMITS(INT32_MIN, INT32_MAX)},
+    {SCONF_TYPE_INT, "int16_t", false, GEN_LIMITS(INT16_MIN, INT16_MAX)},
+    {SCONF_TYPE_INT, "int8_t", false, GEN_LIMITS(INT8_MIN, INT8_MAX)},
+    {SCONF_TYPE_INT, "uint64_t", true, GEN_LIMITS(0, INT64_MAX)},
+    {SCONF_TYPE_INT, "uint32_t", true, GEN_LIMITS(0, UINT32_MAX)},
+    {SCONF_TYPE_INT, "uint16_t", true, GEN_LIMITS(0, UINT16_MAX)},
+    {SCONF_TYPE_INT, "uint8_t", true, GEN_LIMITS(0, UINT8_MAX)},
+    {SCONF_TYPE_INT, "int", false, GEN_LIMITS(INT_MIN, INT_MAX)},
+    {SCONF_TYPE_INT, "unsigned int", true, GEN_LIMITS(0, UINT_MAX)},
+    {SCONF_TYPE_INT, "long", false, GEN_LIMITS(LONG_MIN, LONG_MAX)},
+    {SCONF_TYPE_INT, "unsigned long", true,
+     GEN_LIMITS(0, (ULONG_MAX > INT64_MAX ? INT64_MAX : (int64_t)ULONG_MAX))},
+    {SCONF_TYPE_INT, "size_t", true,
+     GEN_LIMITS(0, (SIZE_MAX > INT64_MAX ? INT64_MAX : (int64_t)SIZE_MAX))},
+    {SCONF_TYPE_BOOL, "bool", false},
+    {SCONF_TYPE_FLOAT, "double", false},
+    {SCONF_TYPE_FLOAT, "float", false},
+    {0}
+};
+
+/* Keywords that can not be used as identifiers, up to C23 */
+static const char *keywords[] = {
+    "alignas", "alignof", "auto", "bool", "break", "case", "char", "const",
+    "constexpr", "continue", "default", "do", "double", "else", "enum",
+    "extern", "false", "float", "for", "goto", "if", "inline", "int", "long",
+    "nullptr", "register", "restrict", "return", "short", "signed", "sizeof",
+    "static", "static_assert", "struct", "switch", "thread_local", "true",
+    "typedef", "typeof", "typeof_unqual", "union", "unsigned", "void",
+    "volatile", "while", "_Alignas", "_Alignof", "_Atomic", "_BitInt",
+    "_Bool", "_Complex", "_Decimal128", "_Decimal32", "_Decimal64",
+    "_Generic", "_Imaginary", "_Noreturn", "_Static_assert", "_Thread_local",
+    NULL
+};
+
+/* Identifier generated for a path, used to check for collisions */
+struct GenName {
+    char *name;
+
+    /* Path of the option, NULL for names generated from the schema name */
+    const char *path;
+};
+
+/* Identifiers generated so far, in one namespace (struct tags or ordinary
+   identifiers) */
+struct GenNames {
+    struct GenName *names;
+    size_t count;
+    size_t capacity;
+};
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+        "Usage: %s <schema.yaml> <header> <source>\n"
+        "\n"
+        "Generate a config struct, typed accessors, a config map and a loader\n"
+        "from a YAML schema. The schema has a name, used as prefix for all\n"
+        "generated identifiers, and a list of options:\n"
+        "\n"
+        "  name: app_config\n"
+        "  options:\n"
+        "    - path: db.port\n"
+        "      type: int          # string, int, bool, float, array,\n"
+        "                         # yaml-file or usage\n"
+        "      ctype: uint16_t    # C type of field (or array elements)\n"
+        "      default: 5432\n"
+        "      required: false\n"
+        "      min: 1             # range of int and float values, within\n"
+        "      max: 65535         # that of the C type\n"
+        "      short: p           # command-line options\n"
+        "      long: db-port\n"
+        "      help: database port\n"
+        "      arg-type: <port>\n"
+        "      env: APP_DB_PORT\n"
+        "    - path: weights\n"
+        "      type: array\n"
+        "      element: int       # element type of arrays\n"
+        "      max-count: 8       # or count for exactly that many elements\n"
+        "    - type: usage\n"
+        "      short: h\n"
+        "      long: help\n"
+        "      help: print this help\n"
+        "      description: Describe the application.\n",
+        prog);
+}
+
+/**
+ * @internal
+ * @brief Print error and return -1.
+ *
+ * @param fmt Format string.
+ *
+ * @return -1.
+ */
+static int gen_error(const char *fmt, ...)
+    __attribute__((format(printf, 1, 2)));
+
+static int gen_error(const char *fmt, ...)
+{
+    va_list args;
+
+    fprintf(stderr, "sconf-gen: ");
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+    fprintf(stderr, "\n");
+
+    return -1;
+}
+
+/**
+ * @internal
+ * @brief Copy string.
+ *
+ * @param str The string.
+ * @param len Length of string.
+ *
+ * @return copy on success, NULL otherwise.
+ */
+static char *gen_strndup(const char *str, size_t len)
+{
+    char *copy = malloc(len + 1);
+    if (!copy) {
+        gen_error("could not allocate memory for string");
+        return NULL;
+    }
+
+    memcpy(copy, str, len);
+    copy[len] = '\0';
+
+    return copy;
+}
+
+/**
+ * @internal
+ * @brief Join two strings with a separator.
+ *
+ * @param a   First string.
+ * @param sep Separator.
+ * @param b   Second string.
+ *
+ * @return joined string on success, NULL otherwise.
+ */
+static char *gen_join(const char *a, const char *sep, const char *b)
+{
+    size_t len = strlen(a) + strlen(sep) + strlen(b);
+    char *joined = malloc(len + 1);
+    if (!joined) {
+        gen_error("could not allocate memory for string");
+        return NULL;
+    }
+
+    snprintf(joined, len + 1, "%s%s%s", a, sep, b);
+
+    return joined;
+}
+
+/**
+ * @internal
+ * @brief Make C identifier from dictionary key, replacing characters that
+ * are not allowed with underscores.
+ *
+ * @param key The dictionary key.
+ * @param len Length of key.
+ *
+ * @return identifier on success, NULL otherwise.
+ */
+static char *gen_ident(const char *key, size_t len)
+{
+    if (len == 0 || isdigit((unsigned char)key[0])) {
+        gen_error("key '%.*s' can not be used as C identifier", (int)len,
+                  key);
+        return NULL;
+    }
+
+    char *ident = gen_strndup(key, len);
+    if (!ident) {
+        return NULL;
+    }
+
+    for (char *c = ident; *c; c++)
+    {
+        if (!isalnum((unsigned char)*c)) {
+            *c = '_';
+        }
+    }
+
+    for (const char **keyword = keywords; *keyword; keyword++)
+    {
+        if (strcmp(ident, *keyword) == 0) {
+            gen_error("key '%.*s' is a C keyword and can not be used as C "
+                      "identifier", (int)len, key);
+            free(ident);
+            return NULL;
+        }
+    }
+
+    return ident;
+}
+
+/**
+ * @internal
+ * @brief Free struct and its nested structs.
+ *
+ * @param gen The struct.
+ */
+static void gen_struct_destroy(struct GenStruct *gen)
+{
+    if (!gen) {
+        return;
+    }
+
+    for (size_t i = 0; i < gen->count; i++)
+    {
+        struct GenField *field = &gen->fields[i];
+        free(field->key);
+        free(field->ident);
+        free(field->path);
+        free(field->default_value);
+        gen_struct_destroy(field->child);
+    }
+
+    free(gen->fields);
+    free(gen->name);
+    free(gen);
+}
+
+/**
+ * @internal
+ * @brief Create struct.
+ *
+ * @param name Struct tag, taken over by the struct.
+ *
+ * @return struct on success, NULL otherwise.
+ */
+static struct GenStruct *gen_struct_create(char *name)
+{
+    if (!name) {
+        return NULL;
+    }
+
+    struct GenStruct *gen = calloc(1, sizeof(*gen));
+    if (!gen) {
+        gen_error("could not allocate memory for struct");
+        free(name);
+        return NULL;
+    }
+
+    gen->name = name;
+
+    return gen;
+}
+
+/**
+ * @internal
+ * @brief Get field of struct by identifier.
+ *
+ * @param gen   The struct.
+ * @param ident The identifier.
+ *
+ * @return field if found, NULL otherwise.
+ */
+static struct GenField *gen_struct_field(struct GenStruct *gen,
+                                         const char *ident)
+{
+    for (size_t i = 0; i < gen->count; i++)
+    {
+        if (strcmp(gen->fields[i].ident, ident) == 0) {
+            return &gen->fields[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @internal
+ * @brief Add field to struct.
+ *
+ * @param gen   The struct.
+ * @param key   Dictionary key.
+ * @param ident Identifier, taken over by the field.
+ * @param path  Full path, taken over by the field.
+ *
+ * @return field on success, NULL otherwise.
+ */
+static struct GenField *gen_struct_add(struct GenStruct *gen, const char *key,
+                                       char *ident, char *path)
+{
+    if (!ident || !path) {
+        free(ident);
+        free(path);
+        return NULL;
+    }
+
+    if (gen->count == gen->capacity) {
+        size_t capacity = gen->capacity ? gen->capacity * 2 : 8;
+        struct GenField *fields = realloc(gen->fields,
+                                          capacity * sizeof(*fields));
+        if (!fields) {
+            gen_error("could not allocate memory for fields");
+            free(ident);
+            free(path);
+            return NULL;
+        }
+        gen->fields = fields;
+        gen->capacity = capacity;
+    }
+
+    struct GenField *field = &gen->fields[gen->count++];
+    memset(field, 0, sizeof(*field));
+    field->ident = ident;
+    field->path = path;
+    field->key = gen_strndup(key, strlen(key));
+    if (!field->key) {
+        return NULL;
+    }
+
+    return field;
+}
+
+/**
+ * @internal
+ * @brief Get optional string from schema entry.
+ *
+ * @param entry The schema entry.
+ * @param key   Key in schema entry.
+ * @param str   Pointer to string, left untouched if missing.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int gen_entry_str(struct SConfNode *entry, const char *key,
+                         const char **str)
+{
+    struct SConfErr err = {0};
+
+    if (sconf_get_str(entry, key, str, &err) == -1) {
+        return gen_error("invalid '%s' in schema: %s", key,
+                         sconf_strerror(&err));
+    }
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Convert config type name used in schema.
+ *
+ * @param name The type name.
+ *
+ * @return config type, SCONF_TYPE_UNKNOWN if not valid.
+ */
+static uint8_t gen_type(const char *name)
+{
+    for (const struct GenType *type = types; type->name; type++)
+    {
+        if (strcmp(type->name, name) == 0) {
+            return type->type;
+        }
+    }
+
+    return SCONF_TYPE_UNKNOWN;
+}
+
+/**
+ * @internal
+ * @brief Get type name used in schema.
+ *
+ * @param type The config type.
+ *
+ * @return type name.
+ */
+static const char *gen_type_name(uint8_t type)
+{
+    for (const struct GenType *entry = types; entry->name; entry++)
+    {
+        if (entry->type == type) {
+            return entry->name;
+        }
+    }
+
+    return "unknown";
+}
+
+/**
+ * @internal
+ * @brief Get name of config type constant used in generated code.
+ *
+ * @param type The config type.
+ *
+ * @return constant name.
+ */
+static const char *gen_type_constant(uint8_t type)
+{
+    for (const struct GenType *entry = types; entry->name; entry++)
+    {
+        if (entry->type == type) {
+            return entry->constant;
+        }
+    }
+
+    return "SCONF_TYPE_UNKNOWN";
+}
+
+/**
+ * @internal
+ * @brief Convert scalar node to the string used as default value.
+ *
+ * @param node The node.
+ * @param type Type of config value.
+ * @param path Path of config value (used in error message).
+ *
+ * @return string on success, NULL otherwise.
+ */
+static char *gen_default(const struct SConfNode *node, uint8_t type,
+                         const char *path)
+{
+    char buf[64];
+    uint8_t node_type = sconf_type(node);
+
+    if (node_type == SCONF_TYPE_STR) {
+        return gen_strndup(sconf_str(node), strlen(sconf_str(node)));
+    }
+
+    if (node_type != type && !(type == SCONF_TYPE_FLOAT &&
+                               node_type == SCONF_TYPE_INT)) {
+        gen_error("default value of '%s' is %s not %s", path,
+                  gen_type_name(node_type), gen_type_name(type));
+        return NULL;
+    }
+
+    switch (node_type)
+    {
+        case SCONF_TYPE_INT:
+            snprintf(buf, sizeof(buf), "%" PRId64, sconf_int(node));
+            break;
+        case SCONF_TYPE_BOOL:
+            snprintf(buf, sizeof(buf), "%s", sconf_bool(node) ? "true"
+                                                              : "false");
+            break;
+        case SCONF_TYPE_FLOAT:
+            snprintf(buf, sizeof(buf), "%.17g", sconf_float(node));
+            break;
+        default:
+            gen_error("default value of '%s' must be a scalar", path);
+            return NULL;
+    }
+
+    return gen_strndup(buf, strlen(buf));
+}
+
+/**
+ * @internal
+ * @brief Get range limit from schema entry.
+ *
+ * @param field The field.
+ * @param key   Key in schema entry ("min" or "max").
+ * @param limit Pointer to integer limit.
+ * @param fp    Pointer to floating-point limit.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int gen_limit(struct GenField *field, const char *key, int64_t *limit,
+                     double *fp)
+{
+    struct SConfErr err = {0};
+    struct SConfNode *node = NULL;
+    uint8_t type = field->type == SCONF_TYPE_ARRAY ? field->element_type
+                                                   : field->type;
+
+    if (sconf_get(field->entry, key, &node, &err) != 1) {
+        return 0;
+    }
+
+    if (type == SCONF_TYPE_INT && sconf_type(node) == SCONF_TYPE_INT) {
+        *limit = sconf_int(node);
+    }
+    else if (type == SCONF_TYPE_FLOAT &&
+             sconf_type(node) == SCONF_TYPE_INT) {
+        *fp = (double)sconf_int(node);
+    }
+    else if (type == SCONF_TYPE_FLOAT &&
+             sconf_type(node) == SCONF_TYPE_FLOAT) {
+        *fp = sconf_float(node);
+    }
+    else {
+        return gen_error("invalid '%s' for '%s'", key, field->path);
+    }
+
+    field->range = true;
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Check that the default value converts to the type of the value and
+ * is within its range, the same way sconf_bind applies it.
+ *
+ * @param field The field, with default value and range set.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int gen_check_default(const struct GenField *field)
+{
+    struct SConfErr err = {0};
+    const struct SConfBinding bindings[] = {
+        {
+            .path = field->path,
+            .type = field->type,
+            .default_value = field->default_value,
+            .range = field->range || field->type == SCONF_TYPE_INT,
+            .min = field->min,
+            .max = field->max,
+            .min_float = field->min_float,
+            .max_float = field->max_float,
+        },
+        {0}
+    };
+    union {
+        const char *string;
+        int64_t integer;
+        bool boolean;
+        double fp;
+    } value;
+
+    struct SConfNode *root = sconf_node_create(SCONF_TYPE_DICT, NULL, &err);
+    if (!root) {
+        return gen_error("%s", sconf_strerror(&err));
+    }
+
+    int r = sconf_bind(root, bindings, &value, &err);
+    sconf_node_destroy(root);
+
+    if (r == -1) {
+        return gen_error("invalid default: %s", sconf_strerror(&err));
+    }
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Read type, C type, default value, range and array size of value.
+ *
+ * @param field The field, with entry and type set.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int gen_field_parse(struct GenField *field)
+{
+    struct SConfErr err = {0};
+    struct SConfNode *node = NULL;
+    const char *name = NULL;
+    uint8_t type = field->type;
+
+    if (type == SCONF_TYPE_ARRAY) {
+        if (gen_entry_str(field->entry, "element", &name) == -1) {
+            return -1;
+        }
+        type = name ? gen_type(name) : SCONF_TYPE_UNKNOWN;
+        if (type != SCONF_TYPE_STR && type != SCONF_TYPE_INT &&
+                type != SCONF_TYPE_BOOL && type != SCONF_TYPE_FLOAT) {
+            return gen_error("array '%s' needs a scalar element type",
+                             field->path);
+        }
+        field->element_type = type;
+
+        const char *count_key = "count";
+        if (sconf_get(field->entry, "max-count", &node, &err) == 1) {
+            field->counted = true;
+            count_key = "max-count";
+        }
+        else if (sconf_get(field->entry, "count", &node, &err) != 1) {
+            return gen_error("array '%s' needs count or max-count",
+                             field->path);
+        }
+        if (sconf_type(node) != SCONF_TYPE_INT || sconf_int(node) < 1 ||
+                sconf_int(node) > UINT32_MAX) {
+            return gen_error("invalid %s for array '%s'", count_key,
+                             field->path);
+        }
+        field->count = sconf_int(node);
+    }
+
+    name = NULL;
+    if (gen_entry_str(field->entry, "ctype", &name) == -1) {
+        return -1;
+    }
+
+    for (const struct GenCType *ctype = ctypes; ctype->type; ctype++)
+    {
+        if (ctype->type == type && (!name || strcmp(ctype->name, name) == 0)) {
+            field->ctype = ctype;
+            break;
+        }
+    }
+
+    if (!field->ctype) {
+        return gen_error("C type '%s' can not hold %s of '%s'", name,
+                         gen_type_name(type), field->path);
+    }
+
+    if (sconf_get(field->entry, "default", &node, &err) == 1) {
+        if (field->type == SCONF_TYPE_ARRAY) {
+            return gen_error("array '%s' can not have a default value",
+                             field->path);
+        }
+        field->default_value = gen_default(node, type, field->path);
+        if (!field->default_value) {
+            return -1;
+        }
+    }
+
+    if (sconf_get(field->entry, "required", &node, &err) == 1) {
+        if (sconf_type(node) != SCONF_TYPE_BOOL) {
+            return gen_error("invalid 'required' for '%s'", field->path);
+        }
+        field->required = sconf_bool(node);
+    }
+
+    field->min = field->ctype->min;
+    field->max = field->ctype->max;
+    field->min_float = -HUGE_VAL;
+    field->max_float = HUGE_VAL;
+
+    if (gen_limit(field, "min", &field->min, &field->min_float) == -1 ||
+            gen_limit(field, "max", &field->max, &field->max_float) == -1) {
+        return -1;
+    }
+
+    if (type == SCONF_TYPE_INT && (field->min < field->ctype->min ||
+                                   field->max > field->ctype->max)) {
+        return gen_error("range of '%s' is outside of C type '%s'",
+                         field->path, field->ctype->name);
+    }
+
+    if (field->default_value && gen_check_default(field) == -1) {
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Add value from schema entry to struct, creating nested structs for
+ * each dictionary in its path.
+ *
+ * @param root  The top-level struct.
+ * @param path  Path of value.
+ * @param type  Type of value.
+ * @param entry The schema entry.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int gen_add_value(struct GenStruct *root, const char *path,
+                         uint8_t type, struct SConfNode *entry)
+{
+    struct GenStruct *gen = root;
+    const char *segment = path;
+
+    for (;;)
+    {
+        const char *end = strchr(segment, '.');
+        size_t len = end ? (size_t)(end - segment) : strlen(segment);
+
+        if (len > 0 && segment[0] == '[') {
+            return gen_error("path '%s' indexes an array, use type array",
+                             path);
+        }
+
+        char *ident = gen_ident(segment, len);
+        if (!ident) {
+            return -1;
+        }
+
+        struct GenField *field = gen_struct_field(gen, ident);
+        if (field && (!end || !field->child)) {
+            free(ident);
+            return gen_error("path '%s' conflicts with earlier option "
+                             "at '%s'", path, field->path);
+        }
+
+        if (field) {
+            free(ident);
+            gen = field->child;
+            segment = end + 1;
+            continue;
+        }
+
+        char *key = gen_strndup(segment, len);
+        if (!key) {
+            free(ident);
+            return -1;
+        }
+
+        field = gen_struct_add(gen, key, ident,
+                               gen_strndup(path, (size_t)(segment - path) +
+                                           len));
+        free(key);
+        if (!field) {
+            return -1;
+        }
+
+        if (!end) {
+            field->type = type;
+            field->entry = entry;
+            return gen_field_parse(field);
+        }
+
+        field->child = gen_struct_create(gen_join(gen->name, "_",
+                                                  field->ident));
+        if (!field->child) {
+            return -1;
+        }
+
+        gen = field->child;
+        segment = end + 1;
+    }
+}
+
+/**
+ * @internal
+ * @brief Check that the count field of counted arrays does not collide with
+ * other fields.
+ *
+ * @param gen The struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int gen_check_counts(struct GenStruct *gen)
+{
+    for (size_t i = 0; i < gen->count; i++)
+    {
+        struct GenField *field = &gen->fields[i];
+
+        if (field->child && gen_check_counts(field->child) == -1) {
+            return -1;
+        }
+
+        if (!field->counted) {
+            continue;
+        }
+
+        char *count = gen_join(field->ident, "", "_count");
+        if (!count) {
+            return -1;
+        }
+
+        struct GenField *other = gen_struct_field(gen, count);
+        free(count);
+        if (other) {
+            return gen_error("count of array '%s' conflicts with '%s'",
+                             field->path, other->path);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Add generated identifier, unless an earlier path generates the same.
+ *
+ * @param names Identifiers generated so far.
+ * @param name  The identifier, taken over.
+ * @param path  Path of the option, NULL if generated from the schema name.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int gen_names_add(struct GenNames *names, char *name, const char *path)
+{
+    if (!name) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < names->count; i++)
+    {
+        const struct GenName *other = &names->names[i];
+        if (strcmp(other->name, name) != 0) {
+            continue;
+        }
+
+        if (other->path) {
+            gen_error("path '%s' conflicts with earlier option at '%s', both "
+                      "generate '%s'", path, other->path, name);
+        }
+        else {
+            gen_error("path '%s' conflicts with generated '%s'", path, name);
+        }
+        free(name);
+        return -1;
+    }
+
+    if (names->count == names->capacity) {
+        size_t capacity = names->capacity ? names->capacity * 2 : 16;
+        struct GenName *new = realloc(names->names, capacity * sizeof(*new));
+        if (!new) {
+            free(name);
+            return gen_error("could not allocate memory for names");
+        }
+        names->names = new;
+        names->capacity = capacity;
+    }
+
+    names->names[names->count++] = (struct GenName) {
+        .name = name,
+        .path = path,
+    };
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Free identifiers generated so far.
+ *
+ * @param names The identifiers.
+ */
+static void gen_names_free(struct GenNames *names)
+{
+    for (size_t i = 0; i < names->count; i++)
+    {
+        free(names->names[i].name);
+    }
+
+    free(names->names);
+}
+
+/**
+ * @internal
+ * @brief Add struct tag, binding table and accessors generated for struct and
+ * its nested structs.
+ *
+ * Keys are joined with underscores, so different paths can generate the same
+ * identifier (e.g "a.b_c" and "a_b.c").
+ *
+ * @param gen    The struct.
+ * @param path   Path of the dictionary, NULL for the top-level struct.
+ * @param tags   Struct tags generated so far.
+ * @param idents Other identifiers generated so far.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int gen_collect_names(const struct GenStruct *gen, const char *path,
+                             struct GenNames *tags, struct GenNames *idents)
+{
+    if (gen_names_add(tags, gen_join(gen->name, "", ""), path) == -1 ||
+            gen_names_add(idents, gen_join(gen->name, "", "_bindings"),
+                          path) == -1) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < gen->count; i++)
+    {
+        const struct GenField *field = &gen->fields[i];
+
+        if (field->child) {
+            if (gen_collect_names(field->child, field->path, tags,
+                                  idents) == -1) {
+                return -1;
+            }
+            continue;
+        }
+
+        char *accessor = gen_join(gen->name, "_", field->ident);
+        if (!accessor) {
+            return -1;
+        }
+
+        char *count = NULL;
+        if (field->type == SCONF_TYPE_ARRAY) {
+            count = gen_join(accessor, "", "_count");
+            if (!count) {
+                free(accessor);
+                return -1;
+            }
+        }
+
+        if (gen_names_add(idents, accessor, field->path) == -1 ||
+                (count && gen_names_add(idents, count, field->path) == -1)) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Check that no two paths generate the same identifier, and that no
+ * path generates one of the identifiers made from the schema name.
+ *
+ * @param root The top-level struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int gen_check_names(const struct GenStruct *root)
+{
+    struct GenNames tags = {0};
+    struct GenNames idents = {0};
+
+    int r = 0;
+    if (gen_names_add(&idents, gen_join(root->name, "", "_map"), NULL) == -1 ||
+            gen_names_add(&idents, gen_join(root->name, "", "_load"),
+                          NULL) == -1 ||
+            gen_names_add(&idents, gen_join(root->name, "", "_initialize"),
+                          NULL) == -1 ||
+            gen_collect_names(root, NULL, &tags, &idents) == -1) {
+        r = -1;
+    }
+
+    gen_names_free(&tags);
+    gen_names_free(&idents);
+
+    return r;
+}
+
+/**
+ * @internal
+ * @brief Write string as C string literal.
+ *
+ * @param out The output file.
+ * @param str The string, or NULL for a null pointer.
+ */
+static void gen_write_str(FILE *out, const char *str)
+{
+    if (!str) {
+        fprintf(out, "NULL");
+        return;
+    }
+
+    fputc('"', out);
+    for (const char *c = str; *c; c++)
+    {
+        if (*c == '"' || *c == '\\') {
+            fprintf(out, "\\%c", *c);
+        }
+        else if (isprint((unsigned char)*c)) {
+            fputc(*c, out);
+        }
+        else {
+            fprintf(out, "\\%03o", (unsigned char)*c);
+        }
+    }
+    fputc('"', out);
+}
+
+/**
+ * @internal
+ * @brief Write integer as C constant.
+ *
+ * @param out     The output file.
+ * @param integer The integer.
+ */
+static void gen_write_int(FILE *out, int64_t integer)
+{
+    if (integer == INT64_MIN) {
+        fprintf(out, "INT64_MIN");
+    }
+    else {
+        fprintf(out, "INT64_C(%" PRId64 ")", integer);
+    }
+}
+
+/**
+ * @internal
+ * @brief Write integer range limit as C constant, using the constant of the
+ * C type when the limit is that of the type.
+ *
+ * @param out   The output file.
+ * @param limit The limit.
+ * @param ctype The C type of the field.
+ * @param max   True for the upper limit, false for the lower.
+ */
+static void gen_write_limit(FILE *out, int64_t limit,
+                            const struct GenCType *ctype, bool max)
+{
+    if (max && limit == ctype->max) {
+        fprintf(out, "%s", ctype->max_constant);
+    }
+    else if (!max && limit == ctype->min) {
+        fprintf(out, "%s", ctype->min_constant);
+    }
+    else {
+        gen_write_int(out, limit);
+    }
+}
+
+/**
+ * @internal
+ * @brief Write floating-point number as C constant.
+ *
+ * @param out The output file.
+ * @param fp  The floating-point number.
+ */
+static void gen_write_float(FILE *out, double fp)
+{
+    if (fp == HUGE_VAL) {
+        fprintf(out, "HUGE_VAL");
+    }
+    else if (fp == -HUGE_VAL) {
+        fprintf(out, "-HUGE_VAL");
+    }
+    else {
+        fprintf(out, "%.17g", fp);
+    }
+}
+
+/**
+ * @internal
+ * @brief Write struct definitions, nested structs first.
+ *
+ * @param out The output file.
+ * @param gen The struct.
+ */
+static void gen_write_struct(FILE *out, const struct GenStruct *gen)
+{
+    for (size_t i = 0; i < gen->count; i++)
+    {
+        if (gen->fields[i].child) {
+            gen_write_struct(out, gen->fields[i].child);
+        }
+    }
+
+    fprintf(out, "struct %s {\n", gen->name);
+
+    for (size_t i = 0; i < gen->count; i++)
+    {
+        const struct GenField *field = &gen->fields[i];
+
+        fprintf(out, "    /* %s */\n", field->path);
+
+        if (field->child) {
+            fprintf(out, "    struct %s %s;\n", field->child->name,
+                    field->ident);
+            continue;
+        }
+
+        const char *space = strchr(field->ctype->name, '*') ? "" : " ";
+
+        if (field->type == SCONF_TYPE_ARRAY) {
+            fprintf(out, "    %s%s%s[%" PRId64 "];\n", field->ctype->name,
+                    space, field->ident, field->count);
+            if (field->counted) {
+                fprintf(out, "    size_t %s_count;\n", field->ident);
+            }
+        }
+        else {
+            fprintf(out, "    %s%s%s;\n", field->ctype->name, space,
+                    field->ident);
+        }
+    }
+
+    fprintf(out, "};\n\n");
+}
+
+/**
+ * @internal
+ * @brief Write accessors for values in struct and nested structs.
+ *
+ * @param out    The output file.
+ * @param gen    The struct.
+ * @param config Name of top-level struct.
+ * @param member Member access expression of struct (e.g "config->db.").
+ */
+static int gen_write_accessors(FILE *out, const struct GenStruct *gen,
+                               const char *config, const char *member)
+{
+    for (size_t i = 0; i < gen->count; i++)
+    {
+        const struct GenField *field = &gen->fields[i];
+
+        if (field->child) {
+            char *nested = malloc(strlen(member) + strlen(field->ident) + 2);
+            if (!nested) {
+                return gen_error("could not allocate memory for accessor");
+            }
+            sprintf(nested, "%s%s.", member, field->ident);
+            int r = gen_write_accessors(out, field->child, config, nested);
+            free(nested);
+            if (r == -1) {
+                return -1;
+            }
+            continue;
+        }
+
+        const char *space = strchr(field->ctype->name, '*') ? "" : " ";
+
+        if (field->type == SCONF_TYPE_ARRAY) {
+            fprintf(out,
+                    "static inline %s%s%s_%s(const struct %s *config, "
+                    "size_t i)\n"
+                    "{\n"
+                    "    return %s%s[i];\n"
+                    "}\n\n",
+                    field->ctype->name, space, gen->name, field->ident, config,
+                    member, field->ident);
+
+            fprintf(out,
+                    "static inline size_t %s_%s_count(const struct %s "
+                    "*config)\n"
+                    "{\n",
+                    gen->name, field->ident, config);
+            if (field->counted) {
+                fprintf(out, "    return %s%s_count;\n", member,
+                        field->ident);
+            }
+            else {
+                fprintf(out, "    (void)config;\n"
+                        "    return %" PRId64 ";\n", field->count);
+            }
+            fprintf(out, "}\n\n");
+            continue;
+        }
+
+        fprintf(out,
+                "static inline %s%s%s_%s(const struct %s *config)\n"
+                "{\n"
+                "    return %s%s;\n"
+                "}\n\n",
+                field->ctype->name, space, gen->name, field->ident, config,
+                member, field->ident);
+    }
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Write binding tables, nested structs first.
+ *
+ * @param out The output file.
+ * @param gen The struct.
+ */
+static void gen_write_bindings(FILE *out, const struct GenStruct *gen)
+{
+    for (size_t i = 0; i < gen->count; i++)
+    {
+        if (gen->fields[i].child) {
+            gen_write_bindings(out, gen->fields[i].child);
+        }
+    }
+
+    fprintf(out, "static const struct SConfBinding %s_bindings[] = {\n",
+            gen->name);
+
+    for (size_t i = 0; i < gen->count; i++)
+    {
+        const struct GenField *field = &gen->fields[i];
+
+        fprintf(out, "    {\n        .path = ");
+        gen_write_str(out, field->key);
+        fprintf(out, ",\n");
+
+        if (field->child) {
+            fprintf(out, "        .type = SCONF_TYPE_DICT,\n"
+                    "        .fields = %s_bindings,\n", field->child->name);
+        }
+        else {
+            fprintf(out, "        .type = %s,\n",
+                    gen_type_constant(field->type));
+        }
+
+        if (field->default_value) {
+            fprintf(out, "        .default_value = ");
+            gen_write_str(out, field->default_value);
+            fprintf(out, ",\n");
+        }
+
+        if (field->required) {
+            fprintf(out, "        .required = true,\n");
+        }
+
+        uint8_t type = field->type == SCONF_TYPE_ARRAY ? field->element_type
+                                                       : field->type;
+        if (field->range && type == SCONF_TYPE_INT) {
+            fprintf(out, "        .range = true, .min = ");
+            gen_write_limit(out, field->min, field->ctype, false);
+            fprintf(out, ", .max = ");
+            gen_write_limit(out, field->max, field->ctype, true);
+            fprintf(out, ",\n");
+        }
+        else if (field->range && type == SCONF_TYPE_FLOAT) {
+            fprintf(out, "        .range = true, .min_float = ");
+            gen_write_float(out, field->min_float);
+            fprintf(out, ", .max_float = ");
+            gen_write_float(out, field->max_float);
+            fprintf(out, ",\n");
+        }
+
+        if (field->type == SCONF_TYPE_ARRAY) {
+            fprintf(out, "        .element_type = %s,\n"
+                    "        .element_size = sizeof(%s),\n",
+                    gen_type_constant(type), field->ctype->name);
+            if (field->counted) {
+                fprintf(out, "        SCONF_COUNT(struct %s, %s_count),\n",
+                        gen->name, field->ident);
+            }
+        }
+
+        fprintf(out, "        SCONF_FIELD%s(struct %s, %s),\n    },\n",
+                field->ctype && field->ctype->is_unsigned ? "_UNSIGNED" : "",
+                gen->name,
+                field->ident);
+    }
+
+    fprintf(out, "    {0}\n};\n\n");
+}
+
+/**
+ * @internal
+ * @brief Write config map entry for schema entry.
+ *
+ * @param out   The output file.
+ * @param entry The schema entry.
+ * @param path  Path of value, NULL for usage entries.
+ * @param type  Type of value.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int gen_write_map_entry(FILE *out, struct SConfNode *entry,
+                               const char *path, uint8_t type)
+{
+    static const struct {
+        const char *key;
+        const char *member;
+    } strings[] = {
+        {"long", "opts_long"},
+        {"help", "help"},
+        {"arg-type", "arg_type"},
+        {"description", "usage_desc"},
+        {"env", "env"},
+    };
+
+    struct SConfErr err = {0};
+    struct SConfNode *node = NULL;
+    const char *opts_short = NULL;
+
+    if (gen_entry_str(entry, "short", &opts_short) == -1) {
+        return -1;
+    }
+
+    if (opts_short && strlen(opts_short) != 1) {
+        return gen_error("short option '%s' must be one character",
+                         opts_short);
+    }
+
+    if (type == SCONF_TYPE_ARRAY) {
+        if (opts_short || sconf_get(entry, "long", &node, &err) == 1 ||
+                sconf_get(entry, "env", &node, &err) == 1) {
+            return gen_error("array '%s' can not be set by options or "
+                             "environment", path);
+        }
+        /* Bound directly, the config map has nothing to do for arrays */
+        return 0;
+    }
+
+    fprintf(out, "    {\n");
+
+    if (path) {
+        fprintf(out, "        .path = ");
+        gen_write_str(out, path);
+        fprintf(out, ",\n");
+    }
+
+    fprintf(out, "        .type = %s,\n", gen_type_constant(type));
+
+    if (opts_short) {
+        fprintf(out, "        .opts_short = '%s%c',\n",
+                opts_short[0] == '\'' || opts_short[0] == '\\' ? "\\" : "",
+                opts_short[0]);
+    }
+
+    for (size_t i = 0; i < sizeof(strings) / sizeof(strings[0]); i++)
+    {
+        const char *str = NULL;
+        if (gen_entry_str(entry, strings[i].key, &str) == -1) {
+            return -1;
+        }
+        if (str) {
+            fprintf(out, "        .%s = ", strings[i].member);
+            gen_write_str(out, str);
+            fprintf(out, ",\n");
+        }
+    }
+
+    if (sconf_get(entry, "default", &node, &err) == 1) {
+        char *default_value = gen_default(node, type, path);
+        if (!default_value) {
+            return -1;
+        }
+        fprintf(out, "        .default_value = ");
+        gen_write_str(out, default_value);
+        fprintf(out, ",\n");
+        free(default_value);
+    }
+
+    if (sconf_get(entry, "required", &node, &err) == 1 && sconf_bool(node)) {
+        fprintf(out, "        .required = true,\n");
+    }
+
+    fprintf(out, "    },\n");
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Read the schema entries and build the structs.
+ *
+ * @param options Array of schema entries.
+ * @param root    The top-level struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int gen_read_options(struct SConfNode *options, struct GenStruct *root)
+{
+    struct SConfErr err = {0};
+    struct SConfNode *entry = NULL;
+    uint32_t next = 0;
+    int r;
+
+    while ((r = sconf_node_array_next(options, &entry, &next, &err)) == 1)
+    {
+        const char *path = NULL;
+        const char *name = NULL;
+
+        if (sconf_type(entry) != SCONF_TYPE_DICT) {
+            return gen_error("option %" PRIu32 " is not a dict", next - 1);
+        }
+
+        if (gen_entry_str(entry, "path", &path) == -1 ||
+                gen_entry_str(entry, "type", &name) == -1) {
+            return -1;
+        }
+
+        uint8_t type = name ? gen_type(name) : SCONF_TYPE_UNKNOWN;
+        if (type == SCONF_TYPE_UNKNOWN || type == SCONF_TYPE_DICT) {
+            return gen_error("option %" PRIu32 " has no valid type",
+                             next - 1);
+        }
+
+        if (type != SCONF_TYPE_USAGE && (!path || path[0] == '\0')) {
+            return gen_error("option %" PRIu32 " has no path", next - 1);
+        }
+
+        if (type != SCONF_TYPE_USAGE && type != SCONF_TYPE_YAML_FILE &&
+                gen_add_value(root, path, type, entry) == -1) {
+            return -1;
+        }
+    }
+
+    if (r == -1) {
+        return gen_error("could not read options: %s", sconf_strerror(&err));
+    }
+
+    if (gen_check_counts(root) == -1) {
+        return -1;
+    }
+
+    return gen_check_names(root);
+}
+
+/**
+ * @internal
+ * @brief Write config map from the schema entries.
+ *
+ * @param out     The output file.
+ * @param options Array of schema entries, already checked by
+ *                gen_read_options.
+ * @param name    Name of top-level struct.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int gen_write_map(FILE *out, struct SConfNode *options,
+                         const char *name)
+{
+    struct SConfErr err = {0};
+    struct SConfNode *entry = NULL;
+    uint32_t next = 0;
+    int r;
+
+    fprintf(out, "const struct SConfMap %s_map[] = {\n", name);
+
+    while ((r = sconf_node_array_next(options, &entry, &next, &err)) == 1)
+    {
+        const char *path = NULL;
+        const char *type_name = NULL;
+
+        if (gen_entry_str(entry, "path", &path) == -1 ||
+                gen_entry_str(entry, "type", &type_name) == -1) {
+            return -1;
+        }
+
+        uint8_t type = gen_type(type_name);
+        if (type == SCONF_TYPE_USAGE) {
+            path = NULL;
+        }
+
+        if (gen_write_map_entry(out, entry, path, type) == -1) {
+            return -1;
+        }
+    }
+
+    if (r == -1) {
+        return gen_error("could not read options: %s", sconf_strerror(&err));
+    }
+
+    fprintf(out, "    {0}\n};\n\n");
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Write header with structs, accessors and declarations.
+ *
+ * @param out    The output file.
+ * @param root   The top-level struct.
+ * @param schema Schema file name (used in comment).
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int gen_write_header(FILE *out, const struct GenStruct *root,
+                            const char *schema)
+{
+    fprintf(out,
+            "/* Generated by sconf-gen from %s, do not edit */\n\n"
+            "#pragma once\n\n"
+            "#include <stdbool.h>\n"
+            "#include <stddef.h>\n"
+            "#include <stdint.h>\n\n"
+            "#include <sconf.h>\n\n", schema);
+
+    gen_write_struct(out, root);
+
+    int len = (int)strlen(root->name);
+
+    fprintf(out,
+            "/* Config map for sconf_initialize */\n"
+            "extern const struct SConfMap %s_map[];\n\n"
+            "/* Fill config struct from config tree */\n"
+            "int %s_load(struct SConfNode *root, struct %s *config,\n"
+            "%*s      struct SConfErr *err);\n\n"
+            "/* Initialize config tree using the config map and fill config "
+            "struct */\n"
+            "int %s_initialize(struct SConfNode *root, int argc, char **argv,\n"
+            "%*s            struct %s *config, struct SConfErr *err);\n\n",
+            root->name, root->name, root->name, len + 4, "", root->name,
+            len + 4, "", root->name);
+
+    return gen_write_accessors(out, root, root->name, "config->");
+}
+
+/**
+ * @internal
+ * @brief Write source with the config map, binding tables and loader.
+ *
+ * @param out     The output file.
+ * @param options Array of schema entries.
+ * @param root    The top-level struct.
+ * @param schema  Schema file name (used in comment).
+ * @param header  Header file name.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int gen_write_source(FILE *out, struct SConfNode *options,
+                            const struct GenStruct *root, const char *schema,
+                            const char *header)
+{
+    fprintf(out,
+            "/* Generated by sconf-gen from %s, do not edit */\n\n"
+            "#include <limits.h>\n"
+            "#include <math.h>\n\n"
+            "#include \"%s\"\n\n", schema, header);
+
+    if (gen_write_map(out, options, root->name) == -1) {
+        return -1;
+    }
+
+    gen_write_bindings(out, root);
+
+    int len = (int)strlen(root->name);
+
+    fprintf(out,
+            "int %s_load(struct SConfNode *root, struct %s *config,\n"
+            "%*s      struct SConfErr *err)\n"
+            "{\n"
+            "    return sconf_bind(root, %s_bindings, config, err);\n"
+            "}\n\n"
+            "int %s_initialize(struct SConfNode *root, int argc, char **argv,\n"
+            "%*s            struct %s *config, struct SConfErr *err)\n"
+            "{\n"
+            "    if (sconf_initialize(root, %s_map, argc, argv, NULL,\n"
+            "                         err) == -1) {\n"
+            "        return -1;\n"
+            "    }\n\n"
+            "    return %s_load(root, config, err);\n"
+            "}\n",
+            root->name, root->name, len + 4, "", root->name, root->name,
+            len + 4, "", root->name, root->name, root->name);
+
+    return 0;
+}
+
+/**
+ * @internal
+ * @brief Get file name without directories.
+ *
+ * @param path The path.
+ *
+ * @return file name.
+ */
+static const char *gen_basename(const char *path)
+{
+    const char *slash = strrchr(path, '/');
+
+    return slash ? slash + 1 : path;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 4) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const char *schema = argv[1];
+    const char *header = argv[2];
+    const char *source = argv[3];
+
+    struct SConfErr err = {0};
+    struct SConfNode *root = SCONF_ROOT(&err);
+    struct GenStruct *gen = NULL;
+    struct SConfNode *options = NULL;
+    const char *name = NULL;
+    FILE *out = NULL;
+    int rc = EXIT_FAILURE;
+    int r;
+
+    if (!root) {
+        gen_error("%s", sconf_strerror(&err));
+        return EXIT_FAILURE;
+    }
+
+    if (sconf_yaml_read(root, schema, &err) == -1) {
+        gen_error("could not read schema '%s': %s", schema,
+                  sconf_strerror(&err));
+        goto out;
+    }
+
+    if (gen_entry_str(root, "name", &name) == -1) {
+        goto out;
+    }
+
+    if (!name) {
+        gen_error("schema '%s' has no name", schema);
+        goto out;
+    }
+
+    if (sconf_get(root, "options", &options, &err) != 1 ||
+            sconf_type(options) != SCONF_TYPE_ARRAY) {
+        gen_error("schema '%s' has no list of options", schema);
+        goto out;
+    }
+
+    gen = gen_struct_create(gen_ident(name, strlen(name)));
+    if (!gen || gen_read_options(options, gen) == -1) {
+        goto out;
+    }
+
+    out = fopen(header, "w");
+    if (!out) {
+        gen_error("could not open '%s'", header);
+        goto out;
+    }
+
+    if (gen_write_header(out, gen, gen_basename(schema)) == -1) {
+        goto out;
+    }
+
+    r = fclose(out);
+    out = NULL;
+    if (r != 0) {
+        gen_error("could not write '%s'", header);
+        goto out;
+    }
+
+    out = fopen(source, "w");
+    if (!out) {
+        gen_error("could not open '%s'", source);
+        goto out;
+    }
+
+    if (gen_write_source(out, options, gen, gen_basename(schema),
+                         gen_basename(header)) == -1) {
+        goto out;
+    }
+
+    r = fclose(out);
+    out = NULL;
+    if (r != 0) {
+        gen_error("could not write '%s'", source);
+        goto out;
+    }
+
+    rc = EXIT_SUCCESS;
+
+out:
+    if (out) {
+        fclose(out);
+    }
+    if (rc != EXIT_SUCCESS) {
+        remove(header);
+        remove(source);
+    }
+    gen_struct_destroy(gen);
+    sconf_node_destroy(root);
+
+    return rc;
+}